@@ -0,0 +1,17 @@
+/* contrib/pg_buffercache/pg_buffercache--1.4--1.5.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION pg_buffercache UPDATE TO '1.5'" to load this file. \quit
+
+CREATE FUNCTION pg_buffercache_numa_usage(
+    OUT numa_node int4,
+    OUT buffers_used int4,
+    OUT buffers_unused int4,
+    OUT buffers_dirty int4)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_buffercache_numa_usage'
+LANGUAGE C PARALLEL SAFE;
+
+-- Don't want these to be available to public.
+REVOKE ALL ON FUNCTION pg_buffercache_numa_usage() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_buffercache_numa_usage() TO pg_monitor;
@@ -11,6 +11,8 @@
 #include "access/htup_details.h"
 #include "catalog/pg_type.h"
 #include "funcapi.h"
+#include "miscadmin.h"
+#include "port/pg_numa.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
 
@@ -19,6 +21,10 @@
 #define NUM_BUFFERCACHE_PAGES_ELEM	9
 #define NUM_BUFFERCACHE_SUMMARY_ELEM 5
 #define NUM_BUFFERCACHE_USAGE_COUNTS_ELEM 4
+#define NUM_BUFFERCACHE_NUMA_USAGE_ELEM 4
+
+/* Number of buffers whose NUMA node is queried at once */
+#define NUMA_QUERY_CHUNK_SIZE 1024
 
 PG_MODULE_MAGIC;
 
@@ -63,6 +69,7 @@ typedef struct
 PG_FUNCTION_INFO_V1(pg_buffercache_pages);
 PG_FUNCTION_INFO_V1(pg_buffercache_summary);
 PG_FUNCTION_INFO_V1(pg_buffercache_usage_counts);
+PG_FUNCTION_INFO_V1(pg_buffercache_numa_usage);
 
 Datum
 pg_buffercache_pages(PG_FUNCTION_ARGS)
@@ -347,3 +354,105 @@ pg_buffercache_usage_counts(PG_FUNCTION_ARGS)
 
 	return (Datum) 0;
 }
+
+/*
+ * Report, for each NUMA node, how many buffers of the pool are located on
+ * it, and how they are used.
+ *
+ * The node is that of the OS memory page holding the buffer's block.  The
+ * last row, with a NULL node, counts the buffers whose node couldn't be
+ * determined, which is all of them if the build or the system has no NUMA
+ * support.
+ */
+Datum
+pg_buffercache_numa_usage(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	bool		numa_ok;
+	int			max_node = 0;
+	int		   *used;
+	int		   *unused;
+	int		   *dirty;
+	void	   *pages[NUMA_QUERY_CHUNK_SIZE];
+	int			status[NUMA_QUERY_CHUNK_SIZE];
+	Datum		values[NUM_BUFFERCACHE_NUMA_USAGE_ELEM];
+	bool		nulls[NUM_BUFFERCACHE_NUMA_USAGE_ELEM] = {0};
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	numa_ok = (pg_numa_init() != -1);
+	if (numa_ok)
+		max_node = pg_numa_get_max_node();
+
+	/* One slot per node, plus one for buffers of unknown location */
+	used = palloc0(sizeof(int) * (max_node + 2));
+	unused = palloc0(sizeof(int) * (max_node + 2));
+	dirty = palloc0(sizeof(int) * (max_node + 2));
+
+	for (int start = 0; start < NBuffers; start += NUMA_QUERY_CHUNK_SIZE)
+	{
+		int			count = Min(NBuffers - start, NUMA_QUERY_CHUNK_SIZE);
+		bool		query_ok = false;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (numa_ok)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				pages[i] = BufferGetBlock(start + i + 1);
+
+				/*
+				 * A page that this process hasn't mapped yet has no known
+				 * location, so touch it first.  It's only read, so this is
+				 * safe without any lock on the buffer.
+				 */
+				(void) *((volatile char *) pages[i]);
+			}
+
+			query_ok = (pg_numa_query_pages(0, count, pages, status) == 0);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			BufferDesc *bufHdr = GetBufferDescriptor(start + i);
+			uint32		buf_state = pg_atomic_read_u32(&bufHdr->state);
+			int			node = max_node + 1;
+
+			if (query_ok && status[i] >= 0 && status[i] <= max_node)
+				node = status[i];
+
+			if (buf_state & BM_VALID)
+			{
+				used[node]++;
+
+				if (buf_state & BM_DIRTY)
+					dirty[node]++;
+			}
+			else
+				unused[node]++;
+		}
+	}
+
+	for (int node = 0; node <= max_node + 1; node++)
+	{
+		/* Skip the unknown node if there's nothing to report for it */
+		if (node == max_node + 1 && used[node] == 0 && unused[node] == 0)
+			continue;
+
+		if (node <= max_node)
+		{
+			values[0] = Int32GetDatum(node);
+			nulls[0] = false;
+		}
+		else
+			nulls[0] = true;
+		values[1] = Int32GetDatum(used[node]);
+		values[2] = Int32GetDatum(unused[node]);
+		values[3] = Int32GetDatum(dirty[node]);
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
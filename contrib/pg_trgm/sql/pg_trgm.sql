@@ -236,3 +236,16 @@ SELECT DISTINCT city, similarity(city, 'Warsaw'), show_limit()
 SELECT set_limit(0.5);
 SELECT DISTINCT city, similarity(city, 'Warsaw'), show_limit()
   FROM restaurants WHERE city % 'Warsaw';
+
+-- Check that a GIN scan gives the right results when it skips very
+-- frequent trigrams
+CREATE TEMP TABLE test_trgm_freq (t text);
+INSERT INTO test_trgm_freq
+  SELECT 'the quick brown fox ' || g FROM generate_series(1, 20000) g;
+CREATE INDEX ON test_trgm_freq USING gin (t gin_trgm_ops);
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM test_trgm_freq WHERE t LIKE '%quick brown fox 1234%';
+SELECT count(*) FROM test_trgm_freq WHERE t LIKE '%quick brown fox 1234%';
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM test_trgm_freq WHERE t LIKE '%fox 77%';
+SELECT count(*) FROM test_trgm_freq WHERE t LIKE '%fox 77%';
@@ -248,9 +248,11 @@ GetConnection(UserMapping *user, bool will_prep_stmt, PgFdwConnState **state)
 	 */
 	PG_TRY();
 	{
-		/* Process a pending asynchronous request if any. */
+		/* Process a pending asynchronous request or prefetch if any. */
 		if (entry->state.pendingAreq)
 			process_pending_request(entry->state.pendingAreq);
+		if (entry->state.pendingPrefetch)
+			process_pending_prefetch(entry->state.pendingPrefetch);
 		/* Start a new transaction or subtransaction if needed. */
 		begin_remote_xact(entry);
 	}
@@ -817,9 +819,11 @@ GetPrepStmtNumber(PGconn *conn)
 PGresult *
 pgfdw_exec_query(PGconn *conn, const char *query, PgFdwConnState *state)
 {
-	/* First, process a pending asynchronous request, if any. */
+	/* First, process a pending asynchronous request or prefetch, if any. */
 	if (state && state->pendingAreq)
 		process_pending_request(state->pendingAreq);
+	if (state && state->pendingPrefetch)
+		process_pending_prefetch(state->pendingPrefetch);
 
 	/*
 	 * Submit a query.  Since we don't use non-blocking mode, this also can
@@ -1005,6 +1009,13 @@ pgfdw_xact_callback(XactEvent event, void *arg)
 					 */
 					pgfdw_reject_incomplete_xact_state_change(entry);
 
+					/*
+					 * A cursor left open at commit might still have a
+					 * prefetch in flight; collect its result first.
+					 */
+					if (entry->state.pendingPrefetch)
+						process_pending_prefetch(entry->state.pendingPrefetch);
+
 					/* Commit all remote transactions during pre-commit */
 					entry->changing_xact_state = true;
 					if (entry->parallel_commit)
@@ -1160,6 +1171,10 @@ pgfdw_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
 			 */
 			pgfdw_reject_incomplete_xact_state_change(entry);
 
+			/* Collect the result of a prefetch still in flight, if any */
+			if (entry->state.pendingPrefetch)
+				process_pending_prefetch(entry->state.pendingPrefetch);
+
 			/* Commit all remote subtransactions during pre-commit */
 			snprintf(sql, sizeof(sql), "RELEASE SAVEPOINT s%d", curlevel);
 			entry->changing_xact_state = true;
@@ -1668,12 +1683,13 @@ pgfdw_abort_cleanup(ConnCacheEntry *entry, bool toplevel)
 	}
 
 	/*
-	 * If pendingAreq of the per-connection state is not NULL, it means that
-	 * an asynchronous fetch begun by fetch_more_data_begin() was not done
-	 * successfully and thus the per-connection state was not reset in
-	 * fetch_more_data(); in that case reset the per-connection state here.
+	 * If pendingAreq or pendingPrefetch of the per-connection state is not
+	 * NULL, it means that an asynchronous fetch begun by
+	 * fetch_more_data_begin() or a prefetch begun by fetch_more_data() was
+	 * not done successfully and thus the per-connection state was not reset
+	 * in fetch_more_data(); in that case reset the per-connection state here.
 	 */
-	if (entry->state.pendingAreq)
+	if (entry->state.pendingAreq || entry->state.pendingPrefetch)
 		memset(&entry->state, 0, sizeof(entry->state));
 
 	/* Disarm changing_xact_state if it all worked */
@@ -1955,7 +1971,7 @@ pgfdw_finish_abort_cleanup(List *pending_entries, List *cancel_requested,
 		}
 
 		/* Reset the per-connection state if needed */
-		if (entry->state.pendingAreq)
+		if (entry->state.pendingAreq || entry->state.pendingPrefetch)
 			memset(&entry->state, 0, sizeof(entry->state));
 
 		/* We're done with this entry; unset the changing_xact_state flag */
@@ -2000,7 +2016,7 @@ pgfdw_finish_abort_cleanup(List *pending_entries, List *cancel_requested,
 		entry->have_error = false;
 
 		/* Reset the per-connection state if needed */
-		if (entry->state.pendingAreq)
+		if (entry->state.pendingAreq || entry->state.pendingPrefetch)
 			memset(&entry->state, 0, sizeof(entry->state));
 
 		/* We're done with this entry; unset the changing_xact_state flag */
@@ -25,6 +25,7 @@
 #include "executor/execAsync.h"
 #include "foreign/fdwapi.h"
 #include "funcapi.h"
+#include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
@@ -77,6 +78,10 @@ enum FdwScanPrivateIndex
 	FdwScanPrivateRetrievedAttrs,
 	/* Integer representing the desired fetch_size */
 	FdwScanPrivateFetchSize,
+	/* Boolean flag showing if the next batch should be prefetched */
+	FdwScanPrivatePrefetch,
+	/* Boolean flag showing if results should be fetched in binary format */
+	FdwScanPrivateBinaryFetch,
 
 	/*
 	 * String describing join i.e. names of relations being joined and types
@@ -132,6 +137,17 @@ enum FdwDirectModifyPrivateIndex
 	FdwDirectModifyPrivateSetProcessed
 };
 
+/*
+ * Binary input conversion metadata for the columns of a tuple descriptor;
+ * the counterpart of AttInMetadata for results fetched in binary format.
+ * Entries are only valid for the columns that are fetched.
+ */
+typedef struct AttRecvMetadata
+{
+	FmgrInfo   *attrecvfuncs;	/* array of attribute type receive functions */
+	Oid		   *attioparams;	/* array of attribute type I/O parameter OIDs */
+} AttRecvMetadata;
+
 /*
  * Execution state of a foreign scan using postgres_fdw.
  */
@@ -141,6 +157,9 @@ typedef struct PgFdwScanState
 								 * for a foreign join scan. */
 	TupleDesc	tupdesc;		/* tuple descriptor of scan */
 	AttInMetadata *attinmeta;	/* attribute datatype conversion metadata */
+	AttRecvMetadata *attrecvmeta;	/* binary conversion metadata, or NULL if
+									 * results are fetched in text format */
+	bool		binary_checked; /* result types verified for binary fetch? */
 
 	/* extracted fdw_private data */
 	char	   *query;			/* text of SELECT command */
@@ -168,8 +187,15 @@ typedef struct PgFdwScanState
 	/* for asynchronous execution */
 	bool		async_capable;	/* engage asynchronous-capable logic? */
 
+	/* for fetching the next batch while the current one is consumed */
+	bool		prefetch;		/* send next FETCH before it's needed? */
+	bool		prefetch_ready; /* prefetched batch is stored in prefetch_cxt */
+	HeapTuple  *prefetch_tuples;	/* array of prefetched tuples */
+	int			prefetch_num_tuples;	/* # of tuples in array */
+
 	/* working memory contexts */
 	MemoryContext batch_cxt;	/* context holding current batch of tuples */
+	MemoryContext prefetch_cxt; /* context holding prefetched batch */
 	MemoryContext temp_cxt;		/* context for per-tuple temporary data */
 
 	int			fetch_size;		/* number of tuples per fetch */
@@ -449,6 +475,15 @@ static bool ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel,
 									  void *arg);
 static void create_cursor(ForeignScanState *node);
 static void fetch_more_data(ForeignScanState *node);
+static HeapTuple *make_tuples_from_result(ForeignScanState *node,
+										  PGresult *res, int *numrows);
+static bool is_binary_fetchable_type(Oid typid);
+static AttRecvMetadata *get_recv_metadata(TupleDesc tupdesc,
+										  List *retrieved_attrs);
+static bool binary_result_types_match(PgFdwScanState *fsstate,
+									  PGresult *res);
+static void prefetch_more_data_begin(ForeignScanState *node);
+static void discard_prefetched_data(ForeignScanState *node);
 static void close_cursor(PGconn *conn, unsigned int cursor_number,
 						 PgFdwConnState *conn_state);
 static PgFdwModifyState *create_foreign_modify(EState *estate,
@@ -511,6 +546,7 @@ static HeapTuple make_tuple_from_result_row(PGresult *res,
 											int row,
 											Relation rel,
 											AttInMetadata *attinmeta,
+											AttRecvMetadata *attrecvmeta,
 											List *retrieved_attrs,
 											ForeignScanState *fsstate,
 											MemoryContext temp_context);
@@ -651,6 +687,8 @@ postgresGetForeignRelSize(PlannerInfo *root,
 	fpinfo->shippable_extensions = NIL;
 	fpinfo->fetch_size = 100;
 	fpinfo->async_capable = false;
+	fpinfo->prefetch = false;
+	fpinfo->binary_fetch = false;
 
 	apply_server_options(fpinfo);
 	apply_table_options(fpinfo);
@@ -1405,9 +1443,11 @@ postgresGetForeignPlan(PlannerInfo *root,
 	 * Build the fdw_private list that will be available to the executor.
 	 * Items in the list must match order in enum FdwScanPrivateIndex.
 	 */
-	fdw_private = list_make3(makeString(sql.data),
+	fdw_private = list_make5(makeString(sql.data),
 							 retrieved_attrs,
-							 makeInteger(fpinfo->fetch_size));
+							 makeInteger(fpinfo->fetch_size),
+							 makeBoolean(fpinfo->prefetch),
+							 makeBoolean(fpinfo->binary_fetch));
 	if (IS_JOIN_REL(foreignrel) || IS_UPPER_REL(foreignrel))
 		fdw_private = lappend(fdw_private,
 							  makeString(fpinfo->relation_name));
@@ -1567,6 +1607,11 @@ postgresBeginForeignScan(ForeignScanState *node, int eflags)
 
 	fsstate->attinmeta = TupleDescGetAttInMetadata(fsstate->tupdesc);
 
+	/* Prepare for fetching in binary format, if requested and possible */
+	if (boolVal(list_nth(fsplan->fdw_private, FdwScanPrivateBinaryFetch)))
+		fsstate->attrecvmeta = get_recv_metadata(fsstate->tupdesc,
+												 fsstate->retrieved_attrs);
+
 	/*
 	 * Prepare for processing of parameters used in remote query, if any.
 	 */
@@ -1582,6 +1627,18 @@ postgresBeginForeignScan(ForeignScanState *node, int eflags)
 
 	/* Set the async-capable flag */
 	fsstate->async_capable = node->ss.ps.async_capable;
+
+	/*
+	 * Set up for prefetching, if requested.  An async-capable scan already
+	 * overlaps its fetches with other work, so it doesn't prefetch.
+	 */
+	fsstate->prefetch = boolVal(list_nth(fsplan->fdw_private,
+										 FdwScanPrivatePrefetch)) &&
+		!fsstate->async_capable;
+	if (fsstate->prefetch)
+		fsstate->prefetch_cxt = AllocSetContextCreate(estate->es_query_cxt,
+													  "postgres_fdw prefetched tuple data",
+													  ALLOCSET_DEFAULT_SIZES);
 }
 
 /*
@@ -1657,6 +1714,15 @@ postgresReScanForeignScan(ForeignScanState *node)
 		fsstate->conn_state->pendingAreq->requestee == (PlanState *) node)
 		fetch_more_data(node);
 
+	/*
+	 * Likewise, if we have prefetched the next batch, or are in the middle of
+	 * doing so, throw it away; the scan will restart from the beginning.
+	 * The prefetch was counted in fetch_ct_2, so we won't wrongly assume
+	 * below that the cursor has not moved past the batch we have.
+	 */
+	if (fsstate->prefetch)
+		discard_prefetched_data(node);
+
 	/*
 	 * If any internal parameters affecting this node have changed, we'd
 	 * better destroy and recreate the cursor.  Otherwise, rewinding it should
@@ -1711,6 +1777,10 @@ postgresEndForeignScan(ForeignScanState *node)
 	if (fsstate == NULL)
 		return;
 
+	/* Throw away any prefetched batch, without bothering to convert it */
+	if (fsstate->prefetch)
+		discard_prefetched_data(node);
+
 	/* Close the cursor if open, to prevent accumulation of cursors */
 	if (fsstate->cursor_exists)
 		close_cursor(fsstate->conn, fsstate->cursor_number,
@@ -2910,6 +2980,20 @@ postgresExplainForeignScan(ForeignScanState *node, ExplainState *es)
 		sql = strVal(list_nth(fdw_private, FdwScanPrivateSelectSql));
 		ExplainPropertyText("Remote SQL", sql, es);
 	}
+
+	/*
+	 * If binary fetching was requested, show whether it was actually used,
+	 * when VERBOSE and ANALYZE options are specified.  It might have been
+	 * given up in BeginForeignScan or on the first fetch.
+	 */
+	if (es->verbose && es->analyze &&
+		boolVal(list_nth(fdw_private, FdwScanPrivateBinaryFetch)))
+	{
+		PgFdwScanState *fsstate = (PgFdwScanState *) node->fdw_state;
+
+		ExplainPropertyText("Fetch Format",
+							fsstate->attrecvmeta ? "binary" : "text", es);
+	}
 }
 
 /*
@@ -3712,9 +3796,11 @@ create_cursor(ForeignScanState *node)
 	StringInfoData buf;
 	PGresult   *res;
 
-	/* First, process a pending asynchronous request, if any. */
+	/* First, process a pending asynchronous request or prefetch, if any. */
 	if (fsstate->conn_state->pendingAreq)
 		process_pending_request(fsstate->conn_state->pendingAreq);
+	if (fsstate->conn_state->pendingPrefetch)
+		process_pending_prefetch(fsstate->conn_state->pendingPrefetch);
 
 	/*
 	 * Construct array of query parameter values in text format.  We do the
@@ -3737,8 +3823,10 @@ create_cursor(ForeignScanState *node)
 
 	/* Construct the DECLARE CURSOR command */
 	initStringInfo(&buf);
-	appendStringInfo(&buf, "DECLARE c%u CURSOR FOR\n%s",
-					 fsstate->cursor_number, fsstate->query);
+	appendStringInfo(&buf, "DECLARE c%u %sCURSOR FOR\n%s",
+					 fsstate->cursor_number,
+					 fsstate->attrecvmeta ? "BINARY " : "",
+					 fsstate->query);
 
 	/*
 	 * Notice that we pass NULL for paramTypes, thus forcing the remote server
@@ -3776,6 +3864,11 @@ create_cursor(ForeignScanState *node)
 
 /*
  * Fetch some more rows from the node's cursor.
+ *
+ * If the scan prefetches, the next batch has usually been requested already,
+ * and we only need to collect it; afterwards, the FETCH for the following
+ * batch is sent before returning, so that the remote server produces it while
+ * we process this one.
  */
 static void
 fetch_more_data(ForeignScanState *node)
@@ -3784,6 +3877,37 @@ fetch_more_data(ForeignScanState *node)
 	PGresult   *volatile res = NULL;
 	MemoryContext oldcontext;
 
+	/* Collect the result of our own prefetch, if it's still in flight. */
+	if (fsstate->conn_state->pendingPrefetch == node)
+		process_pending_prefetch(node);
+
+	if (fsstate->prefetch_ready)
+	{
+		MemoryContext cxt = fsstate->batch_cxt;
+
+		/*
+		 * Make the prefetched batch the current one, and recycle the context
+		 * holding the previous batch for the next prefetch.
+		 */
+		fsstate->batch_cxt = fsstate->prefetch_cxt;
+		fsstate->prefetch_cxt = cxt;
+		MemoryContextReset(fsstate->prefetch_cxt);
+
+		fsstate->tuples = fsstate->prefetch_tuples;
+		fsstate->num_tuples = fsstate->prefetch_num_tuples;
+		fsstate->next_tuple = 0;
+		fsstate->prefetch_tuples = NULL;
+		fsstate->prefetch_num_tuples = 0;
+		fsstate->prefetch_ready = false;
+
+		/* Must be EOF if we didn't get as many tuples as we asked for. */
+		fsstate->eof_reached = (fsstate->num_tuples < fsstate->fetch_size);
+
+		if (!fsstate->eof_reached)
+			prefetch_more_data_begin(node);
+		return;
+	}
+
 	/*
 	 * We'll store the tuples in the batch_cxt.  First, flush the previous
 	 * batch.
@@ -3797,7 +3921,6 @@ fetch_more_data(ForeignScanState *node)
 	{
 		PGconn	   *conn = fsstate->conn;
 		int			numrows;
-		int			i;
 
 		if (fsstate->async_capable)
 		{
@@ -3829,25 +3952,43 @@ fetch_more_data(ForeignScanState *node)
 				pgfdw_report_error(ERROR, res, conn, false, fsstate->query);
 		}
 
+		/*
+		 * On the first fetch in binary format, make sure that the remote
+		 * server sent the same data types we're going to receive them as.
+		 * If not, switch to text format, which can convert between types;
+		 * that requires declaring the cursor anew and fetching again.
+		 */
+		if (fsstate->attrecvmeta && !fsstate->binary_checked)
+		{
+			if (!binary_result_types_match(fsstate, res))
+			{
+				char		sql[64];
+
+				PQclear(res);
+				res = NULL;
+
+				fsstate->attrecvmeta = NULL;
+				close_cursor(conn, fsstate->cursor_number,
+							 fsstate->conn_state);
+				fsstate->cursor_exists = false;
+				create_cursor(node);
+
+				snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
+						 fsstate->fetch_size, fsstate->cursor_number);
+
+				res = pgfdw_exec_query(conn, sql, fsstate->conn_state);
+				/* On error, report the original query, not the FETCH. */
+				if (PQresultStatus(res) != PGRES_TUPLES_OK)
+					pgfdw_report_error(ERROR, res, conn, false, fsstate->query);
+			}
+			fsstate->binary_checked = true;
+		}
+
 		/* Convert the data into HeapTuples */
-		numrows = PQntuples(res);
-		fsstate->tuples = (HeapTuple *) palloc0(numrows * sizeof(HeapTuple));
+		fsstate->tuples = make_tuples_from_result(node, res, &numrows);
 		fsstate->num_tuples = numrows;
 		fsstate->next_tuple = 0;
 
-		for (i = 0; i < numrows; i++)
-		{
-			Assert(IsA(node->ss.ps.plan, ForeignScan));
-
-			fsstate->tuples[i] =
-				make_tuple_from_result_row(res, i,
-										   fsstate->rel,
-										   fsstate->attinmeta,
-										   fsstate->retrieved_attrs,
-										   node,
-										   fsstate->temp_cxt);
-		}
-
 		/* Update fetch_ct_2 */
 		if (fsstate->fetch_ct_2 < 2)
 			fsstate->fetch_ct_2++;
@@ -3862,6 +4003,261 @@ fetch_more_data(ForeignScanState *node)
 	PG_END_TRY();
 
 	MemoryContextSwitchTo(oldcontext);
+
+	if (fsstate->prefetch && !fsstate->eof_reached)
+		prefetch_more_data_begin(node);
+}
+
+/*
+ * Convert all rows of a FETCH result into HeapTuples, allocated in the
+ * current memory context.
+ */
+static HeapTuple *
+make_tuples_from_result(ForeignScanState *node, PGresult *res, int *numrows)
+{
+	PgFdwScanState *fsstate = (PgFdwScanState *) node->fdw_state;
+	HeapTuple  *tuples;
+	int			i;
+
+	Assert(IsA(node->ss.ps.plan, ForeignScan));
+
+	*numrows = PQntuples(res);
+	tuples = (HeapTuple *) palloc0(*numrows * sizeof(HeapTuple));
+
+	for (i = 0; i < *numrows; i++)
+	{
+		tuples[i] = make_tuple_from_result_row(res, i,
+											   fsstate->rel,
+											   fsstate->attinmeta,
+											   fsstate->attrecvmeta,
+											   fsstate->retrieved_attrs,
+											   node,
+											   fsstate->temp_cxt);
+	}
+
+	return tuples;
+}
+
+/*
+ * Can values of the given type be fetched in binary format?
+ *
+ * The binary representation is only well-defined across servers for built-in
+ * types, whose OIDs are the same on both sides, and we stay away from
+ * composite types, whose binary form embeds the column types.
+ */
+static bool
+is_binary_fetchable_type(Oid typid)
+{
+	Oid			basetype = getBaseType(typid);
+	Oid			elemtype;
+
+	if (basetype >= FirstGenbkiObjectId ||
+		get_typtype(basetype) != TYPTYPE_BASE)
+		return false;
+
+	elemtype = get_element_type(basetype);
+	if (OidIsValid(elemtype) &&
+		(elemtype >= FirstGenbkiObjectId ||
+		 get_typtype(elemtype) != TYPTYPE_BASE))
+		return false;
+
+	return true;
+}
+
+/*
+ * Build binary conversion metadata for the columns of tupdesc that are
+ * retrieved, or return NULL if any of them can't be fetched in binary format.
+ *
+ * The receive functions of textual types (text, varchar, name, json, xml,
+ * tsvector and so on, and arrays of those) convert their input from the
+ * session's client_encoding, but the remote server sends them in our
+ * database encoding, which is what connect_pg_server() sets as the remote
+ * client_encoding.  Rather than trying to keep a list of such types, we
+ * don't use binary format at all unless the two encodings are the same.
+ */
+static AttRecvMetadata *
+get_recv_metadata(TupleDesc tupdesc, List *retrieved_attrs)
+{
+	AttRecvMetadata *attrecvmeta;
+	ListCell   *lc;
+
+	if (pg_get_client_encoding() != GetDatabaseEncoding())
+		return NULL;
+
+	foreach(lc, retrieved_attrs)
+	{
+		int			i = lfirst_int(lc);
+
+		if (i > 0 &&
+			!is_binary_fetchable_type(TupleDescAttr(tupdesc, i - 1)->atttypid))
+			return NULL;
+	}
+
+	attrecvmeta = (AttRecvMetadata *) palloc(sizeof(AttRecvMetadata));
+	attrecvmeta->attrecvfuncs = (FmgrInfo *)
+		palloc0(tupdesc->natts * sizeof(FmgrInfo));
+	attrecvmeta->attioparams = (Oid *) palloc0(tupdesc->natts * sizeof(Oid));
+
+	foreach(lc, retrieved_attrs)
+	{
+		int			i = lfirst_int(lc);
+		Oid			recvfunc;
+
+		if (i <= 0)
+			continue;
+
+		getTypeBinaryInputInfo(TupleDescAttr(tupdesc, i - 1)->atttypid,
+							   &recvfunc, &attrecvmeta->attioparams[i - 1]);
+		fmgr_info(recvfunc, &attrecvmeta->attrecvfuncs[i - 1]);
+	}
+
+	return attrecvmeta;
+}
+
+/*
+ * Check that the column types of a binary-format FETCH result are the ones
+ * that the scan's receive functions expect.
+ */
+static bool
+binary_result_types_match(PgFdwScanState *fsstate, PGresult *res)
+{
+	ListCell   *lc;
+	int			j = 0;
+
+	foreach(lc, fsstate->retrieved_attrs)
+	{
+		int			i = lfirst_int(lc);
+		Oid			expected;
+
+		if (j >= PQnfields(res))
+			return false;
+
+		if (i > 0)
+			expected = getBaseType(TupleDescAttr(fsstate->tupdesc,
+												 i - 1)->atttypid);
+		else if (i == SelfItemPointerAttributeNumber)
+			expected = TIDOID;
+		else
+			expected = PQftype(res, j); /* ignored anyway */
+
+		if (PQftype(res, j) != expected)
+			return false;
+
+		j++;
+	}
+
+	return true;
+}
+
+/*
+ * Send the FETCH for the node's next batch, without waiting for the result.
+ *
+ * This is skipped if some other request is in progress on the connection;
+ * the next batch will then be fetched synchronously.
+ *
+ * Note: fetch_more_data or process_pending_prefetch must be called to
+ * collect the result.
+ */
+static void
+prefetch_more_data_begin(ForeignScanState *node)
+{
+	PgFdwScanState *fsstate = (PgFdwScanState *) node->fdw_state;
+	char		sql[64];
+
+	Assert(fsstate->prefetch && !fsstate->prefetch_ready);
+
+	if (fsstate->conn_state->pendingAreq ||
+		fsstate->conn_state->pendingPrefetch)
+		return;
+
+	snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
+			 fsstate->fetch_size, fsstate->cursor_number);
+
+	if (!PQsendQuery(fsstate->conn, sql))
+		pgfdw_report_error(ERROR, NULL, fsstate->conn, false, fsstate->query);
+
+	/* Remember that the prefetch is in process */
+	fsstate->conn_state->pendingPrefetch = node;
+
+	/* The cursor will have moved, so count this as a fetch */
+	if (fsstate->fetch_ct_2 < 2)
+		fsstate->fetch_ct_2++;
+}
+
+/*
+ * Collect the result of the prefetch in flight for the given node, and keep
+ * it for the node's next fetch_more_data call.  This must be done before
+ * anyone else can use the connection.
+ */
+void
+process_pending_prefetch(ForeignScanState *node)
+{
+	PgFdwScanState *fsstate = (PgFdwScanState *) node->fdw_state;
+	PGresult   *volatile res = NULL;
+	MemoryContext oldcontext;
+
+	/* The prefetch should be currently in-process */
+	Assert(fsstate->conn_state->pendingPrefetch == node);
+	Assert(!fsstate->prefetch_ready);
+
+	MemoryContextReset(fsstate->prefetch_cxt);
+	oldcontext = MemoryContextSwitchTo(fsstate->prefetch_cxt);
+
+	/* PGresult must be released before leaving this function. */
+	PG_TRY();
+	{
+		res = pgfdw_get_result(fsstate->conn, fsstate->query);
+		/* On error, report the original query, not the FETCH. */
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			pgfdw_report_error(ERROR, res, fsstate->conn, false,
+							   fsstate->query);
+
+		/* Reset per-connection state */
+		fsstate->conn_state->pendingPrefetch = NULL;
+
+		fsstate->prefetch_tuples =
+			make_tuples_from_result(node, res, &fsstate->prefetch_num_tuples);
+		fsstate->prefetch_ready = true;
+	}
+	PG_FINALLY();
+	{
+		PQclear(res);
+	}
+	PG_END_TRY();
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Throw away the node's prefetched batch, if any, including one that is
+ * still in flight.
+ */
+static void
+discard_prefetched_data(ForeignScanState *node)
+{
+	PgFdwScanState *fsstate = (PgFdwScanState *) node->fdw_state;
+
+	if (fsstate->conn_state->pendingPrefetch == node)
+	{
+		PGresult   *res;
+
+		/*
+		 * We don't use a PG_TRY block here, so be careful not to throw error
+		 * without releasing the PGresult.
+		 */
+		res = pgfdw_get_result(fsstate->conn, fsstate->query);
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			pgfdw_report_error(ERROR, res, fsstate->conn, true,
+							   fsstate->query);
+		PQclear(res);
+
+		fsstate->conn_state->pendingPrefetch = NULL;
+	}
+
+	fsstate->prefetch_tuples = NULL;
+	fsstate->prefetch_num_tuples = 0;
+	fsstate->prefetch_ready = false;
+	MemoryContextReset(fsstate->prefetch_cxt);
 }
 
 /*
@@ -4089,9 +4485,11 @@ execute_foreign_modify(EState *estate,
 		   operation == CMD_UPDATE ||
 		   operation == CMD_DELETE);
 
-	/* First, process a pending asynchronous request, if any. */
+	/* First, process a pending asynchronous request or prefetch, if any. */
 	if (fmstate->conn_state->pendingAreq)
 		process_pending_request(fmstate->conn_state->pendingAreq);
+	if (fmstate->conn_state->pendingPrefetch)
+		process_pending_prefetch(fmstate->conn_state->pendingPrefetch);
 
 	/*
 	 * If the existing query was deparsed and prepared for a different number
@@ -4334,6 +4732,7 @@ store_returning_result(PgFdwModifyState *fmstate,
 		newtup = make_tuple_from_result_row(res, 0,
 											fmstate->rel,
 											fmstate->attinmeta,
+											NULL,
 											fmstate->retrieved_attrs,
 											NULL,
 											fmstate->temp_cxt);
@@ -4538,9 +4937,11 @@ execute_dml_stmt(ForeignScanState *node)
 	int			numParams = dmstate->numParams;
 	const char **values = dmstate->param_values;
 
-	/* First, process a pending asynchronous request, if any. */
+	/* First, process a pending asynchronous request or prefetch, if any. */
 	if (dmstate->conn_state->pendingAreq)
 		process_pending_request(dmstate->conn_state->pendingAreq);
+	if (dmstate->conn_state->pendingPrefetch)
+		process_pending_prefetch(dmstate->conn_state->pendingPrefetch);
 
 	/*
 	 * Construct array of query parameter values in text format.
@@ -4627,6 +5028,7 @@ get_returning_data(ForeignScanState *node)
 												dmstate->next_tuple,
 												dmstate->rel,
 												dmstate->attinmeta,
+												NULL,
 												dmstate->retrieved_attrs,
 												node,
 												dmstate->temp_cxt);
@@ -5417,6 +5819,7 @@ analyze_row_processor(PGresult *res, int row, PgFdwAnalyzeState *astate)
 		astate->rows[pos] = make_tuple_from_result_row(res, row,
 													   astate->rel,
 													   astate->attinmeta,
+													   NULL,
 													   astate->retrieved_attrs,
 													   NULL,
 													   astate->temp_cxt);
@@ -6129,6 +6532,10 @@ apply_server_options(PgFdwRelationInfo *fpinfo)
 			(void) parse_int(defGetString(def), &fpinfo->fetch_size, 0, NULL);
 		else if (strcmp(def->defname, "async_capable") == 0)
 			fpinfo->async_capable = defGetBoolean(def);
+		else if (strcmp(def->defname, "prefetch") == 0)
+			fpinfo->prefetch = defGetBoolean(def);
+		else if (strcmp(def->defname, "binary_fetch") == 0)
+			fpinfo->binary_fetch = defGetBoolean(def);
 	}
 }
 
@@ -6152,6 +6559,10 @@ apply_table_options(PgFdwRelationInfo *fpinfo)
 			(void) parse_int(defGetString(def), &fpinfo->fetch_size, 0, NULL);
 		else if (strcmp(def->defname, "async_capable") == 0)
 			fpinfo->async_capable = defGetBoolean(def);
+		else if (strcmp(def->defname, "prefetch") == 0)
+			fpinfo->prefetch = defGetBoolean(def);
+		else if (strcmp(def->defname, "binary_fetch") == 0)
+			fpinfo->binary_fetch = defGetBoolean(def);
 	}
 }
 
@@ -6187,6 +6598,8 @@ merge_fdw_options(PgFdwRelationInfo *fpinfo,
 	fpinfo->use_remote_estimate = fpinfo_o->use_remote_estimate;
 	fpinfo->fetch_size = fpinfo_o->fetch_size;
 	fpinfo->async_capable = fpinfo_o->async_capable;
+	fpinfo->prefetch = fpinfo_o->prefetch;
+	fpinfo->binary_fetch = fpinfo_o->binary_fetch;
 
 	/* Merge the table level options from either side of the join. */
 	if (fpinfo_i)
@@ -6218,6 +6631,11 @@ merge_fdw_options(PgFdwRelationInfo *fpinfo,
 		 */
 		fpinfo->async_capable = fpinfo_o->async_capable ||
 			fpinfo_i->async_capable;
+
+		/* Likewise for prefetching and binary fetches. */
+		fpinfo->prefetch = fpinfo_o->prefetch || fpinfo_i->prefetch;
+		fpinfo->binary_fetch = fpinfo_o->binary_fetch ||
+			fpinfo_i->binary_fetch;
 	}
 }
 
@@ -7333,6 +7751,10 @@ fetch_more_data_begin(AsyncRequest *areq)
 	if (!fsstate->cursor_exists)
 		create_cursor(node);
 
+	/* Collect the result of another scan's prefetch, if any. */
+	if (fsstate->conn_state->pendingPrefetch)
+		process_pending_prefetch(fsstate->conn_state->pendingPrefetch);
+
 	/* We will send this query, but not wait for the response. */
 	snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
 			 fsstate->fetch_size, fsstate->cursor_number);
@@ -7419,6 +7841,7 @@ make_tuple_from_result_row(PGresult *res,
 						   int row,
 						   Relation rel,
 						   AttInMetadata *attinmeta,
+						   AttRecvMetadata *attrecvmeta,
 						   List *retrieved_attrs,
 						   ForeignScanState *fsstate,
 						   MemoryContext temp_context)
@@ -7478,14 +7901,25 @@ make_tuple_from_result_row(PGresult *res,
 	foreach(lc, retrieved_attrs)
 	{
 		int			i = lfirst_int(lc);
+		bool		binary = (PQfformat(res, j) == 1);
 		char	   *valstr;
+		StringInfoData valbuf;
 
-		/* fetch next column's textual value */
+		/* fetch next column's textual or binary value */
 		if (PQgetisnull(res, row, j))
 			valstr = NULL;
 		else
 			valstr = PQgetvalue(res, row, j);
 
+		if (binary && valstr != NULL)
+		{
+			/* libpq null-terminates binary values too, as StringInfo does */
+			valbuf.data = valstr;
+			valbuf.len = PQgetlength(res, row, j);
+			valbuf.maxlen = valbuf.len + 1;
+			valbuf.cursor = 0;
+		}
+
 		/*
 		 * convert value to internal representation
 		 *
@@ -7498,10 +7932,21 @@ make_tuple_from_result_row(PGresult *res,
 			Assert(i <= tupdesc->natts);
 			nulls[i - 1] = (valstr == NULL);
 			/* Apply the input function even to nulls, to support domains */
-			values[i - 1] = InputFunctionCall(&attinmeta->attinfuncs[i - 1],
-											  valstr,
-											  attinmeta->attioparams[i - 1],
-											  attinmeta->atttypmods[i - 1]);
+			if (binary)
+			{
+				Assert(attrecvmeta);
+				values[i - 1] =
+					ReceiveFunctionCall(&attrecvmeta->attrecvfuncs[i - 1],
+										valstr ? &valbuf : NULL,
+										attrecvmeta->attioparams[i - 1],
+										attinmeta->atttypmods[i - 1]);
+			}
+			else
+				values[i - 1] =
+					InputFunctionCall(&attinmeta->attinfuncs[i - 1],
+									  valstr,
+									  attinmeta->attioparams[i - 1],
+									  attinmeta->atttypmods[i - 1]);
 		}
 		else if (i == SelfItemPointerAttributeNumber)
 		{
@@ -7510,7 +7955,11 @@ make_tuple_from_result_row(PGresult *res,
 			{
 				Datum		datum;
 
-				datum = DirectFunctionCall1(tidin, CStringGetDatum(valstr));
+				if (binary)
+					datum = DirectFunctionCall1(tidrecv,
+												PointerGetDatum(&valbuf));
+				else
+					datum = DirectFunctionCall1(tidin, CStringGetDatum(valstr));
 				ctid = (ItemPointer) DatumGetPointer(datum);
 			}
 		}
@@ -80,6 +80,8 @@ typedef struct PgFdwRelationInfo
 	Cost		fdw_tuple_cost;
 	List	   *shippable_extensions;	/* OIDs of shippable extensions */
 	bool		async_capable;
+	bool		prefetch;
+	bool		binary_fetch;
 
 	/* Cached catalog information. */
 	ForeignTable *table;
@@ -132,6 +134,7 @@ typedef struct PgFdwRelationInfo
 typedef struct PgFdwConnState
 {
 	AsyncRequest *pendingAreq;	/* pending async request */
+	ForeignScanState *pendingPrefetch;	/* scan with a prefetch in flight */
 } PgFdwConnState;
 
 /*
@@ -150,6 +153,7 @@ typedef enum PgFdwSamplingMethod
 extern int	set_transmission_modes(void);
 extern void reset_transmission_modes(int nestlevel);
 extern void process_pending_request(AsyncRequest *areq);
+extern void process_pending_prefetch(ForeignScanState *node);
 
 /* in connection.c */
 extern PGconn *GetConnection(UserMapping *user, bool will_prep_stmt,
@@ -3861,6 +3861,86 @@ DROP TABLE base_tbl;
 ALTER SERVER loopback OPTIONS (DROP async_capable);
 ALTER SERVER loopback2 OPTIONS (DROP async_capable);
 
+-- ===================================================================
+-- test prefetching of batches
+-- ===================================================================
+ALTER SERVER loopback OPTIONS (ADD prefetch 'true');
+CREATE TABLE base_tbl (a int, b text);
+INSERT INTO base_tbl SELECT i, 'val' || i FROM generate_series(1, 1000) i;
+CREATE FOREIGN TABLE foreign_tbl (a int, b text)
+  SERVER loopback OPTIONS (table_name 'base_tbl', fetch_size '10');
+-- random() is not shippable, so all rows are fetched
+SELECT count(*) FROM foreign_tbl WHERE random() >= 0;
+-- Use the connection while a prefetch is in flight
+BEGIN;
+DECLARE c CURSOR FOR SELECT a FROM foreign_tbl WHERE random() >= 0 ORDER BY a;
+FETCH 5 FROM c;
+SELECT count(*) FROM foreign_tbl WHERE random() >= 0;
+FETCH 5 FROM c;
+UPDATE foreign_tbl SET b = 'updated' WHERE a = 1000;
+FETCH 10 FROM c;
+SAVEPOINT s;
+FETCH 5 FROM c;
+RELEASE SAVEPOINT s;
+FETCH 5 FROM c;
+COMMIT;
+SELECT b FROM foreign_tbl WHERE a = 1000;
+-- Rescans
+SET enable_hashjoin TO off;
+SET enable_mergejoin TO off;
+SET enable_material TO off;
+SELECT count(*) FROM (VALUES (1), (2), (3)) v(x), foreign_tbl t
+  WHERE random() >= 0;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+RESET enable_material;
+
+-- Clean up
+DROP FOREIGN TABLE foreign_tbl;
+DROP TABLE base_tbl;
+ALTER SERVER loopback OPTIONS (DROP prefetch);
+
+-- ===================================================================
+-- test fetching in binary format
+-- ===================================================================
+ALTER SERVER loopback OPTIONS (ADD binary_fetch 'true');
+CREATE TABLE base_tbl (a int, b numeric, c timestamp, d text, e int[], f bigint);
+INSERT INTO base_tbl VALUES (1, 1.5, '2023-07-01 12:00', 'one', '{1,2}', 10),
+  (2, NULL, NULL, NULL, NULL, 20);
+CREATE FOREIGN TABLE foreign_tbl (a int, b numeric, c timestamp, d text,
+  e int[], f bigint) SERVER loopback OPTIONS (table_name 'base_tbl');
+SELECT * FROM foreign_tbl ORDER BY a;
+-- A column type that differs from the remote one makes us fall back to text
+CREATE FOREIGN TABLE foreign_tbl2 (a int, f int)
+  SERVER loopback OPTIONS (table_name 'base_tbl');
+SELECT a, f FROM foreign_tbl2 ORDER BY a;
+-- Domains over built-in types are received with the domain's receive function
+CREATE DOMAIN binary_fetch_dom AS int CHECK (VALUE > 0);
+CREATE FOREIGN TABLE foreign_tbl3 (a binary_fetch_dom, d text)
+  SERVER loopback OPTIONS (table_name 'base_tbl');
+SELECT a, d FROM foreign_tbl3 ORDER BY a;
+
+-- EXPLAIN ANALYZE VERBOSE shows the format actually used.  Text format is
+-- used when the remote column types don't match ours, as for foreign_tbl2,
+-- and when client_encoding differs from the database encoding, since the
+-- receive functions of textual types would then mis-convert the data.
+EXPLAIN (ANALYZE, VERBOSE, COSTS OFF, SUMMARY OFF, TIMING OFF)
+SELECT a, d FROM foreign_tbl3;
+EXPLAIN (ANALYZE, VERBOSE, COSTS OFF, SUMMARY OFF, TIMING OFF)
+SELECT a, f FROM foreign_tbl2;
+SELECT CASE WHEN getdatabaseencoding() = 'SQL_ASCII' THEN 'UTF8'
+  ELSE 'SQL_ASCII' END AS other_encoding \gset
+SET client_encoding = :'other_encoding';
+EXPLAIN (ANALYZE, VERBOSE, COSTS OFF, SUMMARY OFF, TIMING OFF)
+SELECT a, d FROM foreign_tbl3;
+RESET client_encoding;
+
+-- Clean up
+DROP FOREIGN TABLE foreign_tbl, foreign_tbl2, foreign_tbl3;
+DROP DOMAIN binary_fetch_dom;
+DROP TABLE base_tbl;
+ALTER SERVER loopback OPTIONS (DROP binary_fetch);
+
 -- ===================================================================
 -- test invalid server, foreign table and foreign data wrapper options
 -- ===================================================================
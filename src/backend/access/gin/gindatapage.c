@@ -130,12 +130,22 @@ static void dataPlaceToPageLeafSplit(disassembledLeaf *leaf,
  * are in the same posting list as the items of interest, so the caller must
  * still check all the returned items. But passing it allows this function to
  * skip whole posting lists.
+ *
+ * If 'more' is not NULL, only the posting list segment containing the first
+ * item > advancePast is decoded, rather than all the rest of the page, and
+ * *more is set to true if there are more segments after it.  That's useful
+ * when the caller is skipping ahead, and will likely need only a few items
+ * before it skips again.
  */
 ItemPointer
-GinDataLeafPageGetItems(Page page, int *nitems, ItemPointerData advancePast)
+GinDataLeafPageGetItems(Page page, int *nitems, ItemPointerData advancePast,
+						bool *more)
 {
 	ItemPointer result;
 
+	if (more)
+		*more = false;
+
 	if (GinPageIsCompressed(page))
 	{
 		GinPostingList *seg = GinDataLeafPageGetPostingList(page);
@@ -156,7 +166,26 @@ GinDataLeafPageGetItems(Page page, int *nitems, ItemPointerData advancePast)
 			len = endptr - (Pointer) seg;
 		}
 
-		if (len > 0)
+		if (len > 0 && more)
+		{
+			/*
+			 * Decode just this segment.  If all of its items are <=
+			 * advancePast, the first item of the next segment is the one
+			 * we're looking for, so decode that segment instead.
+			 */
+			next = GinNextPostingListSegment(seg);
+			result = ginPostingListDecode(seg, nitems);
+			if ((Pointer) next < endptr &&
+				ginCompareItemPointers(&result[*nitems - 1], &advancePast) <= 0)
+			{
+				pfree(result);
+				seg = next;
+				next = GinNextPostingListSegment(seg);
+				result = ginPostingListDecode(seg, nitems);
+			}
+			*more = ((Pointer) next < endptr);
+		}
+		else if (len > 0)
 			result = ginPostingListDecodeAllSegments(seg, len, nitems);
 		else
 		{
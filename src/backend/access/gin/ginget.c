@@ -26,6 +26,14 @@
 /* GUC parameter */
 int			GinFuzzySearchLimit = 0;
 
+/*
+ * An additional entry is skipped if it appears in at least this fraction of
+ * the indexed rows, and is at least this many times larger than the required
+ * entries together.  See skipFrequentEntry().
+ */
+#define GIN_SKIP_ENTRY_MIN_FRACTION	0.5
+#define GIN_SKIP_ENTRY_MIN_RATIO	10
+
 typedef struct pendingPosition
 {
 	Buffer		pendingBuffer;
@@ -333,6 +341,7 @@ restartScanEntry:
 		pfree(entry->list);
 	entry->list = NULL;
 	entry->nlist = 0;
+	entry->moreOnPage = false;
 	entry->matchBitmap = NULL;
 	entry->matchResult = NULL;
 	entry->reduceResult = false;
@@ -436,7 +445,8 @@ restartScanEntry:
 			 * Load the first page into memory.
 			 */
 			ItemPointerSetMin(&minItem);
-			entry->list = GinDataLeafPageGetItems(entrypage, &entry->nlist, minItem);
+			entry->list = GinDataLeafPageGetItems(entrypage, &entry->nlist,
+												  minItem, NULL);
 
 			entry->predictNumberResult = stack->predictNumber * entry->nlist;
 
@@ -503,6 +513,54 @@ entryIndexByFrequencyCmp(const void *a1, const void *a2, void *arg)
 		return 1;
 }
 
+/*
+ * Decide whether an additional entry of a scan key is so frequent that it's
+ * cheaper not to read it at all.
+ *
+ * Once the required entries have been chosen, the additional entries only
+ * serve to filter out some of the items found through the required ones.
+ * An entry that is present in most of the indexed rows can't filter out
+ * many of them, but its posting tree is among the largest in the index, and
+ * reading through it can cost more than the rest of the scan together.  A
+ * typical example is a LIKE search with pg_trgm, where the pattern contains
+ * both rare trigrams and trigrams of some very common word.  If such an
+ * entry is also much larger than the set of candidates produced by the
+ * required entries, we skip it, and pass it to the consistent function as
+ * MAYBE instead.  The recheck then filters out the few rows it would have
+ * excluded.
+ *
+ * The entry frequencies are the sizes of the posting trees, as estimated by
+ * startScanEntry(), relative to the number of rows in the index.
+ */
+static bool
+skipFrequentEntry(GinState *ginstate, GinScanKey key, int i,
+				  double nrequiredItems)
+{
+	GinScanEntry entry = key->scanEntry[i];
+	double		reltuples;
+
+	/*
+	 * Hidden entries have no say in the result, and don't get here anyway.
+	 * Without a native tri-state consistent function, each MAYBE input would
+	 * double the cost of the shim implementation in ginlogic.c.
+	 */
+	if (i >= key->nuserentries ||
+		!OidIsValid(ginstate->triConsistentFn[key->attnum - 1].fn_oid))
+		return false;
+
+	/* Only skip posting trees; posting lists are cheap to read anyway */
+	if (entry->isFinished || entry->matchBitmap != NULL ||
+		!BufferIsValid(entry->buffer))
+		return false;
+
+	reltuples = RelationGetForm(ginstate->index)->reltuples;
+	if (reltuples <= 0)
+		return false;			/* never vacuumed or analyzed, don't guess */
+
+	return entry->predictNumberResult >= reltuples * GIN_SKIP_ENTRY_MIN_FRACTION &&
+		entry->predictNumberResult >= nrequiredItems * GIN_SKIP_ENTRY_MIN_RATIO;
+}
+
 static void
 startScanKey(GinState *ginstate, GinScanOpaque so, GinScanKey key)
 {
@@ -510,11 +568,13 @@ startScanKey(GinState *ginstate, GinScanOpaque so, GinScanKey key)
 	int			i;
 	int			j;
 	int		   *entryIndexes;
+	double		nrequiredItems;
 
 	ItemPointerSetMin(&key->curItem);
 	key->curItemMatches = false;
 	key->recheckCurItem = false;
 	key->isFinished = false;
+	key->skipEntry = NULL;
 
 	/*
 	 * Divide the entries into two distinct sets: required and additional.
@@ -534,7 +594,9 @@ startScanKey(GinState *ginstate, GinScanOpaque so, GinScanKey key)
 	 * (predictNumberResult), and put entries into the required set in that
 	 * order, until the consistent function says that none of the remaining
 	 * entries can form a match, without any items from the required set. The
-	 * rest go to the additional set.
+	 * rest go to the additional set, except for any additional entries so
+	 * frequent that it's better to not read them at all; see
+	 * skipFrequentEntry().
 	 *
 	 * Exclude-only scan keys are known to have no required entries.
 	 */
@@ -579,10 +641,26 @@ startScanKey(GinState *ginstate, GinScanOpaque so, GinScanKey key)
 		key->additionalEntries = palloc(key->nadditional * sizeof(GinScanEntry));
 
 		j = 0;
+		nrequiredItems = 0;
 		for (i = 0; i < key->nrequired; i++)
+		{
 			key->requiredEntries[i] = key->scanEntry[entryIndexes[j++]];
-		for (i = 0; i < key->nadditional; i++)
-			key->additionalEntries[i] = key->scanEntry[entryIndexes[j++]];
+			nrequiredItems += key->requiredEntries[i]->predictNumberResult;
+		}
+		key->nadditional = 0;
+		for (; j < key->nentries; j++)
+		{
+			if (skipFrequentEntry(ginstate, key, entryIndexes[j],
+								  nrequiredItems))
+			{
+				if (key->skipEntry == NULL)
+					key->skipEntry = palloc0(key->nentries * sizeof(bool));
+				key->skipEntry[entryIndexes[j]] = true;
+			}
+			else
+				key->additionalEntries[key->nadditional++] =
+					key->scanEntry[entryIndexes[j]];
+		}
 
 		/* clean up after consistentFn calls (also frees entryIndexes) */
 		MemoryContextReset(so->tempCtx);
@@ -645,6 +723,55 @@ startScan(IndexScanDesc scan)
 		startScanKey(ginstate, so, so->keys + i);
 }
 
+/*
+ * Skip over the items <= advancePast in entry->list, starting at
+ * entry->offset.  entry->offset is set to the first item > advancePast, or
+ * to nlist if there is none, and entry->curItem to the last item skipped.
+ *
+ * When the next item is already > advancePast, this costs one comparison.
+ * Otherwise we gallop: probe items at exponentially growing distances until
+ * we overshoot, and then binary search between the last two probes.  That
+ * makes skipping far ahead in a long list, as when intersecting it with a
+ * much shorter one, cost O(log n) rather than O(n) comparisons.
+ */
+static void
+entrySkipListItems(GinScanEntry entry, ItemPointerData advancePast)
+{
+	int			lo = entry->offset;
+	int			hi;
+	int			step = 1;
+
+	if (lo >= entry->nlist ||
+		ginCompareItemPointers(&entry->list[lo], &advancePast) > 0)
+		return;
+
+	/* Gallop, until list[hi] > advancePast, or we run off the end */
+	hi = lo + 1;
+	while (hi < entry->nlist &&
+		   ginCompareItemPointers(&entry->list[hi], &advancePast) <= 0)
+	{
+		lo = hi;
+		step *= 2;
+		hi = lo + step;
+	}
+	if (hi > entry->nlist)
+		hi = entry->nlist;
+
+	/* Now list[lo] <= advancePast, and list[hi] > advancePast, if it exists */
+	while (hi - lo > 1)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (ginCompareItemPointers(&entry->list[mid], &advancePast) <= 0)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	entry->curItem = entry->list[lo];
+	entry->offset = hi;
+}
+
 /*
  * Load the next batch of item pointers from a posting tree.
  *
@@ -658,6 +785,7 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 	Page		page;
 	int			i;
 	bool		stepright;
+	bool		skipping;
 
 	if (!BufferIsValid(entry->buffer))
 	{
@@ -666,14 +794,38 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 	}
 
 	/*
-	 * We have two strategies for finding the correct page: step right from
-	 * the current page, or descend the tree again from the root. If
-	 * advancePast equals the current item, the next matching item should be
-	 * on the next page, so we step right. Otherwise, descend from root.
+	 * If we're skipping ahead, rather than stepping to the item right after
+	 * the current one, we're likely to skip again soon, so decode only the
+	 * posting list segment we need rather than the rest of the page.
 	 */
-	if (ginCompareItemPointers(&entry->curItem, &advancePast) == 0)
+	skipping = (ginCompareItemPointers(&entry->curItem, &advancePast) != 0);
+
+	/*
+	 * We have three strategies for finding the correct page: stay on the
+	 * current page, step right from it, or descend the tree again from the
+	 * root. If we decoded only part of the current page, and advancePast is
+	 * still within it, we stay on it. Otherwise, if advancePast equals the
+	 * current item, the next matching item should be on the next page, so we
+	 * step right. Otherwise, descend from root.
+	 */
+	stepright = true;
+	if (entry->moreOnPage)
+	{
+		LockBuffer(entry->buffer, GIN_SHARE);
+		page = BufferGetPage(entry->buffer);
+		if (GinPageRightMost(page) ||
+			ginCompareItemPointers(&advancePast, GinDataPageGetRightBound(page)) < 0)
+			stepright = false;
+		else
+			LockBuffer(entry->buffer, GIN_UNLOCK);
+	}
+
+	if (!stepright)
+	{
+		/* stay on the current page, already locked */
+	}
+	else if (!skipping)
 	{
-		stepright = true;
 		LockBuffer(entry->buffer, GIN_SHARE);
 	}
 	else
@@ -710,7 +862,7 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 	elog(DEBUG2, "entryLoadMoreItems, %u/%u, skip: %d",
 		 GinItemPointerGetBlockNumber(&advancePast),
 		 GinItemPointerGetOffsetNumber(&advancePast),
-		 !stepright);
+		 skipping);
 
 	page = BufferGetPage(entry->buffer);
 	for (;;)
@@ -768,7 +920,16 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 			continue;
 		}
 
-		entry->list = GinDataLeafPageGetItems(page, &entry->nlist, advancePast);
+		if (skipping)
+			entry->list = GinDataLeafPageGetItems(page, &entry->nlist,
+												  advancePast,
+												  &entry->moreOnPage);
+		else
+		{
+			entry->list = GinDataLeafPageGetItems(page, &entry->nlist,
+												  advancePast, NULL);
+			entry->moreOnPage = false;
+		}
 
 		for (i = 0; i < entry->nlist; i++)
 		{
@@ -776,7 +937,7 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 			{
 				entry->offset = i;
 
-				if (GinPageRightMost(page))
+				if (GinPageRightMost(page) && !entry->moreOnPage)
 				{
 					/* after processing the copied items, we're done. */
 					UnlockReleaseBuffer(entry->buffer);
@@ -787,6 +948,9 @@ entryLoadMoreItems(GinState *ginstate, GinScanEntry entry,
 				return;
 			}
 		}
+
+		/* a partial list always contains an item > advancePast */
+		Assert(!entry->moreOnPage);
 	}
 }
 
@@ -913,6 +1077,8 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		 */
 		for (;;)
 		{
+			entrySkipListItems(entry, advancePast);
+
 			if (entry->offset >= entry->nlist)
 			{
 				ItemPointerSetInvalid(&entry->curItem);
@@ -921,10 +1087,7 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 			}
 
 			entry->curItem = entry->list[entry->offset++];
-
-			/* If we're not past advancePast, keep scanning */
-			if (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0)
-				continue;
+			Assert(ginCompareItemPointers(&entry->curItem, &advancePast) > 0);
 
 			/* Done unless we need to reduce the result */
 			if (!entry->reduceResult || !dropItem(entry))
@@ -936,6 +1099,8 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 		/* A posting tree */
 		for (;;)
 		{
+			entrySkipListItems(entry, advancePast);
+
 			/* If we've processed the current batch, load more items */
 			while (entry->offset >= entry->nlist)
 			{
@@ -949,10 +1114,7 @@ entryGetItem(GinState *ginstate, GinScanEntry entry,
 			}
 
 			entry->curItem = entry->list[entry->offset++];
-
-			/* If we're not past advancePast, keep scanning */
-			if (ginCompareItemPointers(&entry->curItem, &advancePast) <= 0)
-				continue;
+			Assert(ginCompareItemPointers(&entry->curItem, &advancePast) > 0);
 
 			/* Done unless we need to reduce the result */
 			if (!entry->reduceResult || !dropItem(entry))
@@ -1153,7 +1315,8 @@ keyGetItem(GinState *ginstate, MemoryContext tempCtx, GinScanKey key,
 	 * them. We could pass them as MAYBE as well, but if we're using the
 	 * "shim" implementation of a tri-state consistent function (see
 	 * ginlogic.c), it's better to pass as few MAYBEs as possible. So pass
-	 * them as true.
+	 * them as true.  Skipped entries are always passed as MAYBE, as we don't
+	 * know whether they point to the current item or page.
 	 *
 	 * Note that only lossy-page entries pointing to the current item's page
 	 * should trigger this processing; we might have future lossy pages in the
@@ -1166,8 +1329,10 @@ keyGetItem(GinState *ginstate, MemoryContext tempCtx, GinScanKey key,
 	for (i = 0; i < key->nentries; i++)
 	{
 		entry = key->scanEntry[i];
-		if (entry->isFinished == false &&
-			ginCompareItemPointers(&entry->curItem, &curPageLossy) == 0)
+		if (key->skipEntry && key->skipEntry[i])
+			key->entryRes[i] = GIN_MAYBE;
+		else if (entry->isFinished == false &&
+				 ginCompareItemPointers(&entry->curItem, &curPageLossy) == 0)
 		{
 			if (i < key->nuserentries)
 				key->entryRes[i] = GIN_MAYBE;
@@ -1214,7 +1379,9 @@ keyGetItem(GinState *ginstate, MemoryContext tempCtx, GinScanKey key,
 	for (i = 0; i < key->nentries; i++)
 	{
 		entry = key->scanEntry[i];
-		if (entry->isFinished)
+		if (key->skipEntry && key->skipEntry[i])
+			key->entryRes[i] = GIN_MAYBE;
+		else if (entry->isFinished)
 			key->entryRes[i] = GIN_FALSE;
 #if 0
 
@@ -16,16 +16,133 @@
 
 #include "access/gin_private.h"
 #include "access/ginxlog.h"
+#include "access/parallel.h"
+#include "access/table.h"
 #include "access/tableam.h"
+#include "access/xact.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/condition_variable.h"
 #include "storage/indexfsm.h"
 #include "storage/predicate.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
+#include "utils/tuplesort.h"
+
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_GIN_SHARED			UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xB000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xB000000000000003)
+#define PARALLEL_KEY_WAL_USAGE			UINT64CONST(0xB000000000000004)
+#define PARALLEL_KEY_BUFFER_USAGE		UINT64CONST(0xB000000000000005)
+
+/*
+ * Status for index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment.  Note that there is a separate tuplesort TOC
+ * entry, private to tuplesort.c but allocated by this module on its behalf.
+ */
+typedef struct GinBuildShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scantuplesortstates;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can use
+	 * results built by the workers (and before leader can proceed to
+	 * tuplesort_performsort()).
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before heapdesc.
+	 *
+	 * These fields contain status information of interest to GIN index
+	 * builds that must work just the same when an index is built in parallel.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of the scans.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * indtuples is the total number of entries extracted for the index.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * ParallelTableScanDescData data follows. Can't directly embed here, as
+	 * implementations of the parallel table scan desc interface might need
+	 * stronger alignment.
+	 */
+} GinBuildShared;
+
+/*
+ * Return pointer to a GinBuildShared's parallel table scan.
+ *
+ * c.f. shm_toc_allocate as to why BUFFERALIGN is used, rather than just
+ * MAXALIGN.
+ */
+#define ParallelTableScanFromGinBuildShared(shared) \
+	(ParallelTableScanDesc) ((char *) (shared) + BUFFERALIGN(sizeof(GinBuildShared)))
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct GinLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipanttuplesorts is the exact number of worker processes
+	 * successfully launched, plus one leader process if it participates as a
+	 * worker (only DISABLE_LEADER_PARTICIPATION builds avoid leader
+	 * participating as a worker).
+	 */
+	int			nparticipanttuplesorts;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 *
+	 * ginshared is the shared state for entire build.  sharedsort is the
+	 * shared, tuplesort-managed state passed to each process tuplesort.
+	 * snapshot is the snapshot used by the scan iff an MVCC snapshot is
+	 * required.
+	 */
+	GinBuildShared *ginshared;
+	Sharedsort *sharedsort;
+	Snapshot	snapshot;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+} GinLeader;
 
 typedef struct
 {
@@ -35,8 +152,55 @@ typedef struct
 	MemoryContext tmpCtx;
 	MemoryContext funcCtx;
 	BuildAccumulator accum;
+
+	/*
+	 * Parallel build state.  ginleader is set in the leader if workers were
+	 * launched.  In each participant's scan, sortstate is the tuplesort that
+	 * the accumulated entries are dumped into once the accumulator grows
+	 * beyond accumMaxMemory bytes.
+	 */
+	GinLeader  *ginleader;
+	Tuplesortstate *sortstate;
+	Size		accumMaxMemory;
 } GinBuildState;
 
+/*
+ * Entries collected for one key while merging the sorted output of a parallel
+ * build.  items[] is kept sorted and free of duplicates.
+ */
+typedef struct GinBuffer
+{
+	OffsetNumber attnum;
+	GinNullCategory category;
+	Datum		key;			/* copy of key, in keyCtx */
+	int			nitems;
+	int			maxitems;
+	ItemPointerData *items;
+	MemoryContext keyCtx;
+} GinBuffer;
+
+/*
+ * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
+ * parallel index builds.  This may be useful as a debugging aid.
+#undef DISABLE_LEADER_PARTICIPATION
+ */
+
+static void _gin_begin_parallel(GinBuildState *buildstate, Relation heap,
+								Relation index, bool isconcurrent,
+								int request);
+static void _gin_end_parallel(GinLeader *ginleader);
+static Size _gin_parallel_estimate_shared(Relation heap, Snapshot snapshot);
+static double _gin_parallel_heapscan(GinBuildState *buildstate,
+									 bool *brokenhotchain);
+static void _gin_parallel_merge(GinBuildState *buildstate, Relation heap,
+								Relation index);
+static void _gin_leader_participate_as_worker(GinBuildState *buildstate,
+											  Relation heap, Relation index);
+static void _gin_parallel_scan_and_sort(GinBuildShared *ginshared,
+										Sharedsort *sharedsort,
+										Relation heap, Relation index,
+										int sortmem, bool progress);
+
 
 /*
  * Adds array of item pointers to tuple's posting list, or
@@ -316,6 +480,183 @@ ginBuildCallback(Relation index, ItemPointer tid, Datum *values,
 	MemoryContextSwitchTo(oldCtx);
 }
 
+/*
+ * Build a GinTuple holding the given key and TIDs.  items[] must be in sorted
+ * order with no duplicates.  The result is palloc'd in the current memory
+ * context.
+ */
+static GinTuple *
+ginFormGinTuple(GinState *ginstate, OffsetNumber attnum, Datum key,
+				GinNullCategory category, ItemPointerData *items,
+				uint32 nitems)
+{
+	Form_pg_attribute attr = TupleDescAttr(ginstate->origTupdesc, attnum - 1);
+	GinTuple   *tuple;
+	int			keylen;
+	Size		tuplen;
+
+	/* Compute the space needed for the key */
+	if (category != GIN_CAT_NORM_KEY)
+		keylen = 0;
+	else if (attr->attbyval)
+		keylen = sizeof(Datum);
+	else
+	{
+		/* Make sure we don't store a toast pointer in the sort */
+		if (attr->attlen == -1)
+			key = PointerGetDatum(PG_DETOAST_DATUM(key));
+		keylen = datumGetSize(key, false, attr->attlen);
+	}
+
+	tuplen = MAXALIGN(sizeof(GinTuple)) + MAXALIGN(keylen) +
+		nitems * sizeof(ItemPointerData);
+	if (tuplen > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("too many entries for one key in GIN index \"%s\"",
+						RelationGetRelationName(ginstate->index))));
+
+	tuple = palloc0(tuplen);
+	tuple->tuplen = tuplen;
+	tuple->attrnum = attnum;
+	tuple->typlen = attr->attlen;
+	tuple->typbyval = attr->attbyval;
+	tuple->category = category;
+	tuple->keylen = keylen;
+	tuple->nitems = nitems;
+
+	if (keylen > 0)
+	{
+		if (attr->attbyval)
+			memcpy(GinTupleGetKeyData(tuple), &key, sizeof(Datum));
+		else
+			memcpy(GinTupleGetKeyData(tuple), DatumGetPointer(key), keylen);
+	}
+
+	memcpy(GinTupleGetItems(tuple), items, nitems * sizeof(ItemPointerData));
+
+	return tuple;
+}
+
+/*
+ * Comparison function for sorting GinTuples in a parallel build: by
+ * attribute number, by key in the opclass's order, and then by the first
+ * heap TID, so that the TID lists of a key come out in roughly sorted order.
+ */
+int
+ginCompareGinTuples(GinTuple *a, GinTuple *b, GinState *ginstate)
+{
+	int			res;
+
+	if (a->attrnum != b->attrnum)
+		return (a->attrnum < b->attrnum) ? -1 : 1;
+
+	res = ginCompareEntries(ginstate, a->attrnum,
+							GinTupleGetKey(a), a->category,
+							GinTupleGetKey(b), b->category);
+	if (res != 0)
+		return res;
+
+	return ItemPointerCompare(GinTupleGetItems(a), GinTupleGetItems(b));
+}
+
+/*
+ * Dump all entries collected in the accumulator into the participant's
+ * tuplesort, and reset the accumulator.
+ */
+static void
+ginDumpAccumToSort(GinBuildState *buildstate)
+{
+	ItemPointerData *list;
+	Datum		key;
+	GinNullCategory category;
+	uint32		nlist;
+	OffsetNumber attnum;
+	MemoryContext oldCtx;
+
+	oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+	ginBeginBAScan(&buildstate->accum);
+	while ((list = ginGetBAEntry(&buildstate->accum,
+								 &attnum, &key, &category, &nlist)) != NULL)
+	{
+		GinTuple   *tuple;
+
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+
+		tuple = ginFormGinTuple(&buildstate->ginstate, attnum, key, category,
+								list, nlist);
+		tuplesort_putgintuple(buildstate->sortstate, tuple);
+		pfree(tuple);
+	}
+
+	MemoryContextSwitchTo(oldCtx);
+
+	MemoryContextReset(buildstate->tmpCtx);
+	ginInitBA(&buildstate->accum);
+}
+
+/*
+ * Per-tuple callback for table_index_build_scan in a parallel build.  This is
+ * like ginBuildCallback, except that the accumulated entries are dumped into
+ * the participant's tuplesort rather than inserted into the index.
+ */
+static void
+ginBuildCallbackParallel(Relation index, ItemPointer tid, Datum *values,
+						 bool *isnull, bool tupleIsAlive, void *state)
+{
+	GinBuildState *buildstate = (GinBuildState *) state;
+	MemoryContext oldCtx;
+	int			i;
+
+	oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+	for (i = 0; i < buildstate->ginstate.origTupdesc->natts; i++)
+		ginHeapTupleBulkInsert(buildstate, (OffsetNumber) (i + 1),
+							   values[i], isnull[i], tid);
+
+	MemoryContextSwitchTo(oldCtx);
+
+	/* If we've maxed out our available memory, dump everything to the sort */
+	if (buildstate->accum.allocatedMemory >= buildstate->accumMaxMemory)
+		ginDumpAccumToSort(buildstate);
+}
+
+/*
+ * Set up the parts of a GinBuildState used for scanning the heap and
+ * accumulating entries.
+ */
+static void
+ginInitBuildState(GinBuildState *buildstate, Relation index)
+{
+	initGinState(&buildstate->ginstate, index);
+	buildstate->indtuples = 0;
+	memset(&buildstate->buildStats, 0, sizeof(GinStatsData));
+	buildstate->ginleader = NULL;
+	buildstate->sortstate = NULL;
+	buildstate->accumMaxMemory = (Size) maintenance_work_mem * 1024L;
+
+	/*
+	 * create a temporary memory context that is used to hold data not yet
+	 * dumped out to the index
+	 */
+	buildstate->tmpCtx = AllocSetContextCreate(CurrentMemoryContext,
+											   "Gin build temporary context",
+											   ALLOCSET_DEFAULT_SIZES);
+
+	/*
+	 * create a temporary memory context that is used for calling
+	 * ginExtractEntries(), and can be reset after each tuple
+	 */
+	buildstate->funcCtx = AllocSetContextCreate(CurrentMemoryContext,
+												"Gin build temporary context for user-defined function",
+												ALLOCSET_DEFAULT_SIZES);
+
+	buildstate->accum.ginstate = &buildstate->ginstate;
+	ginInitBA(&buildstate->accum);
+}
+
 IndexBuildResult *
 ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 {
@@ -335,9 +676,7 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 		elog(ERROR, "index \"%s\" already contains data",
 			 RelationGetRelationName(index));
 
-	initGinState(&buildstate.ginstate, index);
-	buildstate.indtuples = 0;
-	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	ginInitBuildState(&buildstate, index);
 
 	/* initialize the meta page */
 	MetaBuffer = GinNewBuffer(index);
@@ -359,45 +698,45 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	/* count the root as first entry page */
 	buildstate.buildStats.nEntryPages++;
 
-	/*
-	 * create a temporary memory context that is used to hold data not yet
-	 * dumped out to the index
-	 */
-	buildstate.tmpCtx = AllocSetContextCreate(CurrentMemoryContext,
-											  "Gin build temporary context",
-											  ALLOCSET_DEFAULT_SIZES);
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		_gin_begin_parallel(&buildstate, heap, index, indexInfo->ii_Concurrent,
+							indexInfo->ii_ParallelWorkers);
 
-	/*
-	 * create a temporary memory context that is used for calling
-	 * ginExtractEntries(), and can be reset after each tuple
-	 */
-	buildstate.funcCtx = AllocSetContextCreate(CurrentMemoryContext,
-											   "Gin build temporary context for user-defined function",
-											   ALLOCSET_DEFAULT_SIZES);
-
-	buildstate.accum.ginstate = &buildstate.ginstate;
-	ginInitBA(&buildstate.accum);
-
-	/*
-	 * Do the heap scan.  We disallow sync scan here because dataPlaceToPage
-	 * prefers to receive tuples in TID order.
-	 */
-	reltuples = table_index_build_scan(heap, index, indexInfo, false, true,
-									   ginBuildCallback, (void *) &buildstate,
-									   NULL);
-
-	/* dump remaining entries to the index */
-	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
-	ginBeginBAScan(&buildstate.accum);
-	while ((list = ginGetBAEntry(&buildstate.accum,
-								 &attnum, &key, &category, &nlist)) != NULL)
+	if (buildstate.ginleader)
 	{
-		/* there could be many entries, so be willing to abort here */
-		CHECK_FOR_INTERRUPTS();
-		ginEntryInsert(&buildstate.ginstate, attnum, key, category,
-					   list, nlist, &buildstate.buildStats);
+		/*
+		 * The participants have scanned the heap and sorted their entries.
+		 * Merge the sorted entries and insert them into the index.
+		 */
+		reltuples = _gin_parallel_heapscan(&buildstate,
+										   &indexInfo->ii_BrokenHotChain);
+		_gin_parallel_merge(&buildstate, heap, index);
+		_gin_end_parallel(buildstate.ginleader);
+	}
+	else
+	{
+		/*
+		 * Do the heap scan.  We disallow sync scan here because
+		 * dataPlaceToPage prefers to receive tuples in TID order.
+		 */
+		reltuples = table_index_build_scan(heap, index, indexInfo, false, true,
+										   ginBuildCallback,
+										   (void *) &buildstate, NULL);
+
+		/* dump remaining entries to the index */
+		oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
+		ginBeginBAScan(&buildstate.accum);
+		while ((list = ginGetBAEntry(&buildstate.accum,
+									 &attnum, &key, &category, &nlist)) != NULL)
+		{
+			/* there could be many entries, so be willing to abort here */
+			CHECK_FOR_INTERRUPTS();
+			ginEntryInsert(&buildstate.ginstate, attnum, key, category,
+						   list, nlist, &buildstate.buildStats);
+		}
+		MemoryContextSwitchTo(oldCtx);
 	}
-	MemoryContextSwitchTo(oldCtx);
 
 	MemoryContextDelete(buildstate.funcCtx);
 	MemoryContextDelete(buildstate.tmpCtx);
@@ -537,3 +876,608 @@ gininsert(Relation index, Datum *values, bool *isnull,
 
 	return false;
 }
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * buildstate argument should be initialized (with the exception of the
+ * tuplesort state, which may later be created based on shared state initially
+ * set up here).
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Sets buildstate's GinLeader, which caller must use to shut down parallel
+ * mode by passing it to _gin_end_parallel() at the very end of its index
+ * build.  If not even a single worker process can be launched, this is
+ * never set, and caller should proceed with a serial index build.
+ */
+static void
+_gin_begin_parallel(GinBuildState *buildstate, Relation heap, Relation index,
+					bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estginshared;
+	Size		estsort;
+	GinBuildShared *ginshared;
+	Sharedsort *sharedsort;
+	GinLeader  *ginleader = (GinLeader *) palloc0(sizeof(GinLeader));
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+	bool		leaderparticipates = true;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of gin index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_gin_parallel_build_main",
+								 request);
+
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Estimate size for our own PARALLEL_KEY_GIN_SHARED workspace, and
+	 * PARALLEL_KEY_TUPLESORT tuplesort workspace
+	 */
+	estginshared = _gin_parallel_estimate_shared(heap, snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, estginshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/*
+	 * Estimate space for WalUsage and BufferUsage -- PARALLEL_KEY_WAL_USAGE
+	 * and PARALLEL_KEY_BUFFER_USAGE.
+	 *
+	 * If there are no extensions loaded that care, we could skip this.  We
+	 * have no way of knowing whether anyone's looking at pgWalUsage or
+	 * pgBufferUsage, so do it unconditionally.
+	 */
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	if (debug_query_string)
+	{
+		querylen = strlen(debug_query_string);
+		shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+	else
+		querylen = 0;			/* keep compiler quiet */
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* If no DSM segment was available, back out (do serial build) */
+	if (pcxt->seg == NULL)
+	{
+		if (IsMVCCSnapshot(snapshot))
+			UnregisterSnapshot(snapshot);
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return;
+	}
+
+	/* Store shared build state, for which we reserved space */
+	ginshared = (GinBuildShared *) shm_toc_allocate(pcxt->toc, estginshared);
+	/* Initialize immutable state */
+	ginshared->heaprelid = RelationGetRelid(heap);
+	ginshared->indexrelid = RelationGetRelid(index);
+	ginshared->isconcurrent = isconcurrent;
+	ginshared->scantuplesortstates = scantuplesortstates;
+	ConditionVariableInit(&ginshared->workersdonecv);
+	SpinLockInit(&ginshared->mutex);
+	/* Initialize mutable state */
+	ginshared->nparticipantsdone = 0;
+	ginshared->reltuples = 0.0;
+	ginshared->indtuples = 0.0;
+	ginshared->brokenhotchain = false;
+	table_parallelscan_initialize(heap,
+								  ParallelTableScanFromGinBuildShared(ginshared),
+								  snapshot);
+
+	/*
+	 * Store shared tuplesort-private state, for which we reserved space.
+	 * Then, initialize opaque state using tuplesort routine.
+	 */
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+								pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GIN_SHARED, ginshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	/* Store query string for workers */
+	if (debug_query_string)
+	{
+		char	   *sharedquery;
+
+		sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+		memcpy(sharedquery, debug_query_string, querylen + 1);
+		shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+	}
+
+	/*
+	 * Allocate space for each worker's WalUsage and BufferUsage; no need to
+	 * initialize.
+	 */
+	walusage = shm_toc_allocate(pcxt->toc,
+								mul_size(sizeof(WalUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_WAL_USAGE, walusage);
+	bufferusage = shm_toc_allocate(pcxt->toc,
+								   mul_size(sizeof(BufferUsage), pcxt->nworkers));
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_BUFFER_USAGE, bufferusage);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	ginleader->pcxt = pcxt;
+	ginleader->nparticipanttuplesorts = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		ginleader->nparticipanttuplesorts++;
+	ginleader->ginshared = ginshared;
+	ginleader->sharedsort = sharedsort;
+	ginleader->snapshot = snapshot;
+	ginleader->walusage = walusage;
+	ginleader->bufferusage = bufferusage;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_gin_end_parallel(ginleader);
+		return;
+	}
+
+	/* Save leader state now that it's clear build will be parallel */
+	buildstate->ginleader = ginleader;
+
+	/* Join heap scan ourselves */
+	if (leaderparticipates)
+		_gin_leader_participate_as_worker(buildstate, heap, index);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+static void
+_gin_end_parallel(GinLeader *ginleader)
+{
+	int			i;
+
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(ginleader->pcxt);
+
+	/*
+	 * Next, accumulate WAL usage.  (This must wait for the workers to finish,
+	 * or we might get incomplete data.)
+	 */
+	for (i = 0; i < ginleader->pcxt->nworkers_launched; i++)
+		InstrAccumParallelQuery(&ginleader->bufferusage[i], &ginleader->walusage[i]);
+
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(ginleader->snapshot))
+		UnregisterSnapshot(ginleader->snapshot);
+	DestroyParallelContext(ginleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * gin index build based on the snapshot its parallel scan will use.
+ */
+static Size
+_gin_parallel_estimate_shared(Relation heap, Snapshot snapshot)
+{
+	/* c.f. shm_toc_allocate as to why BUFFERALIGN is used */
+	return add_size(BUFFERALIGN(sizeof(GinBuildShared)),
+					table_parallelscan_estimate(heap, snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by _gin_begin_parallel() will
+ * already be underway within worker processes (when leader participates
+ * as a worker, we should end up here just as workers are finishing).
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_gin_parallel_heapscan(GinBuildState *buildstate, bool *brokenhotchain)
+{
+	GinBuildShared *ginshared = buildstate->ginleader->ginshared;
+	int			nparticipanttuplesorts;
+	double		reltuples;
+
+	nparticipanttuplesorts = buildstate->ginleader->nparticipanttuplesorts;
+	for (;;)
+	{
+		SpinLockAcquire(&ginshared->mutex);
+		if (ginshared->nparticipantsdone == nparticipanttuplesorts)
+		{
+			buildstate->indtuples = ginshared->indtuples;
+			*brokenhotchain = ginshared->brokenhotchain;
+			reltuples = ginshared->reltuples;
+			SpinLockRelease(&ginshared->mutex);
+			break;
+		}
+		SpinLockRelease(&ginshared->mutex);
+
+		ConditionVariableSleep(&ginshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Add the TIDs of a GinTuple to the buffer.  The tuple's key must be the same
+ * as the buffer's, unless the buffer is empty.
+ */
+static void
+GinBufferAddTuple(GinBuffer *buffer, GinTuple *tup)
+{
+	ItemPointer items = GinTupleGetItems(tup);
+	MemoryContext oldCtx;
+
+	oldCtx = MemoryContextSwitchTo(buffer->keyCtx);
+
+	if (buffer->nitems == 0)
+	{
+		buffer->attnum = tup->attrnum;
+		buffer->category = tup->category;
+		if (tup->category == GIN_CAT_NORM_KEY)
+			buffer->key = datumCopy(GinTupleGetKey(tup), tup->typbyval,
+									tup->typlen);
+		else
+			buffer->key = (Datum) 0;
+	}
+
+	if (buffer->nitems == 0 ||
+		ItemPointerCompare(&buffer->items[buffer->nitems - 1], &items[0]) < 0)
+	{
+		/* Common case: the new TIDs all follow the ones we have, append */
+		if (buffer->nitems + tup->nitems > buffer->maxitems)
+		{
+			int			newmax = Max(buffer->maxitems * 2,
+									 buffer->nitems + tup->nitems);
+
+			if (buffer->items == NULL)
+				buffer->items = palloc(newmax * sizeof(ItemPointerData));
+			else
+				buffer->items = repalloc_huge(buffer->items,
+											  newmax * sizeof(ItemPointerData));
+			buffer->maxitems = newmax;
+		}
+		memcpy(&buffer->items[buffer->nitems], items,
+			   tup->nitems * sizeof(ItemPointerData));
+		buffer->nitems += tup->nitems;
+	}
+	else
+	{
+		/* The lists overlap, because they came from different participants */
+		ItemPointer merged;
+		int			nmerged;
+
+		merged = ginMergeItemPointers(buffer->items, buffer->nitems,
+									  items, tup->nitems, &nmerged);
+		pfree(buffer->items);
+		buffer->items = merged;
+		buffer->maxitems = buffer->nitems + tup->nitems;
+		buffer->nitems = nmerged;
+	}
+
+	MemoryContextSwitchTo(oldCtx);
+}
+
+/*
+ * Insert the first nitems TIDs in the buffer into the index, and remove them
+ * from the buffer.
+ */
+static void
+GinBufferFlush(GinBuildState *buildstate, GinBuffer *buffer, int nitems)
+{
+	Assert(nitems > 0 && nitems <= buffer->nitems);
+
+	ginEntryInsert(&buildstate->ginstate, buffer->attnum, buffer->key,
+				   buffer->category, buffer->items, nitems,
+				   &buildstate->buildStats);
+
+	if (nitems < buffer->nitems)
+	{
+		memmove(buffer->items, &buffer->items[nitems],
+				(buffer->nitems - nitems) * sizeof(ItemPointerData));
+		buffer->nitems -= nitems;
+	}
+	else
+	{
+		buffer->nitems = 0;
+		buffer->maxitems = 0;
+		buffer->items = NULL;
+		MemoryContextReset(buffer->keyCtx);
+	}
+}
+
+/*
+ * Within leader, merge the sorted output of all participants, and insert the
+ * entries into the index.
+ *
+ * The sorted stream contains, for each key, a sequence of partial TID lists
+ * ordered by their first TID.  These are combined into a single list per key,
+ * so that in the common case each key is inserted into the index with just
+ * one ginEntryInsert() call, in key order, which is the same access pattern
+ * as the final dump of a serial build.  To bound memory use for very frequent
+ * keys, once the list grows beyond maintenance_work_mem the TIDs known to
+ * precede all remaining input for the key are inserted early.
+ */
+static void
+_gin_parallel_merge(GinBuildState *buildstate, Relation heap, Relation index)
+{
+	GinLeader  *ginleader = buildstate->ginleader;
+	SortCoordinate coordinate;
+	Tuplesortstate *sortstate;
+	GinBuffer	buffer;
+	GinTuple   *tup;
+	Size		maxitems;
+
+	/* Initialize leader's coordination state for the final merge */
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = ginleader->nparticipanttuplesorts;
+	coordinate->sharedsort = ginleader->sharedsort;
+
+	sortstate = tuplesort_begin_index_gin(heap, index, maintenance_work_mem,
+										  coordinate, TUPLESORT_NONE);
+	tuplesort_performsort(sortstate);
+
+	memset(&buffer, 0, sizeof(GinBuffer));
+	buffer.keyCtx = AllocSetContextCreate(CurrentMemoryContext,
+										  "Gin build merge context",
+										  ALLOCSET_DEFAULT_SIZES);
+	maxitems = ((Size) maintenance_work_mem * 1024L) / sizeof(ItemPointerData);
+
+	while ((tup = tuplesort_getgintuple(sortstate, true)) != NULL)
+	{
+		/* there could be many entries, so be willing to abort here */
+		CHECK_FOR_INTERRUPTS();
+
+		if (buffer.nitems > 0 &&
+			(buffer.attnum != tup->attrnum ||
+			 ginCompareEntries(&buildstate->ginstate, buffer.attnum,
+							   buffer.key, buffer.category,
+							   GinTupleGetKey(tup), tup->category) != 0))
+		{
+			/* Key changed, so insert everything we have for the old one */
+			GinBufferFlush(buildstate, &buffer, buffer.nitems);
+		}
+		else if (buffer.nitems > maxitems)
+		{
+			ItemPointer first = GinTupleGetItems(tup);
+			int			nflush = 0;
+
+			/*
+			 * Later tuples for this key all start at or after this tuple's
+			 * first TID, so everything before it is final.
+			 */
+			while (nflush < buffer.nitems &&
+				   ItemPointerCompare(&buffer.items[nflush], first) < 0)
+				nflush++;
+			if (nflush > 0)
+				GinBufferFlush(buildstate, &buffer, nflush);
+		}
+
+		GinBufferAddTuple(&buffer, tup);
+	}
+
+	if (buffer.nitems > 0)
+		GinBufferFlush(buildstate, &buffer, buffer.nitems);
+
+	MemoryContextDelete(buffer.keyCtx);
+	tuplesort_end(sortstate);
+}
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_gin_leader_participate_as_worker(GinBuildState *buildstate, Relation heap,
+								  Relation index)
+{
+	GinLeader  *ginleader = buildstate->ginleader;
+	int			sortmem;
+
+	/*
+	 * Might as well use reliable figure when doling out maintenance_work_mem
+	 * (when requested number of workers were not launched, this will be
+	 * somewhat higher than it is for other workers).
+	 */
+	sortmem = maintenance_work_mem / ginleader->nparticipanttuplesorts;
+
+	/* Perform work common to all participants */
+	_gin_parallel_scan_and_sort(ginleader->ginshared, ginleader->sharedsort,
+								heap, index, sortmem, true);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_gin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	GinBuildShared *ginshared;
+	Sharedsort *sharedsort;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	WalUsage   *walusage;
+	BufferUsage *bufferusage;
+	int			sortmem;
+
+	/*
+	 * The only possible status flag that can be set to the parallel worker is
+	 * PROC_IN_SAFE_IC.
+	 */
+	Assert((MyProc->statusFlags == 0) ||
+		   (MyProc->statusFlags == PROC_IN_SAFE_IC));
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, true);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up gin shared state */
+	ginshared = shm_toc_lookup(toc, PARALLEL_KEY_GIN_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!ginshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Open relations within worker */
+	heapRel = table_open(ginshared->heaprelid, heapLockmode);
+	indexRel = index_open(ginshared->indexrelid, indexLockmode);
+
+	/* Look up shared state private to tuplesort.c */
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/* Prepare to track buffer usage during parallel execution */
+	InstrStartParallelQuery();
+
+	/* Scan the heap and sort the extracted entries */
+	sortmem = maintenance_work_mem / ginshared->scantuplesortstates;
+	_gin_parallel_scan_and_sort(ginshared, sharedsort, heapRel, indexRel,
+								sortmem, false);
+
+	/* Report WAL/buffer usage during parallel execution */
+	bufferusage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
+	walusage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
+	InstrEndParallelQuery(&bufferusage[ParallelWorkerNumber],
+						  &walusage[ParallelWorkerNumber]);
+
+	index_close(indexRel, indexLockmode);
+	table_close(heapRel, heapLockmode);
+}
+
+/*
+ * Perform a worker's portion of a parallel build.
+ *
+ * Entries are extracted from this participant's share of the heap and
+ * accumulated in memory just like in a serial build, but instead of being
+ * inserted into the index, the accumulated TID lists are dumped into a
+ * tuplesort whenever the accumulator fills up.  Half of sortmem is given to
+ * the accumulator, the other half to the tuplesort.
+ *
+ * sortmem is the amount of working memory to use within each worker,
+ * expressed in KBs.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_gin_parallel_scan_and_sort(GinBuildShared *ginshared, Sharedsort *sharedsort,
+							Relation heap, Relation index,
+							int sortmem, bool progress)
+{
+	SortCoordinate coordinate;
+	GinBuildState buildstate;
+	TableScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+
+	/* Initialize local tuplesort coordination state */
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	/* Fill in buildstate for ginBuildCallbackParallel() */
+	ginInitBuildState(&buildstate, index);
+	buildstate.accumMaxMemory = (Size) Max(sortmem / 2, 64) * 1024L;
+
+	/* Begin "partial" tuplesort */
+	buildstate.sortstate = tuplesort_begin_index_gin(heap, index,
+													 Max(sortmem / 2, 64),
+													 coordinate,
+													 TUPLESORT_NONE);
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = ginshared->isconcurrent;
+	scan = table_beginscan_parallel(heap,
+									ParallelTableScanFromGinBuildShared(ginshared));
+	reltuples = table_index_build_scan(heap, index, indexInfo, true, progress,
+									   ginBuildCallbackParallel,
+									   (void *) &buildstate, scan);
+
+	/* Dump remaining entries, and execute this worker's part of the sort */
+	ginDumpAccumToSort(&buildstate);
+	tuplesort_performsort(buildstate.sortstate);
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&ginshared->mutex);
+	ginshared->nparticipantsdone++;
+	ginshared->reltuples += reltuples;
+	ginshared->indtuples += buildstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		ginshared->brokenhotchain = true;
+	SpinLockRelease(&ginshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&ginshared->workersdonecv);
+
+	/* We can end tuplesorts immediately */
+	tuplesort_end(buildstate.sortstate);
+
+	MemoryContextDelete(buildstate.funcCtx);
+	MemoryContextDelete(buildstate.tmpCtx);
+}
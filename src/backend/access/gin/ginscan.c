@@ -110,6 +110,7 @@ ginFillScanEntry(GinScanOpaque so, OffsetNumber attnum,
 	scanEntry->list = NULL;
 	scanEntry->nlist = 0;
 	scanEntry->offset = InvalidOffsetNumber;
+	scanEntry->moreOnPage = false;
 	scanEntry->isFinished = false;
 	scanEntry->reduceResult = false;
 
@@ -191,6 +192,7 @@ ginFillScanKey(GinScanOpaque so, OffsetNumber attnum,
 	key->nadditional = 0;
 	key->requiredEntries = NULL;
 	key->additionalEntries = NULL;
+	key->skipEntry = NULL;
 
 	ginInitConsistentFunction(ginstate, key);
 
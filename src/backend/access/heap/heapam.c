@@ -2015,15 +2015,12 @@ heap_prepare_insert(Relation relation, HeapTuple tup, TransactionId xid,
 					CommandId cid, int options)
 {
 	/*
-	 * To allow parallel inserts, we need to ensure that they are safe to be
-	 * performed in workers. We have the infrastructure to allow parallel
-	 * inserts in general except for the cases where inserts generate a new
-	 * CommandId (eg. inserts into a table having a foreign key column).
+	 * Parallel workers may insert tuples, as long as the leader has assigned
+	 * the transaction ID and marked the command ID as used before starting
+	 * them; GetCurrentTransactionId() and GetCurrentCommandId() enforce that.
+	 * Inserts that would need a new command ID, such as those into a table
+	 * having a foreign key column, are never planned to run in workers.
 	 */
-	if (IsParallelWorker())
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_TRANSACTION_STATE),
-				 errmsg("cannot insert tuples in a parallel worker")));
 
 	tup->t_data->t_infomask &= ~(HEAP_XACT_MASK);
 	tup->t_data->t_infomask2 &= ~(HEAP2_XACT_MASK);
@@ -32,6 +32,7 @@
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_am.h"
 #include "catalog/toasting.h"
 #include "commands/createas.h"
 #include "commands/matview.h"
@@ -55,6 +56,8 @@ typedef struct
 {
 	DestReceiver pub;			/* publicly-known function pointers */
 	IntoClause *into;			/* target relation specification */
+	GatherState *gatherstate;	/* top plan node, if workers may insert */
+	Oid			parallel_relid; /* in a parallel worker, the target table */
 	/* These fields are filled by intorel_startup: */
 	Relation	rel;			/* relation to write to */
 	ObjectAddress reladdr;		/* address of rel, for ExecCreateTableAs */
@@ -66,6 +69,7 @@ typedef struct
 /* utility functions for CTAS definition creation */
 static ObjectAddress create_ctas_internal(List *attrList, IntoClause *into);
 static ObjectAddress create_ctas_nodata(List *tlist, IntoClause *into);
+static bool ctas_parallel_insert_ok(QueryDesc *queryDesc);
 
 /* DestReceiver routines for collecting data */
 static void intorel_startup(DestReceiver *self, int operation, TupleDesc typeinfo);
@@ -332,6 +336,11 @@ ExecCreateTableAs(ParseState *pstate, CreateTableAsStmt *stmt,
 		/* call ExecutorStart to prepare the plan for execution */
 		ExecutorStart(queryDesc, GetIntoRelEFlags(into));
 
+		/* see if parallel workers can insert rows themselves */
+		if (ctas_parallel_insert_ok(queryDesc))
+			((DR_intorel *) dest)->gatherstate =
+				castNode(GatherState, queryDesc->planstate);
+
 		/* run the plan to completion */
 		ExecutorRun(queryDesc, ForwardScanDirection, 0, true);
 
@@ -363,6 +372,27 @@ ExecCreateTableAs(ParseState *pstate, CreateTableAsStmt *stmt,
 	return address;
 }
 
+/*
+ * ctas_parallel_insert_ok --- can parallel workers insert the query's rows?
+ *
+ * If the top plan node is a Gather that passes on its workers' tuples
+ * unchanged, the workers can insert them into the new table themselves,
+ * rather than funnel all of them through the leader.  In a serializable
+ * transaction, though, workers have no way to tell the leader about their
+ * writes for the purposes of predicate locking.  intorel_startup makes the
+ * final decision, once the table exists.
+ */
+static bool
+ctas_parallel_insert_ok(QueryDesc *queryDesc)
+{
+	PlanState  *planstate = queryDesc->planstate;
+
+	return IsA(planstate, GatherState) &&
+		planstate->ps_ProjInfo == NULL &&
+		queryDesc->estate->es_junkFilter == NULL &&
+		!IsolationIsSerializable();
+}
+
 /*
  * GetIntoRelEFlags --- compute executor flags needed for CREATE TABLE AS
  *
@@ -452,6 +482,22 @@ CreateIntoRelDestReceiver(IntoClause *intoClause)
 	return (DestReceiver *) self;
 }
 
+/*
+ * CreateParallelIntoRelDestReceiver -- create a DestReceiver for a parallel
+ * worker, which inserts its share of the rows of a CREATE TABLE AS into the
+ * table created by the leader
+ */
+DestReceiver *
+CreateParallelIntoRelDestReceiver(Oid relid)
+{
+	DR_intorel *self;
+
+	self = (DR_intorel *) CreateIntoRelDestReceiver(makeNode(IntoClause));
+	self->parallel_relid = relid;
+
+	return (DestReceiver *) self;
+}
+
 /*
  * intorel_startup --- executor startup
  */
@@ -469,6 +515,19 @@ intorel_startup(DestReceiver *self, int operation, TupleDesc typeinfo)
 
 	Assert(into != NULL);		/* else somebody forgot to set it */
 
+	/*
+	 * In a parallel worker, the leader has created the table already, and
+	 * holds an exclusive lock on it that doesn't conflict with ours.
+	 */
+	if (OidIsValid(myState->parallel_relid))
+	{
+		myState->rel = table_open(myState->parallel_relid, RowExclusiveLock);
+		myState->output_cid = GetCurrentCommandId(true);
+		myState->ti_options = TABLE_INSERT_SKIP_FSM;
+		myState->bistate = GetBulkInsertState();
+		return;
+	}
+
 	/* This code supports both CREATE TABLE AS and CREATE MATERIALIZED VIEW */
 	is_matview = (into->viewQuery != NULL);
 
@@ -569,6 +628,20 @@ intorel_startup(DestReceiver *self, int operation, TupleDesc typeinfo)
 	else
 		myState->bistate = NULL;
 
+	/*
+	 * If parallel workers may insert rows, tell the Gather node where.
+	 * Workers can't access temporary tables, and other table AMs haven't
+	 * been taught to insert in parallel.  Nor can workers know whether WAL
+	 * is being skipped for the new table, so they can only help if it
+	 * isn't.
+	 */
+	if (myState->gatherstate != NULL &&
+		intoRelationDesc->rd_rel->relpersistence != RELPERSISTENCE_TEMP &&
+		intoRelationDesc->rd_rel->relam == HEAP_TABLE_AM_OID &&
+		(RelationNeedsWAL(intoRelationDesc) ||
+		 intoRelationDesc->rd_rel->relpersistence != RELPERSISTENCE_PERMANENT))
+		myState->gatherstate->insert_relid = intoRelationAddr.objectId;
+
 	/*
 	 * Valid smgr_targblock implies something already wrote to the relation.
 	 * This may be harmless, but this function hasn't planned for it.
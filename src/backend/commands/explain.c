@@ -18,6 +18,7 @@
 #include "commands/createas.h"
 #include "commands/defrem.h"
 #include "commands/prepare.h"
+#include "executor/nodeAgg.h"
 #include "executor/nodeHash.h"
 #include "foreign/fdwapi.h"
 #include "jit/jit.h"
@@ -89,6 +90,8 @@ static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
 								   ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
 						  ExplainState *es);
+static void show_agg_distinct_hash(AggState *astate, List *ancestors,
+								   ExplainState *es);
 static void show_grouping_sets(PlanState *planstate, Agg *agg,
 							   List *ancestors, ExplainState *es);
 static void show_grouping_set_keys(PlanState *planstate,
@@ -2018,6 +2021,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			break;
 		case T_Agg:
 			show_agg_keys(castNode(AggState, planstate), ancestors, es);
+			if (es->verbose)
+				show_agg_distinct_hash(castNode(AggState, planstate),
+									   ancestors, es);
 			show_upper_qual(plan->qual, "Filter", planstate, ancestors, es);
 			show_hashagg_info((AggState *) planstate, es);
 			if (plan->qual)
@@ -2445,6 +2451,39 @@ show_agg_keys(AggState *astate, List *ancestors,
 	}
 }
 
+/*
+ * Show the DISTINCT aggregates that discard duplicate inputs with a hash
+ * table before sorting them.
+ */
+static void
+show_agg_distinct_hash(AggState *astate, List *ancestors,
+					   ExplainState *es)
+{
+	List	   *context = NIL;
+	List	   *result = NIL;
+
+	for (int transno = 0; transno < astate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &astate->pertrans[transno];
+
+		if (pertrans->distincthashes == NULL)
+			continue;
+
+		/* Set up deparsing context */
+		if (context == NIL)
+			context = set_deparse_context_plan(es->deparse_cxt,
+											   astate->ss.ps.plan,
+											   ancestors);
+
+		result = lappend(result,
+						 deparse_expression((Node *) pertrans->aggref,
+											context, true, false));
+	}
+
+	if (result != NIL)
+		ExplainPropertyList("Hashed Distinct Aggregates", result, es);
+}
+
 static void
 show_grouping_sets(PlanState *planstate, Agg *agg,
 				   List *ancestors, ExplainState *es)
@@ -3096,6 +3135,14 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 											  worker_hi->nbatch_original);
 			hinstrument.space_peak = Max(hinstrument.space_peak,
 										 worker_hi->space_peak);
+			if (worker_hi->reversed)
+			{
+				hinstrument.reversed = true;
+				hinstrument.reversed_tuples = Max(hinstrument.reversed_tuples,
+												  worker_hi->reversed_tuples);
+				hinstrument.reversed_space = Max(hinstrument.reversed_space,
+												 worker_hi->reversed_space);
+			}
 		}
 	}
 
@@ -3137,6 +3184,29 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 							 spacePeakKb);
 		}
 	}
+
+	/* Report it if the join hashed the outer relation instead */
+	if (hinstrument.reversed)
+	{
+		long		reversedSpaceKb = (hinstrument.reversed_space + 1023) / 1024;
+
+		if (es->format != EXPLAIN_FORMAT_TEXT)
+		{
+			ExplainPropertyBool("Roles Reversed", true, es);
+			ExplainPropertyInteger("Reversed Outer Rows", NULL,
+								   hinstrument.reversed_tuples, es);
+			ExplainPropertyInteger("Reversed Memory Usage", "kB",
+								   reversedSpaceKb, es);
+		}
+		else
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str,
+							 "Roles Reversed: Outer Rows: " INT64_FORMAT "  Memory Usage: %ldkB\n",
+							 hinstrument.reversed_tuples,
+							 reversedSpaceKb);
+		}
+	}
 }
 
 /*
@@ -3620,6 +3690,10 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 				if (usage->temp_blks_written > 0)
 					appendStringInfo(es->str, " written=%lld",
 									 (long long) usage->temp_blks_written);
+				if (usage->temp_compressed_bytes > 0)
+					appendStringInfo(es->str, " compression=%.2f",
+									 (double) usage->temp_raw_bytes /
+									 usage->temp_compressed_bytes);
 			}
 			appendStringInfoChar(es->str, '\n');
 		}
@@ -3680,6 +3754,11 @@ show_buffer_usage(ExplainState *es, const BufferUsage *usage, bool planning)
 							   usage->temp_blks_read, es);
 		ExplainPropertyInteger("Temp Written Blocks", NULL,
 							   usage->temp_blks_written, es);
+		if (usage->temp_compressed_bytes > 0)
+			ExplainPropertyFloat("Temp Compression Ratio", NULL,
+								 (double) usage->temp_raw_bytes /
+								 usage->temp_compressed_bytes,
+								 2, es);
 		if (track_io_timing)
 		{
 			ExplainPropertyFloat("I/O Read Time", "ms",
@@ -1157,6 +1157,20 @@ check_bonjour(bool *newval, void **extra, GucSource source)
 	return true;
 }
 
+bool
+check_shared_buffers_numa_interleave(bool *newval, void **extra,
+									 GucSource source)
+{
+#ifndef USE_LIBNUMA
+	if (*newval)
+	{
+		GUC_check_errmsg("NUMA is not supported by this build");
+		return false;
+	}
+#endif
+	return true;
+}
+
 bool
 check_default_with_oids(bool *newval, void **extra, GucSource source)
 {
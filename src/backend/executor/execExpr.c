@@ -48,6 +48,7 @@
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
@@ -68,6 +69,8 @@ static void ExecInitExprRec(Expr *node, ExprState *state,
 static void ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args,
 						 Oid funcid, Oid inputcollid,
 						 ExprState *state);
+static void ExecInitJsonbExpand(ExprState *state, Oid funcid, Expr *arg,
+								Datum *resv, bool *resnull);
 static void ExecCreateExprSetupSteps(ExprState *state, Node *node);
 static void ExecPushExprSetupSteps(ExprState *state, ExprSetupInfo *info);
 static bool expr_setup_walker(Node *node, ExprSetupInfo *info);
@@ -2638,6 +2641,11 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 			ExecInitExprRec(arg, state,
 							&fcinfo->args[argno].value,
 							&fcinfo->args[argno].isnull);
+
+			if (argno == 0)
+				ExecInitJsonbExpand(state, funcid, arg,
+									&fcinfo->args[argno].value,
+									&fcinfo->args[argno].isnull);
 		}
 		argno++;
 	}
@@ -2659,6 +2667,68 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 	}
 }
 
+/*
+ * Set up sharing of an expanded jsonb among key lookups, if appropriate.
+ *
+ * If 'arg', just compiled to evaluate into resv and resnull, is a jsonb Var
+ * serving as the object argument of a key lookup function, add a step that
+ * replaces its value with an expanded copy.  All such steps for the same Var
+ * share a cache, so that a document that's looked up many times per row is
+ * only detoasted once, and searched through its hash table of keys.  A Var
+ * that turns out to be used only once is left alone at runtime.
+ */
+static void
+ExecInitJsonbExpand(ExprState *state, Oid funcid, Expr *arg,
+					Datum *resv, bool *resnull)
+{
+	ExprEvalStep scratch = {0};
+	JsonbExpandCache *cache = NULL;
+	Var		   *var;
+	int			i;
+
+	if (funcid != F_JSONB_OBJECT_FIELD &&
+		funcid != F_JSONB_OBJECT_FIELD_TEXT &&
+		funcid != F_JSONB_EXISTS)
+		return;
+
+	if (!IsA(arg, Var))
+		return;
+	var = (Var *) arg;
+	if (var->vartype != JSONBOID || var->varattno <= 0 ||
+		var->varlevelsup != 0)
+		return;
+
+	/* Look for the cache of an earlier lookup on the same Var */
+	for (i = 0; i < state->steps_len; i++)
+	{
+		ExprEvalStep *step = &state->steps[i];
+
+		if (step->opcode == EEOP_JSONB_EXPAND &&
+			step->d.jsonb_expand.cache->varno == var->varno &&
+			step->d.jsonb_expand.cache->varattno == var->varattno)
+		{
+			cache = step->d.jsonb_expand.cache;
+			break;
+		}
+	}
+
+	if (cache == NULL)
+	{
+		cache = palloc0(sizeof(JsonbExpandCache));
+		cache->varno = var->varno;
+		cache->varattno = var->varattno;
+		cache->cxt = CurrentMemoryContext;
+		cache->value = (Datum) 0;
+	}
+	cache->nrefs++;
+
+	scratch.opcode = EEOP_JSONB_EXPAND;
+	scratch.resvalue = resv;
+	scratch.resnull = resnull;
+	scratch.d.jsonb_expand.cache = cache;
+	ExprEvalPushStep(state, &scratch);
+}
+
 /*
  * Add expression steps performing setup that's needed before any of the
  * main execution of the expression.
@@ -56,6 +56,7 @@
  */
 #include "postgres.h"
 
+#include "access/detoast.h"
 #include "access/heaptoast.h"
 #include "catalog/pg_type.h"
 #include "commands/sequence.h"
@@ -480,6 +481,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_XMLEXPR,
 		&&CASE_EEOP_JSON_CONSTRUCTOR,
 		&&CASE_EEOP_IS_JSON,
+		&&CASE_EEOP_JSONB_EXPAND,
 		&&CASE_EEOP_AGGREF,
 		&&CASE_EEOP_GROUPING_FUNC,
 		&&CASE_EEOP_WINDOW_FUNC,
@@ -1543,6 +1545,14 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		EEO_CASE(EEOP_JSONB_EXPAND)
+		{
+			/* too complex for an inline implementation */
+			ExecEvalJsonbExpand(state, op);
+
+			EEO_NEXT();
+		}
+
 		EEO_CASE(EEOP_AGGREF)
 		{
 			/*
@@ -4097,6 +4107,52 @@ ExecEvalJsonIsPredicate(ExprState *state, ExprEvalStep *op)
 	*op->resvalue = BoolGetDatum(res);
 }
 
+/*
+ * Replace a jsonb Var's value by a read-only pointer to an expanded copy of
+ * it, shared among all key lookups on that Var in the expression.
+ *
+ * Only values stored out of line are cached.  Their TOAST pointer identifies
+ * the value reliably across rows, and they are the large values for which
+ * detoasting and searching the object repeatedly is expensive.  The cache
+ * only holds the value last seen, which is freed once another one comes
+ * along; lookup functions return copies of what they extract, so nothing
+ * can point into it by then.
+ */
+void
+ExecEvalJsonbExpand(ExprState *state, ExprEvalStep *op)
+{
+	JsonbExpandCache *cache = op->d.jsonb_expand.cache;
+	struct varlena *attr;
+	struct varatt_external toast_pointer;
+
+	/* Nothing to gain unless the value is used by more than one lookup */
+	if (*op->resnull || cache->nrefs < 2)
+		return;
+
+	attr = (struct varlena *) DatumGetPointer(*op->resvalue);
+	if (!VARATT_IS_EXTERNAL_ONDISK(attr))
+		return;
+
+	VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+
+	if (cache->value == (Datum) 0 ||
+		cache->valueid != toast_pointer.va_valueid ||
+		cache->toastrelid != toast_pointer.va_toastrelid)
+	{
+		if (cache->value != (Datum) 0)
+		{
+			DeleteExpandedObject(cache->value);
+			cache->value = (Datum) 0;
+		}
+
+		cache->value = expand_jsonb(*op->resvalue, cache->cxt);
+		cache->toastrelid = toast_pointer.va_toastrelid;
+		cache->valueid = toast_pointer.va_valueid;
+	}
+
+	*op->resvalue = EOHPGetRODatum(DatumGetEOHP(cache->value));
+}
+
 
 /*
  * ExecEvalGroupingFunc
@@ -4581,6 +4637,12 @@ ExecEvalAggOrderedTransDatum(ExprState *state, ExprEvalStep *op,
 	AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 	int			setno = op->d.agg_trans.setno;
 
+	/* skip values already seen in this group, if hashing DISTINCT inputs */
+	if (pertrans->distincthashes &&
+		!ExecAggDistinctHashInsert(pertrans, setno,
+								   *op->resvalue, *op->resnull))
+		return;
+
 	tuplesort_putdatum(pertrans->sortstates[setno],
 					   *op->resvalue, *op->resnull);
 }
@@ -39,6 +39,7 @@
 
 #include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/parallel.h"
 #include "access/sysattr.h"
 #include "access/tableam.h"
 #include "access/transam.h"
@@ -819,7 +820,13 @@ ExecCheckXactReadOnly(PlannedStmt *plannedstmt)
 		PreventCommandIfReadOnly(CreateCommandName((Node *) plannedstmt));
 	}
 
-	if (plannedstmt->commandType != CMD_SELECT || plannedstmt->hasModifyingCTE)
+	/*
+	 * A parallel worker may be running the ModifyTable of an INSERT that was
+	 * planned to insert rows in parallel, but nothing else may write.
+	 */
+	if ((plannedstmt->commandType != CMD_SELECT &&
+		 !(plannedstmt->commandType == CMD_INSERT && IsParallelWorker())) ||
+		plannedstmt->hasModifyingCTE)
 		PreventCommandIfParallelMode(CreateCommandName((Node *) plannedstmt));
 }
 
@@ -1654,7 +1661,17 @@ ExecutePlan(EState *estate,
 
 	estate->es_use_parallel_mode = use_parallel_mode;
 	if (use_parallel_mode)
+	{
+		/*
+		 * An INSERT can run in parallel mode, but no transaction ID can be
+		 * assigned once we're in it, so make sure we have one now.  Any
+		 * parallel workers inserting rows will use it, too.
+		 */
+		if (operation == CMD_INSERT)
+			(void) GetCurrentTransactionId();
+
 		EnterParallelMode();
+	}
 
 	/*
 	 * Loop until we've processed the proper number of tuples from the plan.
@@ -23,6 +23,7 @@
 
 #include "postgres.h"
 
+#include "commands/createas.h"
 #include "executor/execParallel.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
@@ -78,6 +79,8 @@ typedef struct FixedParallelExecutorState
 	dsa_pointer param_exec;
 	int			eflags;
 	int			jit_flags;
+	Oid			insert_relid;	/* table to insert output tuples into */
+	pg_atomic_uint64 processed; /* rows inserted by workers */
 } FixedParallelExecutorState;
 
 /*
@@ -188,6 +191,19 @@ ExecSerializePlan(Plan *plan, EState *estate)
 	pstmt->resultRelations = NIL;
 	pstmt->appendRelations = NIL;
 
+	/*
+	 * If we're running the ModifyTable of an INSERT in parallel, the workers
+	 * need to know it's an INSERT, and into what.
+	 */
+	if (IsA(plan, ModifyTable))
+	{
+		ModifyTable *node = (ModifyTable *) plan;
+
+		Assert(node->operation == CMD_INSERT);
+		pstmt->commandType = CMD_INSERT;
+		pstmt->resultRelations = node->resultRelations;
+	}
+
 	/*
 	 * Transfer only parallel-safe subplans, leaving a NULL "hole" in the list
 	 * for unsafe ones (so that the list indexes of the safe ones are
@@ -584,11 +600,14 @@ ExecParallelSetupTupleQueues(ParallelContext *pcxt, bool reinitialize)
 /*
  * Sets up the required infrastructure for backend workers to perform
  * execution and return results to the main backend.
+ *
+ * If insert_relid is valid, the workers insert their output tuples into that
+ * table instead of returning them; see ExecCreateTableAs.
  */
 ParallelExecutorInfo *
 ExecInitParallelPlan(PlanState *planstate, EState *estate,
 					 Bitmapset *sendParams, int nworkers,
-					 int64 tuples_needed)
+					 int64 tuples_needed, Oid insert_relid)
 {
 	ParallelExecutorInfo *pei;
 	ParallelContext *pcxt;
@@ -739,6 +758,8 @@ ExecInitParallelPlan(PlanState *planstate, EState *estate,
 	fpes->param_exec = InvalidDsaPointer;
 	fpes->eflags = estate->es_top_eflags;
 	fpes->jit_flags = estate->es_jit_flags;
+	fpes->insert_relid = insert_relid;
+	pg_atomic_init_u64(&fpes->processed, 0);
 	shm_toc_insert(pcxt->toc, PARALLEL_KEY_EXECUTOR_FIXED, fpes);
 
 	/* Store query string */
@@ -919,6 +940,7 @@ ExecParallelReinitialize(PlanState *planstate,
 	pei->finished = false;
 
 	fpes = shm_toc_lookup(pei->pcxt->toc, PARALLEL_KEY_EXECUTOR_FIXED, false);
+	pg_atomic_write_u64(&fpes->processed, 0);
 
 	/* Free any serialized parameters from the last round. */
 	if (DsaPointerIsValid(fpes->param_exec))
@@ -1120,12 +1142,13 @@ ExecParallelRetrieveJitInstrumentation(PlanState *planstate,
 
 /*
  * Finish parallel execution.  We wait for parallel workers to finish, and
- * accumulate their buffer/WAL usage.
+ * accumulate their buffer/WAL usage and the number of rows they inserted.
  */
 void
 ExecParallelFinish(ParallelExecutorInfo *pei)
 {
 	int			nworkers = pei->pcxt->nworkers_launched;
+	FixedParallelExecutorState *fpes;
 	int			i;
 
 	/* Make this be a no-op if called twice in a row. */
@@ -1166,6 +1189,13 @@ ExecParallelFinish(ParallelExecutorInfo *pei)
 	for (i = 0; i < nworkers; i++)
 		InstrAccumParallelQuery(&pei->buffer_usage[i], &pei->wal_usage[i]);
 
+	/*
+	 * Rows that the workers inserted themselves, rather than returning them
+	 * to us, count towards the statement's total.
+	 */
+	fpes = shm_toc_lookup(pei->pcxt->toc, PARALLEL_KEY_EXECUTOR_FIXED, false);
+	pei->planstate->state->es_processed += pg_atomic_read_u64(&fpes->processed);
+
 	pei->finished = true;
 }
 
@@ -1398,6 +1428,7 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 	BufferUsage *buffer_usage;
 	WalUsage   *wal_usage;
 	DestReceiver *receiver;
+	DestReceiver *dest;
 	QueryDesc  *queryDesc;
 	SharedExecutorInstrumentation *instrumentation;
 	SharedJitInstrumentation *jit_instrumentation;
@@ -1416,7 +1447,17 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 		instrument_options = instrumentation->instrument_options;
 	jit_instrumentation = shm_toc_lookup(toc, PARALLEL_KEY_JIT_INSTRUMENTATION,
 										 true);
-	queryDesc = ExecParallelGetQueryDesc(toc, receiver, instrument_options);
+
+	/*
+	 * If the leader asked us to insert our output tuples into a table
+	 * ourselves, do that instead of sending them back.  We still attach to
+	 * our tuple queue, so that the leader sees us detach from it as usual.
+	 */
+	if (OidIsValid(fpes->insert_relid))
+		dest = CreateParallelIntoRelDestReceiver(fpes->insert_relid);
+	else
+		dest = receiver;
+	queryDesc = ExecParallelGetQueryDesc(toc, dest, instrument_options);
 
 	/* Setting debug_query_string for individual workers */
 	debug_query_string = queryDesc->sourceText;
@@ -1469,6 +1510,11 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 	/* Shut down the executor */
 	ExecutorFinish(queryDesc);
 
+	/* Report the number of rows we inserted, if we're inserting */
+	if (queryDesc->operation == CMD_INSERT || dest != receiver)
+		pg_atomic_fetch_add_u64(&fpes->processed,
+								queryDesc->estate->es_processed);
+
 	/* Report buffer/WAL usage during parallel execution. */
 	buffer_usage = shm_toc_lookup(toc, PARALLEL_KEY_BUFFER_USAGE, false);
 	wal_usage = shm_toc_lookup(toc, PARALLEL_KEY_WAL_USAGE, false);
@@ -1494,5 +1540,7 @@ ParallelQueryMain(dsm_segment *seg, shm_toc *toc)
 	/* Cleanup. */
 	dsa_detach(area);
 	FreeQueryDesc(queryDesc);
+	if (dest != receiver)
+		dest->rDestroy(dest);
 	receiver->rDestroy(receiver);
 }
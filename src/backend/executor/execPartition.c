@@ -1020,7 +1020,8 @@ ExecInitRoutingInfo(ModifyTableState *mtstate,
 	 * (a FDW may support batching, but it may be disabled for the
 	 * server/table or for this particular query).
 	 *
-	 * If the FDW does not support batching, we set the batch size to 1.
+	 * If the FDW does not support batching, we set the batch size to 1.  For
+	 * a local partition, see if we can use multi-insert instead.
 	 */
 	if (partRelInfo->ri_FdwRoutine != NULL &&
 		partRelInfo->ri_FdwRoutine->GetForeignModifyBatchSize &&
@@ -1028,7 +1029,8 @@ ExecInitRoutingInfo(ModifyTableState *mtstate,
 		partRelInfo->ri_BatchSize =
 			partRelInfo->ri_FdwRoutine->GetForeignModifyBatchSize(partRelInfo);
 	else
-		partRelInfo->ri_BatchSize = 1;
+		partRelInfo->ri_BatchSize =
+			ExecGetMultiInsertBatchSize(mtstate, partRelInfo);
 
 	Assert(partRelInfo->ri_BatchSize >= 1);
 
@@ -818,6 +818,9 @@ ExecShutdownNode_walker(PlanState *node, void *context)
 		case T_HashJoinState:
 			ExecShutdownHashJoin((HashJoinState *) node);
 			break;
+		case T_MemoizeState:
+			ExecShutdownMemoize((MemoizeState *) node);
+			break;
 		default:
 			break;
 	}
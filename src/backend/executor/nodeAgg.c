@@ -38,6 +38,13 @@
  *	  is not supported in these cases, since we couldn't ensure global
  *	  ordering or distinctness of the inputs.
  *
+ *	  For a single-argument DISTINCT aggregate, the planner may also ask us
+ *	  (by setting aggdistincthash) to discard duplicate inputs with a hash
+ *	  table as they arrive, so that only the distinct values get sorted.  If
+ *	  the hash table outgrows hash_mem, we stop adding to it, and values not
+ *	  already in it are passed on to the sort, which removes any remaining
+ *	  duplicates as usual.
+ *
  *	  If transfunc is marked "strict" in pg_proc and initcond is NULL,
  *	  then the first non-NULL input_value is assigned directly to transvalue,
  *	  and transfunc isn't applied until the second non-NULL input_value.
@@ -357,6 +364,50 @@ typedef struct HashAggBatch
 	double		input_card;		/* estimated group cardinality */
 } HashAggBatch;
 
+/*
+ * Entry in the hash table used to discard duplicate inputs of a DISTINCT
+ * aggregate before sorting them.
+ */
+typedef struct AggDistinctEntry
+{
+	Datum		value;			/* distinct input value */
+	uint32		hash;			/* hash value (cached) */
+	char		status;			/* hash status */
+} AggDistinctEntry;
+
+static inline uint32 aggdistinct_hash_value(AggStatePerTrans pertrans,
+											Datum value);
+static inline bool aggdistinct_equal(AggStatePerTrans pertrans,
+									 Datum a, Datum b);
+
+#define SH_PREFIX aggdistinct
+#define SH_ELEMENT_TYPE AggDistinctEntry
+#define SH_KEY_TYPE Datum
+#define SH_KEY value
+#define SH_HASH_KEY(tb, key) \
+	aggdistinct_hash_value((AggStatePerTrans) (tb)->private_data, key)
+#define SH_EQUAL(tb, a, b) \
+	aggdistinct_equal((AggStatePerTrans) (tb)->private_data, a, b)
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/*
+ * Per-grouping-set state for discarding duplicate inputs of a DISTINCT
+ * aggregate with a hash table.  The table and copies of by-reference values
+ * live in 'context', which is reset at the start of each group.
+ */
+typedef struct AggDistinctHashData
+{
+	MemoryContext context;		/* holds the table and the values */
+	aggdistinct_hash *table;	/* distinct values seen in this group */
+	bool		seennull;		/* got a NULL input in this group? */
+	bool		full;			/* table reached hash_mem, stop adding */
+} AggDistinctHashData;
+
 /* used to find referenced colnos */
 typedef struct FindColsContext
 {
@@ -375,6 +426,8 @@ static void advance_transition_function(AggState *aggstate,
 										AggStatePerTrans pertrans,
 										AggStatePerGroup pergroupstate);
 static void advance_aggregates(AggState *aggstate);
+static void initialize_distinct_hash(AggStatePerTrans pertrans,
+									 AggDistinctHash distincthash);
 static void process_ordered_aggregate_single(AggState *aggstate,
 											 AggStatePerTrans pertrans,
 											 AggStatePerGroup pergroupstate);
@@ -617,6 +670,11 @@ initialize_aggregate(AggState *aggstate, AggStatePerTrans pertrans,
 									 pertrans->sortCollations,
 									 pertrans->sortNullsFirst,
 									 work_mem, NULL, TUPLESORT_NONE);
+
+		/* Likewise start with an empty hash table, if we're using one */
+		if (pertrans->distincthashes)
+			initialize_distinct_hash(pertrans,
+									 &pertrans->distincthashes[aggstate->current_set]);
 	}
 
 	/*
@@ -823,6 +881,87 @@ advance_aggregates(AggState *aggstate)
 							  &dummynull);
 }
 
+/*
+ * Hash and equality functions for the DISTINCT hash table.  These use the
+ * aggregate's input collation, like the equality checks made after sorting.
+ */
+static inline uint32
+aggdistinct_hash_value(AggStatePerTrans pertrans, Datum value)
+{
+	return DatumGetUInt32(FunctionCall1Coll(&pertrans->hashfnOne,
+											pertrans->aggCollation,
+											value));
+}
+
+static inline bool
+aggdistinct_equal(AggStatePerTrans pertrans, Datum a, Datum b)
+{
+	return DatumGetBool(FunctionCall2Coll(&pertrans->equalfnOne,
+										  pertrans->aggCollation,
+										  a, b));
+}
+
+/*
+ * Start a new group with an empty DISTINCT hash table.
+ */
+static void
+initialize_distinct_hash(AggStatePerTrans pertrans,
+						 AggDistinctHash distincthash)
+{
+	MemoryContextReset(distincthash->context);
+	distincthash->table = aggdistinct_create(distincthash->context, 32,
+											 pertrans);
+	distincthash->seennull = false;
+	distincthash->full = false;
+}
+
+/*
+ * Check an input value of a DISTINCT aggregate against the values seen in
+ * the current group, and remember it if it's new.
+ *
+ * Returns true if the value must be passed on to the sort, false if it's a
+ * known duplicate.  Once the table is full, values not found in it are
+ * passed on without being added; the sort removes duplicates among those.
+ */
+bool
+ExecAggDistinctHashInsert(AggStatePerTrans pertrans, int setno,
+						  Datum value, bool isnull)
+{
+	AggDistinctHash distincthash = &pertrans->distincthashes[setno];
+	AggDistinctEntry *entry;
+	bool		found;
+
+	if (isnull)
+	{
+		if (distincthash->seennull)
+			return false;
+		distincthash->seennull = true;
+		return true;
+	}
+
+	if (distincthash->full)
+		return aggdistinct_lookup(distincthash->table, value) == NULL;
+
+	entry = aggdistinct_insert(distincthash->table, value, &found);
+	if (found)
+		return false;
+
+	if (!pertrans->inputtypeByVal)
+	{
+		MemoryContext oldContext;
+
+		oldContext = MemoryContextSwitchTo(distincthash->context);
+		entry->value = datumCopy(value, false, pertrans->inputtypeLen);
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	if (MemoryContextMemAllocated(distincthash->context, false) >
+		get_hash_memory_limit())
+		distincthash->full = true;
+
+	return true;
+}
+
 /*
  * Run the transition function for a DISTINCT or ORDER BY aggregate
  * with only one input.  This is called after we have completed
@@ -4280,6 +4419,32 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 		pfree(ops);
 	}
 
+	/*
+	 * If the planner asked us to discard duplicates with a hash table before
+	 * sorting, set up one for each grouping set.
+	 */
+	if (aggref->aggdistincthash && pertrans->aggsortrequired)
+	{
+		SortGroupClause *sortcl;
+		Oid			hashfn;
+
+		Assert(numInputs == 1 && numDistinctCols == 1);
+
+		sortcl = linitial_node(SortGroupClause, aggref->aggdistinct);
+		if (!get_op_hash_functions(sortcl->eqop, &hashfn, NULL))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 sortcl->eqop);
+		fmgr_info(hashfn, &pertrans->hashfnOne);
+
+		pertrans->distincthashes = (AggDistinctHash)
+			palloc0(sizeof(AggDistinctHashData) * numGroupingSets);
+		for (i = 0; i < numGroupingSets; i++)
+			pertrans->distincthashes[i].context =
+				AllocSetContextCreate(CurrentMemoryContext,
+									  "AggDistinctHash",
+									  ALLOCSET_DEFAULT_SIZES);
+	}
+
 	pertrans->sortstates = (Tuplesortstate **)
 		palloc0(sizeof(Tuplesortstate *) * numGroupingSets);
 }
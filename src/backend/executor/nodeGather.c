@@ -76,6 +76,7 @@ ExecInitGather(Gather *node, EState *estate, int eflags)
 	gatherstate->need_to_scan_locally =
 		!node->single_copy && parallel_leader_participation;
 	gatherstate->tuples_needed = -1;
+	gatherstate->insert_relid = InvalidOid;
 
 	/*
 	 * Miscellaneous initialization
@@ -160,9 +161,13 @@ ExecGather(PlanState *pstate)
 
 		/*
 		 * Sometimes we might have to run without parallelism; but if parallel
-		 * mode is active then we can try to fire up some workers.
+		 * mode is active then we can try to fire up some workers.  Workers
+		 * can't run an INSERT in a serializable transaction, though, since
+		 * they have no way to tell the leader about their writes for the
+		 * purposes of predicate locking; the leader inserts all the rows then.
 		 */
-		if (gather->num_workers > 0 && estate->es_use_parallel_mode)
+		if (gather->num_workers > 0 && estate->es_use_parallel_mode &&
+			!(IsA(outerPlan(gather), ModifyTable) && IsolationIsSerializable()))
 		{
 			ParallelContext *pcxt;
 
@@ -172,7 +177,8 @@ ExecGather(PlanState *pstate)
 												 estate,
 												 gather->initParam,
 												 gather->num_workers,
-												 node->tuples_needed);
+												 node->tuples_needed,
+												 node->insert_relid);
 			else
 				ExecParallelReinitialize(outerPlanState(node),
 										 node->pei,
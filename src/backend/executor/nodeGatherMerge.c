@@ -216,7 +216,8 @@ ExecGatherMerge(PlanState *pstate)
 												 estate,
 												 gm->initParam,
 												 gm->num_workers,
-												 node->tuples_needed);
+												 node->tuples_needed,
+												 InvalidOid);
 			else
 				ExecParallelReinitialize(outerPlanState(node),
 										 node->pei,
@@ -56,6 +56,9 @@ static void ExecHashSkewTableInsert(HashJoinTable hashtable,
 									int bucketNumber);
 static void ExecHashRemoveNextSkewBucket(HashJoinTable hashtable);
 
+static void ExecHashAllocBuckets(HashJoinTable hashtable, int nbuckets);
+static inline void ExecHashPushTuple(HashJoinTable hashtable, int bucketno,
+									 HashJoinTuple tuple);
 static void *dense_alloc(HashJoinTable hashtable, Size size);
 static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
 												size_t size,
@@ -66,9 +69,12 @@ static inline HashJoinTuple ExecParallelHashFirstTuple(HashJoinTable hashtable,
 													   int bucketno);
 static inline HashJoinTuple ExecParallelHashNextTuple(HashJoinTable hashtable,
 													  HashJoinTuple tuple);
-static inline void ExecParallelHashPushTuple(dsa_pointer_atomic *head,
+static inline void ExecParallelHashPushTuple(HashJoinTable hashtable,
+											 int bucketno,
 											 HashJoinTuple tuple,
 											 dsa_pointer tuple_shared);
+static void ExecParallelHashInitBuckets(dsa_pointer_atomic *buckets,
+										int nbuckets);
 static void ExecParallelHashJoinSetUpBatches(HashJoinTable hashtable, int nbatch);
 static void ExecParallelHashEnsureBatchAccessors(HashJoinTable hashtable);
 static void ExecParallelHashRepartitionFirst(HashJoinTable hashtable);
@@ -144,6 +150,7 @@ MultiExecPrivateHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	double		startTuples;
 
 	/*
 	 * get state info from node
@@ -151,6 +158,12 @@ MultiExecPrivateHash(HashState *node)
 	outerNode = outerPlanState(node);
 	hashtable = node->hashtable;
 
+	/*
+	 * We may be resuming a build that was stopped to let the join consider
+	 * swapping roles, so count only the tuples we get this time.
+	 */
+	startTuples = hashtable->totalTuples;
+
 	/*
 	 * set expression context
 	 */
@@ -188,6 +201,13 @@ MultiExecPrivateHash(HashState *node)
 				ExecHashTableInsert(hashtable, slot, hashvalue);
 			}
 			hashtable->totalTuples += 1;
+
+			/* If the table is full and the join asked us to stop, do so */
+			if (hashtable->buildPaused)
+			{
+				hashtable->partialTuples = hashtable->totalTuples - startTuples;
+				return;
+			}
 		}
 	}
 
@@ -196,11 +216,11 @@ MultiExecPrivateHash(HashState *node)
 		ExecHashIncreaseNumBuckets(hashtable);
 
 	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
-	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
+	hashtable->spaceUsed += hashtable->nbuckets * HJ_BUCKET_SIZE;
 	if (hashtable->spaceUsed > hashtable->spacePeak)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
-	hashtable->partialTuples = hashtable->totalTuples;
+	hashtable->partialTuples = hashtable->totalTuples - startTuples;
 }
 
 /* ----------------------------------------------------------------
@@ -493,6 +513,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
 	hashtable->buckets.unshared = NULL;
+	hashtable->bucketTags.unshared = NULL;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -504,6 +525,11 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->nbatch_original = nbatch;
 	hashtable->nbatch_outstart = nbatch;
 	hashtable->growEnabled = true;
+	hashtable->reversible = false;
+	hashtable->buildPaused = false;
+	hashtable->reversed = false;
+	hashtable->reversedTuples = 0;
+	hashtable->reversedSpace = 0;
 	hashtable->totalTuples = 0;
 	hashtable->partialTuples = 0;
 	hashtable->skewTuples = 0;
@@ -650,7 +676,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 		 */
 		MemoryContextSwitchTo(hashtable->batchCxt);
 
-		hashtable->buckets.unshared = palloc0_array(HashJoinTuple, nbuckets);
+		ExecHashAllocBuckets(hashtable, nbuckets);
 
 		/*
 		 * Set up for skew optimization, if possible and there's a need for
@@ -793,8 +819,8 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 	 * Note that both nbuckets and nbatch must be powers of 2 to make
 	 * ExecHashGetBucketAndBatch fast.
 	 */
-	max_pointers = hash_table_bytes / sizeof(HashJoinTuple);
-	max_pointers = Min(max_pointers, MaxAllocSize / sizeof(HashJoinTuple));
+	max_pointers = hash_table_bytes / HJ_BUCKET_SIZE;
+	max_pointers = Min(max_pointers, MaxAllocSize / HJ_BUCKET_SIZE);
 	/* If max_pointers isn't a power of 2, must round it down to one */
 	max_pointers = pg_prevpower2_size_t(max_pointers);
 
@@ -814,7 +840,7 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 	 * If there's not enough space to store the projected number of tuples and
 	 * the required bucket headers, we will need multiple batches.
 	 */
-	bucket_bytes = sizeof(HashJoinTuple) * nbuckets;
+	bucket_bytes = HJ_BUCKET_SIZE * nbuckets;
 	if (inner_rel_bytes + bucket_bytes > hash_table_bytes)
 	{
 		/* We'll need multiple batches */
@@ -844,7 +870,7 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 		 * NTUP_PER_BUCKET tuples, whose projected size already includes
 		 * overhead for the hash code, pointer to the next tuple, etc.
 		 */
-		bucket_size = (tupsize * NTUP_PER_BUCKET + sizeof(HashJoinTuple));
+		bucket_size = (tupsize * NTUP_PER_BUCKET + HJ_BUCKET_SIZE);
 		if (hash_table_bytes <= bucket_size)
 			sbuckets = 1;		/* avoid pg_nextpower2_size_t(0) */
 		else
@@ -852,7 +878,7 @@ ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 		sbuckets = Min(sbuckets, max_pointers);
 		nbuckets = (int) sbuckets;
 		nbuckets = pg_nextpower2_32(nbuckets);
-		bucket_bytes = nbuckets * sizeof(HashJoinTuple);
+		bucket_bytes = nbuckets * HJ_BUCKET_SIZE;
 
 		/*
 		 * Buckets are simple pointers to hashjoin tuples, while tupsize
@@ -980,10 +1006,6 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 
 		hashtable->nbuckets = hashtable->nbuckets_optimal;
 		hashtable->log2_nbuckets = hashtable->log2_nbuckets_optimal;
-
-		hashtable->buckets.unshared =
-			repalloc_array(hashtable->buckets.unshared,
-						   HashJoinTuple, hashtable->nbuckets);
 	}
 
 	/*
@@ -991,8 +1013,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	 * buckets now and not have to keep track which tuples in the buckets have
 	 * already been processed. We will free the old chunks as we go.
 	 */
-	memset(hashtable->buckets.unshared, 0,
-		   sizeof(HashJoinTuple) * hashtable->nbuckets);
+	pfree(hashtable->buckets.unshared);
+	ExecHashAllocBuckets(hashtable, hashtable->nbuckets);
 	oldchunks = hashtable->chunks;
 	hashtable->chunks = NULL;
 
@@ -1026,8 +1048,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				memcpy(copyTuple, hashTuple, hashTupleSize);
 
 				/* and add it back to the appropriate bucket */
-				copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-				hashtable->buckets.unshared[bucketno] = copyTuple;
+				ExecHashPushTuple(hashtable, bucketno, copyTuple);
 			}
 			else
 			{
@@ -1110,7 +1131,6 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 				dsa_pointer_atomic *buckets;
 				ParallelHashJoinBatch *old_batch0;
 				int			new_nbatch;
-				int			i;
 
 				/* Move the old batch out of the way. */
 				old_batch0 = hashtable->batches[0].shared;
@@ -1174,19 +1194,18 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 					dtuples = (old_batch0->ntuples * 2.0) / new_nbatch;
 					dbuckets = ceil(dtuples / NTUP_PER_BUCKET);
 					dbuckets = Min(dbuckets,
-								   MaxAllocSize / sizeof(dsa_pointer_atomic));
+								   MaxAllocSize / HJ_SHARED_BUCKET_SIZE);
 					new_nbuckets = (int) dbuckets;
 					new_nbuckets = Max(new_nbuckets, 1024);
 					new_nbuckets = pg_nextpower2_32(new_nbuckets);
 					dsa_free(hashtable->area, old_batch0->buckets);
 					hashtable->batches[0].shared->buckets =
 						dsa_allocate(hashtable->area,
-									 sizeof(dsa_pointer_atomic) * new_nbuckets);
+									 HJ_SHARED_BUCKET_SIZE * new_nbuckets);
 					buckets = (dsa_pointer_atomic *)
 						dsa_get_address(hashtable->area,
 										hashtable->batches[0].shared->buckets);
-					for (i = 0; i < new_nbuckets; ++i)
-						dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+					ExecParallelHashInitBuckets(buckets, new_nbuckets);
 					pstate->nbuckets = new_nbuckets;
 				}
 				else
@@ -1195,8 +1214,7 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 					hashtable->batches[0].shared->buckets = old_batch0->buckets;
 					buckets = (dsa_pointer_atomic *)
 						dsa_get_address(hashtable->area, old_batch0->buckets);
-					for (i = 0; i < hashtable->nbuckets; ++i)
-						dsa_pointer_atomic_write(&buckets[i], InvalidDsaPointer);
+					ExecParallelHashInitBuckets(buckets, hashtable->nbuckets);
 				}
 
 				/* Move all chunks to the work queue for parallel processing. */
@@ -1333,7 +1351,7 @@ ExecParallelHashRepartitionFirst(HashJoinTable hashtable)
 											   &shared);
 				copyTuple->hashvalue = hashTuple->hashvalue;
 				memcpy(HJTUPLE_MINTUPLE(copyTuple), tuple, tuple->t_len);
-				ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
+				ExecParallelHashPushTuple(hashtable, bucketno,
 										  copyTuple, shared);
 			}
 			else
@@ -1482,12 +1500,8 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 	 * ExecHashIncreaseNumBatches, but without all the copying into new
 	 * chunks)
 	 */
-	hashtable->buckets.unshared =
-		repalloc_array(hashtable->buckets.unshared,
-					   HashJoinTuple, hashtable->nbuckets);
-
-	memset(hashtable->buckets.unshared, 0,
-		   hashtable->nbuckets * sizeof(HashJoinTuple));
+	pfree(hashtable->buckets.unshared);
+	ExecHashAllocBuckets(hashtable, hashtable->nbuckets);
 
 	/* scan through all tuples in all chunks to rebuild the hash table */
 	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
@@ -1505,8 +1519,7 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 									  &bucketno, &batchno);
 
 			/* add the tuple to the proper bucket */
-			hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-			hashtable->buckets.unshared[bucketno] = hashTuple;
+			ExecHashPushTuple(hashtable, bucketno, hashTuple);
 
 			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
@@ -1522,7 +1535,6 @@ static void
 ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 {
 	ParallelHashJoinState *pstate = hashtable->parallel_state;
-	int			i;
 	HashMemoryChunk chunk;
 	dsa_pointer chunk_s;
 
@@ -1545,7 +1557,7 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 
 				/* Double the size of the bucket array. */
 				pstate->nbuckets *= 2;
-				size = pstate->nbuckets * sizeof(dsa_pointer_atomic);
+				size = pstate->nbuckets * HJ_SHARED_BUCKET_SIZE;
 				hashtable->batches[0].shared->size += size / 2;
 				dsa_free(hashtable->area, hashtable->batches[0].shared->buckets);
 				hashtable->batches[0].shared->buckets =
@@ -1553,8 +1565,7 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 				buckets = (dsa_pointer_atomic *)
 					dsa_get_address(hashtable->area,
 									hashtable->batches[0].shared->buckets);
-				for (i = 0; i < pstate->nbuckets; ++i)
-					dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+				ExecParallelHashInitBuckets(buckets, pstate->nbuckets);
 
 				/* Put the chunk list onto the work queue. */
 				pstate->chunk_work_queue = hashtable->batches[0].shared->chunks;
@@ -1590,7 +1601,7 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 					Assert(batchno == 0);
 
 					/* add the tuple to the proper bucket */
-					ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
+					ExecParallelHashPushTuple(hashtable, bucketno,
 											  hashTuple, shared);
 
 					/* advance index past the tuple */
@@ -1658,8 +1669,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
-		hashTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-		hashtable->buckets.unshared[bucketno] = hashTuple;
+		ExecHashPushTuple(hashtable, bucketno, hashTuple);
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -1671,7 +1681,7 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		{
 			/* Guard against integer overflow and alloc size overflow */
 			if (hashtable->nbuckets_optimal <= INT_MAX / 2 &&
-				hashtable->nbuckets_optimal * 2 <= MaxAllocSize / sizeof(HashJoinTuple))
+				hashtable->nbuckets_optimal * 2 <= MaxAllocSize / HJ_BUCKET_SIZE)
 			{
 				hashtable->nbuckets_optimal *= 2;
 				hashtable->log2_nbuckets_optimal += 1;
@@ -1683,9 +1693,18 @@ ExecHashTableInsert(HashJoinTable hashtable,
 		if (hashtable->spaceUsed > hashtable->spacePeak)
 			hashtable->spacePeak = hashtable->spaceUsed;
 		if (hashtable->spaceUsed +
-			hashtable->nbuckets_optimal * sizeof(HashJoinTuple)
+			hashtable->nbuckets_optimal * HJ_BUCKET_SIZE
 			> hashtable->spaceAllowed)
-			ExecHashIncreaseNumBatches(hashtable);
+		{
+			/*
+			 * If the join might rather swap the roles of its inputs, stop
+			 * building and let it have a look at the outer relation first.
+			 */
+			if (hashtable->reversible)
+				hashtable->buildPaused = true;
+			else
+				ExecHashIncreaseNumBatches(hashtable);
+		}
 	}
 	else
 	{
@@ -1740,7 +1759,7 @@ retry:
 		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
-		ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
+		ExecParallelHashPushTuple(hashtable, bucketno,
 								  hashTuple, shared);
 	}
 	else
@@ -1793,7 +1812,7 @@ ExecParallelHashTableInsertCurrentBatch(HashJoinTable hashtable,
 	hashTuple->hashvalue = hashvalue;
 	memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, tuple->t_len);
 	HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
-	ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
+	ExecParallelHashPushTuple(hashtable, bucketno,
 							  hashTuple, shared);
 
 	if (shouldFree)
@@ -1977,8 +1996,11 @@ ExecScanHashBucket(HashJoinState *hjstate,
 		hashTuple = hashTuple->next.unshared;
 	else if (hjstate->hj_CurSkewBucketNo != INVALID_SKEW_BUCKET_NO)
 		hashTuple = hashtable->skewBucket[hjstate->hj_CurSkewBucketNo]->tuples;
-	else
+	else if (hashtable->bucketTags.unshared[hjstate->hj_CurBucketNo] &
+			 HJ_TAG_BIT(hashvalue))
 		hashTuple = hashtable->buckets.unshared[hjstate->hj_CurBucketNo];
+	else
+		return false;			/* the tag says there's no match */
 
 	while (hashTuple != NULL)
 	{
@@ -2008,6 +2030,68 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	return false;
 }
 
+/*
+ * ExecHashPrefetchBucket
+ *		hint that the bucket for a hash value is going to be probed soon
+ *
+ * This loads the bucket's tag and pointer into cache.  Once they have
+ * arrived, ExecHashPrefetchTuple can do the same for the bucket's first
+ * tuple.
+ */
+void
+ExecHashPrefetchBucket(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno = hashvalue & (hashtable->nbuckets - 1);
+
+	if (hashtable->parallel_state)
+	{
+		pg_prefetch_mem(&hashtable->bucketTags.shared[bucketno]);
+		pg_prefetch_mem(&hashtable->buckets.shared[bucketno]);
+	}
+	else
+	{
+		pg_prefetch_mem(&hashtable->bucketTags.unshared[bucketno]);
+		pg_prefetch_mem(&hashtable->buckets.unshared[bucketno]);
+	}
+}
+
+/*
+ * ExecHashPrefetchTuple
+ *		hint that the first tuple of the bucket for a hash value is going to
+ *		be examined soon
+ *
+ * Nothing is done if the bucket's tag shows that the probe won't match.
+ * Skew buckets are not considered; there are few of them, and they are
+ * likely to be in cache anyway.
+ */
+void
+ExecHashPrefetchTuple(HashJoinTable hashtable, uint32 hashvalue)
+{
+	int			bucketno = hashvalue & (hashtable->nbuckets - 1);
+
+	if (hashtable->parallel_state)
+	{
+		dsa_pointer p;
+
+		if (!(pg_atomic_read_u32(&hashtable->bucketTags.shared[bucketno]) &
+			  HJ_TAG_BIT(hashvalue)))
+			return;
+		p = dsa_pointer_atomic_read(&hashtable->buckets.shared[bucketno]);
+		if (DsaPointerIsValid(p))
+			pg_prefetch_mem(dsa_get_address(hashtable->area, p));
+	}
+	else
+	{
+		HashJoinTuple hashTuple;
+
+		if (!(hashtable->bucketTags.unshared[bucketno] & HJ_TAG_BIT(hashvalue)))
+			return;
+		hashTuple = hashtable->buckets.unshared[bucketno];
+		if (hashTuple != NULL)
+			pg_prefetch_mem(hashTuple);
+	}
+}
+
 /*
  * ExecParallelScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -2033,9 +2117,12 @@ ExecParallelScanHashBucket(HashJoinState *hjstate,
 	 */
 	if (hashTuple != NULL)
 		hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
-	else
+	else if (pg_atomic_read_u32(&hashtable->bucketTags.shared[hjstate->hj_CurBucketNo]) &
+			 HJ_TAG_BIT(hashvalue))
 		hashTuple = ExecParallelHashFirstTuple(hashtable,
 											   hjstate->hj_CurBucketNo);
+	else
+		return false;			/* the tag says there's no match */
 
 	while (hashTuple != NULL)
 	{
@@ -2122,7 +2209,7 @@ ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate)
 		 */
 		hashtable->spacePeak =
 			Max(hashtable->spacePeak,
-				batch->size + sizeof(dsa_pointer_atomic) * hashtable->nbuckets);
+				batch->size + HJ_SHARED_BUCKET_SIZE * hashtable->nbuckets);
 		hashtable->curbatch = -1;
 		return false;
 	}
@@ -2306,7 +2393,7 @@ ExecHashTableReset(HashJoinTable hashtable)
 	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
 
 	/* Reallocate and reinitialize the hash bucket headers. */
-	hashtable->buckets.unshared = palloc0_array(HashJoinTuple, nbuckets);
+	ExecHashAllocBuckets(hashtable, nbuckets);
 
 	hashtable->spaceUsed = 0;
 
@@ -2666,8 +2753,7 @@ ExecHashRemoveNextSkewBucket(HashJoinTable hashtable)
 			memcpy(copyTuple, hashTuple, tupleSize);
 			pfree(hashTuple);
 
-			copyTuple->next.unshared = hashtable->buckets.unshared[bucketno];
-			hashtable->buckets.unshared[bucketno] = copyTuple;
+			ExecHashPushTuple(hashtable, bucketno, copyTuple);
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
@@ -2857,6 +2943,38 @@ ExecHashAccumInstrumentation(HashInstrumentation *instrument,
 									  hashtable->nbatch_original);
 	instrument->space_peak = Max(instrument->space_peak,
 								 hashtable->spacePeak);
+	if (hashtable->reversed)
+	{
+		instrument->reversed = true;
+		instrument->reversed_tuples = Max(instrument->reversed_tuples,
+										  (int64) hashtable->reversedTuples);
+		instrument->reversed_space = Max(instrument->reversed_space,
+										 hashtable->reversedSpace);
+	}
+}
+
+/*
+ * Allocate an empty bucket array, with its tags, in the batch context
+ */
+static void
+ExecHashAllocBuckets(HashJoinTable hashtable, int nbuckets)
+{
+	hashtable->buckets.unshared = (HashJoinTuple *)
+		MemoryContextAllocZero(hashtable->batchCxt, nbuckets * HJ_BUCKET_SIZE);
+	hashtable->bucketTags.unshared =
+		HJ_BUCKET_TAGS(hashtable->buckets.unshared, nbuckets);
+}
+
+/*
+ * Insert a tuple at the front of a bucket's chain, and add it to the
+ * bucket's tag
+ */
+static inline void
+ExecHashPushTuple(HashJoinTable hashtable, int bucketno, HashJoinTuple tuple)
+{
+	tuple->next.unshared = hashtable->buckets.unshared[bucketno];
+	hashtable->buckets.unshared[bucketno] = tuple;
+	hashtable->bucketTags.unshared[bucketno] |= HJ_TAG_BIT(tuple->hashvalue);
 }
 
 /*
@@ -3039,7 +3157,7 @@ ExecParallelHashTupleAlloc(HashJoinTable hashtable, size_t size,
 				hashtable->nbuckets * NTUP_PER_BUCKET &&
 				hashtable->nbuckets < (INT_MAX / 2) &&
 				hashtable->nbuckets * 2 <=
-				MaxAllocSize / sizeof(dsa_pointer_atomic))
+				MaxAllocSize / HJ_SHARED_BUCKET_SIZE)
 			{
 				pstate->growth = PHJ_GROWTH_NEED_MORE_BUCKETS;
 				LWLockRelease(&pstate->lock);
@@ -3261,14 +3379,12 @@ ExecParallelHashTableAlloc(HashJoinTable hashtable, int batchno)
 	ParallelHashJoinBatch *batch = hashtable->batches[batchno].shared;
 	dsa_pointer_atomic *buckets;
 	int			nbuckets = hashtable->parallel_state->nbuckets;
-	int			i;
 
 	batch->buckets =
-		dsa_allocate(hashtable->area, sizeof(dsa_pointer_atomic) * nbuckets);
+		dsa_allocate(hashtable->area, HJ_SHARED_BUCKET_SIZE * nbuckets);
 	buckets = (dsa_pointer_atomic *)
 		dsa_get_address(hashtable->area, batch->buckets);
-	for (i = 0; i < nbuckets; ++i)
-		dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+	ExecParallelHashInitBuckets(buckets, nbuckets);
 }
 
 /*
@@ -3357,7 +3473,7 @@ ExecHashTableDetachBatch(HashJoinTable hashtable)
 		 */
 		hashtable->spacePeak =
 			Max(hashtable->spacePeak,
-				batch->size + sizeof(dsa_pointer_atomic) * hashtable->nbuckets);
+				batch->size + HJ_SHARED_BUCKET_SIZE * hashtable->nbuckets);
 
 		/* Remember that we are not attached to a batch. */
 		hashtable->curbatch = -1;
@@ -3445,13 +3561,17 @@ ExecParallelHashNextTuple(HashJoinTable hashtable, HashJoinTuple tuple)
 }
 
 /*
- * Insert a tuple at the front of a chain of tuples in DSA memory atomically.
+ * Insert a tuple at the front of a bucket's chain of tuples in DSA memory
+ * atomically, and add it to the bucket's tag.
  */
 static inline void
-ExecParallelHashPushTuple(dsa_pointer_atomic *head,
+ExecParallelHashPushTuple(HashJoinTable hashtable,
+						  int bucketno,
 						  HashJoinTuple tuple,
 						  dsa_pointer tuple_shared)
 {
+	dsa_pointer_atomic *head = &hashtable->buckets.shared[bucketno];
+
 	for (;;)
 	{
 		tuple->next.shared = dsa_pointer_atomic_read(head);
@@ -3460,6 +3580,24 @@ ExecParallelHashPushTuple(dsa_pointer_atomic *head,
 												tuple_shared))
 			break;
 	}
+	pg_atomic_fetch_or_u32(&hashtable->bucketTags.shared[bucketno],
+						   HJ_TAG_BIT(tuple->hashvalue));
+}
+
+/*
+ * Initialize a shared bucket array and its tags to "empty".
+ */
+static void
+ExecParallelHashInitBuckets(dsa_pointer_atomic *buckets, int nbuckets)
+{
+	pg_atomic_uint32 *tags = HJ_SHARED_BUCKET_TAGS(buckets, nbuckets);
+	int			i;
+
+	for (i = 0; i < nbuckets; ++i)
+	{
+		dsa_pointer_atomic_init(&buckets[i], InvalidDsaPointer);
+		pg_atomic_init_u32(&tags[i], 0);
+	}
 }
 
 /*
@@ -3476,6 +3614,8 @@ ExecParallelHashTableSetCurrentBatch(HashJoinTable hashtable, int batchno)
 						hashtable->batches[batchno].shared->buckets);
 	hashtable->nbuckets = hashtable->parallel_state->nbuckets;
 	hashtable->log2_nbuckets = my_log2(hashtable->nbuckets);
+	hashtable->bucketTags.shared =
+		HJ_SHARED_BUCKET_TAGS(hashtable->buckets.shared, hashtable->nbuckets);
 	hashtable->current_chunk = NULL;
 	hashtable->current_chunk_shared = InvalidDsaPointer;
 	hashtable->batches[batchno].at_least_one_chunk = false;
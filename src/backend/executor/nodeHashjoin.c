@@ -55,6 +55,13 @@
  * have previously triggered an increase in the number of batches instead
  * exceed the space allowed.
  *
+ * A serial inner join whose inner relation was expected to fit in memory can
+ * also swap the roles of its inputs, when that turns out to be wrong.  The
+ * first time the hash table would need a second batch, the executor stops
+ * building it and reads the outer relation instead.  If all of that fits in
+ * memory, it is hashed, and the inner relation is streamed past it; see
+ * ExecHashJoinTryReverse.
+ *
  * PARALLELISM
  *
  * Hash joins can participate in parallel query execution in several ways.  A
@@ -183,23 +190,76 @@
 #define HJ_FILL_OUTER_TUPLE		4
 #define HJ_FILL_INNER_TUPLES	5
 #define HJ_NEED_NEW_BATCH		6
+#define HJ_REVERSED_NEED_NEW_INNER	7
+#define HJ_REVERSED_SCAN_BUCKET	8
 
 /* Returns true if doing null-fill on outer relation */
 #define HJ_FILL_OUTER(hjstate)	((hjstate)->hj_NullInnerTupleSlot != NULL)
 /* Returns true if doing null-fill on inner relation */
 #define HJ_FILL_INNER(hjstate)	((hjstate)->hj_NullOuterTupleSlot != NULL)
 
+/*
+ * State of a join that stopped building its hash table to consider swapping
+ * the roles of its inputs.  If it did swap them, the outer tuples form the
+ * hash table, and the inner tuples come from the temporary file and then the
+ * Hash node's input.  Otherwise, the outer tuples read so far are replayed
+ * from a temporary file.
+ */
+typedef struct HashJoinReversal
+{
+	MemoryContext cxt;			/* holds the outer tuples and buckets */
+	HashJoinTuple outerHead;	/* outer tuples read so far, in order */
+	HashJoinTuple outerTail;
+	HashJoinTuple *buckets;		/* hash table of outer tuples, if swapped */
+	int			nbuckets;		/* # buckets (a power of 2) */
+	BufFile    *innerFile;		/* inner tuples hashed before we stopped */
+	BufFile    *outerFile;		/* outer tuples read, if not swapped */
+	bool		innerDone;		/* inner relation exhausted? */
+} HashJoinReversal;
+
+/*
+ * Once the hash table is much bigger than the CPU caches, most probes miss
+ * the cache twice, on the bucket and on the tuple it points to.  To hide
+ * that latency, outer tuples are then read into a queue some way ahead of
+ * being probed.  Each tuple's bucket is prefetched as it enters the queue,
+ * and the bucket's first tuple when it's halfway through.  The queue holds
+ * a copy of each outer tuple, which isn't worth it for smaller tables.
+ */
+#define HJ_PREFETCH_DEPTH		16
+#define HJ_PREFETCH_MIN_BUCKETS	65536
+
+typedef struct HashJoinPrefetch
+{
+	int			head;			/* index of the next tuple to return */
+	int			count;			/* number of tuples in the queue */
+	bool		exhausted;		/* no more outer tuples in this batch? */
+	MinimalTuple current;		/* tuple last returned, in hj_OuterTupleSlot */
+	MinimalTuple tuples[HJ_PREFETCH_DEPTH];
+	uint32		hashvalues[HJ_PREFETCH_DEPTH];
+} HashJoinPrefetch;
+
 static TupleTableSlot *ExecHashJoinOuterGetTuple(PlanState *outerNode,
 												 HashJoinState *hjstate,
 												 uint32 *hashvalue);
 static TupleTableSlot *ExecParallelHashJoinOuterGetTuple(PlanState *outerNode,
 														 HashJoinState *hjstate,
 														 uint32 *hashvalue);
+static pg_attribute_always_inline TupleTableSlot *ExecHashJoinOuterGetTupleAhead(PlanState *outerNode,
+																				HashJoinState *hjstate,
+																				uint32 *hashvalue,
+																				bool parallel);
+static void ExecHashJoinResetPrefetch(HashJoinState *hjstate);
 static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 												 BufFile *file,
 												 uint32 *hashvalue,
 												 TupleTableSlot *tupleSlot);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
+static bool ExecHashJoinTryReverse(HashJoinState *hjstate);
+static TupleTableSlot *ExecHashJoinReversedGetInner(HashJoinState *hjstate,
+													uint32 *hashvalue);
+static bool ExecHashJoinReversedScanBucket(HashJoinState *hjstate,
+										   ExprContext *econtext);
+static void ExecHashJoinEndReversal(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *hjstate);
 
@@ -228,6 +288,7 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 	ExprContext *econtext;
 	HashJoinTable hashtable;
 	TupleTableSlot *outerTupleSlot;
+	TupleTableSlot *innerTupleSlot;
 	uint32		hashvalue;
 	int			batchno;
 	ParallelHashJoinState *parallel_state;
@@ -338,6 +399,16 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 												HJ_FILL_INNER(node));
 				node->hj_HashTable = hashtable;
 
+				/*
+				 * For an inner join, it doesn't matter which input is hashed.
+				 * If the planner expected the inner relation to fit in
+				 * memory, ask the Hash node to stop if it doesn't, so that we
+				 * can see whether the outer relation does.
+				 */
+				hashtable->reversible = (!parallel &&
+										 node->js.jointype == JOIN_INNER &&
+										 hashtable->nbatch == 1);
+
 				/*
 				 * Execute the Hash node, to build the hash table.  If using
 				 * Parallel Hash, then we'll try to help hashing unless we
@@ -346,6 +417,18 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				hashNode->hashtable = hashtable;
 				(void) MultiExecProcNode((PlanState *) hashNode);
 
+				if (!parallel && hashtable->buildPaused)
+				{
+					if (ExecHashJoinTryReverse(node))
+					{
+						node->hj_JoinState = HJ_REVERSED_NEED_NEW_INNER;
+						continue;
+					}
+
+					/* No luck, so finish building the hash table */
+					(void) MultiExecProcNode((PlanState *) hashNode);
+				}
+
 				/*
 				 * If the inner relation is completely empty, and we're not
 				 * doing a left outer join, we can quit without scanning the
@@ -426,13 +509,9 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				/*
 				 * We don't have an outer tuple, try to get the next one
 				 */
-				if (parallel)
-					outerTupleSlot =
-						ExecParallelHashJoinOuterGetTuple(outerNode, node,
-														  &hashvalue);
-				else
-					outerTupleSlot =
-						ExecHashJoinOuterGetTuple(outerNode, node, &hashvalue);
+				outerTupleSlot = ExecHashJoinOuterGetTupleAhead(outerNode, node,
+																&hashvalue,
+																parallel);
 
 				if (TupIsNull(outerTupleSlot))
 				{
@@ -661,6 +740,48 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				node->hj_JoinState = HJ_NEED_NEW_OUTER;
 				break;
 
+			case HJ_REVERSED_NEED_NEW_INNER:
+
+				/*
+				 * The roles of the inputs have been swapped.  Get the next
+				 * inner tuple, to probe the hash table of outer tuples.
+				 */
+				innerTupleSlot = ExecHashJoinReversedGetInner(node,
+															  &hashvalue);
+				if (TupIsNull(innerTupleSlot))
+					return NULL;	/* end of join */
+
+				econtext->ecxt_innertuple = innerTupleSlot;
+				node->hj_CurHashValue = hashvalue;
+				node->hj_CurTuple = NULL;
+				node->hj_JoinState = HJ_REVERSED_SCAN_BUCKET;
+
+				/* FALL THRU */
+
+			case HJ_REVERSED_SCAN_BUCKET:
+
+				/*
+				 * Scan the selected bucket for outer tuples matching the
+				 * current inner tuple.  This is only done for inner joins,
+				 * so there's no need to track match status.
+				 */
+				if (!ExecHashJoinReversedScanBucket(node, econtext))
+				{
+					node->hj_JoinState = HJ_REVERSED_NEED_NEW_INNER;
+					continue;
+				}
+
+				if (joinqual == NULL || ExecQual(joinqual, econtext))
+				{
+					if (otherqual == NULL || ExecQual(otherqual, econtext))
+						return ExecProject(node->js.ps.ps_ProjInfo);
+					else
+						InstrCountFiltered2(node, 1);
+				}
+				else
+					InstrCountFiltered1(node, 1);
+				break;
+
 			default:
 				elog(ERROR, "unrecognized hashjoin state: %d",
 					 (int) node->hj_JoinState);
@@ -863,6 +984,7 @@ ExecEndHashJoin(HashJoinState *node)
 	 */
 	if (node->hj_HashTable)
 	{
+		ExecHashJoinEndReversal(node);
 		ExecHashTableDestroy(node->hj_HashTable);
 		node->hj_HashTable = NULL;
 	}
@@ -909,6 +1031,27 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 
 	if (curbatch == 0)			/* if it is the first pass */
 	{
+		HashJoinReversal *rev = hjstate->hj_Reversal;
+
+		/*
+		 * Replay any outer tuples that ExecHashJoinTryReverse() read before
+		 * deciding not to swap roles.
+		 */
+		if (rev != NULL && rev->outerFile != NULL)
+		{
+			slot = ExecHashJoinGetSavedTuple(hjstate,
+											 rev->outerFile,
+											 hashvalue,
+											 hjstate->hj_OuterTupleSlot);
+			if (!TupIsNull(slot))
+			{
+				hjstate->hj_OuterNotEmpty = true;
+				return slot;
+			}
+			BufFileClose(rev->outerFile);
+			rev->outerFile = NULL;
+		}
+
 		/*
 		 * Check to see if first outer tuple was already fetched by
 		 * ExecHashJoin() and not used yet.
@@ -969,6 +1112,133 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 	return NULL;
 }
 
+/*
+ * ExecHashJoinOuterGetTupleAhead
+ *
+ *		Get the next outer tuple to probe the hash table with, like
+ *		ExecHashJoinOuterGetTuple or ExecParallelHashJoinOuterGetTuple.
+ *		When the hash table is large, the tuples are read a few at a time
+ *		ahead of being returned, so that their buckets can be prefetched.
+ *		The tuple is then returned in hj_OuterTupleSlot.
+ */
+static pg_attribute_always_inline TupleTableSlot *
+ExecHashJoinOuterGetTupleAhead(PlanState *outerNode,
+							   HashJoinState *hjstate,
+							   uint32 *hashvalue,
+							   bool parallel)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinPrefetch *pf = hjstate->hj_Prefetch;
+	TupleTableSlot *slot;
+	MinimalTuple tuple;
+	int			i;
+
+	/* Unless we're in the middle of using the queue, consider bypassing it */
+	if ((pf == NULL || pf->count == 0) &&
+		hashtable->nbuckets < HJ_PREFETCH_MIN_BUCKETS)
+	{
+		if (parallel)
+			return ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+													 hashvalue);
+		else
+			return ExecHashJoinOuterGetTuple(outerNode, hjstate, hashvalue);
+	}
+
+	if (pf == NULL)
+	{
+		pf = (HashJoinPrefetch *)
+			MemoryContextAllocZero(hjstate->js.ps.state->es_query_cxt,
+								   sizeof(HashJoinPrefetch));
+		hjstate->hj_Prefetch = pf;
+	}
+
+	/* Fill up the queue, and prefetch the buckets of the new tuples */
+	while (pf->count < HJ_PREFETCH_DEPTH && !pf->exhausted)
+	{
+		uint32		newhashvalue;
+
+		if (parallel)
+			slot = ExecParallelHashJoinOuterGetTuple(outerNode, hjstate,
+													 &newhashvalue);
+		else
+			slot = ExecHashJoinOuterGetTuple(outerNode, hjstate,
+											 &newhashvalue);
+		if (TupIsNull(slot))
+		{
+			pf->exhausted = true;
+			break;
+		}
+
+		i = (pf->head + pf->count) % HJ_PREFETCH_DEPTH;
+		pf->tuples[i] = ExecCopySlotMinimalTuple(slot);
+		pf->hashvalues[i] = newhashvalue;
+		pf->count++;
+		ExecHashPrefetchBucket(hashtable, newhashvalue);
+	}
+
+	if (pf->count == 0)
+	{
+		/* End of this batch; the caller will see the next one normally */
+		ExecHashJoinResetPrefetch(hjstate);
+		return NULL;
+	}
+
+	/*
+	 * The bucket of the tuple halfway through the queue has had time to
+	 * arrive, so go after its first tuple.
+	 */
+	if (pf->count > HJ_PREFETCH_DEPTH / 2)
+		ExecHashPrefetchTuple(hashtable,
+							  pf->hashvalues[(pf->head + HJ_PREFETCH_DEPTH / 2) %
+											 HJ_PREFETCH_DEPTH]);
+
+	i = pf->head;
+	pf->head = (pf->head + 1) % HJ_PREFETCH_DEPTH;
+	pf->count--;
+
+	/*
+	 * Store the tuple without handing it over to the slot, which would make
+	 * a non-minimal slot copy it once more.  Instead, we free the previous
+	 * one, now that the slot no longer points into it.
+	 */
+	tuple = pf->tuples[i];
+	ExecForceStoreMinimalTuple(tuple, hjstate->hj_OuterTupleSlot, false);
+	if (pf->current != NULL)
+		pfree(pf->current);
+	pf->current = tuple;
+
+	*hashvalue = pf->hashvalues[i];
+	return hjstate->hj_OuterTupleSlot;
+}
+
+/*
+ * ExecHashJoinResetPrefetch
+ *		empty the queue of outer tuples read ahead, if any
+ */
+static void
+ExecHashJoinResetPrefetch(HashJoinState *hjstate)
+{
+	HashJoinPrefetch *pf = hjstate->hj_Prefetch;
+
+	if (pf == NULL)
+		return;
+
+	while (pf->count > 0)
+	{
+		pfree(pf->tuples[pf->head]);
+		pf->head = (pf->head + 1) % HJ_PREFETCH_DEPTH;
+		pf->count--;
+	}
+	if (pf->current != NULL)
+	{
+		ExecClearTuple(hjstate->hj_OuterTupleSlot);
+		pfree(pf->current);
+		pf->current = NULL;
+	}
+	pf->head = 0;
+	pf->exhausted = false;
+}
+
 /*
  * ExecHashJoinOuterGetTuple variant for the parallel case.
  */
@@ -1342,12 +1612,15 @@ ExecHashJoinSaveTuple(MinimalTuple tuple, uint32 hashvalue,
 	 *
 	 * Also, we use spillCxt instead of hashCxt for a better accounting of the
 	 * spilling memory consumption.
+	 *
+	 * Batch files are only written sequentially, then rewound and read back,
+	 * so they can be compressed if temp_file_compression says so.
 	 */
 	if (file == NULL)
 	{
 		MemoryContext oldctx = MemoryContextSwitchTo(hashtable->spillCxt);
 
-		file = BufFileCreateTemp(false);
+		file = BufFileCreateCompressTemp(false);
 		*fileptr = file;
 
 		MemoryContextSwitchTo(oldctx);
@@ -1402,6 +1675,322 @@ ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 	return tupleSlot;
 }
 
+/*
+ * ExecHashJoinTryReverse
+ *		Consider swapping the roles of the join's inputs, after the hash
+ *		table turned out not to fit in a single batch.
+ *
+ * The planner hashes the input it expects to be smaller, but if it badly
+ * underestimated the inner relation, the hash table is split into many
+ * batches, while the outer relation might have fitted in memory.  For an
+ * inner join it doesn't matter which input is hashed, so when the Hash node
+ * stops at the first sign of running out of memory, we move the tuples
+ * hashed so far to a temporary file and read the outer relation instead, as
+ * long as it fits in the same amount of memory.  If all of it does, the
+ * outer tuples become the hash table, and the caller goes on to stream the
+ * inner relation past it.  Otherwise the outer tuples read so far are
+ * written to another temporary file, for ExecHashJoinOuterGetTuple to
+ * replay, and the inner tuples are put back into the hash table, so that the
+ * caller can resume building it as usual.
+ *
+ * Returns true if the roles were swapped.
+ */
+static bool
+ExecHashJoinTryReverse(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	PlanState  *outerNode = outerPlanState(hjstate);
+	ExprContext *econtext = hjstate->js.ps.ps_ExprContext;
+	HashJoinReversal *rev;
+	HashMemoryChunk chunk;
+	HashJoinTuple hashTuple;
+	TupleTableSlot *slot;
+	Size		spaceUsed = 0;
+	size_t		ntuples = 0;
+	bool		fits = true;
+	uint32		hashvalue;
+
+	Assert(hashtable->buildPaused);
+	Assert(hashtable->nbatch == 1);
+	/* The skew table is only built when there are several batches */
+	Assert(hashtable->nSkewBuckets == 0);
+	hashtable->reversible = false;
+	hashtable->buildPaused = false;
+
+	rev = MemoryContextAllocZero(hashtable->hashCxt, sizeof(HashJoinReversal));
+	rev->cxt = AllocSetContextCreate(hashtable->hashCxt,
+									 "HashReversalContext",
+									 ALLOCSET_DEFAULT_SIZES);
+	hjstate->hj_Reversal = rev;
+
+	/* Move the tuples in the hash table out of the way */
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			MinimalTuple tuple;
+
+			hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			tuple = HJTUPLE_MINTUPLE(hashTuple);
+			ExecHashJoinSaveTuple(tuple, hashTuple->hashvalue,
+								  &rev->innerFile, hashtable);
+			idx += MAXALIGN(HJTUPLE_OVERHEAD + tuple->t_len);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	ExecHashTableReset(hashtable);
+
+	/*
+	 * Read the outer relation, while its tuples and a bucket array for them
+	 * fit in the hash table's memory.  Tuples that can't match because of a
+	 * NULL key are dropped, as ExecHashJoinOuterGetTuple would.
+	 */
+	slot = hjstate->hj_FirstOuterTupleSlot;
+	hjstate->hj_FirstOuterTupleSlot = NULL;
+	if (TupIsNull(slot))
+		slot = ExecProcNode(outerNode);
+	while (!TupIsNull(slot))
+	{
+		econtext->ecxt_outertuple = slot;
+		if (ExecHashGetHashValue(hashtable, econtext,
+								 hjstate->hj_OuterHashKeys,
+								 true,	/* outer tuple */
+								 false,
+								 &hashvalue))
+		{
+			bool		shouldFree;
+			MinimalTuple tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+			Size		hashTupleSize = HJTUPLE_OVERHEAD + tuple->t_len;
+
+			hashTuple = (HashJoinTuple) MemoryContextAlloc(rev->cxt,
+														   hashTupleSize);
+			hashTuple->next.unshared = NULL;
+			hashTuple->hashvalue = hashvalue;
+			memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, tuple->t_len);
+			if (shouldFree)
+				heap_free_minimal_tuple(tuple);
+
+			if (rev->outerTail != NULL)
+				rev->outerTail->next.unshared = hashTuple;
+			else
+				rev->outerHead = hashTuple;
+			rev->outerTail = hashTuple;
+
+			ntuples++;
+			spaceUsed += hashTupleSize;
+			if (spaceUsed + pg_nextpower2_size_t(ntuples) * sizeof(HashJoinTuple)
+				> hashtable->spaceAllowed)
+			{
+				fits = false;
+				break;
+			}
+		}
+		slot = ExecProcNode(outerNode);
+	}
+
+	if (fits)
+	{
+		/* Build the hash table of outer tuples */
+		rev->nbuckets = pg_nextpower2_32((uint32) Max(ntuples, 1));
+		rev->buckets = (HashJoinTuple *)
+			MemoryContextAllocZero(rev->cxt,
+								   rev->nbuckets * sizeof(HashJoinTuple));
+		hashTuple = rev->outerHead;
+		while (hashTuple != NULL)
+		{
+			HashJoinTuple nextTuple = hashTuple->next.unshared;
+			int			bucketno = hashTuple->hashvalue & (rev->nbuckets - 1);
+
+			hashTuple->next.unshared = rev->buckets[bucketno];
+			rev->buckets[bucketno] = hashTuple;
+			hashTuple = nextTuple;
+		}
+		rev->outerHead = rev->outerTail = NULL;
+
+		if (rev->innerFile != NULL &&
+			BufFileSeek(rev->innerFile, 0, 0, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-join temporary file")));
+
+		/* With no outer tuples, there's no need to read the inner relation */
+		rev->innerDone = (ntuples == 0);
+		hjstate->hj_OuterNotEmpty = (ntuples > 0);
+
+		hashtable->reversed = true;
+		hashtable->reversedTuples = ntuples;
+		hashtable->reversedSpace = spaceUsed +
+			rev->nbuckets * sizeof(HashJoinTuple);
+		return true;
+	}
+
+	/* Set the outer tuples aside, to be replayed */
+	for (hashTuple = rev->outerHead; hashTuple != NULL;
+		 hashTuple = hashTuple->next.unshared)
+		ExecHashJoinSaveTuple(HJTUPLE_MINTUPLE(hashTuple), hashTuple->hashvalue,
+							  &rev->outerFile, hashtable);
+	MemoryContextReset(rev->cxt);
+	rev->outerHead = rev->outerTail = NULL;
+	if (BufFileSeek(rev->outerFile, 0, 0, SEEK_SET))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind hash-join temporary file")));
+
+	/* ... and put the inner tuples back into the hash table */
+	if (rev->innerFile != NULL)
+	{
+		if (BufFileSeek(rev->innerFile, 0, 0, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-join temporary file")));
+
+		while ((slot = ExecHashJoinGetSavedTuple(hjstate,
+												 rev->innerFile,
+												 &hashvalue,
+												 hjstate->hj_HashTupleSlot)))
+			ExecHashTableInsert(hashtable, slot, hashvalue);
+
+		BufFileClose(rev->innerFile);
+		rev->innerFile = NULL;
+	}
+
+	return false;
+}
+
+/*
+ * ExecHashJoinReversedGetInner
+ *		get the next inner tuple, after the roles of the inputs have been
+ *		swapped.  Return NULL if no more.
+ *
+ * The tuples written out by ExecHashJoinTryReverse() come first, then the
+ * rest of the Hash node's input.  The tuple is returned in hj_HashTupleSlot,
+ * as when scanning the hash table, and *hashvalue is set to its hash value.
+ */
+static TupleTableSlot *
+ExecHashJoinReversedGetInner(HashJoinState *hjstate, uint32 *hashvalue)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinReversal *rev = hjstate->hj_Reversal;
+	HashState  *hashNode = castNode(HashState, innerPlanState(hjstate));
+	ExprContext *econtext = hashNode->ps.ps_ExprContext;
+	TupleTableSlot *slot;
+
+	if (rev->innerDone)
+		return NULL;
+
+	if (rev->innerFile != NULL)
+	{
+		slot = ExecHashJoinGetSavedTuple(hjstate,
+										 rev->innerFile,
+										 hashvalue,
+										 hjstate->hj_HashTupleSlot);
+		if (!TupIsNull(slot))
+			return slot;
+		BufFileClose(rev->innerFile);
+		rev->innerFile = NULL;
+	}
+
+	for (;;)
+	{
+		slot = ExecProcNode(outerPlanState(hashNode));
+		if (TupIsNull(slot))
+			break;
+
+		/* Compute the hash value, as MultiExecPrivateHash would */
+		econtext->ecxt_outertuple = slot;
+		if (ExecHashGetHashValue(hashtable, econtext, hashNode->hashkeys,
+								 false, false, hashvalue))
+		{
+			bool		shouldFree;
+			MinimalTuple tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+			hashtable->totalTuples += 1;
+			return ExecStoreMinimalTuple(tuple, hjstate->hj_HashTupleSlot,
+										 shouldFree);
+		}
+	}
+
+	rev->innerDone = true;
+	return NULL;
+}
+
+/*
+ * ExecHashJoinReversedScanBucket
+ *		scan the hash table of outer tuples for matches to the current
+ *		inner tuple
+ *
+ * This is the counterpart of ExecScanHashBucket() for a join whose inputs
+ * have swapped roles.  On success, the matching outer tuple is stored in
+ * hj_OuterTupleSlot and econtext's outer tuple, and hj_CurTuple remembers
+ * where to continue the search.
+ */
+static bool
+ExecHashJoinReversedScanBucket(HashJoinState *hjstate, ExprContext *econtext)
+{
+	HashJoinReversal *rev = hjstate->hj_Reversal;
+	ExprState  *hjclauses = hjstate->hashclauses;
+	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
+	uint32		hashvalue = hjstate->hj_CurHashValue;
+
+	/*
+	 * hj_CurTuple is the address of the tuple last matched to the current
+	 * inner tuple, or NULL if it's time to start scanning a new bucket.
+	 */
+	if (hashTuple != NULL)
+		hashTuple = hashTuple->next.unshared;
+	else
+		hashTuple = rev->buckets[hashvalue & (rev->nbuckets - 1)];
+
+	while (hashTuple != NULL)
+	{
+		if (hashTuple->hashvalue == hashvalue)
+		{
+			/* insert hashtable's tuple into exec slot so ExecQual sees it */
+			ExecForceStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+									   hjstate->hj_OuterTupleSlot,
+									   false);	/* do not pfree */
+			econtext->ecxt_outertuple = hjstate->hj_OuterTupleSlot;
+
+			if (ExecQualAndReset(hjclauses, econtext))
+			{
+				hjstate->hj_CurTuple = hashTuple;
+				return true;
+			}
+		}
+
+		hashTuple = hashTuple->next.unshared;
+	}
+
+	/*
+	 * no match
+	 */
+	return false;
+}
+
+/*
+ * ExecHashJoinEndReversal
+ *		release the state used to swap the roles of the inputs, if any
+ */
+static void
+ExecHashJoinEndReversal(HashJoinState *hjstate)
+{
+	HashJoinReversal *rev = hjstate->hj_Reversal;
+
+	if (rev == NULL)
+		return;
+
+	if (rev->innerFile != NULL)
+		BufFileClose(rev->innerFile);
+	if (rev->outerFile != NULL)
+		BufFileClose(rev->outerFile);
+	MemoryContextDelete(rev->cxt);
+	pfree(rev);
+	hjstate->hj_Reversal = NULL;
+}
+
 
 void
 ExecReScanHashJoin(HashJoinState *node)
@@ -1414,12 +2003,18 @@ ExecReScanHashJoin(HashJoinState *node)
 	 * primarily because batch temp files may have already been released. But
 	 * if it's a single-batch join, and there is no parameter change for the
 	 * inner subnode, then we can just re-use the existing hash table without
-	 * rebuilding it.
+	 * rebuilding it.  That's not possible if the roles of the inputs were
+	 * swapped, since then the hash table was never completed.
 	 */
 	if (node->hj_HashTable != NULL)
 	{
+		bool		reversed = node->hj_HashTable->reversed;
+
+		ExecHashJoinEndReversal(node);
+
 		if (node->hj_HashTable->nbatch == 1 &&
-			innerPlan->chgParam == NULL)
+			innerPlan->chgParam == NULL &&
+			!reversed)
 		{
 			/*
 			 * Okay to reuse the hash table; needn't rescan inner, either.
@@ -1474,6 +2069,9 @@ ExecReScanHashJoin(HashJoinState *node)
 		}
 	}
 
+	/* Forget any outer tuples read ahead */
+	ExecHashJoinResetPrefetch(node);
+
 	/* Always reset intra-tuple state */
 	node->hj_CurHashValue = 0;
 	node->hj_CurBucketNo = 0;
@@ -50,6 +50,23 @@
  * demanding, then that may allow us to start putting useful entries back into
  * the cache again.
  *
+ * A Parallel Memoize node shares one cache between all participants of a
+ * parallel query, so that a worker can use results that another worker has
+ * already cached.  The cache is a dshash table in the query's DSA area, and
+ * its memory budget is hash_mem for each participant, as for Parallel Hash.
+ * A participant that misses inserts a pinned, incomplete entry and fills it
+ * as it reads its subplan.  Nobody else reads the entry until it's marked
+ * complete, and a participant that misses on an entry that's still being
+ * filled simply runs its subplan without caching.  Entries can't be kept in
+ * an LRU list, since that would need a lock shared by all participants on
+ * every lookup.  Instead each entry records the value of a shared clock at
+ * its last lookup.  When the cache exceeds its budget, one participant
+ * sorts the clock values of all unpinned entries and evicts the least
+ * recently used entries until the cache is back below 90% of the budget.
+ * This is only done when all the Params that the subplan depends on are
+ * cache keys.  Otherwise, the results for a given key could differ between
+ * participants, and we fall back on a cache local to each participant.
+ *
  *
  * INTERFACE ROUTINES
  *		ExecMemoize			- lookup cache, exec subplan when not found
@@ -61,6 +78,7 @@
  *		ExecMemoizeInitializeDSM initialize DSM for parallel plan
  *		ExecMemoizeInitializeWorker attach to DSM info in parallel worker
  *		ExecMemoizeRetrieveInstrumentation get instrumentation from worker
+ *		ExecShutdownMemoize		detach from the shared cache
  *-------------------------------------------------------------------------
  */
 
@@ -69,9 +87,13 @@
 #include "common/hashfn.h"
 #include "executor/executor.h"
 #include "executor/nodeMemoize.h"
+#include "lib/dshash.h"
 #include "lib/ilist.h"
 #include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
 #include "utils/datum.h"
+#include "utils/dsa.h"
 #include "utils/lsyscache.h"
 
 /* States of the ExecMemoize state machine */
@@ -89,6 +111,21 @@
 										 (e)->key->params->t_len);
 #define CACHE_TUPLE_BYTES(t)			(sizeof(MemoizeTuple) + \
 										 (t)->mintuple->t_len)
+#define SHARED_ENTRY_BYTES(params)		(sizeof(MemoizeSharedEntry) + \
+										 (params)->t_len)
+#define SHARED_TUPLE_BYTES(mintuple)	(MAXALIGN(sizeof(MemoizeSharedTuple)) + \
+										 (mintuple)->t_len)
+
+/* Get the MinimalTuple stored in a MemoizeSharedTuple */
+#define SHARED_TUPLE_DATA(t) \
+	((MinimalTuple) ((char *) (t) + MAXALIGN(sizeof(MemoizeSharedTuple))))
+
+/*
+ * When a shared cache goes over budget, evict entries until it's using no
+ * more than this much of its budget, so that we needn't evict again for a
+ * while.
+ */
+#define SHARED_EVICT_TARGET(limit)		((limit) / 10 * 9)
 
  /* MemoizeTuple Stores an individually cached tuple */
 typedef struct MemoizeTuple
@@ -130,6 +167,70 @@ typedef struct MemoizeEntry
 #define SH_DECLARE
 #include "lib/simplehash.h"
 
+/*
+ * ParallelMemoizeCache
+ *		Shared state of a Parallel Memoize node's cache, in the DSA area
+ */
+typedef struct ParallelMemoizeCache
+{
+	dshash_table_handle handle; /* hash table of MemoizeSharedEntry */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	pg_atomic_uint64 mem_used;	/* bytes of memory used by cache */
+	pg_atomic_uint64 clock;		/* advanced by every lookup */
+	LWLock		evict_lock;		/* held while evicting entries */
+} ParallelMemoizeCache;
+
+/*
+ * MemoizeSharedKey
+ *		The hash table key for shared cache entries
+ *
+ * The key of an entry points to a MinimalTuple holding the key values.  A key
+ * that's only used for a lookup has an invalid 'params' pointer instead, and
+ * the values to look up are in the MemoizeState's probeslot.
+ */
+typedef struct MemoizeSharedKey
+{
+	uint32		hash;			/* hash of the key values */
+	dsa_pointer params;			/* MinimalTuple of the key values */
+} MemoizeSharedKey;
+
+/*
+ * MemoizeSharedTuple
+ *		An individually cached tuple in a shared cache.  The MinimalTuple
+ *		follows the header.
+ */
+typedef struct MemoizeSharedTuple
+{
+	dsa_pointer next;			/* The next tuple with the same parameter
+								 * values or InvalidDsaPointer */
+} MemoizeSharedTuple;
+
+/*
+ * MemoizeSharedEntry
+ *		The data struct that a shared cache's hash table stores
+ *
+ * An entry can't be evicted while it's pinned.  Only the participant that
+ * pinned an incomplete entry may add tuples to it, and nobody may read its
+ * tuples until it's complete.
+ */
+typedef struct MemoizeSharedEntry
+{
+	MemoizeSharedKey key;		/* Hash key; must be first */
+	dsa_pointer tuplehead;		/* The first MemoizeSharedTuple, or
+								 * InvalidDsaPointer */
+	uint64		mem;			/* bytes used by the entry and its tuples */
+	pg_atomic_uint64 last_used; /* cache clock at the last lookup */
+	pg_atomic_uint32 pins;		/* number of participants using the entry */
+	bool		complete;		/* Did we read the outer plan to completion? */
+} MemoizeSharedEntry;
+
+/* An unpinned entry that cache_shared_reduce_memory() might evict */
+typedef struct MemoizeEvictCandidate
+{
+	uint64		last_used;
+	uint64		mem;
+} MemoizeEvictCandidate;
+
 static uint32 MemoizeHash_hash(struct memoize_hash *tb,
 							   const MemoizeKey *key);
 static bool MemoizeHash_equal(struct memoize_hash *tb,
@@ -149,15 +250,12 @@ static bool MemoizeHash_equal(struct memoize_hash *tb,
 #include "lib/simplehash.h"
 
 /*
- * MemoizeHash_hash
- *		Hash function for simplehash hashtable.  'key' is unused here as we
- *		require that all table lookups first populate the MemoizeState's
- *		probeslot with the key values to be looked up.
+ * memoize_hash_probeslot
+ *		Compute the hash value of the key values in mstate's probeslot.
  */
 static uint32
-MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
+memoize_hash_probeslot(MemoizeState *mstate)
 {
-	MemoizeState *mstate = (MemoizeState *) tb->private_data;
 	TupleTableSlot *pslot = mstate->probeslot;
 	uint32		hashkey = 0;
 	int			numkeys = mstate->nkeys;
@@ -207,22 +305,19 @@ MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
 }
 
 /*
- * MemoizeHash_equal
- *		Equality function for confirming hash value matches during a hash
- *		table lookup.  'key2' is never used.  Instead the MemoizeState's
- *		probeslot is always populated with details of what's being looked up.
+ * memoize_probeslot_equal
+ *		Check if the key values in 'params' are the same as those in mstate's
+ *		probeslot.
  */
 static bool
-MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
-				  const MemoizeKey *key2)
+memoize_probeslot_equal(MemoizeState *mstate, MinimalTuple params)
 {
-	MemoizeState *mstate = (MemoizeState *) tb->private_data;
 	ExprContext *econtext = mstate->ss.ps.ps_ExprContext;
 	TupleTableSlot *tslot = mstate->tableslot;
 	TupleTableSlot *pslot = mstate->probeslot;
 
 	/* probeslot should have already been prepared by prepare_probe_slot() */
-	ExecStoreMinimalTuple(key1->params, tslot, false);
+	ExecStoreMinimalTuple(params, tslot, false);
 
 	if (mstate->binary_mode)
 	{
@@ -258,6 +353,76 @@ MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
 	}
 }
 
+/*
+ * MemoizeHash_hash
+ *		Hash function for simplehash hashtable.  'key' is unused here as we
+ *		require that all table lookups first populate the MemoizeState's
+ *		probeslot with the key values to be looked up.
+ */
+static uint32
+MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
+{
+	return memoize_hash_probeslot((MemoizeState *) tb->private_data);
+}
+
+/*
+ * MemoizeHash_equal
+ *		Equality function for confirming hash value matches during a hash
+ *		table lookup.  'key2' is never used.  Instead the MemoizeState's
+ *		probeslot is always populated with details of what's being looked up.
+ */
+static bool
+MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
+				  const MemoizeKey *key2)
+{
+	return memoize_probeslot_equal((MemoizeState *) tb->private_data,
+								   key1->params);
+}
+
+/*
+ * MemoizeShared_hash
+ *		Hash function for a shared cache's dshash table.  Lookup keys carry
+ *		the hash value of the probeslot, which we computed beforehand.
+ */
+static dshash_hash
+MemoizeShared_hash(const void *key, size_t size, void *arg)
+{
+	return ((const MemoizeSharedKey *) key)->hash;
+}
+
+/*
+ * MemoizeShared_compare
+ *		Comparison function for a shared cache's dshash table.  dshash passes
+ *		the key being looked up as 'a' and the key of an entry as 'b'.  As
+ *		with the local cache, the values being looked up are in the
+ *		MemoizeState's probeslot.
+ */
+static int
+MemoizeShared_compare(const void *a, const void *b, size_t size, void *arg)
+{
+	const MemoizeSharedKey *lookupkey = (const MemoizeSharedKey *) a;
+	const MemoizeSharedKey *entrykey = (const MemoizeSharedKey *) b;
+	MemoizeState *mstate = (MemoizeState *) arg;
+
+	if (lookupkey->hash != entrykey->hash)
+		return 1;
+
+	Assert(!DsaPointerIsValid(lookupkey->params));
+	Assert(DsaPointerIsValid(entrykey->params));
+
+	return memoize_probeslot_equal(mstate,
+								   dsa_get_address(mstate->shared_area,
+												   entrykey->params)) ? 0 : 1;
+}
+
+static const dshash_parameters memoize_shared_params = {
+	sizeof(MemoizeSharedKey),
+	sizeof(MemoizeSharedEntry),
+	MemoizeShared_compare,
+	MemoizeShared_hash,
+	LWTRANCHE_PARALLEL_MEMOIZE
+};
+
 /*
  * Initialize the hash table to empty.
  */
@@ -671,6 +836,544 @@ cache_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
 	return true;
 }
 
+/*
+ * cache_shared_purge_tuples
+ *		Remove all tuples from the shared cache entry 'entry', leaving an
+ *		empty cache entry, and update the memory accounting.  The caller must
+ *		either have pinned the entry, or hold an exclusive lock on it while
+ *		nobody has it pinned.
+ */
+static void
+cache_shared_purge_tuples(MemoizeState *mstate, MemoizeSharedEntry *entry)
+{
+	dsa_area   *area = mstate->shared_area;
+	dsa_pointer tuplep = entry->tuplehead;
+	uint64		freed_mem = 0;
+
+	while (DsaPointerIsValid(tuplep))
+	{
+		MemoizeSharedTuple *tuple = dsa_get_address(area, tuplep);
+		dsa_pointer next = tuple->next;
+
+		freed_mem += SHARED_TUPLE_BYTES(SHARED_TUPLE_DATA(tuple));
+		dsa_free(area, tuplep);
+		tuplep = next;
+	}
+
+	entry->complete = false;
+	entry->tuplehead = InvalidDsaPointer;
+	entry->mem -= freed_mem;
+
+	pg_atomic_sub_fetch_u64(&mstate->shared_cache->mem_used, freed_mem);
+}
+
+/*
+ * cache_shared_release_entry
+ *		Unpin the shared cache entry used by the current scan, if any.
+ */
+static void
+cache_shared_release_entry(MemoizeState *mstate)
+{
+	if (mstate->shared_entry == NULL)
+		return;
+
+	/* The result slot may point to one of the entry's tuples */
+	ExecClearTuple(mstate->ss.ps.ps_ResultTupleSlot);
+
+	pg_atomic_fetch_sub_u32(&mstate->shared_entry->pins, 1);
+	mstate->shared_entry = NULL;
+	mstate->shared_last_tuple = InvalidDsaPointer;
+}
+
+static int
+evict_candidate_cmp(const void *a, const void *b)
+{
+	uint64		a_last_used = ((const MemoizeEvictCandidate *) a)->last_used;
+	uint64		b_last_used = ((const MemoizeEvictCandidate *) b)->last_used;
+
+	if (a_last_used < b_last_used)
+		return -1;
+	if (a_last_used > b_last_used)
+		return 1;
+	return 0;
+}
+
+/*
+ * cache_shared_reduce_memory
+ *		Evict the least recently used unpinned entries from the shared cache,
+ *		until it uses no more than SHARED_EVICT_TARGET of its budget.
+ *
+ * Only one participant evicts at a time.  If someone else is already doing
+ * it, we just carry on, as they'll free enough memory for us too.
+ */
+static void
+cache_shared_reduce_memory(MemoizeState *mstate)
+{
+	ParallelMemoizeCache *cache = mstate->shared_cache;
+	dshash_seq_status status;
+	MemoizeSharedEntry *entry;
+	MemoizeEvictCandidate *candidates;
+	int			ncandidates = 0;
+	int			maxcandidates = 64;
+	uint64		mem_used;
+	uint64		target;
+	uint64		cutoff = 0;
+	uint64		evictions = 0;
+	int			i;
+
+	if (!LWLockConditionalAcquire(&cache->evict_lock, LW_EXCLUSIVE))
+		return;
+
+	/* Someone else may have evicted entries since we looked */
+	mem_used = pg_atomic_read_u64(&cache->mem_used);
+	if (mem_used <= cache->mem_limit)
+	{
+		LWLockRelease(&cache->evict_lock);
+		return;
+	}
+	target = SHARED_EVICT_TARGET(cache->mem_limit);
+
+	/*
+	 * First, find the clock value at or below which all unpinned entries must
+	 * go to bring the cache down to the target.
+	 */
+	candidates = palloc(sizeof(MemoizeEvictCandidate) * maxcandidates);
+	dshash_seq_init(&status, mstate->shared_table, false);
+	while ((entry = dshash_seq_next(&status)) != NULL)
+	{
+		if (pg_atomic_read_u32(&entry->pins) > 0)
+			continue;
+
+		if (ncandidates == maxcandidates)
+		{
+			maxcandidates *= 2;
+			candidates = repalloc_huge(candidates,
+									   sizeof(MemoizeEvictCandidate) *
+									   maxcandidates);
+		}
+		candidates[ncandidates].last_used =
+			pg_atomic_read_u64(&entry->last_used);
+		candidates[ncandidates].mem = entry->mem;
+		ncandidates++;
+	}
+	dshash_seq_term(&status);
+
+	qsort(candidates, ncandidates, sizeof(MemoizeEvictCandidate),
+		  evict_candidate_cmp);
+
+	for (i = 0; i < ncandidates && mem_used > target; i++)
+	{
+		mem_used -= Min(mem_used, candidates[i].mem);
+		cutoff = candidates[i].last_used;
+	}
+	pfree(candidates);
+
+	/*
+	 * Now evict those entries.  Any that were looked up in the meantime have
+	 * a later clock value and survive.
+	 */
+	if (i > 0)
+	{
+		dsa_area   *area = mstate->shared_area;
+
+		dshash_seq_init(&status, mstate->shared_table, true);
+		while ((entry = dshash_seq_next(&status)) != NULL)
+		{
+			if (pg_atomic_read_u32(&entry->pins) > 0 ||
+				pg_atomic_read_u64(&entry->last_used) > cutoff)
+				continue;
+
+			cache_shared_purge_tuples(mstate, entry);
+			pg_atomic_sub_fetch_u64(&cache->mem_used, entry->mem);
+			dsa_free(area, entry->key.params);
+			dshash_delete_current(&status);
+			evictions++;
+		}
+		dshash_seq_term(&status);
+	}
+
+	LWLockRelease(&cache->evict_lock);
+
+	mstate->stats.cache_evictions += evictions; /* Update Stats */
+}
+
+/*
+ * cache_shared_lookup
+ *		Look up the scan's current parameters in the shared cache.
+ *
+ * If we find a complete entry, we set *found to true and return it.  If
+ * there's no entry, or only one that somebody started filling but abandoned,
+ * we set *found to false and return an empty entry for us to fill.  Either
+ * way, the entry is pinned until cache_shared_release_entry() is called.  If
+ * another participant is currently filling the entry, we return NULL.
+ */
+static MemoizeSharedEntry *
+cache_shared_lookup(MemoizeState *mstate, bool *found)
+{
+	ParallelMemoizeCache *cache = mstate->shared_cache;
+	dshash_table *table = mstate->shared_table;
+	MemoizeSharedKey key;
+	MemoizeSharedEntry *entry;
+	bool		found_entry;
+	uint64		now;
+
+	/* prepare the probe slot with the current scan parameters */
+	prepare_probe_slot(mstate, NULL);
+
+	key.hash = memoize_hash_probeslot(mstate);
+	key.params = InvalidDsaPointer;
+
+	now = pg_atomic_fetch_add_u64(&cache->clock, 1);
+
+	/* Cache hits only need a shared lock */
+	entry = dshash_find(table, &key, false);
+	if (entry == NULL || !entry->complete)
+	{
+		if (entry != NULL)
+			dshash_release_lock(table, entry);
+
+		entry = dshash_find_or_insert(table, &key, &found_entry);
+		if (!found_entry)
+		{
+			dsa_area   *area = mstate->shared_area;
+			MinimalTuple params;
+
+			params = ExecCopySlotMinimalTuple(mstate->probeslot);
+			entry->key.params = dsa_allocate(area, params->t_len);
+			memcpy(dsa_get_address(area, entry->key.params), params,
+				   params->t_len);
+			entry->tuplehead = InvalidDsaPointer;
+			entry->mem = SHARED_ENTRY_BYTES(params);
+			pg_atomic_init_u64(&entry->last_used, now);
+			pg_atomic_init_u32(&entry->pins, 0);
+			entry->complete = false;
+			pfree(params);
+
+			pg_atomic_add_fetch_u64(&cache->mem_used, entry->mem);
+		}
+		else if (!entry->complete)
+		{
+			if (pg_atomic_read_u32(&entry->pins) > 0)
+			{
+				/* Somebody else is filling it */
+				dshash_release_lock(table, entry);
+				*found = false;
+				return NULL;
+			}
+
+			/*
+			 * Whoever started filling this entry didn't run the scan to
+			 * completion.  As in the local case, start again rather than
+			 * continue where they left off.
+			 */
+			cache_shared_purge_tuples(mstate, entry);
+		}
+	}
+
+	pg_atomic_fetch_add_u32(&entry->pins, 1);
+	pg_atomic_write_u64(&entry->last_used, now);
+	*found = entry->complete;
+	dshash_release_lock(table, entry);
+
+	mstate->shared_entry = entry;
+	mstate->shared_last_tuple = InvalidDsaPointer;
+
+	if (*found)
+	{
+		/* Pairs with the write barrier in cache_shared_complete_entry() */
+		pg_read_barrier();
+	}
+	else if (pg_atomic_read_u64(&cache->mem_used) > cache->mem_limit)
+		cache_shared_reduce_memory(mstate);
+
+	return entry;
+}
+
+/*
+ * cache_shared_store_tuple
+ *		Add the tuple stored in 'slot' to the shared cache entry that we're
+ *		filling.  Returns false if the entry would take more than the whole
+ *		cache's budget, in which case we don't store it.
+ */
+static bool
+cache_shared_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
+{
+	ParallelMemoizeCache *cache = mstate->shared_cache;
+	MemoizeSharedEntry *entry = mstate->shared_entry;
+	dsa_area   *area = mstate->shared_area;
+	MinimalTuple mintuple;
+	MemoizeSharedTuple *tuple;
+	dsa_pointer tuplep;
+	uint64		tuple_mem;
+	uint64		mem_used;
+	bool		shouldFree;
+
+	Assert(entry != NULL && !entry->complete);
+
+	mintuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	tuple_mem = SHARED_TUPLE_BYTES(mintuple);
+
+	if (entry->mem + tuple_mem > cache->mem_limit)
+	{
+		if (shouldFree)
+			pfree(mintuple);
+		return false;
+	}
+
+	tuplep = dsa_allocate(area, tuple_mem);
+	tuple = dsa_get_address(area, tuplep);
+	tuple->next = InvalidDsaPointer;
+	memcpy(SHARED_TUPLE_DATA(tuple), mintuple, mintuple->t_len);
+
+	if (shouldFree)
+		pfree(mintuple);
+
+	/* push this tuple onto the tail of the list */
+	if (!DsaPointerIsValid(mstate->shared_last_tuple))
+		entry->tuplehead = tuplep;
+	else
+	{
+		MemoizeSharedTuple *last;
+
+		last = dsa_get_address(area, mstate->shared_last_tuple);
+		last->next = tuplep;
+	}
+	mstate->shared_last_tuple = tuplep;
+
+	/* Account for the memory we just consumed */
+	entry->mem += tuple_mem;
+	mem_used = pg_atomic_add_fetch_u64(&cache->mem_used, tuple_mem);
+
+	/* Update peak memory usage */
+	if (mem_used > mstate->stats.mem_peak)
+		mstate->stats.mem_peak = mem_used;
+
+	if (mem_used > cache->mem_limit)
+		cache_shared_reduce_memory(mstate);
+
+	return true;
+}
+
+/*
+ * cache_shared_complete_entry
+ *		Mark the shared cache entry that we're filling as complete, making it
+ *		available to the other participants.
+ */
+static void
+cache_shared_complete_entry(MemoizeState *mstate)
+{
+	/* Make sure the tuples are visible before the entry is complete */
+	pg_write_barrier();
+	mstate->shared_entry->complete = true;
+}
+
+/*
+ * ExecMemoizeShared
+ *		ExecMemoize for a Parallel Memoize node.  The state machine is the
+ *		same as for the local cache.
+ */
+static TupleTableSlot *
+ExecMemoizeShared(MemoizeState *node)
+{
+	PlanState  *outerNode;
+	TupleTableSlot *slot;
+
+	switch (node->mstatus)
+	{
+		case MEMO_CACHE_LOOKUP:
+			{
+				MemoizeSharedEntry *entry;
+				TupleTableSlot *outerslot;
+				bool		found;
+
+				Assert(node->shared_entry == NULL);
+
+				entry = cache_shared_lookup(node, &found);
+
+				if (found)
+				{
+					node->stats.cache_hits += 1;	/* stats update */
+
+					/* Fetch the first cached tuple, if there is one */
+					if (DsaPointerIsValid(entry->tuplehead))
+					{
+						MemoizeSharedTuple *tuple;
+
+						node->shared_last_tuple = entry->tuplehead;
+						node->mstatus = MEMO_CACHE_FETCH_NEXT_TUPLE;
+
+						tuple = dsa_get_address(node->shared_area,
+												entry->tuplehead);
+						slot = node->ss.ps.ps_ResultTupleSlot;
+						ExecStoreMinimalTuple(SHARED_TUPLE_DATA(tuple), slot,
+											  false);
+
+						return slot;
+					}
+
+					/* The cache entry is void of any tuples. */
+					cache_shared_release_entry(node);
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				/* Handle cache miss */
+				node->stats.cache_misses += 1;	/* stats update */
+
+				/* Scan the outer node for a tuple to cache */
+				outerNode = outerPlanState(node);
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/*
+					 * cache_shared_lookup returns NULL when somebody else is
+					 * filling the entry, in which case we leave it to them.
+					 */
+					if (likely(entry))
+					{
+						cache_shared_complete_entry(node);
+						cache_shared_release_entry(node);
+					}
+
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				if (entry == NULL)
+				{
+					/* Read the subplan without caching, but not an overflow */
+					node->mstatus = MEMO_CACHE_BYPASS_MODE;
+				}
+				else if (unlikely(!cache_shared_store_tuple(node, outerslot)))
+				{
+					node->stats.cache_overflows += 1;	/* stats update */
+
+					/* Empty the entry, so that somebody can try again */
+					cache_shared_purge_tuples(node, entry);
+					cache_shared_release_entry(node);
+					node->mstatus = MEMO_CACHE_BYPASS_MODE;
+				}
+				else
+				{
+					/*
+					 * If we only expect a single row from this scan then we
+					 * can mark that we're not expecting more.
+					 */
+					if (node->singlerow)
+						cache_shared_complete_entry(node);
+					node->mstatus = MEMO_FILLING_CACHE;
+				}
+
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_CACHE_FETCH_NEXT_TUPLE:
+			{
+				MemoizeSharedTuple *tuple;
+
+				/* We shouldn't be in this state if these are not set */
+				Assert(node->shared_entry != NULL);
+				Assert(DsaPointerIsValid(node->shared_last_tuple));
+
+				/* Skip to the next tuple to output */
+				tuple = dsa_get_address(node->shared_area,
+										node->shared_last_tuple);
+				node->shared_last_tuple = tuple->next;
+
+				/* No more tuples in the cache */
+				if (!DsaPointerIsValid(node->shared_last_tuple))
+				{
+					cache_shared_release_entry(node);
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				tuple = dsa_get_address(node->shared_area,
+										node->shared_last_tuple);
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecStoreMinimalTuple(SHARED_TUPLE_DATA(tuple), slot, false);
+
+				return slot;
+			}
+
+		case MEMO_FILLING_CACHE:
+			{
+				TupleTableSlot *outerslot;
+				MemoizeSharedEntry *entry = node->shared_entry;
+
+				/* entry should already have been set by MEMO_CACHE_LOOKUP */
+				Assert(entry != NULL);
+
+				outerNode = outerPlanState(node);
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/* No more tuples.  Mark it as complete */
+					if (!entry->complete)
+						cache_shared_complete_entry(node);
+					cache_shared_release_entry(node);
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				/*
+				 * Validate if the planner properly set the singlerow flag. It
+				 * should only set that if each cache entry can, at most,
+				 * return 1 row.
+				 */
+				if (unlikely(entry->complete))
+					elog(ERROR, "cache entry already complete");
+
+				/* Record the tuple in the current cache entry */
+				if (unlikely(!cache_shared_store_tuple(node, outerslot)))
+				{
+					/* Couldn't store it?  Handle overflow */
+					node->stats.cache_overflows += 1;	/* stats update */
+
+					cache_shared_purge_tuples(node, entry);
+					cache_shared_release_entry(node);
+					node->mstatus = MEMO_CACHE_BYPASS_MODE;
+				}
+
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_CACHE_BYPASS_MODE:
+			{
+				TupleTableSlot *outerslot;
+
+				outerNode = outerPlanState(node);
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				slot = node->ss.ps.ps_ResultTupleSlot;
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_END_OF_SCAN:
+
+			/*
+			 * We've already returned NULL for this scan, but just in case
+			 * something calls us again by mistake.
+			 */
+			return NULL;
+
+		default:
+			elog(ERROR, "unrecognized memoize state: %d",
+				 (int) node->mstatus);
+			return NULL;
+	}							/* switch */
+}
+
 static TupleTableSlot *
 ExecMemoize(PlanState *pstate)
 {
@@ -678,6 +1381,9 @@ ExecMemoize(PlanState *pstate)
 	PlanState  *outerNode;
 	TupleTableSlot *slot;
 
+	if (node->shared_cache != NULL)
+		return ExecMemoizeShared(node);
+
 	switch (node->mstatus)
 	{
 		case MEMO_CACHE_LOOKUP:
@@ -1032,6 +1738,13 @@ ExecInitMemoize(Memoize *node, EState *estate, int eflags)
 	/* Zero the statistics counters */
 	memset(&mstate->stats, 0, sizeof(MemoizeInstrumentation));
 
+	/* A Parallel Memoize node sets these up in ExecMemoizeInitializeDSM */
+	mstate->shared_cache = NULL;
+	mstate->shared_table = NULL;
+	mstate->shared_area = NULL;
+	mstate->shared_entry = NULL;
+	mstate->shared_last_tuple = InvalidDsaPointer;
+
 	/* Allocate and set up the actual cache */
 	build_hash_table(mstate, node->est_entries);
 
@@ -1117,6 +1830,7 @@ ExecReScanMemoize(MemoizeState *node)
 	/* nullify pointers used for the last scan */
 	node->entry = NULL;
 	node->last_tuple = NULL;
+	cache_shared_release_entry(node);
 
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
@@ -1150,10 +1864,25 @@ ExecEstimateCacheEntryOverheadBytes(double ntuples)
  * ----------------------------------------------------------------
  */
 
+/*
+ * Can this node share its cache with the other participants?  Only if the
+ * planner asked for it, and the subplan's results don't depend on any Params
+ * other than the cache keys, which could differ between participants.
+ */
+static bool
+memoize_can_share(MemoizeState *node)
+{
+	Plan	   *plan = node->ss.ps.plan;
+
+	return plan->parallel_aware &&
+		bms_is_subset(outerPlan(plan)->extParam, node->keyparamids);
+}
+
  /* ----------------------------------------------------------------
   *		ExecMemoizeEstimate
   *
-  *		Estimate space required to propagate memoize statistics.
+  *		Estimate space required to propagate memoize statistics and
+  *		to find a shared cache.
   * ----------------------------------------------------------------
   */
 void
@@ -1161,8 +1890,9 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need this if not instrumenting or sharing, or no workers */
+	if ((!node->ss.ps.instrument && !memoize_can_share(node)) ||
+		pcxt->nworkers == 0)
 		return;
 
 	size = mul_size(pcxt->nworkers, sizeof(MemoizeInstrumentation));
@@ -1174,7 +1904,8 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeDSM
  *
- *		Initialize DSM space for memoize statistics.
+ *		Initialize DSM space for memoize statistics, and create the
+ *		shared cache for a Parallel Memoize node.
  * ----------------------------------------------------------------
  */
 void
@@ -1182,8 +1913,9 @@ ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need this if not instrumenting or sharing, or no workers */
+	if ((!node->ss.ps.instrument && !memoize_can_share(node)) ||
+		pcxt->nworkers == 0)
 		return;
 
 	size = offsetof(SharedMemoizeInfo, sinstrument)
@@ -1192,6 +1924,30 @@ ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 	/* ensure any unfilled slots will contain zeroes */
 	memset(node->shared_info, 0, size);
 	node->shared_info->num_workers = pcxt->nworkers;
+	node->shared_info->shared_cache = InvalidDsaPointer;
+
+	if (memoize_can_share(node))
+	{
+		dsa_area   *area = node->ss.ps.state->es_query_dsa;
+		ParallelMemoizeCache *cache;
+		dsa_pointer cachep;
+
+		cachep = dsa_allocate(area, sizeof(ParallelMemoizeCache));
+		cache = dsa_get_address(area, cachep);
+
+		/* As for Parallel Hash, each participant brings its hash_mem */
+		cache->mem_limit = node->mem_limit * (pcxt->nworkers + 1);
+		pg_atomic_init_u64(&cache->mem_used, 0);
+		pg_atomic_init_u64(&cache->clock, 0);
+		LWLockInitialize(&cache->evict_lock, LWTRANCHE_PARALLEL_MEMOIZE);
+
+		node->shared_area = area;
+		node->shared_table = dshash_create(area, &memoize_shared_params, node);
+		cache->handle = dshash_get_hash_table_handle(node->shared_table);
+		node->shared_cache = cache;
+		node->shared_info->shared_cache = cachep;
+	}
+
 	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id,
 				   node->shared_info);
 }
@@ -1199,7 +1955,8 @@ ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeWorker
  *
- *		Attach worker to DSM space for memoize statistics.
+ *		Attach worker to DSM space for memoize statistics, and to the
+ *		shared cache of a Parallel Memoize node.
  * ----------------------------------------------------------------
  */
 void
@@ -1207,6 +1964,18 @@ ExecMemoizeInitializeWorker(MemoizeState *node, ParallelWorkerContext *pwcxt)
 {
 	node->shared_info =
 		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+
+	if (node->shared_info != NULL &&
+		DsaPointerIsValid(node->shared_info->shared_cache))
+	{
+		dsa_area   *area = node->ss.ps.state->es_query_dsa;
+
+		node->shared_area = area;
+		node->shared_cache = dsa_get_address(area,
+											 node->shared_info->shared_cache);
+		node->shared_table = dshash_attach(area, &memoize_shared_params,
+										   node->shared_cache->handle, node);
+	}
 }
 
 /* ----------------------------------------------------------------
@@ -1230,3 +1999,23 @@ ExecMemoizeRetrieveInstrumentation(MemoizeState *node)
 	memcpy(si, node->shared_info, size);
 	node->shared_info = si;
 }
+
+/* ----------------------------------------------------------------
+ *		ExecShutdownMemoize
+ *
+ *		Let go of the shared cache before the DSA area goes away.
+ * ----------------------------------------------------------------
+ */
+void
+ExecShutdownMemoize(MemoizeState *node)
+{
+	if (node->shared_table == NULL)
+		return;
+
+	cache_shared_release_entry(node);
+	dshash_detach(node->shared_table);
+
+	node->shared_table = NULL;
+	node->shared_cache = NULL;
+	node->shared_area = NULL;
+}
@@ -64,6 +64,14 @@
 #include "utils/rel.h"
 
 
+/*
+ * Limits on the rows buffered for multi-insert into local tables, over all
+ * the result relations of a ModifyTable node.  These are the same limits
+ * COPY FROM uses; see copyfrom.c.
+ */
+#define MT_MAX_BUFFERED_TUPLES		1000
+#define MT_MAX_BUFFERED_BYTES		65535
+
 typedef struct MTTargetRelLookup
 {
 	Oid			relationOid;	/* hash key, must be first */
@@ -121,6 +129,12 @@ typedef struct UpdateContext
 } UpdateContext;
 
 
+static void ExecBufferInsert(ModifyTableState *mtstate,
+							 ResultRelInfo *resultRelInfo,
+							 TupleTableSlot *slot,
+							 TupleTableSlot *planSlot,
+							 EState *estate,
+							 bool canSetTag);
 static void ExecBatchInsert(ModifyTableState *mtstate,
 							ResultRelInfo *resultRelInfo,
 							TupleTableSlot **slots,
@@ -766,7 +780,6 @@ ExecInsert(ModifyTableContext *context,
 	ModifyTable *node = (ModifyTable *) mtstate->ps.plan;
 	OnConflictAction onconflict = node->onConflictAction;
 	PartitionTupleRouting *proute = mtstate->mt_partition_tuple_routing;
-	MemoryContext oldContext;
 
 	/*
 	 * If the input result relation is a partitioned table, find the leaf
@@ -843,88 +856,8 @@ ExecInsert(ModifyTableContext *context,
 		 */
 		if (resultRelInfo->ri_BatchSize > 1)
 		{
-			bool		flushed = false;
-
-			/*
-			 * When we've reached the desired batch size, perform the
-			 * insertion.
-			 */
-			if (resultRelInfo->ri_NumSlots == resultRelInfo->ri_BatchSize)
-			{
-				ExecBatchInsert(mtstate, resultRelInfo,
-								resultRelInfo->ri_Slots,
-								resultRelInfo->ri_PlanSlots,
-								resultRelInfo->ri_NumSlots,
-								estate, canSetTag);
-				flushed = true;
-			}
-
-			oldContext = MemoryContextSwitchTo(estate->es_query_cxt);
-
-			if (resultRelInfo->ri_Slots == NULL)
-			{
-				resultRelInfo->ri_Slots = palloc(sizeof(TupleTableSlot *) *
-												 resultRelInfo->ri_BatchSize);
-				resultRelInfo->ri_PlanSlots = palloc(sizeof(TupleTableSlot *) *
-													 resultRelInfo->ri_BatchSize);
-			}
-
-			/*
-			 * Initialize the batch slots. We don't know how many slots will
-			 * be needed, so we initialize them as the batch grows, and we
-			 * keep them across batches. To mitigate an inefficiency in how
-			 * resource owner handles objects with many references (as with
-			 * many slots all referencing the same tuple descriptor) we copy
-			 * the appropriate tuple descriptor for each slot.
-			 */
-			if (resultRelInfo->ri_NumSlots >= resultRelInfo->ri_NumSlotsInitialized)
-			{
-				TupleDesc	tdesc = CreateTupleDescCopy(slot->tts_tupleDescriptor);
-				TupleDesc	plan_tdesc =
-					CreateTupleDescCopy(planSlot->tts_tupleDescriptor);
-
-				resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots] =
-					MakeSingleTupleTableSlot(tdesc, slot->tts_ops);
-
-				resultRelInfo->ri_PlanSlots[resultRelInfo->ri_NumSlots] =
-					MakeSingleTupleTableSlot(plan_tdesc, planSlot->tts_ops);
-
-				/* remember how many batch slots we initialized */
-				resultRelInfo->ri_NumSlotsInitialized++;
-			}
-
-			ExecCopySlot(resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots],
-						 slot);
-
-			ExecCopySlot(resultRelInfo->ri_PlanSlots[resultRelInfo->ri_NumSlots],
-						 planSlot);
-
-			/*
-			 * If these are the first tuples stored in the buffers, add the
-			 * target rel and the mtstate to the
-			 * es_insert_pending_result_relations and
-			 * es_insert_pending_modifytables lists respectively, except in
-			 * the case where flushing was done above, in which case they
-			 * would already have been added to the lists, so no need to do
-			 * this.
-			 */
-			if (resultRelInfo->ri_NumSlots == 0 && !flushed)
-			{
-				Assert(!list_member_ptr(estate->es_insert_pending_result_relations,
-										resultRelInfo));
-				estate->es_insert_pending_result_relations =
-					lappend(estate->es_insert_pending_result_relations,
-							resultRelInfo);
-				estate->es_insert_pending_modifytables =
-					lappend(estate->es_insert_pending_modifytables, mtstate);
-			}
-			Assert(list_member_ptr(estate->es_insert_pending_result_relations,
-								   resultRelInfo));
-
-			resultRelInfo->ri_NumSlots++;
-
-			MemoryContextSwitchTo(oldContext);
-
+			ExecBufferInsert(mtstate, resultRelInfo, slot, planSlot,
+							 estate, canSetTag);
 			return NULL;
 		}
 
@@ -1008,6 +941,18 @@ ExecInsert(ModifyTableContext *context,
 			  resultRelInfo->ri_TrigDesc->trig_insert_before_row)))
 			ExecPartitionCheck(resultRelInfo, slot, estate, true);
 
+		/*
+		 * If we can use multi-insert, buffer the tuple; it's inserted
+		 * together with others by ExecBatchInsert.
+		 */
+		if (resultRelInfo->ri_BatchSize > 1)
+		{
+			Assert(onconflict == ONCONFLICT_NONE);
+			ExecBufferInsert(mtstate, resultRelInfo, slot, planSlot,
+							 estate, canSetTag);
+			return NULL;
+		}
+
 		if (onconflict != ONCONFLICT_NONE && resultRelInfo->ri_NumIndices > 0)
 		{
 			/* Perform a speculative insertion. */
@@ -1205,12 +1150,144 @@ ExecInsert(ModifyTableContext *context,
 	return result;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecBufferInsert
+ *
+ *		Add a tuple to the batch of tuples to be inserted into the given
+ *		result relation, inserting the batch first if it's full.
+ *
+ *		For foreign tables, the batch size is chosen by the FDW.  Batches for
+ *		local tables are flushed together, whenever the rows buffered over
+ *		all of this node's result relations reach the limits.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecBufferInsert(ModifyTableState *mtstate,
+				 ResultRelInfo *resultRelInfo,
+				 TupleTableSlot *slot,
+				 TupleTableSlot *planSlot,
+				 EState *estate,
+				 bool canSetTag)
+{
+	bool		isforeign = (resultRelInfo->ri_FdwRoutine != NULL);
+	bool		flushed = false;
+	MemoryContext oldContext;
+
+	/*
+	 * When we've reached the desired batch size, perform the insertion.
+	 */
+	if (resultRelInfo->ri_NumSlots == resultRelInfo->ri_BatchSize)
+	{
+		ExecBatchInsert(mtstate, resultRelInfo,
+						resultRelInfo->ri_Slots,
+						resultRelInfo->ri_PlanSlots,
+						resultRelInfo->ri_NumSlots,
+						estate, canSetTag);
+		flushed = true;
+	}
+
+	oldContext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	if (resultRelInfo->ri_Slots == NULL)
+	{
+		resultRelInfo->ri_Slots = palloc(sizeof(TupleTableSlot *) *
+										 resultRelInfo->ri_BatchSize);
+		/* only FDWs need the plan's output tuples */
+		if (isforeign)
+			resultRelInfo->ri_PlanSlots = palloc(sizeof(TupleTableSlot *) *
+												 resultRelInfo->ri_BatchSize);
+	}
+
+	/*
+	 * Initialize the batch slots. We don't know how many slots will be
+	 * needed, so we initialize them as the batch grows, and we keep them
+	 * across batches. To mitigate an inefficiency in how resource owner
+	 * handles objects with many references (as with many slots all
+	 * referencing the same tuple descriptor) we copy the appropriate tuple
+	 * descriptor for each slot.  For local tables, use the kind of slot the
+	 * table AM's multi-insert works with.
+	 */
+	if (resultRelInfo->ri_NumSlots >= resultRelInfo->ri_NumSlotsInitialized)
+	{
+		TupleDesc	tdesc = CreateTupleDescCopy(slot->tts_tupleDescriptor);
+
+		if (isforeign)
+		{
+			TupleDesc	plan_tdesc =
+				CreateTupleDescCopy(planSlot->tts_tupleDescriptor);
+
+			resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots] =
+				MakeSingleTupleTableSlot(tdesc, slot->tts_ops);
+
+			resultRelInfo->ri_PlanSlots[resultRelInfo->ri_NumSlots] =
+				MakeSingleTupleTableSlot(plan_tdesc, planSlot->tts_ops);
+		}
+		else
+			resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots] =
+				MakeSingleTupleTableSlot(tdesc,
+										 table_slot_callbacks(resultRelInfo->ri_RelationDesc));
+
+		/* remember how many batch slots we initialized */
+		resultRelInfo->ri_NumSlotsInitialized++;
+	}
+
+	ExecCopySlot(resultRelInfo->ri_Slots[resultRelInfo->ri_NumSlots],
+				 slot);
+
+	if (isforeign)
+		ExecCopySlot(resultRelInfo->ri_PlanSlots[resultRelInfo->ri_NumSlots],
+					 planSlot);
+
+	/*
+	 * If these are the first tuples stored in the buffers, add the target
+	 * rel and the mtstate to the es_insert_pending_result_relations and
+	 * es_insert_pending_modifytables lists respectively, except in the case
+	 * where flushing was done above, in which case they would already have
+	 * been added to the lists, so no need to do this.
+	 */
+	if (resultRelInfo->ri_NumSlots == 0 && !flushed)
+	{
+		Assert(!list_member_ptr(estate->es_insert_pending_result_relations,
+								resultRelInfo));
+		estate->es_insert_pending_result_relations =
+			lappend(estate->es_insert_pending_result_relations,
+					resultRelInfo);
+		estate->es_insert_pending_modifytables =
+			lappend(estate->es_insert_pending_modifytables, mtstate);
+	}
+	Assert(list_member_ptr(estate->es_insert_pending_result_relations,
+						   resultRelInfo));
+
+	resultRelInfo->ri_NumSlots++;
+
+	MemoryContextSwitchTo(oldContext);
+
+	/*
+	 * For local tables, keep track of how much we have buffered, and flush
+	 * everything once that gets too large.  This bounds the memory used when
+	 * the rows are routed to many partitions.
+	 */
+	if (!isforeign)
+	{
+		slot_getallattrs(slot);
+		mtstate->mt_buffered_tuples++;
+		mtstate->mt_buffered_bytes +=
+			heap_compute_data_size(slot->tts_tupleDescriptor,
+								   slot->tts_values, slot->tts_isnull);
+
+		if (mtstate->mt_buffered_tuples >= MT_MAX_BUFFERED_TUPLES ||
+			mtstate->mt_buffered_bytes >= MT_MAX_BUFFERED_BYTES)
+			ExecPendingInserts(estate);
+	}
+}
+
 /* ----------------------------------------------------------------
  *		ExecBatchInsert
  *
  *		Insert multiple tuples in an efficient way.
  *		Currently, this handles inserting into a foreign table without
- *		RETURNING clause.
+ *		RETURNING clause, and into a local table without RETURNING clause
+ *		or row triggers.
  * ----------------------------------------------------------------
  */
 static void
@@ -1227,6 +1304,45 @@ ExecBatchInsert(ModifyTableState *mtstate,
 	TupleTableSlot *slot = NULL;
 	TupleTableSlot **rslots;
 
+	if (resultRelInfo->ri_FdwRoutine == NULL)
+	{
+		MemoryContext oldContext;
+
+		/*
+		 * Insert into local table, like COPY FROM does.  table_multi_insert
+		 * may leak memory, so switch to short-lived memory context before
+		 * calling it.
+		 */
+		oldContext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+		table_multi_insert(resultRelInfo->ri_RelationDesc,
+						   slots,
+						   numSlots,
+						   estate->es_output_cid,
+						   0,
+						   NULL);
+		MemoryContextSwitchTo(oldContext);
+
+		/*
+		 * Insert index entries for the tuples.  There are no AFTER ROW
+		 * triggers to fire, see ExecGetMultiInsertBatchSize().
+		 */
+		for (i = 0; i < numSlots; i++)
+		{
+			if (resultRelInfo->ri_NumIndices > 0)
+				list_free(ExecInsertIndexTuples(resultRelInfo,
+												slots[i], estate,
+												false, false, NULL,
+												NIL, false));
+			ExecClearTuple(slots[i]);
+		}
+
+		if (canSetTag)
+			estate->es_processed += numSlots;
+
+		resultRelInfo->ri_NumSlots = 0;
+		return;
+	}
+
 	/*
 	 * insert into foreign table: let the FDW do it
 	 */
@@ -1271,7 +1387,8 @@ ExecBatchInsert(ModifyTableState *mtstate,
 }
 
 /*
- * ExecPendingInserts -- flushes all pending inserts to the foreign tables
+ * ExecPendingInserts -- flushes all pending inserts to the foreign and local
+ * tables
  */
 static void
 ExecPendingInserts(EState *estate)
@@ -1291,6 +1408,10 @@ ExecPendingInserts(EState *estate)
 						resultRelInfo->ri_PlanSlots,
 						resultRelInfo->ri_NumSlots,
 						estate, mtstate->canSetTag);
+
+		/* nothing is buffered for local tables anymore */
+		mtstate->mt_buffered_tuples = 0;
+		mtstate->mt_buffered_bytes = 0;
 	}
 
 	list_free(estate->es_insert_pending_result_relations);
@@ -3917,6 +4038,50 @@ ExecLookupResultRelByOid(ModifyTableState *node, Oid resultoid,
 	return NULL;
 }
 
+/*
+ * ExecGetMultiInsertBatchSize
+ *		Determine how many tuples inserted into the given result relation can
+ *		be buffered and inserted at once with table_multi_insert().  Returns
+ *		1 if they must be inserted one by one.
+ *
+ * The planner has already checked that the statement is a plain INSERT that
+ * doesn't need the inserted tuples for anything else, like RETURNING.  Here
+ * we check the relation itself: it must be a local table without row
+ * triggers, which might want to see the tuples already inserted, or run
+ * code of their own for each tuple, and without WITH CHECK OPTIONs, which
+ * must be checked after each tuple is inserted.  Transition tables are not
+ * supported either.
+ */
+int
+ExecGetMultiInsertBatchSize(ModifyTableState *mtstate,
+							ResultRelInfo *resultRelInfo)
+{
+	TriggerDesc *trigDesc = resultRelInfo->ri_TrigDesc;
+
+	if (!mtstate->mt_multi_insert)
+		return 1;
+
+	if (resultRelInfo->ri_FdwRoutine != NULL ||
+		resultRelInfo->ri_RelationDesc->rd_rel->relkind != RELKIND_RELATION)
+		return 1;
+
+	if (trigDesc != NULL &&
+		(trigDesc->trig_insert_before_row ||
+		 trigDesc->trig_insert_after_row ||
+		 trigDesc->trig_insert_instead_row ||
+		 trigDesc->trig_insert_new_table))
+		return 1;
+
+	/* a partitioned table's transition tables are captured per tuple, too */
+	if (mtstate->mt_transition_capture != NULL)
+		return 1;
+
+	if (resultRelInfo->ri_WithCheckOptions != NIL)
+		return 1;
+
+	return MT_MAX_BUFFERED_TUPLES;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitModifyTable
  * ----------------------------------------------------------------
@@ -4355,7 +4520,9 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 	/*
 	 * Determine if the FDW supports batch insert and determine the batch size
 	 * (a FDW may support batching, but it may be disabled for the
-	 * server/table).
+	 * server/table).  For a local table, see if we can use multi-insert
+	 * instead; that's decided separately for each partition when routing
+	 * tuples, see ExecInitPartitionInfo().
 	 *
 	 * We only do this for INSERT, so that for UPDATE/DELETE the batch size
 	 * remains set to 0.
@@ -4365,6 +4532,7 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 		/* insert may only have one relation, inheritance is not expanded */
 		Assert(nrels == 1);
 		resultRelInfo = mtstate->resultRelInfo;
+		mtstate->mt_multi_insert = node->canMultiInsert;
 		if (!resultRelInfo->ri_usesFdwDirectModify &&
 			resultRelInfo->ri_FdwRoutine != NULL &&
 			resultRelInfo->ri_FdwRoutine->GetForeignModifyBatchSize &&
@@ -4375,7 +4543,8 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 			Assert(resultRelInfo->ri_BatchSize >= 1);
 		}
 		else
-			resultRelInfo->ri_BatchSize = 1;
+			resultRelInfo->ri_BatchSize =
+				ExecGetMultiInsertBatchSize(mtstate, resultRelInfo);
 	}
 
 	/*
@@ -4423,13 +4592,15 @@ ExecEndModifyTable(ModifyTableState *node)
 
 		/*
 		 * Cleanup the initialized batch slots. This only matters for FDWs
-		 * with batching, but the other cases will have ri_NumSlotsInitialized
-		 * == 0.
+		 * with batching and for multi-insert into local tables, but the other
+		 * cases will have ri_NumSlotsInitialized == 0.  There are no plan
+		 * slots for local tables.
 		 */
 		for (j = 0; j < resultRelInfo->ri_NumSlotsInitialized; j++)
 		{
 			ExecDropSingleTupleTableSlot(resultRelInfo->ri_Slots[j]);
-			ExecDropSingleTupleTableSlot(resultRelInfo->ri_PlanSlots[j]);
+			if (resultRelInfo->ri_PlanSlots)
+				ExecDropSingleTupleTableSlot(resultRelInfo->ri_PlanSlots[j]);
 		}
 	}
 
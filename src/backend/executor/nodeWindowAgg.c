@@ -37,6 +37,7 @@
 #include "catalog/objectaccess.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeWindowAgg.h"
 #include "miscadmin.h"
@@ -157,8 +158,34 @@ typedef struct WindowStatePerAggData
 
 	/* Data local to eval_windowaggregates() */
 	bool		restart;		/* need to restart this agg in this cycle? */
+
+	/*
+	 * Segment tree state, see eval_segtree_aggregate().  combinefn is only
+	 * valid if use_segtree is true.  The tree itself lives in the partition
+	 * context and is rebuilt for each partition.
+	 */
+	FmgrInfo	combinefn;
+	bool		use_segtree;	/* may we evaluate frames using a segtree? */
+	bool		segtree_active; /* still doing so in the current partition? */
+	bool		segtree_dropped;	/* just stopped doing so, must restart */
+	struct WindowSegTreeNode *segtree;	/* 2 * segtree_size nodes, or NULL */
+	int64		segtree_size;	/* number of leaves, a power of 2 */
+	int64		segtree_nrows;	/* rows before this have been added */
 } WindowStatePerAggData;
 
+/*
+ * A node of an aggregate's segment tree.  Leaves hold the transition value
+ * of a single row, inner nodes the combination of their children.  'empty'
+ * marks a node to which no row contributed; it acts as the identity element
+ * when combining.
+ */
+typedef struct WindowSegTreeNode
+{
+	Datum		value;
+	bool		isnull;
+	bool		empty;
+} WindowSegTreeNode;
+
 static void initialize_windowaggregate(WindowAggState *winstate,
 									   WindowStatePerFunc perfuncstate,
 									   WindowStatePerAgg peraggstate);
@@ -173,6 +200,25 @@ static void finalize_windowaggregate(WindowAggState *winstate,
 									 WindowStatePerAgg peraggstate,
 									 Datum *result, bool *isnull);
 
+static void segtree_combine(WindowAggState *winstate,
+							WindowStatePerFunc perfuncstate,
+							WindowStatePerAgg peraggstate,
+							WindowSegTreeNode *result,
+							const WindowSegTreeNode *left,
+							const WindowSegTreeNode *right);
+static bool segtree_add_rows(WindowAggState *winstate,
+							 WindowStatePerFunc perfuncstate,
+							 WindowStatePerAgg peraggstate,
+							 int64 nrows);
+static void segtree_query(WindowAggState *winstate,
+						  WindowStatePerFunc perfuncstate,
+						  WindowStatePerAgg peraggstate,
+						  int64 l, int64 r,
+						  WindowSegTreeNode *result);
+static bool eval_segtree_aggregate(WindowAggState *winstate,
+								   WindowStatePerFunc perfuncstate,
+								   WindowStatePerAgg peraggstate);
+
 static void eval_windowaggregates(WindowAggState *winstate);
 static void eval_windowfunction(WindowAggState *winstate,
 								WindowStatePerFunc perfuncstate,
@@ -648,6 +694,333 @@ finalize_windowaggregate(WindowAggState *winstate,
 	MemoryContextSwitchTo(oldContext);
 }
 
+/*
+ * segtree_combine
+ * combine the transition values of two adjacent segments of the partition
+ *
+ * 'result' may point to the same node as 'left' or 'right'.  The caller is
+ * responsible for resetting winstate->tmpcontext afterwards.
+ */
+static void
+segtree_combine(WindowAggState *winstate,
+				WindowStatePerFunc perfuncstate,
+				WindowStatePerAgg peraggstate,
+				WindowSegTreeNode *result,
+				const WindowSegTreeNode *left,
+				const WindowSegTreeNode *right)
+{
+	LOCAL_FCINFO(fcinfo, 2);
+	MemoryContext oldContext;
+	Datum		newVal;
+
+	if (right->empty)
+	{
+		*result = *left;
+		return;
+	}
+	if (left->empty)
+	{
+		*result = *right;
+		return;
+	}
+
+	/*
+	 * As in nodeAgg.c, a strict combine function is not called with NULL
+	 * inputs: a NULL right-hand state is ignored, and a NULL left-hand state
+	 * stays NULL.
+	 */
+	if (peraggstate->combinefn.fn_strict && (left->isnull || right->isnull))
+	{
+		*result = *left;
+		return;
+	}
+
+	oldContext = MemoryContextSwitchTo(winstate->tmpcontext->ecxt_per_tuple_memory);
+
+	InitFunctionCallInfoData(*fcinfo, &(peraggstate->combinefn),
+							 2,
+							 perfuncstate->winCollation,
+							 (void *) winstate, NULL);
+	fcinfo->args[0].value = left->value;
+	fcinfo->args[0].isnull = left->isnull;
+	fcinfo->args[1].value = right->value;
+	fcinfo->args[1].isnull = right->isnull;
+	winstate->curaggcontext = peraggstate->aggcontext;
+	newVal = FunctionCallInvoke(fcinfo);
+	winstate->curaggcontext = NULL;
+
+	MemoryContextSwitchTo(oldContext);
+
+	/* transition type is pass-by-value, so no need to copy anything */
+	result->value = newVal;
+	result->isnull = fcinfo->isnull;
+	result->empty = false;
+}
+
+/*
+ * segtree_add_rows
+ * add the transition values of all rows before 'nrows' to the segment tree
+ *
+ * The tree is used as a ring buffer: it only has to hold the rows from the
+ * current frame head onwards, since the frame head never moves backwards, so
+ * its size is bounded by the largest frame seen rather than the partition
+ * size.  Row 'pos' is kept in leaf (pos % segtree_size).  Inner nodes that
+ * combine leaves of rows on both sides of the frame head hold garbage, but
+ * those are never looked at by segtree_query().
+ *
+ * Returns false if the tree would need more than work_mem, in which case the
+ * caller must fall back to the regular aggregation code.
+ */
+static bool
+segtree_add_rows(WindowAggState *winstate,
+				 WindowStatePerFunc perfuncstate,
+				 WindowStatePerAgg peraggstate,
+				 int64 nrows)
+{
+	int64		headpos = winstate->frameheadpos;
+	TupleTableSlot *slot = winstate->temp_slot_1;
+	WindowSegTreeNode *tree;
+	int64		size;
+	int64		pos;
+
+	/* Rows before the frame head will never be needed again */
+	if (peraggstate->segtree_nrows < headpos)
+		peraggstate->segtree_nrows = headpos;
+	if (peraggstate->segtree_nrows >= nrows)
+		return true;
+
+	/* Enlarge the tree if rows [headpos, nrows) don't fit */
+	if (nrows - headpos > peraggstate->segtree_size)
+	{
+		WindowSegTreeNode *oldtree = peraggstate->segtree;
+		int64		oldsize = peraggstate->segtree_size;
+		int64		i;
+
+		size = Max(oldsize, 64);
+		while (size < nrows - headpos)
+			size *= 2;
+		if ((double) size * 2 * sizeof(WindowSegTreeNode) >
+			(double) work_mem * 1024.0)
+			return false;
+
+		tree = (WindowSegTreeNode *)
+			MemoryContextAllocHuge(winstate->partcontext,
+								   size * 2 * sizeof(WindowSegTreeNode));
+		for (i = 0; i < size * 2; i++)
+		{
+			tree[i].value = (Datum) 0;
+			tree[i].isnull = true;
+			tree[i].empty = true;
+		}
+
+		/* Move over the leaves still needed, and recompute inner nodes */
+		for (pos = headpos; pos < peraggstate->segtree_nrows; pos++)
+			tree[size + (pos & (size - 1))] =
+				oldtree[oldsize + (pos & (oldsize - 1))];
+		for (i = size - 1; i > 0; i--)
+			segtree_combine(winstate, perfuncstate, peraggstate,
+							&tree[i], &tree[2 * i], &tree[2 * i + 1]);
+		ResetExprContext(winstate->tmpcontext);
+
+		if (oldtree)
+			pfree(oldtree);
+		peraggstate->segtree = tree;
+		peraggstate->segtree_size = size;
+	}
+
+	tree = peraggstate->segtree;
+	size = peraggstate->segtree_size;
+
+	for (pos = peraggstate->segtree_nrows; pos < nrows; pos++)
+	{
+		int64		i;
+
+		if (!window_gettupleslot(winstate->agg_winobj, pos, slot))
+			elog(ERROR, "could not fetch window frame row");
+
+		/*
+		 * A leaf's value is simply the result of aggregating its row alone.
+		 * If the row doesn't contribute anything (because it's FILTERed out,
+		 * or it has a NULL input to a strict transfn), the leaf stays empty.
+		 */
+		winstate->tmpcontext->ecxt_outertuple = slot;
+		peraggstate->transValue = peraggstate->initValue;
+		peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+		peraggstate->transValueCount = 0;
+		advance_windowaggregate(winstate, perfuncstate, peraggstate);
+
+		i = size + (pos & (size - 1));
+		tree[i].value = peraggstate->transValue;
+		tree[i].isnull = peraggstate->transValueIsNull;
+		tree[i].empty = (peraggstate->transValueCount == 0);
+
+		/* ... and propagate it up to the root */
+		for (i >>= 1; i > 0; i >>= 1)
+			segtree_combine(winstate, perfuncstate, peraggstate,
+							&tree[i], &tree[2 * i], &tree[2 * i + 1]);
+
+		ResetExprContext(winstate->tmpcontext);
+	}
+	ExecClearTuple(slot);
+
+	peraggstate->segtree_nrows = nrows;
+	return true;
+}
+
+/*
+ * segtree_query
+ * combine the tree nodes in [l, r), which must be leaf indexes, in order
+ */
+static void
+segtree_query(WindowAggState *winstate,
+			  WindowStatePerFunc perfuncstate,
+			  WindowStatePerAgg peraggstate,
+			  int64 l, int64 r,
+			  WindowSegTreeNode *result)
+{
+	WindowSegTreeNode *tree = peraggstate->segtree;
+	WindowSegTreeNode resl;
+	WindowSegTreeNode resr;
+
+	resl.value = resr.value = (Datum) 0;
+	resl.isnull = resr.isnull = true;
+	resl.empty = resr.empty = true;
+
+	/*
+	 * Walk up from both ends, collecting the nodes that are fully inside the
+	 * range.  Those found on the left side are appended to resl, those on
+	 * the right side prepended to resr, so the combine function always sees
+	 * rows in their original order.
+	 */
+	for (; l < r; l >>= 1, r >>= 1)
+	{
+		if (l & 1)
+		{
+			segtree_combine(winstate, perfuncstate, peraggstate,
+							&resl, &resl, &tree[l]);
+			l++;
+		}
+		if (r & 1)
+		{
+			r--;
+			segtree_combine(winstate, perfuncstate, peraggstate,
+							&resr, &tree[r], &resr);
+		}
+	}
+
+	segtree_combine(winstate, perfuncstate, peraggstate,
+					result, &resl, &resr);
+}
+
+/*
+ * eval_segtree_aggregate
+ * evaluate an aggregate over the current frame using its segment tree
+ *
+ * Without an inverse transition function, an aggregate whose frame head
+ * moves must be recomputed over the whole frame for every row, which is
+ * O(N * frame size) per partition.  For aggregates with a combine function
+ * we instead keep every row's individual transition value in a segment tree
+ * and only need to combine O(log(frame size)) tree nodes for each frame.
+ *
+ * Returns false if the tree has outgrown work_mem.  The aggregate is then
+ * switched over to the regular code for the rest of the partition.
+ */
+static bool
+eval_segtree_aggregate(WindowAggState *winstate,
+					   WindowStatePerFunc perfuncstate,
+					   WindowStatePerAgg peraggstate)
+{
+	ExprContext *econtext = winstate->ss.ps.ps_ExprContext;
+	int			wfuncno = peraggstate->wfuncno;
+	Datum	   *result = &econtext->ecxt_aggvalues[wfuncno];
+	bool	   *isnull = &econtext->ecxt_aggnulls[wfuncno];
+	int64		headpos;
+	int64		tailpos;
+	WindowSegTreeNode res;
+	MemoryContext oldContext;
+
+	update_frametailpos(winstate);
+	headpos = winstate->frameheadpos;
+	tailpos = winstate->frametailpos;
+
+	res.value = (Datum) 0;
+	res.isnull = true;
+	res.empty = true;
+
+	if (tailpos > headpos)
+	{
+		int64		size;
+		int64		l,
+					r;
+
+		if (!segtree_add_rows(winstate, perfuncstate, peraggstate, tailpos))
+		{
+			if (peraggstate->segtree)
+				pfree(peraggstate->segtree);
+			peraggstate->segtree = NULL;
+			peraggstate->segtree_size = 0;
+			peraggstate->segtree_nrows = 0;
+			peraggstate->segtree_active = false;
+			peraggstate->segtree_dropped = true;
+			return false;
+		}
+
+		/* The frame may wrap around the end of the ring */
+		size = peraggstate->segtree_size;
+		l = size + (headpos & (size - 1));
+		r = size + ((tailpos - 1) & (size - 1)) + 1;
+		if (l < r)
+			segtree_query(winstate, perfuncstate, peraggstate, l, r, &res);
+		else
+		{
+			WindowSegTreeNode res2;
+
+			segtree_query(winstate, perfuncstate, peraggstate,
+						  l, 2 * size, &res);
+			segtree_query(winstate, perfuncstate, peraggstate,
+						  size, r, &res2);
+			segtree_combine(winstate, perfuncstate, peraggstate,
+							&res, &res, &res2);
+		}
+	}
+
+	/* An empty frame yields the aggregate's initial value */
+	if (res.empty)
+	{
+		peraggstate->transValue = peraggstate->initValue;
+		peraggstate->transValueIsNull = peraggstate->initValueIsNull;
+	}
+	else
+	{
+		peraggstate->transValue = res.value;
+		peraggstate->transValueIsNull = res.isnull;
+	}
+
+	finalize_windowaggregate(winstate, perfuncstate, peraggstate,
+							 result, isnull);
+	ResetExprContext(winstate->tmpcontext);
+
+	/* save the result in case next row shares the same frame */
+	if (!peraggstate->resulttypeByVal && !peraggstate->resultValueIsNull)
+		pfree(DatumGetPointer(peraggstate->resultValue));
+	if (!peraggstate->resulttypeByVal && !*isnull)
+	{
+		oldContext = MemoryContextSwitchTo(peraggstate->aggcontext);
+		peraggstate->resultValue =
+			datumCopy(*result,
+					  peraggstate->resulttypeByVal,
+					  peraggstate->resulttypeLen);
+		MemoryContextSwitchTo(oldContext);
+	}
+	else
+	{
+		peraggstate->resultValue = *result;
+	}
+	peraggstate->resultValueIsNull = *isnull;
+
+	return true;
+}
+
 /*
  * eval_windowaggregates
  * evaluate plain aggregates being used as window functions
@@ -666,6 +1039,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	int			wfuncno,
 				numaggs,
 				numaggs_restart,
+				numaggs_segtree,
 				i;
 	int64		aggregatedupto_nonrestarted;
 	MemoryContext oldContext;
@@ -715,6 +1089,11 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * (For some frame end choices, it might be that the frame is always
 	 * contiguous anyway, but that's an optimization to investigate later.)
 	 *
+	 * Aggregates without an inverse transition function but with a combine
+	 * function are instead evaluated using a segment tree, if the frame head
+	 * can move, see eval_segtree_aggregate().  These don't take part in the
+	 * restart logic described above.
+	 *
 	 * In many common cases, multiple rows share the same frame and hence the
 	 * same aggregate value. (In particular, if there's no ORDER BY in a RANGE
 	 * window, then all rows are peers and so they all have window frame equal
@@ -765,6 +1144,30 @@ eval_windowaggregates(WindowAggState *winstate)
 		return;
 	}
 
+	/*
+	 * Evaluate the aggregates that use a segment tree.  If those are all we
+	 * have, we're done, once we've moved the mark pointer up to the frame
+	 * head so that the tuplestore can discard rows we don't need anymore.
+	 */
+	numaggs_segtree = 0;
+	for (i = 0; i < numaggs; i++)
+	{
+		peraggstate = &winstate->peragg[i];
+		if (!peraggstate->segtree_active)
+			continue;
+
+		wfuncno = peraggstate->wfuncno;
+		if (eval_segtree_aggregate(winstate,
+								   &winstate->perfunc[wfuncno],
+								   peraggstate))
+			numaggs_segtree++;
+	}
+	if (numaggs_segtree == numaggs)
+	{
+		WinSetMarkPosition(agg_winobj, winstate->frameheadpos);
+		return;
+	}
+
 	/*----------
 	 * Initialize restart flags.
 	 *
@@ -773,7 +1176,8 @@ eval_windowaggregates(WindowAggState *winstate)
 	 *	 - if the frame's head moved and we cannot use an inverse
 	 *	   transition function, or
 	 *	 - we have an EXCLUSION clause, or
-	 *	 - if the new frame doesn't overlap the old one
+	 *	 - if the new frame doesn't overlap the old one, or
+	 *	 - if it has just stopped using its segment tree
 	 *
 	 * Note that we don't strictly need to restart in the last case, but if
 	 * we're going to remove all rows from the aggregation anyway, a restart
@@ -784,13 +1188,20 @@ eval_windowaggregates(WindowAggState *winstate)
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
+		if (peraggstate->segtree_active)
+		{
+			peraggstate->restart = false;
+			continue;
+		}
 		if (winstate->currentpos == 0 ||
 			(winstate->aggregatedbase != winstate->frameheadpos &&
 			 !OidIsValid(peraggstate->invtransfn_oid)) ||
 			(winstate->frameOptions & FRAMEOPTION_EXCLUSION) ||
-			winstate->aggregatedupto <= winstate->frameheadpos)
+			winstate->aggregatedupto <= winstate->frameheadpos ||
+			peraggstate->segtree_dropped)
 		{
 			peraggstate->restart = true;
+			peraggstate->segtree_dropped = false;
 			numaggs_restart++;
 		}
 		else
@@ -804,7 +1215,7 @@ eval_windowaggregates(WindowAggState *winstate)
 	 * i.e. advance_windowaggregate_base() can return false, in which case
 	 * we'll restart that aggregate below.
 	 */
-	while (numaggs_restart < numaggs &&
+	while (numaggs_restart + numaggs_segtree < numaggs &&
 		   winstate->aggregatedbase < winstate->frameheadpos)
 	{
 		/*
@@ -827,7 +1238,7 @@ eval_windowaggregates(WindowAggState *winstate)
 			bool		ok;
 
 			peraggstate = &winstate->peragg[i];
-			if (peraggstate->restart)
+			if (peraggstate->restart || peraggstate->segtree_active)
 				continue;
 
 			wfuncno = peraggstate->wfuncno;
@@ -879,6 +1290,8 @@ eval_windowaggregates(WindowAggState *winstate)
 	for (i = 0; i < numaggs; i++)
 	{
 		peraggstate = &winstate->peragg[i];
+		if (peraggstate->segtree_active)
+			continue;
 
 		/* Aggregates using the shared ctx must restart if *any* agg does */
 		Assert(peraggstate->aggcontext != winstate->aggcontext ||
@@ -955,6 +1368,8 @@ eval_windowaggregates(WindowAggState *winstate)
 		for (i = 0; i < numaggs; i++)
 		{
 			peraggstate = &winstate->peragg[i];
+			if (peraggstate->segtree_active)
+				continue;
 
 			/* Non-restarted aggs skip until aggregatedupto_nonrestarted */
 			if (!peraggstate->restart &&
@@ -988,6 +1403,9 @@ next_tuple:
 		bool	   *isnull;
 
 		peraggstate = &winstate->peragg[i];
+		if (peraggstate->segtree_active)
+			continue;
+
 		wfuncno = peraggstate->wfuncno;
 		result = &econtext->ecxt_aggvalues[wfuncno];
 		isnull = &econtext->ecxt_aggnulls[wfuncno];
@@ -1355,8 +1773,25 @@ release_partition(WindowAggState *winstate)
 	MemoryContextResetAndDeleteChildren(winstate->aggcontext);
 	for (i = 0; i < winstate->numaggs; i++)
 	{
-		if (winstate->peragg[i].aggcontext != winstate->aggcontext)
-			MemoryContextResetAndDeleteChildren(winstate->peragg[i].aggcontext);
+		WindowStatePerAgg peraggstate = &winstate->peragg[i];
+
+		if (peraggstate->aggcontext != winstate->aggcontext)
+			MemoryContextResetAndDeleteChildren(peraggstate->aggcontext);
+
+		/*
+		 * The segment tree was in partcontext, and any saved result in the
+		 * private aggcontext; start afresh in the next partition.
+		 */
+		if (peraggstate->use_segtree)
+		{
+			peraggstate->resultValue = (Datum) 0;
+			peraggstate->resultValueIsNull = true;
+		}
+		peraggstate->segtree = NULL;
+		peraggstate->segtree_size = 0;
+		peraggstate->segtree_nrows = 0;
+		peraggstate->segtree_active = peraggstate->use_segtree;
+		peraggstate->segtree_dropped = false;
 	}
 
 	if (winstate->buffer)
@@ -2776,12 +3211,14 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	bool		use_ma_code;
 	Oid			transfn_oid,
 				invtransfn_oid,
-				finalfn_oid;
+				finalfn_oid,
+				combinefn_oid;
 	bool		finalextra;
 	char		finalmodify;
 	Expr	   *transfnexpr,
 			   *invtransfnexpr,
-			   *finalfnexpr;
+			   *finalfnexpr,
+			   *combinefnexpr;
 	Datum		textInitVal;
 	int			i;
 	ListCell   *lc;
@@ -2852,6 +3289,30 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 		initvalAttNo = Anum_pg_aggregate_agginitval;
 	}
 
+	/*
+	 * If we're not using the moving-aggregate implementation but the frame
+	 * head can move, every frame would have to be aggregated from scratch.
+	 * If the aggregate has a combine function, we can use a segment tree
+	 * instead, see eval_segtree_aggregate().  That only works for contiguous
+	 * frames, so not with an EXCLUSION clause.  It evaluates each row's
+	 * arguments only once, so like the moving-aggregate code, avoid it if
+	 * that could be visible.  We also insist on a pass-by-value, non-float
+	 * transition type, checked below once we know the actual type.  INTERNAL
+	 * is nominally pass-by-value, but such states are pointers to data that
+	 * the combine function may modify in place, which would corrupt tree
+	 * nodes shared by many frames; so exclude those right away.
+	 */
+	if (!use_ma_code &&
+		OidIsValid(aggform->aggcombinefn) &&
+		aggtranstype != INTERNALOID &&
+		!(winstate->frameOptions & FRAMEOPTION_START_UNBOUNDED_PRECEDING) &&
+		!(winstate->frameOptions & FRAMEOPTION_EXCLUSION) &&
+		!contain_volatile_functions((Node *) wfunc) &&
+		!contain_subplans((Node *) wfunc))
+		combinefn_oid = aggform->aggcombinefn;
+	else
+		combinefn_oid = InvalidOid;
+
 	/*
 	 * ExecInitWindowAgg already checked permission to call aggregate function
 	 * ... but we still need to check the component functions
@@ -2896,6 +3357,16 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 							   get_func_name(finalfn_oid));
 			InvokeFunctionExecuteHook(finalfn_oid);
 		}
+
+		if (OidIsValid(combinefn_oid))
+		{
+			aclresult = object_aclcheck(ProcedureRelationId, combinefn_oid, aggOwner,
+										ACL_EXECUTE);
+			if (aclresult != ACLCHECK_OK)
+				aclcheck_error(aclresult, OBJECT_FUNCTION,
+							   get_func_name(combinefn_oid));
+			InvokeFunctionExecuteHook(combinefn_oid);
+		}
 	}
 
 	/*
@@ -2964,6 +3435,39 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 					&peraggstate->transtypeLen,
 					&peraggstate->transtypeByVal);
 
+	/*
+	 * Segment tree nodes are simple Datums, so don't bother with pass-by-ref
+	 * transition types.  (That also keeps out expanded objects, which are
+	 * always pass-by-ref.)  Floating-point states are out too: the tree
+	 * combines rows in a different grouping than sequential aggregation
+	 * does, and float addition isn't associative, so e.g. sum(float8) would
+	 * give results that differ in rounding from other frame types.
+	 */
+	Assert(!OidIsValid(combinefn_oid) || aggtranstype != INTERNALOID);
+	if (OidIsValid(combinefn_oid) && peraggstate->transtypeByVal &&
+		aggtranstype != FLOAT4OID && aggtranstype != FLOAT8OID)
+	{
+		/* the combinefn's sole input, besides the state, is another state */
+		Oid			combineFnInputTypes[] = {aggtranstype};
+
+		build_aggregate_transfn_expr(combineFnInputTypes,
+									 1,
+									 0,
+									 false,
+									 aggtranstype,
+									 wfunc->inputcollid,
+									 combinefn_oid,
+									 InvalidOid,
+									 &combinefnexpr,
+									 NULL);
+		fmgr_info(combinefn_oid, &peraggstate->combinefn);
+		fmgr_info_set_expr((Node *) combinefnexpr, &peraggstate->combinefn);
+		peraggstate->use_segtree = true;
+	}
+	else
+		peraggstate->use_segtree = false;
+	peraggstate->segtree_active = peraggstate->use_segtree;
+
 	/*
 	 * initval is potentially null, so don't try to access it as a struct
 	 * field. Must do it the hard way with SysCacheGetAttr.
@@ -3021,8 +3525,11 @@ initialize_peragg(WindowAggState *winstate, WindowFunc *wfunc,
 	 * make the memory allocation rules for moving aggregates different than
 	 * they have historically been for plain aggregates, but that seems grotty
 	 * and likely to lead to memory leaks.
+	 *
+	 * Aggregates using a segment tree also need their own aggcontext, since
+	 * they may switch to the regular code in mid-partition and restart alone.
 	 */
-	if (OidIsValid(invtransfn_oid))
+	if (OidIsValid(invtransfn_oid) || peraggstate->use_segtree)
 		peraggstate->aggcontext =
 			AllocSetContextCreate(CurrentMemoryContext,
 								  "WindowAgg Per Aggregate",
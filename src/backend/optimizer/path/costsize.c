@@ -150,6 +150,7 @@ bool		enable_partitionwise_join = false;
 bool		enable_partitionwise_aggregate = false;
 bool		enable_parallel_append = true;
 bool		enable_parallel_hash = true;
+bool		enable_parallel_memoize = true;
 bool		enable_partition_pruning = true;
 bool		enable_presorted_aggregate = true;
 bool		enable_async_append = true;
@@ -2501,6 +2502,18 @@ cost_memoize_rescan(PlannerInfo *root, MemoizePath *mpath,
 	/* available cache space */
 	hash_mem_bytes = get_hash_memory_limit();
 
+	/*
+	 * A Parallel Memoize node's cache is shared by all participants, and each
+	 * of them brings its hash_mem, as with Parallel Hash.  The cache sees the
+	 * rescans of all participants, so hits depend on the total number of
+	 * calls rather than on the calls made by any one participant.
+	 */
+	if (mpath->path.parallel_aware)
+	{
+		calls *= get_parallel_divisor(&mpath->path);
+		hash_mem_bytes *= mpath->path.parallel_workers + 1;
+	}
+
 	/*
 	 * Set the number of bytes each cache entry should consume in the cache.
 	 * To provide us with better estimations on how many cache entries we can
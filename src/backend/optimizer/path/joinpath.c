@@ -662,6 +662,16 @@ get_memoize_path(PlannerInfo *root, RelOptInfo *innerrel,
 									&hash_operators,
 									&binary_mode))
 	{
+		/*
+		 * When the outer path is partial, each participant of the parallel
+		 * query rescans the inner side for its own share of the outer rows.
+		 * Let them share one cache, if allowed.
+		 */
+		int			parallel_workers = 0;
+
+		if (enable_parallel_memoize && outer_path->parallel_workers > 0)
+			parallel_workers = outer_path->parallel_workers;
+
 		return (Path *) create_memoize_path(root,
 											innerrel,
 											inner_path,
@@ -669,7 +679,8 @@ get_memoize_path(PlannerInfo *root, RelOptInfo *innerrel,
 											hash_operators,
 											extra->inner_unique,
 											binary_mode,
-											outer_path->rows);
+											outer_path->rows,
+											parallel_workers);
 	}
 
 	return NULL;
@@ -351,9 +351,11 @@ create_plan(PlannerInfo *root, Path *best_path)
 	 * column names and other decorative info.  Targetlists generated within
 	 * the planner don't bother with that stuff, but we must have it on the
 	 * top-level tlist seen at execution time.  However, ModifyTable plan
-	 * nodes don't have a tlist matching the querytree targetlist.
+	 * nodes don't have a tlist matching the querytree targetlist, nor does a
+	 * Gather above one.
 	 */
-	if (!IsA(plan, ModifyTable))
+	if (!IsA(plan, ModifyTable) &&
+		!(IsA(plan, Gather) && IsA(outerPlan(plan), ModifyTable)))
 		apply_tlist_labeling(plan->targetlist, root->processed_tlist);
 
 	/*
@@ -7051,6 +7053,31 @@ make_modifytable(PlannerInfo *root, Plan *subplan,
 	node->mergeActionLists = mergeActionLists;
 	node->epqParam = epqParam;
 
+	/*
+	 * The executor may buffer the rows of a plain INSERT that's expected to
+	 * insert several rows, and write them out together.  That's not safe if
+	 * the query contains volatile functions, since they might query the
+	 * target table and notice that the buffered rows are missing.  As in
+	 * COPY FROM, we make an exception for nextval().
+	 */
+	node->canMultiInsert = false;
+	if (operation == CMD_INSERT && onconflict == NULL &&
+		returningLists == NIL && subplan->plan_rows > 1 &&
+		!contain_volatile_functions_not_nextval((Node *) root->parse))
+	{
+		node->canMultiInsert = true;
+		foreach(lc, root->glob->subroots)
+		{
+			PlannerInfo *subroot = lfirst_node(PlannerInfo, lc);
+
+			if (contain_volatile_functions_not_nextval((Node *) subroot->parse))
+			{
+				node->canMultiInsert = false;
+				break;
+			}
+		}
+	}
+
 	/*
 	 * For each result relation that is a foreign table, allow the FDW to
 	 * construct private plan data, and accumulate it all into a list.
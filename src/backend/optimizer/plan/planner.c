@@ -148,6 +148,7 @@ static double get_number_of_groups(PlannerInfo *root,
 								   double path_rows,
 								   grouping_sets_data *gd,
 								   List *target_list);
+static void choose_hashed_distinct_aggs(PlannerInfo *root, double path_rows);
 static RelOptInfo *create_grouping_paths(PlannerInfo *root,
 										 RelOptInfo *input_rel,
 										 PathTarget *target,
@@ -334,9 +335,10 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	 * the command is writing into a completely new table which workers won't
 	 * be able to see.  If the workers could see the table, the fact that
 	 * group locking would cause them to ignore the leader's heavyweight GIN
-	 * page locks would make this unsafe.  We'll have to fix that somehow if
-	 * we want to allow parallel inserts in general; updates and deletes have
-	 * additional problems especially around combo CIDs.)
+	 * page locks would make this unsafe.  We also allow INSERT, but only into
+	 * tables without indexes; max_parallel_hazard checks the target table.
+	 * Updates and deletes have additional problems especially around combo
+	 * CIDs.)
 	 *
 	 * For now, we don't try to use parallel mode if we're running inside a
 	 * parallel worker.  We might eventually be able to relax this
@@ -345,7 +347,8 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	 */
 	if ((cursorOptions & CURSOR_OPT_PARALLEL_OK) != 0 &&
 		IsUnderPostmaster &&
-		parse->commandType == CMD_SELECT &&
+		(parse->commandType == CMD_SELECT ||
+		 parse->commandType == CMD_INSERT) &&
 		!parse->hasModifyingCTE &&
 		max_parallel_workers_per_gather > 0 &&
 		!IsParallelWorker())
@@ -376,9 +379,12 @@ standard_planner(Query *parse, const char *query_string, int cursorOptions,
 	 * parallel-mode restrictions.  If that ends up breaking something, then
 	 * either some function the user included in the query is incorrectly
 	 * labeled as parallel-safe or parallel-restricted when in reality it's
-	 * parallel-unsafe, or else the query planner itself has a bug.
+	 * parallel-unsafe, or else the query planner itself has a bug.  We don't
+	 * impose parallel mode on an INSERT that doesn't use parallelism,
+	 * though.
 	 */
 	glob->parallelModeNeeded = glob->parallelModeOK &&
+		parse->commandType == CMD_SELECT &&
 		(debug_parallel_query != DEBUG_PARALLEL_OFF);
 
 	/* Determine what fraction of the plan is likely to be scanned */
@@ -1636,6 +1642,9 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 		 */
 		if (have_grouping)
 		{
+			if (root->numOrderedAggs > 0 && parse->groupingSets == NIL)
+				choose_hashed_distinct_aggs(root, current_rel->rows);
+
 			current_rel = create_grouping_paths(root,
 												current_rel,
 												grouping_target,
@@ -1710,8 +1719,8 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 	 * If the input rel is marked consider_parallel and there's nothing that's
 	 * not parallel-safe in the LIMIT clause, then the final_rel can be marked
 	 * consider_parallel as well.  Note that if the query has rowMarks or is
-	 * not a SELECT, consider_parallel will be false for every relation in the
-	 * query.
+	 * not a SELECT or INSERT, consider_parallel will be false for every
+	 * relation in the query.
 	 */
 	if (current_rel->consider_parallel &&
 		is_parallel_safe(root, parse->limitOffset) &&
@@ -1956,6 +1965,49 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 		add_path(final_rel, path);
 	}
 
+	/*
+	 * For an INSERT, also consider inserting the rows in parallel workers:
+	 * run the ModifyTable on top of a partial path in each worker, and
+	 * gather nothing but the number of rows inserted.  max_parallel_hazard
+	 * has checked that the target table allows this.
+	 */
+	if (parse->commandType == CMD_INSERT &&
+		final_rel->consider_parallel &&
+		root->glob->maxParallelHazard == PROPARALLEL_SAFE &&
+		current_rel->partial_pathlist != NIL &&
+		!limit_needed(parse))
+	{
+		Path	   *partial_path = linitial(current_rel->partial_pathlist);
+		Path	   *path;
+		double		rows = 0;
+
+		Assert(rt_fetch(parse->resultRelation, parse->rtable)->relkind ==
+			   RELKIND_RELATION);
+		path = (Path *)
+			create_modifytable_path(root, final_rel,
+									partial_path,
+									CMD_INSERT,
+									parse->canSetTag,
+									parse->resultRelation,
+									0,
+									false,
+									list_make1_int(parse->resultRelation),
+									NIL,
+									NIL,
+									NIL,
+									NIL,
+									NULL,
+									NIL,
+									assign_special_exec_param(root));
+		path->parallel_safe = true;
+		path->parallel_workers = partial_path->parallel_workers;
+
+		path = (Path *) create_gather_path(root, final_rel, path,
+										   create_empty_pathtarget(),
+										   NULL, &rows);
+		add_path(final_rel, path);
+	}
+
 	/*
 	 * Generate partial paths for final_rel, too, if outer query levels might
 	 * be able to make use of them.
@@ -3656,6 +3708,111 @@ get_number_of_groups(PlannerInfo *root,
 	return dNumGroups;
 }
 
+/*
+ * choose_hashed_distinct_aggs
+ *		Decide which DISTINCT aggregates should eliminate duplicate inputs
+ *		with a hash table, and mark their Aggrefs with aggdistincthash.
+ *
+ * A DISTINCT aggregate that doesn't get presorted input sorts all its input
+ * rows in each group, discarding the duplicates only afterwards.  When there
+ * are many duplicates, it's cheaper to weed them out with a hash table as the
+ * rows arrive, so that only the distinct values need to be sorted.  They are
+ * still fed to the transition function in sorted order, so this doesn't
+ * change the aggregate's result.
+ *
+ * We only consider single-argument aggregates with a hashable equality
+ * operator, and only when the distinct values of a group are expected to fit
+ * in hash_mem.  If the hash table fills up anyway, the executor sorts the
+ * remaining input as usual.
+ *
+ * This runs before create_grouping_paths decides which aggregates get
+ * presorted input, so we can't skip those here.  That's harmless: the
+ * executor ignores aggdistincthash when the Aggref is marked aggpresorted.
+ */
+static void
+choose_hashed_distinct_aggs(PlannerInfo *root, double path_rows)
+{
+	Query	   *parse = root->parse;
+	List	   *groupExprs = NIL;
+	double		dNumGroups = 1;
+	double		hash_mem_limit = (double) get_hash_memory_limit();
+	ListCell   *lc;
+
+	/* Shouldn't be here if there are grouping sets */
+	Assert(parse->groupingSets == NIL);
+
+	if (root->processed_groupClause)
+	{
+		groupExprs = get_sortgrouplist_exprs(root->processed_groupClause,
+											 parse->targetList);
+		dNumGroups = estimate_num_groups(root, groupExprs, path_rows,
+										 NULL, NULL);
+	}
+
+	foreach(lc, root->agginfos)
+	{
+		AggInfo    *agginfo = lfirst_node(AggInfo, lc);
+		Aggref	   *aggref = linitial_node(Aggref, agginfo->aggrefs);
+		SortGroupClause *sortcl;
+		TargetEntry *tle;
+		double		inputRows;
+		double		distinctRows;
+		int32		width;
+		Path		sort_path;	/* dummy for result of cost_sort */
+		Cost		sort_cost;
+		Cost		hash_cost;
+		ListCell   *lc2;
+
+		if (AGGKIND_IS_ORDERED_SET(aggref->aggkind) ||
+			list_length(aggref->aggdistinct) != 1 ||
+			list_length(aggref->args) != 1)
+			continue;
+
+		sortcl = linitial_node(SortGroupClause, aggref->aggdistinct);
+		tle = linitial_node(TargetEntry, aggref->args);
+
+		if (!sortcl->hashable ||
+			contain_volatile_functions((Node *) tle->expr))
+			continue;
+
+		/* Estimate the number of input rows and distinct values per group */
+		inputRows = clamp_row_est(path_rows / dNumGroups);
+		distinctRows = estimate_num_groups(root,
+										   lappend(list_copy(groupExprs),
+												   tle->expr),
+										   path_rows, NULL, NULL);
+		distinctRows = Min(clamp_row_est(distinctRows / dNumGroups),
+						   inputRows);
+
+		/* Give up if the hash table isn't expected to fit in memory */
+		width = get_typavgwidth(exprType((Node *) tle->expr),
+								exprTypmod((Node *) tle->expr));
+		if (distinctRows * (2 * sizeof(Datum) + width) > hash_mem_limit)
+			continue;
+
+		/*
+		 * Compare the cost of sorting all the input rows with that of hashing
+		 * them, at a hash function and an equality function call per row,
+		 * and then sorting only the distinct values.
+		 */
+		cost_sort(&sort_path, root, NIL, 0.0, inputRows, width,
+				  0.0, work_mem, -1.0);
+		sort_cost = sort_path.total_cost;
+		cost_sort(&sort_path, root, NIL, 0.0, distinctRows, width,
+				  0.0, work_mem, -1.0);
+		hash_cost = 2.0 * cpu_operator_cost * inputRows + sort_path.total_cost;
+		if (hash_cost >= sort_cost)
+			continue;
+
+		foreach(lc2, agginfo->aggrefs)
+		{
+			Aggref	   *aggref2 = lfirst_node(Aggref, lc2);
+
+			aggref2->aggdistincthash = true;
+		}
+	}
+}
+
 /*
  * create_grouping_paths
  *
@@ -6654,7 +6811,8 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
  *		CREATE INDEX should request for use
  *
  * tableOid is the table on which the index is to be built.  indexOid is the
- * OID of an index to be created or reindexed (which must be a btree index).
+ * OID of an index to be created or reindexed (which must be a btree or GIN
+ * index).
  *
  * Return value is the number of parallel worker processes to request.  It
  * may be unsafe to proceed if this is 0.  Note that this does not include the
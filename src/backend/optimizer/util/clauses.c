@@ -20,6 +20,8 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "access/table.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_class.h"
 #include "catalog/pg_language.h"
@@ -44,6 +46,7 @@
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
 #include "parser/parse_func.h"
+#include "parser/parsetree.h"
 #include "rewrite/rewriteHandler.h"
 #include "rewrite/rewriteManip.h"
 #include "tcop/tcopprot.h"
@@ -55,6 +58,7 @@
 #include "utils/jsonb.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
 #include "utils/syscache.h"
 #include "utils/typcache.h"
 
@@ -102,6 +106,8 @@ static bool contain_volatile_functions_walker(Node *node, void *context);
 static bool contain_volatile_functions_not_nextval_walker(Node *node, void *context);
 static bool max_parallel_hazard_walker(Node *node,
 									   max_parallel_hazard_context *context);
+static bool target_rel_max_parallel_hazard(Query *parse,
+										   max_parallel_hazard_context *context);
 static bool contain_nonstrict_functions_walker(Node *node, void *context);
 static bool contain_exec_param_walker(Node *node, List *param_ids);
 static bool contain_context_dependent_node(Node *clause);
@@ -646,6 +652,8 @@ contain_volatile_functions_not_nextval_walker(Node *node, void *context)
  * can be parallelized at all.  The caller will also save the result in
  * PlannerGlobal so as to short-circuit checks of portions of the querytree
  * later, in the common case where everything is SAFE.
+ *
+ * For an INSERT, the target table is taken into account, too.
  */
 char
 max_parallel_hazard(Query *parse)
@@ -655,7 +663,9 @@ max_parallel_hazard(Query *parse)
 	context.max_hazard = PROPARALLEL_SAFE;
 	context.max_interesting = PROPARALLEL_UNSAFE;
 	context.safe_param_ids = NIL;
-	(void) max_parallel_hazard_walker((Node *) parse, &context);
+	if (!max_parallel_hazard_walker((Node *) parse, &context) &&
+		parse->commandType == CMD_INSERT)
+		(void) target_rel_max_parallel_hazard(parse, &context);
 	return context.max_hazard;
 }
 
@@ -889,6 +899,71 @@ max_parallel_hazard_walker(Node *node, max_parallel_hazard_context *context)
 								  context);
 }
 
+/*
+ * target_rel_max_parallel_hazard
+ *		Check the target table of an INSERT for parallel hazards
+ *
+ * Rows can be inserted in parallel mode, or by parallel workers, only into a
+ * plain heap table without indexes, triggers or stored generated columns,
+ * and only by an INSERT without ON CONFLICT, RETURNING or WITH CHECK
+ * OPTIONs; anything else is parallel-unsafe.  Otherwise, the table's CHECK
+ * constraints are the only expressions evaluated while inserting, so their
+ * hazard is what counts.
+ */
+static bool
+target_rel_max_parallel_hazard(Query *parse,
+							   max_parallel_hazard_context *context)
+{
+	RangeTblEntry *rte = rt_fetch(parse->resultRelation, parse->rtable);
+	Relation	rel;
+	TupleConstr *constr;
+	List	   *indexoidlist;
+	bool		result = false;
+
+	if (rte->relkind != RELKIND_RELATION ||
+		parse->onConflict != NULL ||
+		parse->returningList != NIL ||
+		parse->withCheckOptions != NIL)
+		return max_parallel_hazard_test(PROPARALLEL_UNSAFE, context);
+
+	/* The parser or rewriter already locked the table */
+	rel = table_open(rte->relid, NoLock);
+	constr = rel->rd_att->constr;
+	indexoidlist = RelationGetIndexList(rel);
+
+	/*
+	 * Workers can't access temporary tables, and other table AMs haven't
+	 * been taught to insert in parallel.  Nor can workers know whether WAL
+	 * is being skipped for a table created or truncated in this transaction.
+	 */
+	if (rel->rd_rel->relpersistence == RELPERSISTENCE_TEMP ||
+		rel->rd_rel->relam != HEAP_TABLE_AM_OID ||
+		(rel->rd_rel->relpersistence == RELPERSISTENCE_PERMANENT &&
+		 !RelationNeedsWAL(rel)) ||
+		rel->trigdesc != NULL ||
+		indexoidlist != NIL ||
+		(constr != NULL && constr->has_generated_stored))
+		result = max_parallel_hazard_test(PROPARALLEL_UNSAFE, context);
+	else if (constr != NULL)
+	{
+		for (int i = 0; i < constr->num_check; i++)
+		{
+			Node	   *check_expr = stringToNode(constr->check[i].ccbin);
+
+			if (max_parallel_hazard_walker(check_expr, context))
+			{
+				result = true;
+				break;
+			}
+		}
+	}
+
+	list_free(indexoidlist);
+	table_close(rel, NoLock);
+
+	return result;
+}
+
 
 /*****************************************************************************
  *		Check clauses for nonstrict functions
@@ -1591,11 +1591,16 @@ create_material_path(RelOptInfo *rel, Path *subpath)
 /*
  * create_memoize_path
  *	  Creates a path corresponding to a Memoize plan, returning the pathnode.
+ *
+ * 'calls' is the number of rescans expected in each process.  If
+ * 'parallel_workers' is nonzero, the cache is to be shared by that many
+ * workers and the leader, making this a Parallel Memoize path.
  */
 MemoizePath *
 create_memoize_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 					List *param_exprs, List *hash_operators,
-					bool singlerow, bool binary_mode, double calls)
+					bool singlerow, bool binary_mode, double calls,
+					int parallel_workers)
 {
 	MemoizePath *pathnode = makeNode(MemoizePath);
 
@@ -1605,10 +1610,11 @@ create_memoize_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 	pathnode->path.parent = rel;
 	pathnode->path.pathtarget = rel->reltarget;
 	pathnode->path.param_info = subpath->param_info;
-	pathnode->path.parallel_aware = false;
+	pathnode->path.parallel_aware = (parallel_workers > 0);
 	pathnode->path.parallel_safe = rel->consider_parallel &&
 		subpath->parallel_safe;
-	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.parallel_workers = pathnode->path.parallel_aware ?
+		parallel_workers : subpath->parallel_workers;
 	pathnode->path.pathkeys = subpath->pathkeys;
 
 	pathnode->subpath = subpath;
@@ -3999,7 +4005,9 @@ reparameterize_path(PlannerInfo *root, Path *path,
 													mpath->hash_operators,
 													mpath->singlerow,
 													mpath->binary_mode,
-													mpath->calls);
+													mpath->calls,
+													mpath->path.parallel_aware ?
+													mpath->path.parallel_workers : 0);
 			}
 		default:
 			break;
@@ -3733,6 +3733,7 @@ transformJsonAggConstructor(ParseState *pstate, JsonAggConstructor *agg_ctor,
 		aggref->aggvariadic = false;
 		aggref->aggkind = AGGKIND_NORMAL;
 		aggref->aggpresorted = false;
+		aggref->aggdistincthash = false;
 		/* agglevelsup will be set by transformAggregateCall */
 		aggref->aggsplit = AGGSPLIT_SIMPLE; /* planner might change this */
 		aggref->aggno = -1;		/* planner will set aggno and aggtransno */
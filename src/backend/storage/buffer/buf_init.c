@@ -14,9 +14,12 @@
  */
 #include "postgres.h"
 
+#include "port/pg_numa.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/pg_shmem.h"
 #include "storage/proc.h"
+#include "utils/guc.h"
 
 BufferDescPadded *BufferDescriptors;
 char	   *BufferBlocks;
@@ -24,6 +27,11 @@ ConditionVariableMinimallyPadded *BufferIOCVArray;
 WritebackContext BackendWritebackContext;
 CkptSortItem *CkptBufferIds;
 
+/* GUC variable */
+bool		shared_buffers_numa_interleave = false;
+
+static void InterleaveBufferPool(void);
+
 
 /*
  * Data Structures:
@@ -112,6 +120,13 @@ InitBufferPool(void)
 	{
 		int			i;
 
+		/*
+		 * Set up NUMA placement before anything touches the memory, as the
+		 * policy only applies to pages faulted in afterwards.
+		 */
+		if (shared_buffers_numa_interleave)
+			InterleaveBufferPool();
+
 		/*
 		 * Initialize all the buffer headers.
 		 */
@@ -150,6 +165,46 @@ InitBufferPool(void)
 						 &backend_flush_after);
 }
 
+/*
+ * Spread the buffer pool and the buffer descriptors evenly over all NUMA
+ * nodes.
+ *
+ * By default, each page of shared memory ends up on the node of the process
+ * that first touches it, which for the buffer descriptors is the postmaster
+ * initializing them, and for the buffer blocks is whichever backend happens
+ * to read a page into the buffer first.  On large multi-socket machines that
+ * can leave most of the buffer pool on a few nodes, so that the memory
+ * bandwidth of the others goes unused.  Interleaving makes accesses from all
+ * backends equally expensive on average, and balances the bandwidth usage.
+ *
+ * If shared memory is backed by huge pages, those are the unit that gets
+ * placed on a node, so the ranges are aligned to the huge page size.
+ */
+static void
+InterleaveBufferPool(void)
+{
+	Size		pagesize = 0;
+
+	if (pg_numa_init() == -1)
+	{
+		ereport(LOG,
+				(errmsg("NUMA is not available on this system, shared buffers will not be interleaved")));
+		return;
+	}
+
+	if (strcmp(GetConfigOption("huge_pages_status", false, false), "on") == 0)
+		GetHugePageSize(&pagesize, NULL);
+
+	if (pg_numa_interleave_memory(BufferDescriptors,
+								  NBuffers * sizeof(BufferDescPadded),
+								  pagesize) != 0 ||
+		pg_numa_interleave_memory(BufferBlocks,
+								  NBuffers * (Size) BLCKSZ,
+								  pagesize) != 0)
+		ereport(LOG,
+				(errmsg("could not interleave shared buffers across NUMA nodes: %m")));
+}
+
 /*
  * BufferShmemSize
  *
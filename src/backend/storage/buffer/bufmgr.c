@@ -53,6 +53,7 @@
 #include "storage/smgr.h"
 #include "storage/standby.h"
 #include "utils/memdebug.h"
+#include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
@@ -67,12 +68,21 @@
 #define LocalBufHdrGetBlock(bufHdr) \
 	LocalBufferBlockPointers[-((bufHdr)->buf_id + 2)]
 
-/* Bits in SyncOneBuffer's return value */
-#define BUF_WRITTEN				0x01
-#define BUF_REUSABLE			0x02
+/*
+ * Number of dirty buffers the bgwriter's LRU scan collects before sorting
+ * them and writing them out, so that buffers holding consecutive blocks can
+ * be written with a single vectored write.
+ */
+#define LRU_WRITE_BATCH			64
 
 #define RELS_BSEARCH_THRESHOLD		20
 
+/*
+ * Maximum number of buffers holding consecutive blocks that the checkpointer
+ * writes out with a single vectored write.
+ */
+#define MAX_WRITE_COMBINE_BUFFERS	Min(PG_IOV_MAX, 16)
+
 /*
  * This is the size (in the number of blocks) above which we scan the
  * entire buffer pool to remove the buffers for all the pages of relation
@@ -472,8 +482,14 @@ static void PinBuffer_Locked(BufferDesc *buf);
 static void UnpinBuffer(BufferDesc *buf);
 static void BufferSync(int flags);
 static uint32 WaitBufHdrUnlocked(BufferDesc *buf);
-static int	SyncOneBuffer(int buf_id, bool skip_recently_used,
+static bool CheckLruBuffer(int buf_id, CkptSortItem *item, bool *needs_write);
+static int	SyncLruBuffers(CkptSortItem *items, int nitems,
+						   WritebackContext *wb_context);
+static int	SyncBufferRun(CkptSortItem *items, int nitems,
+						  bool skip_recently_used,
 						  WritebackContext *wb_context);
+static int	FlushBufferBatch(BufferDesc **batch, int nbuffers,
+							 WritebackContext *wb_context);
 static void WaitIO(BufferDesc *buf);
 static bool StartBufferIO(BufferDesc *buf, bool forInput);
 static void TerminateBufferIO(BufferDesc *buf, bool clear_dirty,
@@ -1684,6 +1700,14 @@ again:
 		FlushBuffer(buf_hdr, NULL, IOOBJECT_RELATION, io_context);
 		LWLockRelease(content_lock);
 
+		/*
+		 * Buffers recycled by a strategy ring are expected to be written by
+		 * the backend itself, but if the clock sweep handed us a dirty
+		 * buffer, the bgwriter hasn't kept up.  Let it know.
+		 */
+		if (!from_ring)
+			StrategyReportDirtyEviction();
+
 		ScheduleBufferTagForWriteback(&BackendWritebackContext, io_context,
 									  &buf_hdr->tag);
 	}
@@ -2491,9 +2515,6 @@ BufferSync(int flags)
 	int			mask = BM_DIRTY;
 	WritebackContext wb_context;
 
-	/* Make sure we can handle the pin inside SyncOneBuffer */
-	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
-
 	/*
 	 * Unless this is a shutdown checkpoint or we have been explicitly told,
 	 * we write only permanent, dirty buffers.  But at shutdown or end of
@@ -2526,7 +2547,7 @@ BufferSync(int flags)
 
 		/*
 		 * Header spinlock is enough to examine BM_DIRTY, see comment in
-		 * SyncOneBuffer.
+		 * CheckLruBuffer.
 		 */
 		buf_state = LockBufHdr(bufHdr);
 
@@ -2659,51 +2680,44 @@ BufferSync(int flags)
 	 * marked with BM_CHECKPOINT_NEEDED. The writes are balanced between
 	 * tablespaces; otherwise the sorting would lead to only one tablespace
 	 * receiving writes at a time, making inefficient use of the hardware.
+	 *
+	 * Since the buffers are sorted by block number within each relation
+	 * fork, runs of consecutive blocks are processed together, so that they
+	 * can be written with a single vectored write.
 	 */
 	num_processed = 0;
 	num_written = 0;
 	while (!binaryheap_empty(ts_heap))
 	{
-		BufferDesc *bufHdr = NULL;
 		CkptTsStatus *ts_stat = (CkptTsStatus *)
 			DatumGetPointer(binaryheap_first(ts_heap));
+		CkptSortItem *run = &CkptBufferIds[ts_stat->index];
+		int			nremaining = ts_stat->num_to_scan - ts_stat->num_scanned;
+		int			nrun;
+		int			nwritten;
 
-		buf_id = CkptBufferIds[ts_stat->index].buf_id;
-		Assert(buf_id != -1);
-
-		bufHdr = GetBufferDescriptor(buf_id);
-
-		num_processed++;
-
-		/*
-		 * We don't need to acquire the lock here, because we're only looking
-		 * at a single bit. It's possible that someone else writes the buffer
-		 * and clears the flag right after we check, but that doesn't matter
-		 * since SyncOneBuffer will then do nothing.  However, there is a
-		 * further race condition: it's conceivable that between the time we
-		 * examine the bit here and the time SyncOneBuffer acquires the lock,
-		 * someone else not only wrote the buffer but replaced it with another
-		 * page and dirtied it.  In that improbable case, SyncOneBuffer will
-		 * write the buffer though we didn't need to.  It doesn't seem worth
-		 * guarding against this, though.
-		 */
-		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
+		/* Find the run of consecutive blocks starting at this buffer */
+		for (nrun = 1; nrun < Min(nremaining, MAX_WRITE_COMBINE_BUFFERS); nrun++)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
-			{
-				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
-				PendingCheckpointerStats.buf_written_checkpoints++;
-				num_written++;
-			}
+			if (run[nrun].relNumber != run[0].relNumber ||
+				run[nrun].forkNum != run[0].forkNum ||
+				run[nrun].blockNum != run[0].blockNum + nrun)
+				break;
 		}
 
+		num_processed += nrun;
+
+		nwritten = SyncBufferRun(run, nrun, false, &wb_context);
+		PendingCheckpointerStats.buf_written_checkpoints += nwritten;
+		num_written += nwritten;
+
 		/*
 		 * Measure progress independent of actually having to flush the buffer
 		 * - otherwise writing become unbalanced.
 		 */
-		ts_stat->progress += ts_stat->progress_slice;
-		ts_stat->num_scanned++;
-		ts_stat->index++;
+		ts_stat->progress += ts_stat->progress_slice * nrun;
+		ts_stat->num_scanned += nrun;
+		ts_stat->index += nrun;
 
 		/* Have all the buffers from the tablespace been processed? */
 		if (ts_stat->num_scanned == ts_stat->num_to_scan)
@@ -2761,6 +2775,7 @@ BgBufferSync(WritebackContext *wb_context)
 	int			strategy_buf_id;
 	uint32		strategy_passes;
 	uint32		recent_alloc;
+	uint32		recent_dirty_evictions;
 
 	/*
 	 * Information saved between calls so we can determine the strategy
@@ -2776,6 +2791,9 @@ BgBufferSync(WritebackContext *wb_context)
 	static float smoothed_alloc = 0;
 	static float smoothed_density = 10.0;
 
+	/* Extra clean buffers to provide, driven by backends' own writes */
+	static float eviction_demand = 0;
+
 	/* Potentially these could be tunables, but for now, not */
 	float		smoothing_samples = 16;
 	float		scan_whole_pool_milliseconds = 120000.0;
@@ -2788,9 +2806,13 @@ BgBufferSync(WritebackContext *wb_context)
 	int			reusable_buffers_est;
 	int			upcoming_alloc_est;
 	int			min_scan_buffers;
+	int			max_to_write;
 
 	/* Variables for the scanning loop proper */
+	CkptSortItem candidates[LRU_WRITE_BATCH];
+	int			num_candidates;
 	int			num_to_scan;
+	int			num_to_write;
 	int			num_written;
 	int			reusable_buffers;
 
@@ -2799,13 +2821,16 @@ BgBufferSync(WritebackContext *wb_context)
 	uint32		new_recent_alloc;
 
 	/*
-	 * Find out where the freelist clock sweep currently is, and how many
-	 * buffer allocations have happened since our last call.
+	 * Find out where the freelist clock sweep currently is, how many buffer
+	 * allocations have happened since our last call, and how many of those
+	 * found a dirty victim that the backend had to write out itself.
 	 */
-	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc);
+	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc,
+										&recent_dirty_evictions);
 
 	/* Report buffer alloc counts to pgstat */
 	PendingBgWriterStats.buf_alloc += recent_alloc;
+	PendingBgWriterStats.buf_written_evict += recent_dirty_evictions;
 
 	/*
 	 * If we're not running the LRU scan, just stop after doing the stats
@@ -2963,25 +2988,50 @@ BgBufferSync(WritebackContext *wb_context)
 		upcoming_alloc_est = min_scan_buffers + reusable_buffers_est;
 	}
 
+	/*
+	 * Every dirty victim a backend had to write out itself since last time
+	 * means the pool of clean, reusable buffers ahead of the clock sweep ran
+	 * dry, however good the allocation estimate looked.  Feed that demand
+	 * back: raise the clean-buffer target by the number of such writes, and
+	 * let the extra target decay only slowly once backends stop writing.
+	 * The extra target also raises the bgwriter_lru_maxpages limit for this
+	 * round, since the point of that limit is to avoid needless writes, and
+	 * these writes are going to happen anyway, just in the foreground.
+	 */
+	if (recent_dirty_evictions > 0)
+		eviction_demand = Min(eviction_demand + recent_dirty_evictions,
+							  (float) NBuffers);
+	else
+		eviction_demand -= eviction_demand / smoothing_samples;
+	if (eviction_demand < 1)
+		eviction_demand = 0;
+
+	upcoming_alloc_est = Min(upcoming_alloc_est + (int) eviction_demand,
+							 NBuffers);
+	max_to_write = bgwriter_lru_maxpages + (int) eviction_demand;
+
 	/*
 	 * Now write out dirty reusable buffers, working forward from the
 	 * next_to_clean point, until we have lapped the strategy scan, or cleaned
 	 * enough buffers to match our estimate of the next cycle's allocation
-	 * requirements, or hit the bgwriter_lru_maxpages limit.
+	 * requirements, or hit the write limit.
+	 *
+	 * Dirty buffers are collected in batches of LRU_WRITE_BATCH, which
+	 * SyncLruBuffers() sorts so that consecutive blocks of a relation can be
+	 * written together.  Buffers are usually filled in clock sweep order as
+	 * they are read in, so scans tend to leave such runs behind.
 	 */
-
-	/* Make sure we can handle the pin inside SyncOneBuffer */
-	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
-
 	num_to_scan = bufs_to_lap;
+	num_candidates = 0;
+	num_to_write = 0;
 	num_written = 0;
 	reusable_buffers = reusable_buffers_est;
 
 	/* Execute the LRU scan */
 	while (num_to_scan > 0 && reusable_buffers < upcoming_alloc_est)
 	{
-		int			sync_state = SyncOneBuffer(next_to_clean, true,
-											   wb_context);
+		int			buf_id = StrategyBufferAtClockPosition(next_to_clean);
+		bool		needs_write;
 
 		if (++next_to_clean >= NBuffers)
 		{
@@ -2990,24 +3040,35 @@ BgBufferSync(WritebackContext *wb_context)
 		}
 		num_to_scan--;
 
-		if (sync_state & BUF_WRITTEN)
+		if (!CheckLruBuffer(buf_id, &candidates[num_candidates], &needs_write))
+			continue;
+
+		reusable_buffers++;
+		if (needs_write)
 		{
-			reusable_buffers++;
-			if (++num_written >= bgwriter_lru_maxpages)
+			if (++num_candidates == LRU_WRITE_BATCH)
+			{
+				num_written += SyncLruBuffers(candidates, num_candidates,
+											  wb_context);
+				num_candidates = 0;
+			}
+			if (++num_to_write >= max_to_write)
 			{
 				PendingBgWriterStats.maxwritten_clean++;
 				break;
 			}
 		}
-		else if (sync_state & BUF_REUSABLE)
-			reusable_buffers++;
 	}
 
+	if (num_candidates > 0)
+		num_written += SyncLruBuffers(candidates, num_candidates, wb_context);
+
 	PendingBgWriterStats.buf_written_clean += num_written;
 
 #ifdef BGW_DEBUG
-	elog(DEBUG1, "bgwriter: recent_alloc=%u smoothed=%.2f delta=%ld ahead=%d density=%.2f reusable_est=%d upcoming_est=%d scanned=%d wrote=%d reusable=%d",
-		 recent_alloc, smoothed_alloc, strategy_delta, bufs_ahead,
+	elog(DEBUG1, "bgwriter: recent_alloc=%u smoothed=%.2f dirty_evictions=%u demand=%.2f delta=%ld ahead=%d density=%.2f reusable_est=%d upcoming_est=%d scanned=%d wrote=%d reusable=%d",
+		 recent_alloc, smoothed_alloc, recent_dirty_evictions, eviction_demand,
+		 strategy_delta, bufs_ahead,
 		 smoothed_density, reusable_buffers_est, upcoming_alloc_est,
 		 bufs_to_lap - num_to_scan,
 		 num_written,
@@ -3042,30 +3103,19 @@ BgBufferSync(WritebackContext *wb_context)
 }
 
 /*
- * SyncOneBuffer -- process a single buffer during syncing.
+ * CheckLruBuffer -- examine a buffer during the bgwriter's LRU scan
  *
- * If skip_recently_used is true, we don't write currently-pinned buffers, nor
- * buffers marked recently used, as these are not replacement candidates.
- *
- * Returns a bitmask containing the following flag bits:
- *	BUF_WRITTEN: we wrote the buffer.
- *	BUF_REUSABLE: buffer is available for replacement, ie, it has
- *		pin count 0 and usage count 0.
- *
- * (BUF_WRITTEN could be set in error if FlushBuffer finds the buffer clean
- * after locking it, but we don't care all that much.)
- *
- * Note: caller must have done ResourceOwnerEnlargeBuffers.
+ * Returns true if the buffer is available for replacement, ie, it has pin
+ * count 0 and usage count 0.  If it is also dirty, *needs_write is set and
+ * *item is filled in to describe the buffer for SyncLruBuffers().
  */
-static int
-SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
+static bool
+CheckLruBuffer(int buf_id, CkptSortItem *item, bool *needs_write)
 {
 	BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
-	int			result = 0;
 	uint32		buf_state;
-	BufferTag	tag;
 
-	ReservePrivateRefCountEntry();
+	*needs_write = false;
 
 	/*
 	 * Check whether buffer needs writing.
@@ -3078,47 +3128,328 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	 */
 	buf_state = LockBufHdr(bufHdr);
 
-	if (BUF_STATE_GET_REFCOUNT(buf_state) == 0 &&
-		BUF_STATE_GET_USAGECOUNT(buf_state) == 0)
+	if (BUF_STATE_GET_REFCOUNT(buf_state) != 0 ||
+		BUF_STATE_GET_USAGECOUNT(buf_state) != 0)
 	{
-		result |= BUF_REUSABLE;
+		UnlockBufHdr(bufHdr, buf_state);
+		return false;
 	}
-	else if (skip_recently_used)
+
+	if ((buf_state & BM_VALID) && (buf_state & BM_DIRTY))
 	{
-		/* Caller told us not to write recently-used buffers */
-		UnlockBufHdr(bufHdr, buf_state);
-		return result;
+		*needs_write = true;
+		item->buf_id = buf_id;
+		item->tsId = bufHdr->tag.spcOid;
+		item->relNumber = BufTagGetRelNumber(&bufHdr->tag);
+		item->forkNum = BufTagGetForkNum(&bufHdr->tag);
+		item->blockNum = bufHdr->tag.blockNum;
 	}
 
-	if (!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY))
+	UnlockBufHdr(bufHdr, buf_state);
+
+	return true;
+}
+
+/*
+ * SyncLruBuffers -- write out dirty buffers found by the LRU scan
+ *
+ * The items are sorted into block order and handed to SyncBufferRun() one run
+ * of consecutive blocks at a time.  Buffers that have been used again since
+ * CheckLruBuffer() looked at them are skipped.
+ *
+ * Returns the number of buffers written.
+ */
+static int
+SyncLruBuffers(CkptSortItem *items, int nitems, WritebackContext *wb_context)
+{
+	int			num_written = 0;
+	int			nrun;
+
+	sort_checkpoint_bufferids(items, nitems);
+
+	for (int i = 0; i < nitems; i += nrun)
 	{
-		/* It's clean, so nothing to do */
-		UnlockBufHdr(bufHdr, buf_state);
-		return result;
+		CkptSortItem *run = &items[i];
+
+		for (nrun = 1; nrun < Min(nitems - i, MAX_WRITE_COMBINE_BUFFERS); nrun++)
+		{
+			if (run[nrun].tsId != run[0].tsId ||
+				run[nrun].relNumber != run[0].relNumber ||
+				run[nrun].forkNum != run[0].forkNum ||
+				run[nrun].blockNum != run[0].blockNum + nrun)
+				break;
+		}
+
+		num_written += SyncBufferRun(run, nrun, true, wb_context);
+	}
+
+	return num_written;
+}
+
+/*
+ * SyncBufferRun -- write out a run of buffers for BufferSync or BgBufferSync
+ *
+ * The items are consecutive entries of a sorted buffer list, describing
+ * consecutive blocks of one relation fork.  Each buffer that still needs
+ * writing and is dirty is pinned, share-locked and put into I/O-in-progress
+ * state, and the buffers are then handed to FlushBufferBatch() to be written
+ * with as few vectored writes as possible.
+ *
+ * For a checkpoint, a buffer needs writing if it is still marked
+ * BM_CHECKPOINT_NEEDED.  If skip_recently_used is true (for the bgwriter),
+ * a buffer needs writing if it is still unpinned and has usage count 0, as
+ * in CheckLruBuffer().
+ *
+ * A buffer might have been evicted and reused for another page since the
+ * list was built, so before adding a buffer to the batch we recheck, with the
+ * pin held, that it really holds the block following the previous one.
+ * Likewise, a buffer that doesn't need writing anymore leaves a gap in the
+ * run.  In both cases the batch collected so far is written out first.
+ *
+ * To avoid deadlocks, we never wait for a buffer content lock while holding
+ * content locks on other buffers; if a lock isn't immediately available, the
+ * pending batch is written out before waiting for it.
+ *
+ * Returns the number of buffers written.
+ */
+static int
+SyncBufferRun(CkptSortItem *items, int nitems, bool skip_recently_used,
+			  WritebackContext *wb_context)
+{
+	BufferDesc *batch[MAX_WRITE_COMBINE_BUFFERS];
+	int			nbatch = 0;
+	int			num_written = 0;
+
+	Assert(nitems <= MAX_WRITE_COMBINE_BUFFERS);
+
+	for (int i = 0; i < nitems; i++)
+	{
+		BufferDesc *bufHdr = GetBufferDescriptor(items[i].buf_id);
+		LWLock	   *content_lock = BufferDescriptorGetContentLock(bufHdr);
+		uint32		buf_state;
+
+		/*
+		 * We don't need to acquire the lock here, because we're only looking
+		 * at a single bit. It's possible that someone else writes the buffer
+		 * and clears the flag right after we check, but that doesn't matter
+		 * since StartBufferIO will then tell us there's nothing to do.
+		 * However, there is a further race condition: it's conceivable that
+		 * between the time we examine the bit here and the time we pin the
+		 * buffer, someone else not only wrote the buffer but replaced it with
+		 * another page and dirtied it.  In that improbable case, we will
+		 * write the buffer though we didn't need to.  It doesn't seem worth
+		 * guarding against this, though.
+		 */
+		if (!skip_recently_used &&
+			!(pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED))
+			continue;
+
+		/* Make sure we can handle the pin */
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+		ReservePrivateRefCountEntry();
+
+		/*
+		 * Header spinlock is enough to examine BM_DIRTY, see comment in
+		 * CheckLruBuffer.
+		 */
+		buf_state = LockBufHdr(bufHdr);
+
+		if (skip_recently_used &&
+			(BUF_STATE_GET_REFCOUNT(buf_state) != 0 ||
+			 BUF_STATE_GET_USAGECOUNT(buf_state) != 0))
+		{
+			/* Caller told us not to write recently-used buffers */
+			UnlockBufHdr(bufHdr, buf_state);
+			continue;
+		}
+
+		if (!(buf_state & BM_VALID) || !(buf_state & BM_DIRTY))
+		{
+			/* It's clean, so nothing to do */
+			UnlockBufHdr(bufHdr, buf_state);
+			continue;
+		}
+
+		PinBuffer_Locked(bufHdr);
+
+		/* Pinned, so the tag can't change anymore */
+		if (nbatch > 0)
+		{
+			BufferTag  *prev = &batch[nbatch - 1]->tag;
+			RelFileLocator rlocator = BufTagGetRelFileLocator(prev);
+
+			if (!BufTagMatchesRelFileLocator(&bufHdr->tag, &rlocator) ||
+				BufTagGetForkNum(&bufHdr->tag) != BufTagGetForkNum(prev) ||
+				bufHdr->tag.blockNum != prev->blockNum + 1)
+			{
+				num_written += FlushBufferBatch(batch, nbatch, wb_context);
+				nbatch = 0;
+			}
+		}
+
+		if (nbatch == 0)
+			LWLockAcquire(content_lock, LW_SHARED);
+		else if (!LWLockConditionalAcquire(content_lock, LW_SHARED))
+		{
+			num_written += FlushBufferBatch(batch, nbatch, wb_context);
+			nbatch = 0;
+			LWLockAcquire(content_lock, LW_SHARED);
+		}
+
+		/*
+		 * If StartBufferIO returns false, then someone else flushed the
+		 * buffer before we could, so we need not do anything.
+		 */
+		if (!StartBufferIO(bufHdr, false))
+		{
+			LWLockRelease(content_lock);
+			UnpinBuffer(bufHdr);
+			continue;
+		}
+
+		batch[nbatch++] = bufHdr;
+	}
+
+	if (nbatch > 0)
+		num_written += FlushBufferBatch(batch, nbatch, wb_context);
+
+	return num_written;
+}
+
+/*
+ * FlushBufferBatch -- write out buffers holding consecutive blocks
+ *
+ * This is the equivalent of FlushBuffer() for a batch of buffers prepared by
+ * SyncBufferRun(): the buffers hold consecutive blocks of one relation fork,
+ * and are pinned, share-locked and marked BM_IO_IN_PROGRESS by us.  They are
+ * written with smgrwritev(), after which the I/O is terminated, and the locks
+ * and pins are released.
+ *
+ * Returns the number of buffers written.
+ */
+static int
+FlushBufferBatch(BufferDesc **batch, int nbuffers, WritebackContext *wb_context)
+{
+	static char *pageCopies = NULL;
+	const void *blocks[MAX_WRITE_COMBINE_BUFFERS];
+	BufferDesc *first = batch[0];
+	XLogRecPtr	max_recptr = InvalidXLogRecPtr;
+	ErrorContextCallback errcallback;
+	instr_time	io_start;
+	SMgrRelation reln;
+
+	Assert(nbuffers > 0 && nbuffers <= MAX_WRITE_COMBINE_BUFFERS);
+
+	/* Setup error traceback support for ereport() */
+	errcallback.callback = shared_buffer_write_error_callback;
+	errcallback.arg = (void *) first;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	reln = smgropen(BufTagGetRelFileLocator(&first->tag), InvalidBackendId);
+
+	for (int i = 0; i < nbuffers; i++)
+	{
+		BufferDesc *buf = batch[i];
+		XLogRecPtr	recptr;
+		uint32		buf_state;
+
+		buf_state = LockBufHdr(buf);
+
+		/*
+		 * Run PageGetLSN while holding header lock, since we don't have the
+		 * buffer locked exclusively in all cases.
+		 */
+		recptr = BufferGetLSN(buf);
+
+		/* To check if block content changes while flushing. */
+		buf_state &= ~BM_JUST_DIRTIED;
+		UnlockBufHdr(buf, buf_state);
+
+		/* See FlushBuffer about skipping the flush for unlogged buffers */
+		if ((buf_state & BM_PERMANENT) && recptr > max_recptr)
+			max_recptr = recptr;
 	}
 
 	/*
-	 * Pin it, share-lock it, write it.  (FlushBuffer will do nothing if the
-	 * buffer is clean by the time we've locked it.)
+	 * Force XLOG flush up to the highest LSN of the batch, which is enough to
+	 * satisfy the WAL-before-data rule for all of its buffers.
 	 */
-	PinBuffer_Locked(bufHdr);
-	LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
+	if (!XLogRecPtrIsInvalid(max_recptr))
+		XLogFlush(max_recptr);
 
-	FlushBuffer(bufHdr, NULL, IOOBJECT_RELATION, IOCONTEXT_NORMAL);
+	/*
+	 * Update page checksums if desired.  Since we have only shared locks on
+	 * the buffers, other processes might be updating hint bits in them, so
+	 * we must copy the pages to private storage if we do checksumming.
+	 */
+	for (int i = 0; i < nbuffers; i++)
+	{
+		Block		bufBlock = BufHdrGetBlock(batch[i]);
 
-	LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
+		if (DataChecksumsEnabled())
+		{
+			char	   *copy;
+
+			if (pageCopies == NULL)
+				pageCopies = MemoryContextAllocAligned(TopMemoryContext,
+													   MAX_WRITE_COMBINE_BUFFERS * BLCKSZ,
+													   PG_IO_ALIGN_SIZE,
+													   0);
+
+			copy = pageCopies + i * BLCKSZ;
+			memcpy(copy, bufBlock, BLCKSZ);
+			PageSetChecksumInplace((Page) copy, batch[i]->tag.blockNum);
+			blocks[i] = copy;
+		}
+		else
+			blocks[i] = bufBlock;
+	}
 
-	tag = bufHdr->tag;
+	io_start = pgstat_prepare_io_time();
 
-	UnpinBuffer(bufHdr);
+	smgrwritev(reln,
+			   BufTagGetForkNum(&first->tag),
+			   first->tag.blockNum,
+			   blocks,
+			   nbuffers,
+			   false);
 
 	/*
-	 * SyncOneBuffer() is only called by checkpointer and bgwriter, so
-	 * IOContext will always be IOCONTEXT_NORMAL.
+	 * Only checkpointer and bgwriter get here, so IOContext is always
+	 * IOCONTEXT_NORMAL.
 	 */
-	ScheduleBufferTagForWriteback(wb_context, IOCONTEXT_NORMAL, &tag);
+	pgstat_count_io_op_time(IOOBJECT_RELATION, IOCONTEXT_NORMAL,
+							IOOP_WRITE, io_start, nbuffers);
+
+	pgBufferUsage.shared_blks_written += nbuffers;
+
+	for (int i = 0; i < nbuffers; i++)
+	{
+		BufferDesc *buf = batch[i];
+		BufferTag	tag;
+
+		/*
+		 * Mark the buffer as clean (unless BM_JUST_DIRTIED has become set)
+		 * and end the BM_IO_IN_PROGRESS state.
+		 */
+		TerminateBufferIO(buf, true, 0);
+
+		TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf->buf_id);
+
+		LWLockRelease(BufferDescriptorGetContentLock(buf));
+
+		tag = buf->tag;
+
+		UnpinBuffer(buf);
+
+		ScheduleBufferTagForWriteback(wb_context, IOCONTEXT_NORMAL, &tag);
+	}
+
+	/* Pop the error context stack */
+	error_context_stack = errcallback.previous;
 
-	return result | BUF_WRITTEN;
+	return nbuffers;
 }
 
 /*
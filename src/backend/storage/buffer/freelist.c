@@ -25,20 +25,69 @@
 
 
 /*
- * The shared freelist control information.
+ * The clock sweep is split into partitions, each covering a contiguous range
+ * of buffer ids and having its own clock hand.  A single hand shared by all
+ * backends makes its cache line the hottest spot in the system once many
+ * backends are evicting buffers concurrently; with partitions, backends
+ * mostly advance different hands.  See "Clock Sweep Partitions" in
+ * buffer/README.
+ *
+ * The number of partitions is chosen at startup so that each partition has at
+ * least MIN_CLOCK_SWEEP_PARTITION_SIZE buffers, up to a maximum of
+ * MAX_CLOCK_SWEEP_PARTITIONS.  A backend re-checks whether it should move off
+ * its home partition every CLOCK_SWEEP_REBALANCE_INTERVAL allocations.
+ */
+#define MAX_CLOCK_SWEEP_PARTITIONS		64
+#define MIN_CLOCK_SWEEP_PARTITION_SIZE	32768
+#define CLOCK_SWEEP_REBALANCE_INTERVAL	64
+
+/*
+ * Shared state of one clock sweep partition.
  */
 typedef struct
 {
-	/* Spinlock: protects the values below */
-	slock_t		buffer_strategy_lock;
+	/* Spinlock: protects completePasses */
+	slock_t		lock;
+
+	int			firstBuffer;	/* id of the first buffer in this partition */
+	int			numBuffers;		/* number of buffers in this partition */
 
 	/*
-	 * Clock sweep hand: index of next buffer to consider grabbing. Note that
-	 * this isn't a concrete buffer - we only ever increase the value. So, to
-	 * get an actual buffer, it needs to be used modulo NBuffers.
+	 * Clock sweep hand: index, relative to firstBuffer, of next buffer to
+	 * consider grabbing. Note that this isn't a concrete buffer - we only
+	 * ever increase the value. So, to get an actual buffer, it needs to be
+	 * used modulo numBuffers.
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
+	/*
+	 * Statistics.  These counters should be wide enough that they can't
+	 * overflow during a single bgwriter cycle.
+	 */
+	uint32		completePasses; /* Complete cycles of the clock sweep */
+	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
+	pg_atomic_uint32 numDirtyEvictions; /* Victims written by backends since
+										 * last reset */
+} ClockSweepPartition;
+
+/*
+ * Each partition gets its own cache line, so that advancing one hand doesn't
+ * disturb backends working on the others.
+ */
+typedef union ClockSweepPartitionPadded
+{
+	ClockSweepPartition part;
+	char		pad[PG_CACHE_LINE_SIZE];
+} ClockSweepPartitionPadded;
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	/* Spinlock: protects the values below */
+	slock_t		buffer_strategy_lock;
+
 	int			firstFreeBuffer;	/* Head of list of unused buffers */
 	int			lastFreeBuffer; /* Tail of list of unused buffers */
 
@@ -47,12 +96,8 @@ typedef struct
 	 * when the list is empty)
 	 */
 
-	/*
-	 * Statistics.  These counters should be wide enough that they can't
-	 * overflow during a single bgwriter cycle.
-	 */
-	uint32		completePasses; /* Complete cycles of the clock sweep */
-	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
+	/* Number of clock sweep partitions; fixed at startup */
+	int			numPartitions;
 
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
@@ -63,6 +108,15 @@ typedef struct
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
+static ClockSweepPartitionPadded *ClockSweepPartitions = NULL;
+
+/*
+ * Backend-local state: the partition this backend currently sweeps, and the
+ * number of allocations until it next checks whether that is still the right
+ * one.
+ */
+static int	MyClockSweepPartition = -1;
+static int	allocsUntilRebalance = 0;
 
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
@@ -101,11 +155,11 @@ static void AddBufferToRing(BufferAccessStrategy strategy,
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the clock hand of the given partition one buffer ahead of its current
+ * position and return the id of the buffer now under the hand.
  */
 static inline uint32
-ClockSweepTick(void)
+ClockSweepTick(ClockSweepPartition *part)
 {
 	uint32		victim;
 
@@ -115,14 +169,14 @@ ClockSweepTick(void)
 	 * apparent order.
 	 */
 	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+		pg_atomic_fetch_add_u32(&part->nextVictimBuffer, 1);
 
-	if (victim >= NBuffers)
+	if (victim >= part->numBuffers)
 	{
 		uint32		originalVictim = victim;
 
 		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		victim = victim % part->numBuffers;
 
 		/*
 		 * If we're the one that just caused a wraparound, force
@@ -148,19 +202,89 @@ ClockSweepTick(void)
 				 * could lead to an overflow of nextVictimBuffers, but that's
 				 * highly unlikely and wouldn't be particularly harmful.
 				 */
-				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+				SpinLockAcquire(&part->lock);
 
-				wrapped = expected % NBuffers;
+				wrapped = expected % part->numBuffers;
 
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+				success = pg_atomic_compare_exchange_u32(&part->nextVictimBuffer,
 														 &expected, wrapped);
 				if (success)
-					StrategyControl->completePasses++;
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+					part->completePasses++;
+				SpinLockRelease(&part->lock);
 			}
 		}
 	}
-	return victim;
+	return part->firstBuffer + victim;
+}
+
+/*
+ * ClockSweepProgress - how far the hand of a partition has advanced, in
+ * (fractional) complete passes over that partition.
+ *
+ * The result is read without locking and is only meant for balancing
+ * decisions, where a slightly stale value does no harm.
+ */
+static inline double
+ClockSweepProgress(ClockSweepPartition *part)
+{
+	uint32		completePasses = *((volatile uint32 *) &part->completePasses);
+	uint32		nextVictimBuffer = pg_atomic_read_u32(&part->nextVictimBuffer);
+
+	return completePasses + (double) nextVictimBuffer / part->numBuffers;
+}
+
+/*
+ * ChooseClockSweepPartition - Helper routine for StrategyGetBuffer()
+ *
+ * Return the index of the partition this backend should take its next victim
+ * buffer from.  Each backend has a home partition, chosen by its pgprocno,
+ * which it normally sticks to.  Since backends are not spread evenly over
+ * partitions and don't all allocate buffers at the same rate, some hands
+ * would otherwise move a lot faster than others, evicting pages from one
+ * part of the buffer pool while more cold pages stay behind in the rest.
+ * To prevent that, a backend periodically compares the progress of its home
+ * partition with the slowest one, and helps out on the slowest partition
+ * while its home partition is more than half a pass ahead.
+ */
+static int
+ChooseClockSweepPartition(void)
+{
+	int			numPartitions = StrategyControl->numPartitions;
+	int			home;
+	int			slowest;
+	double		homeProgress;
+	double		slowestProgress;
+
+	if (numPartitions == 1)
+		return 0;
+
+	if (MyClockSweepPartition >= 0 && --allocsUntilRebalance > 0)
+		return MyClockSweepPartition;
+
+	allocsUntilRebalance = CLOCK_SWEEP_REBALANCE_INTERVAL;
+
+	home = (MyProc != NULL) ? MyProc->pgprocno % numPartitions : 0;
+	homeProgress = ClockSweepProgress(&ClockSweepPartitions[home].part);
+
+	slowest = home;
+	slowestProgress = homeProgress;
+	for (int i = 0; i < numPartitions; i++)
+	{
+		double		progress = ClockSweepProgress(&ClockSweepPartitions[i].part);
+
+		if (progress < slowestProgress)
+		{
+			slowest = i;
+			slowestProgress = progress;
+		}
+	}
+
+	if (homeProgress - slowestProgress > 0.5)
+		MyClockSweepPartition = slowest;
+	else
+		MyClockSweepPartition = home;
+
+	return MyClockSweepPartition;
 }
 
 /*
@@ -197,6 +321,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 {
 	BufferDesc *buf;
 	int			bgwprocno;
+	int			partition;
+	int			partitionsTried;
 	int			trycounter;
 	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
 
@@ -247,7 +373,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 	 * the rate of buffer consumption.  Note that buffers recycled by a
 	 * strategy object are intentionally not counted here.
 	 */
-	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
+	partition = ChooseClockSweepPartition();
+	pg_atomic_fetch_add_u32(&ClockSweepPartitions[partition].part.numBufferAllocs, 1);
 
 	/*
 	 * First check, without acquiring the lock, whether there's buffers in the
@@ -311,49 +438,68 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 		}
 	}
 
-	/* Nothing on the freelist, so run the "clock sweep" algorithm */
-	trycounter = NBuffers;
-	for (;;)
+	/*
+	 * Nothing on the freelist, so run the "clock sweep" algorithm on the
+	 * chosen partition.  If all buffers in that partition are pinned, move on
+	 * to the next one.
+	 */
+	for (partitionsTried = 0; partitionsTried < StrategyControl->numPartitions;
+		 partitionsTried++)
 	{
-		buf = GetBufferDescriptor(ClockSweepTick());
+		ClockSweepPartition *part = &ClockSweepPartitions[partition].part;
 
-		/*
-		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
-		 * it; decrement the usage_count (unless pinned) and keep scanning.
-		 */
-		local_buf_state = LockBufHdr(buf);
-
-		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+		trycounter = part->numBuffers;
+		for (;;)
 		{
-			if (BUF_STATE_GET_USAGECOUNT(local_buf_state) != 0)
-			{
-				local_buf_state -= BUF_USAGECOUNT_ONE;
+			buf = GetBufferDescriptor(ClockSweepTick(part));
 
-				trycounter = NBuffers;
+			/*
+			 * If the buffer is pinned or has a nonzero usage_count, we cannot
+			 * use it; decrement the usage_count (unless pinned) and keep
+			 * scanning.
+			 */
+			local_buf_state = LockBufHdr(buf);
+
+			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+			{
+				if (BUF_STATE_GET_USAGECOUNT(local_buf_state) != 0)
+				{
+					local_buf_state -= BUF_USAGECOUNT_ONE;
+
+					trycounter = part->numBuffers;
+				}
+				else
+				{
+					/* Found a usable buffer */
+					if (strategy != NULL)
+						AddBufferToRing(strategy, buf);
+					*buf_state = local_buf_state;
+					return buf;
+				}
 			}
-			else
+			else if (--trycounter == 0)
 			{
-				/* Found a usable buffer */
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
+				/*
+				 * We've scanned all the buffers of this partition without
+				 * making any state changes, so they are all pinned (or were
+				 * when we looked at them).  Try the next partition.
+				 */
+				UnlockBufHdr(buf, local_buf_state);
+				break;
 			}
-		}
-		else if (--trycounter == 0)
-		{
-			/*
-			 * We've scanned all the buffers without making any state changes,
-			 * so all the buffers are pinned (or were when we looked at them).
-			 * We could hope that someone will free one eventually, but it's
-			 * probably better to fail than to risk getting stuck in an
-			 * infinite loop.
-			 */
 			UnlockBufHdr(buf, local_buf_state);
-			elog(ERROR, "no unpinned buffers available");
 		}
-		UnlockBufHdr(buf, local_buf_state);
+
+		partition = (partition + 1) % StrategyControl->numPartitions;
 	}
+
+	/*
+	 * All the buffers are pinned.  We could hope that someone will free one
+	 * eventually, but it's probably better to fail than to risk getting stuck
+	 * in an infinite loop.
+	 */
+	elog(ERROR, "no unpinned buffers available");
+	return NULL;				/* keep compiler quiet */
 }
 
 /*
@@ -382,43 +528,98 @@ StrategyFreeBuffer(BufferDesc *buf)
 /*
  * StrategySyncStart -- tell BufferSync where to start syncing
  *
- * The result is the buffer index of the best buffer to sync first.
- * BufferSync() will proceed circularly around the buffer array from there.
+ * The result is the clock position of the best buffer to sync first; use
+ * StrategyBufferAtClockPosition() to map it to a buffer id.  BgBufferSync()
+ * will proceed circularly around the clock positions from there.
  *
- * In addition, we return the completed-pass count (which is effectively
- * the higher-order bits of nextVictimBuffer) and the count of recent buffer
- * allocs if non-NULL pointers are passed.  The alloc count is reset after
- * being read.
+ * With multiple clock sweep partitions there is no single clock hand.  Clock
+ * positions interleave the partitions (position p refers to buffer p / N of
+ * partition p % N, for N partitions), and the hand of each partition is
+ * scaled to the position at the same fraction of a full pass.  We report the
+ * partition that is furthest behind, so that scanning forward from the
+ * result visits the buffers just ahead of every hand in turn, as long as the
+ * hands are kept roughly level by ChooseClockSweepPartition().  Since each
+ * hand only moves forward, so does the result.  With a single partition,
+ * clock positions are simply buffer ids.
+ *
+ * In addition, we return the completed-pass count of that partition (which
+ * is effectively the higher-order bits of the position), the count of recent
+ * buffer allocs and the count of recent dirty evictions (see
+ * StrategyReportDirtyEviction) in all partitions if non-NULL pointers are
+ * passed.  The alloc and eviction counts are reset after being read.
  */
 int
-StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
+StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+				  uint32 *num_dirty_evictions)
 {
-	uint32		nextVictimBuffer;
-	int			result;
-
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
-	result = nextVictimBuffer % NBuffers;
-
-	if (complete_passes)
+	int			numPartitions = StrategyControl->numPartitions;
+	int			result = 0;
+	uint32		resultPasses = 0;
+	uint64		slowest = PG_UINT64_MAX;
+	uint32		allocs = 0;
+	uint32		evictions = 0;
+
+	for (int i = 0; i < numPartitions; i++)
 	{
-		*complete_passes = StrategyControl->completePasses;
+		ClockSweepPartition *part = &ClockSweepPartitions[i].part;
+		uint32		nextVictimBuffer;
+		uint32		passes;
+		int			pos;
+
+		SpinLockAcquire(&part->lock);
+		nextVictimBuffer = pg_atomic_read_u32(&part->nextVictimBuffer);
 
 		/*
 		 * Additionally add the number of wraparounds that happened before
 		 * completePasses could be incremented. C.f. ClockSweepTick().
 		 */
-		*complete_passes += nextVictimBuffer / NBuffers;
+		passes = part->completePasses + nextVictimBuffer / part->numBuffers;
+		pos = ((uint64) (nextVictimBuffer % part->numBuffers) * NBuffers) /
+			part->numBuffers;
+
+		if (num_buf_alloc)
+			allocs += pg_atomic_exchange_u32(&part->numBufferAllocs, 0);
+		if (num_dirty_evictions)
+			evictions += pg_atomic_exchange_u32(&part->numDirtyEvictions, 0);
+		SpinLockRelease(&part->lock);
+
+		if ((uint64) passes * NBuffers + pos < slowest)
+		{
+			slowest = (uint64) passes * NBuffers + pos;
+			resultPasses = passes;
+			result = pos;
+		}
 	}
 
+	if (complete_passes)
+		*complete_passes = resultPasses;
 	if (num_buf_alloc)
-	{
-		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
-	}
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+		*num_buf_alloc = allocs;
+	if (num_dirty_evictions)
+		*num_dirty_evictions = evictions;
+
 	return result;
 }
 
+/*
+ * StrategyBufferAtClockPosition -- map a clock position to a buffer id
+ *
+ * Clock positions are returned by StrategySyncStart(); see there.
+ */
+int
+StrategyBufferAtClockPosition(int pos)
+{
+	int			numPartitions = StrategyControl->numPartitions;
+	ClockSweepPartition *part;
+
+	Assert(pos >= 0 && pos < NBuffers);
+
+	part = &ClockSweepPartitions[pos % numPartitions].part;
+	Assert(pos / numPartitions < part->numBuffers);
+
+	return part->firstBuffer + pos / numPartitions;
+}
+
 /*
  * StrategyNotifyBgWriter -- set or clear allocation notification latch
  *
@@ -440,6 +641,37 @@ StrategyNotifyBgWriter(int bgwprocno)
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 }
 
+/*
+ * StrategyReportDirtyEviction -- count a dirty victim written by a backend
+ *
+ * Called by a backend that got a dirty buffer from the clock sweep and had to
+ * write it out itself before it could reuse it.  The bgwriter uses these
+ * counts as a measure of unmet demand for clean buffers, see BgBufferSync().
+ * The count goes to the partition this backend is sweeping, so that backends
+ * don't all hit one counter.
+ */
+void
+StrategyReportDirtyEviction(void)
+{
+	int			partition = Max(MyClockSweepPartition, 0);
+
+	pg_atomic_fetch_add_u32(&ClockSweepPartitions[partition].part.numDirtyEvictions, 1);
+}
+
+
+/*
+ * StrategyNumPartitions -- number of clock sweep partitions to use
+ *
+ * Partitions are only worth having with a large buffer pool, so that each of
+ * them still holds enough buffers for the clock sweep to tell hot pages from
+ * cold ones.
+ */
+static int
+StrategyNumPartitions(void)
+{
+	return Max(1, Min(MAX_CLOCK_SWEEP_PARTITIONS,
+					  NBuffers / MIN_CLOCK_SWEEP_PARTITION_SIZE));
+}
 
 /*
  * StrategyShmemSize
@@ -460,6 +692,10 @@ StrategyShmemSize(void)
 	/* size of the shared replacement strategy control block */
 	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
 
+	/* size of the clock sweep partitions */
+	size = add_size(size, mul_size(StrategyNumPartitions(),
+								   sizeof(ClockSweepPartitionPadded)));
+
 	return size;
 }
 
@@ -474,6 +710,7 @@ void
 StrategyInitialize(bool init)
 {
 	bool		found;
+	bool		foundPartitions;
 
 	/*
 	 * Initialize the shared buffer lookup hashtable.
@@ -495,8 +732,16 @@ StrategyInitialize(bool init)
 						sizeof(BufferStrategyControl),
 						&found);
 
+	ClockSweepPartitions = (ClockSweepPartitionPadded *)
+		ShmemInitStruct("Buffer Clock Sweep Partitions",
+						StrategyNumPartitions() * sizeof(ClockSweepPartitionPadded),
+						&foundPartitions);
+
 	if (!found)
 	{
+		int			numPartitions = StrategyNumPartitions();
+		int			firstBuffer = 0;
+
 		/*
 		 * Only done once, usually in postmaster
 		 */
@@ -511,18 +756,38 @@ StrategyInitialize(bool init)
 		StrategyControl->firstFreeBuffer = 0;
 		StrategyControl->lastFreeBuffer = NBuffers - 1;
 
-		/* Initialize the clock sweep pointer */
-		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
+		/*
+		 * Divide the buffers among the clock sweep partitions.  The first
+		 * NBuffers % numPartitions partitions get one extra buffer, which is
+		 * what StrategyBufferAtClockPosition() relies on.
+		 */
+		StrategyControl->numPartitions = numPartitions;
+		for (int i = 0; i < numPartitions; i++)
+		{
+			ClockSweepPartition *part = &ClockSweepPartitions[i].part;
+
+			SpinLockInit(&part->lock);
+			part->firstBuffer = firstBuffer;
+			part->numBuffers = NBuffers / numPartitions +
+				(i < NBuffers % numPartitions ? 1 : 0);
+			firstBuffer += part->numBuffers;
 
-		/* Clear statistics */
-		StrategyControl->completePasses = 0;
-		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
+			/* Initialize the clock sweep pointer */
+			pg_atomic_init_u32(&part->nextVictimBuffer, 0);
+
+			/* Clear statistics */
+			part->completePasses = 0;
+			pg_atomic_init_u32(&part->numBufferAllocs, 0);
+			pg_atomic_init_u32(&part->numDirtyEvictions, 0);
+		}
+		Assert(firstBuffer == NBuffers);
 
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
 	}
 	else
 		Assert(!init);
+	Assert(found == foundPartitions);
 }
 
 
@@ -40,18 +40,36 @@
  * when the corresponding files need to be survived across the transaction and
  * need to be opened and closed multiple times.  Such files need to be created
  * as a member of a FileSet.
+ *
+ * Temporary files can also be compressed, see BufFileCreateCompressTemp().
+ * Each BLCKSZ-sized logical block is then compressed and stored as a
+ * variable-length chunk, and a block map records where the chunk of each
+ * block is.  The block map is stored in pages in the file itself, of which
+ * only a few are kept in memory.  Positions seen by the user of the BufFile
+ * are logical positions, as in an uncompressed file, so a compressed file can
+ * still be seeked and overwritten.  It cannot be concatenated with
+ * BufFileAppend() or truncated, though.
  *-------------------------------------------------------------------------
  */
 
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "commands/tablespace.h"
+#include "common/pg_lzcompress.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/buf_internals.h"
 #include "storage/buffile.h"
 #include "storage/fd.h"
+#include "utils/memutils.h"
 #include "utils/resowner.h"
 
 /*
@@ -62,6 +80,88 @@
 #define MAX_PHYSICAL_FILESIZE	0x40000000
 #define BUFFILE_SEG_SIZE		(MAX_PHYSICAL_FILESIZE / BLCKSZ)
 
+/*
+ * In a compressed BufFile, each logical block is stored as a chunk consisting
+ * of this header followed by the data.  If compression didn't make the data
+ * smaller, it's stored as is, with complen equal to rawlen.  Chunks never
+ * cross a segment file boundary.
+ */
+typedef struct BufFileChunkHeader
+{
+	int32		rawlen;			/* # of bytes of data */
+	int32		complen;		/* # of bytes stored after the header */
+} BufFileChunkHeader;
+
+#define BUFFILE_CHUNK_BUFSIZE \
+	(sizeof(BufFileChunkHeader) + PGLZ_MAX_OUTPUT(BLCKSZ))
+
+/*
+ * Space is allocated for chunks in multiples of BUFFILE_CHUNK_ALIGN bytes, so
+ * that a block that is rewritten can usually reuse the space of its previous
+ * chunk.
+ */
+#define BUFFILE_CHUNK_ALIGN		512
+#define BUFFILE_CHUNK_SPACE(chunklen) \
+	(((chunklen) + BUFFILE_CHUNK_ALIGN - 1) & ~(BUFFILE_CHUNK_ALIGN - 1))
+
+/*
+ * Block map entry of a compressed BufFile.  physpos is the position of the
+ * block's chunk, counting across segment files, or -1 if the block was never
+ * written (a hole left by seeking beyond the end of the file), in which case
+ * it reads as zeroes.
+ */
+typedef struct BufFileBlockMapEntry
+{
+	off_t		physpos;		/* physical position of chunk, or -1 */
+	int32		rawlen;			/* # of bytes of data in the block */
+	int32		chunklen;		/* # of bytes in chunk, including header */
+} BufFileBlockMapEntry;
+
+/*
+ * The block map would need 16 bytes of memory per block if it was kept in
+ * memory as a whole, which adds up for files of hundreds of gigabytes.  So it
+ * is divided into pages of BUFFILE_MAP_PAGE_ENTRIES entries, which are stored
+ * in the file's own space, like chunks, and only the BUFFILE_MAP_CACHE_PAGES
+ * most recently used pages are kept in memory.  What remains in memory for
+ * the whole file is the position of each map page, 8 bytes for every 512kB of
+ * data.
+ */
+#define BUFFILE_MAP_PAGE_ENTRIES	64
+#define BUFFILE_MAP_PAGE_SIZE \
+	(sizeof(BufFileBlockMapEntry) * BUFFILE_MAP_PAGE_ENTRIES)
+#define BUFFILE_MAP_CACHE_PAGES		8
+#define BUFFILE_INITIAL_MAPDIR_SIZE	16
+
+typedef struct BufFileMapPage
+{
+	long		pageno;			/* number of the map page held here */
+	bool		dirty;			/* must be written out before reuse? */
+	uint64		lastused;		/* for least-recently-used replacement */
+	BufFileBlockMapEntry entries[BUFFILE_MAP_PAGE_ENTRIES];
+} BufFileMapPage;
+
+/*
+ * A compressed BufFile that belongs to a FileSet writes out its block map
+ * pages when it is closed or exported, and stores their positions in a
+ * separate file, so that BufFileOpenFileSet() can find the chunks.  The map
+ * file consists of this header followed by the map page positions.
+ */
+typedef struct BufFileMapHeader
+{
+	int32		compression;	/* compression method */
+	int64		nblocks;		/* # of block map entries */
+} BufFileMapHeader;
+
+/*
+ * Scratch space to (de)compress chunks in.  Chunks are processed one at a
+ * time, so this is shared by all compressed files, rather than adding to the
+ * memory used by each of them.
+ */
+static char *chunk_buffer = NULL;
+
+/* GUC variable */
+int			temp_file_compression = TEMP_FILE_COMPRESSION_NONE;
+
 /*
  * This data structure represents a buffered file that consists of one or
  * more physical files (each accessed through a virtual file descriptor
@@ -80,6 +180,23 @@ struct BufFile
 	FileSet    *fileset;		/* space for fileset based segment files */
 	const char *name;			/* name of fileset based BufFile */
 
+	/*
+	 * In a compressed file, the buffer always holds a single logical block,
+	 * so curOffset is a multiple of BLCKSZ, and 'loaded' says whether the
+	 * block has been read into the buffer yet.  New chunks are appended at
+	 * physEnd.
+	 */
+	TempFileCompression compression;	/* compression method, or NONE */
+	bool		loaded;			/* buffer holds block at curOffset? */
+	long		nblocks;		/* # of blocks in the block map */
+	BufFileMapPage *mappages;	/* palloc'd array, nmappages entries */
+	int			nmappages;		/* # of map pages held in memory */
+	uint64		mapclock;		/* counter for mappages[].lastused */
+	off_t	   *mapdir;			/* positions of map pages, or -1 if never
+								 * written out; palloc'd array */
+	long		mapdirsize;		/* allocated length of mapdir */
+	off_t		physEnd;		/* physical end of the chunks written */
+
 	/*
 	 * resowner is the ResourceOwner to use for underlying temp files.  (We
 	 * don't need to remember the memory context we're using explicitly,
@@ -109,6 +226,19 @@ static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
 static void BufFileDumpBuffer(BufFile *file);
 static void BufFileFlush(BufFile *file);
+static void BufFileSetCompression(BufFile *file,
+								  TempFileCompression compression);
+static void BufFileLoadBlock(BufFile *file);
+static void BufFileDumpBlock(BufFile *file);
+static void BufFileNextBlock(BufFile *file);
+static off_t BufFileAllocSpace(BufFile *file, int len);
+static BufFileBlockMapEntry *BufFileGetMapEntry(BufFile *file, long blknum,
+												bool forwrite);
+static void BufFileWriteMapPage(BufFile *file, BufFileMapPage *page);
+static int	BufFileSeekCompressed(BufFile *file, int fileno, off_t offset,
+								  int whence);
+static void BufFileWriteMap(BufFile *file);
+static void BufFileReadMap(BufFile *file, File mapfile);
 static File MakeNewFileSetSegment(BufFile *buffile, int segment);
 
 /*
@@ -127,6 +257,15 @@ makeBufFileCommon(int nfiles)
 	file->curOffset = 0;
 	file->pos = 0;
 	file->nbytes = 0;
+	file->compression = TEMP_FILE_COMPRESSION_NONE;
+	file->loaded = false;
+	file->nblocks = 0;
+	file->mappages = NULL;
+	file->nmappages = 0;
+	file->mapclock = 0;
+	file->mapdir = NULL;
+	file->mapdirsize = 0;
+	file->physEnd = 0;
 
 	return file;
 }
@@ -215,6 +354,47 @@ BufFileCreateTemp(bool interXact)
 	return file;
 }
 
+/*
+ * Create a BufFile for a new temporary file, compressed with the method
+ * selected by temp_file_compression.
+ *
+ * A compressed file can be used like any other BufFile, but reading or
+ * writing a few bytes at a time at random positions is expensive, since the
+ * block containing them must be decompressed every time.  If
+ * temp_file_compression is "none", this is the same as BufFileCreateTemp().
+ */
+BufFile *
+BufFileCreateCompressTemp(bool interXact)
+{
+	BufFile    *file = BufFileCreateTemp(interXact);
+
+	if (temp_file_compression != TEMP_FILE_COMPRESSION_NONE)
+		BufFileSetCompression(file,
+							  (TempFileCompression) temp_file_compression);
+
+	return file;
+}
+
+/*
+ * Set up a new BufFile to be compressed with the given method.
+ */
+static void
+BufFileSetCompression(BufFile *file, TempFileCompression compression)
+{
+	Assert(compression != TEMP_FILE_COMPRESSION_NONE);
+
+	file->compression = compression;
+	file->mappages = (BufFileMapPage *) palloc(sizeof(BufFileMapPage));
+	file->mapdirsize = BUFFILE_INITIAL_MAPDIR_SIZE;
+	file->mapdir = (off_t *) palloc(sizeof(off_t) * file->mapdirsize);
+	for (int i = 0; i < file->mapdirsize; i++)
+		file->mapdir[i] = -1;
+
+	if (chunk_buffer == NULL)
+		chunk_buffer = MemoryContextAlloc(TopMemoryContext,
+										  BUFFILE_CHUNK_BUFSIZE);
+}
+
 /*
  * Build the name for a given segment of a given BufFile.
  */
@@ -224,6 +404,15 @@ FileSetSegmentName(char *name, const char *buffile_name, int segment)
 	snprintf(name, MAXPGPATH, "%s.%d", buffile_name, segment);
 }
 
+/*
+ * Build the name of the block map file of a given compressed BufFile.
+ */
+static void
+FileSetMapName(char *name, const char *buffile_name)
+{
+	snprintf(name, MAXPGPATH, "%s.map", buffile_name);
+}
+
 /*
  * Create a new segment file backing a fileset based BufFile.
  */
@@ -242,6 +431,13 @@ MakeNewFileSetSegment(BufFile *buffile, int segment)
 	FileSetSegmentName(name, buffile->name, segment + 1);
 	FileSetDelete(buffile->fileset, name, true);
 
+	/* Likewise, a left-over block map would make it look compressed. */
+	if (segment == 0)
+	{
+		FileSetMapName(name, buffile->name);
+		FileSetDelete(buffile->fileset, name, true);
+	}
+
 	/* Create the new segment. */
 	FileSetSegmentName(name, buffile->name, segment);
 	file = FileSetCreate(buffile->fileset, name);
@@ -278,6 +474,28 @@ BufFileCreateFileSet(FileSet *fileset, const char *name)
 	return file;
 }
 
+/*
+ * Like BufFileCreateFileSet, but the file is compressed with the method
+ * selected by temp_file_compression, as in BufFileCreateCompressTemp.
+ *
+ * The positions of the block map pages are stored in a separate file when
+ * the BufFile is closed or exported.  BufFileOpenFileSet() finds them there,
+ * so readers don't need to know that the file is compressed.  BufFileSize()
+ * works, but files created this way cannot be passed to BufFileAppend() or
+ * BufFileTruncateFileSet().
+ */
+BufFile *
+BufFileCreateCompressFileSet(FileSet *fileset, const char *name)
+{
+	BufFile    *file = BufFileCreateFileSet(fileset, name);
+
+	if (temp_file_compression != TEMP_FILE_COMPRESSION_NONE)
+		BufFileSetCompression(file,
+							  (TempFileCompression) temp_file_compression);
+
+	return file;
+}
+
 /*
  * Open a file that was previously created in another backend (or this one)
  * with BufFileCreateFileSet in the same FileSet using the same name.
@@ -295,6 +513,7 @@ BufFileOpenFileSet(FileSet *fileset, const char *name, int mode,
 	char		segment_name[MAXPGPATH];
 	Size		capacity = 16;
 	File	   *files;
+	File		mapfile;
 	int			nfiles = 0;
 
 	files = palloc(sizeof(File) * capacity);
@@ -345,6 +564,17 @@ BufFileOpenFileSet(FileSet *fileset, const char *name, int mode,
 	file->fileset = fileset;
 	file->name = pstrdup(name);
 
+	/* If there's a block map, the file is compressed. */
+	FileSetMapName(segment_name, name);
+	mapfile = FileSetOpen(fileset, segment_name, O_RDONLY);
+	if (mapfile > 0)
+	{
+		if (!file->readOnly)
+			elog(ERROR, "cannot open compressed BufFile \"%s\" for writing",
+				 name);
+		BufFileReadMap(file, mapfile);
+	}
+
 	return file;
 }
 
@@ -383,6 +613,10 @@ BufFileDeleteFileSet(FileSet *fileset, const char *name, bool missing_ok)
 		CHECK_FOR_INTERRUPTS();
 	}
 
+	/* Delete the block map too, if the file was compressed. */
+	FileSetMapName(segment_name, name);
+	FileSetDelete(fileset, segment_name, true);
+
 	if (!found && !missing_ok)
 		elog(ERROR, "could not delete unknown BufFile \"%s\"", name);
 }
@@ -400,6 +634,8 @@ BufFileExportFileSet(BufFile *file)
 	Assert(!file->readOnly);
 
 	BufFileFlush(file);
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+		BufFileWriteMap(file);
 	file->readOnly = true;
 }
 
@@ -415,14 +651,156 @@ BufFileClose(BufFile *file)
 
 	/* flush any unwritten data */
 	BufFileFlush(file);
+	/* save the block map of a compressed file, for BufFileOpenFileSet */
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE &&
+		file->fileset != NULL && !file->readOnly)
+		BufFileWriteMap(file);
 	/* close and delete the underlying file(s) */
 	for (i = 0; i < file->numFiles; i++)
 		FileClose(file->files[i]);
 	/* release the buffer space */
 	pfree(file->files);
+	if (file->mappages)
+		pfree(file->mappages);
+	if (file->mapdir)
+		pfree(file->mapdir);
 	pfree(file);
 }
 
+/*
+ * BufFileWriteMap
+ *
+ * Write out the block map pages of a compressed BufFile that belongs to a
+ * FileSet, and store their positions in its map file.
+ */
+static void
+BufFileWriteMap(BufFile *file)
+{
+	char		name[MAXPGPATH];
+	BufFileMapHeader hdr;
+	File		mapfile;
+	ResourceOwner oldowner;
+	long		npages;
+	size_t		maplen;
+
+	Assert(file->fileset != NULL);
+
+	for (int i = 0; i < file->nmappages; i++)
+	{
+		if (file->mappages[i].dirty)
+			BufFileWriteMapPage(file, &file->mappages[i]);
+	}
+	npages = (file->nblocks + BUFFILE_MAP_PAGE_ENTRIES - 1) /
+		BUFFILE_MAP_PAGE_ENTRIES;
+	maplen = sizeof(off_t) * npages;
+
+	/* Be sure to associate the file with the BufFile's resource owner */
+	oldowner = CurrentResourceOwner;
+	CurrentResourceOwner = file->resowner;
+	FileSetMapName(name, file->name);
+	mapfile = FileSetCreate(file->fileset, name);
+	CurrentResourceOwner = oldowner;
+
+	MemSet(&hdr, 0, sizeof(hdr));	/* don't write uninitialized padding */
+	hdr.compression = (int32) file->compression;
+	hdr.nblocks = file->nblocks;
+
+	errno = 0;
+	if (FileWrite(mapfile, &hdr, sizeof(hdr), 0,
+				  WAIT_EVENT_BUFFILE_WRITE) != sizeof(hdr) ||
+		(maplen > 0 &&
+		 FileWrite(mapfile, file->mapdir, maplen, sizeof(hdr),
+				   WAIT_EVENT_BUFFILE_WRITE) != (ssize_t) maplen))
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m",
+						FilePathName(mapfile))));
+	}
+
+	FileClose(mapfile);
+}
+
+/*
+ * BufFileReadMap
+ *
+ * Load the map page positions of a compressed BufFile opened by
+ * BufFileOpenFileSet, and close the map file.
+ */
+static void
+BufFileReadMap(BufFile *file, File mapfile)
+{
+	BufFileMapHeader hdr;
+	long		npages;
+	size_t		maplen;
+	int			nread;
+
+	nread = FileRead(mapfile, &hdr, sizeof(hdr), 0, WAIT_EVENT_BUFFILE_READ);
+	if (nread < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m",
+						FilePathName(mapfile))));
+	if (nread != sizeof(hdr) ||
+		hdr.compression <= TEMP_FILE_COMPRESSION_NONE ||
+		hdr.compression > TEMP_FILE_COMPRESSION_ZSTD ||
+		hdr.nblocks < 0 ||
+		hdr.nblocks / BUFFILE_MAP_PAGE_ENTRIES >=
+		MaxAllocHugeSize / sizeof(off_t))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("invalid block map file \"%s\"",
+								 FilePathName(mapfile))));
+
+	npages = (long) ((hdr.nblocks + BUFFILE_MAP_PAGE_ENTRIES - 1) /
+					 BUFFILE_MAP_PAGE_ENTRIES);
+	maplen = sizeof(off_t) * npages;
+	file->compression = (TempFileCompression) hdr.compression;
+	file->nblocks = (long) hdr.nblocks;
+	file->mappages = (BufFileMapPage *) palloc(sizeof(BufFileMapPage));
+	file->mapdirsize = Max(npages, 1);
+	file->mapdir = (off_t *)
+		MemoryContextAllocHuge(CurrentMemoryContext,
+							   sizeof(off_t) * file->mapdirsize);
+
+	if (maplen > 0)
+	{
+		nread = FileRead(mapfile, file->mapdir, maplen, sizeof(hdr),
+						 WAIT_EVENT_BUFFILE_READ);
+		if (nread < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m",
+							FilePathName(mapfile))));
+		if ((size_t) nread != maplen)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg_internal("invalid block map file \"%s\"",
+									 FilePathName(mapfile))));
+	}
+
+	/* All map pages must have been written out, within the file */
+	for (long i = 0; i < npages; i++)
+	{
+		if (file->mapdir[i] < 0 ||
+			file->mapdir[i] % BUFFILE_CHUNK_ALIGN != 0 ||
+			file->mapdir[i] / MAX_PHYSICAL_FILESIZE >= file->numFiles)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg_internal("invalid block map file \"%s\"",
+									 FilePathName(mapfile))));
+	}
+
+	FileClose(mapfile);
+
+	if (chunk_buffer == NULL)
+		chunk_buffer = MemoryContextAlloc(TopMemoryContext,
+										  BUFFILE_CHUNK_BUFSIZE);
+}
+
 /*
  * BufFileLoadBuffer
  *
@@ -437,6 +815,8 @@ BufFileLoadBuffer(BufFile *file)
 	instr_time	io_start;
 	instr_time	io_time;
 
+	Assert(file->compression == TEMP_FILE_COMPRESSION_NONE);
+
 	/*
 	 * Advance to next component file if necessary and possible.
 	 */
@@ -497,6 +877,12 @@ BufFileDumpBuffer(BufFile *file)
 	int			bytestowrite;
 	File		thisfile;
 
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		BufFileDumpBlock(file);
+		return;
+	}
+
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
 	 * crosses a component-file boundary; so we need a loop.
@@ -579,6 +965,467 @@ BufFileDumpBuffer(BufFile *file)
 	file->nbytes = 0;
 }
 
+/*
+ * Block number of the logical block in the buffer of a compressed file.
+ */
+static inline long
+BufFileCurBlock(BufFile *file)
+{
+	return (long) file->curFile * BUFFILE_SEG_SIZE +
+		(long) (file->curOffset / BLCKSZ);
+}
+
+/*
+ * BufFileLoadBlock
+ *
+ * BufFileLoadBuffer for a compressed file: load the logical block at
+ * (curFile, curOffset) into the buffer, decompressing its chunk.  On exit,
+ * nbytes is the number of bytes in the block, which is less than BLCKSZ only
+ * in the last block, and 0 beyond the end of the file.  pos is unchanged.
+ */
+static void
+BufFileLoadBlock(BufFile *file)
+{
+	BufFileChunkHeader *hdr = (BufFileChunkHeader *) chunk_buffer;
+	char	   *data = chunk_buffer + sizeof(BufFileChunkHeader);
+	long		blknum = BufFileCurBlock(file);
+	BufFileBlockMapEntry *entry;
+	File		thisfile;
+	int			nread;
+	int			rawlen = -1;
+	instr_time	io_start;
+	instr_time	io_time;
+
+	Assert(!file->dirty);
+	file->loaded = true;
+
+	if (blknum >= file->nblocks)
+	{
+		file->nbytes = 0;		/* end of file */
+		return;
+	}
+
+	entry = BufFileGetMapEntry(file, blknum, false);
+	if (entry->physpos < 0)
+	{
+		/* a hole reads as zeroes */
+		memset(file->buffer.data, 0, BLCKSZ);
+		file->nbytes = BLCKSZ;
+		return;
+	}
+
+	thisfile = file->files[entry->physpos / MAX_PHYSICAL_FILESIZE];
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+	else
+		INSTR_TIME_SET_ZERO(io_start);
+
+	nread = FileRead(thisfile, chunk_buffer, entry->chunklen,
+					 entry->physpos % MAX_PHYSICAL_FILESIZE,
+					 WAIT_EVENT_BUFFILE_READ);
+	if (nread < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read file \"%s\": %m",
+						FilePathName(thisfile))));
+	if (nread != entry->chunklen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from temporary file: read only %d of %d bytes",
+						nread, entry->chunklen)));
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_ACCUM_DIFF(pgBufferUsage.temp_blk_read_time, io_time, io_start);
+	}
+
+	if (hdr->rawlen != entry->rawlen ||
+		hdr->complen != entry->chunklen - (int) sizeof(BufFileChunkHeader) ||
+		hdr->complen <= 0 || hdr->complen > hdr->rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("invalid chunk header in compressed temporary file \"%s\"",
+								 FilePathName(thisfile))));
+
+	if (hdr->complen == hdr->rawlen)
+	{
+		memcpy(file->buffer.data, data, hdr->rawlen);
+		rawlen = hdr->rawlen;
+	}
+	else
+	{
+		switch (file->compression)
+		{
+			case TEMP_FILE_COMPRESSION_PGLZ:
+				rawlen = pglz_decompress(data, hdr->complen,
+										 file->buffer.data, hdr->rawlen,
+										 true);
+				break;
+
+			case TEMP_FILE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+				rawlen = LZ4_decompress_safe(data, file->buffer.data,
+											 hdr->complen, hdr->rawlen);
+#else
+				elog(ERROR, "LZ4 is not supported by this build");
+#endif
+				break;
+
+			case TEMP_FILE_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+				{
+					size_t		result = ZSTD_decompress(file->buffer.data,
+														 hdr->rawlen,
+														 data, hdr->complen);
+
+					rawlen = ZSTD_isError(result) ? -1 : (int) result;
+				}
+#else
+				elog(ERROR, "zstd is not supported by this build");
+#endif
+				break;
+
+			case TEMP_FILE_COMPRESSION_NONE:
+				Assert(false);	/* cannot happen */
+				break;
+				/* no default case, so that compiler will warn */
+		}
+	}
+
+	if (rawlen != hdr->rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg_internal("could not decompress chunk of temporary file \"%s\"",
+								 FilePathName(thisfile))));
+
+	/*
+	 * A short block followed by others was the last block once, before
+	 * something was written beyond it.  The rest of it is a hole.
+	 */
+	if (rawlen < BLCKSZ && blknum < file->nblocks - 1)
+	{
+		memset(file->buffer.data + rawlen, 0, BLCKSZ - rawlen);
+		rawlen = BLCKSZ;
+	}
+
+	file->nbytes = rawlen;
+	pgBufferUsage.temp_blks_read++;
+}
+
+/*
+ * BufFileDumpBlock
+ *
+ * BufFileDumpBuffer for a compressed file: compress the block in the buffer,
+ * and write it as a chunk.  The chunk goes to the space of the block's
+ * previous chunk if it fits there, otherwise it is appended at physEnd, and
+ * the old space is wasted.  Unlike BufFileDumpBuffer, this leaves the buffer
+ * contents and position alone.
+ */
+static void
+BufFileDumpBlock(BufFile *file)
+{
+	BufFileChunkHeader *hdr = (BufFileChunkHeader *) chunk_buffer;
+	char	   *data = chunk_buffer + sizeof(BufFileChunkHeader);
+	long		blknum = BufFileCurBlock(file);
+	BufFileBlockMapEntry *entry;
+	int			complen = -1;
+	int			chunklen;
+	int			segment;
+	File		thisfile;
+	instr_time	io_start;
+	instr_time	io_time;
+
+	Assert(file->loaded);
+	Assert(file->nbytes > 0);
+
+	switch (file->compression)
+	{
+		case TEMP_FILE_COMPRESSION_PGLZ:
+			complen = pglz_compress(file->buffer.data, file->nbytes, data,
+									PGLZ_strategy_default);
+			break;
+
+		case TEMP_FILE_COMPRESSION_LZ4:
+#ifdef USE_LZ4
+			complen = LZ4_compress_default(file->buffer.data, data,
+										   file->nbytes, file->nbytes);
+			if (complen <= 0)
+				complen = -1;	/* failure */
+#else
+			elog(ERROR, "LZ4 is not supported by this build");
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_ZSTD:
+#ifdef USE_ZSTD
+			{
+				size_t		result = ZSTD_compress(data, file->nbytes,
+												   file->buffer.data,
+												   file->nbytes, 1);
+
+				complen = ZSTD_isError(result) ? -1 : (int) result;
+			}
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			break;
+
+		case TEMP_FILE_COMPRESSION_NONE:
+			Assert(false);		/* cannot happen */
+			break;
+			/* no default case, so that compiler will warn */
+	}
+
+	/* If the data didn't compress, store it as is */
+	if (complen < 0 || complen >= file->nbytes)
+	{
+		complen = file->nbytes;
+		memcpy(data, file->buffer.data, complen);
+	}
+	hdr->rawlen = file->nbytes;
+	hdr->complen = complen;
+	chunklen = sizeof(BufFileChunkHeader) + complen;
+
+	/* Extend the block map if needed; skipped blocks become holes */
+	while (file->nblocks <= blknum)
+	{
+		long		newblk = file->nblocks++;
+
+		entry = BufFileGetMapEntry(file, newblk, true);
+		entry->physpos = -1;
+		entry->rawlen = BLCKSZ;
+		entry->chunklen = 0;
+	}
+	entry = BufFileGetMapEntry(file, blknum, true);
+
+	if (entry->physpos < 0 ||
+		BUFFILE_CHUNK_SPACE(chunklen) > BUFFILE_CHUNK_SPACE(entry->chunklen))
+		entry->physpos = BufFileAllocSpace(file, chunklen);
+	entry->rawlen = file->nbytes;
+	entry->chunklen = chunklen;
+
+	segment = (int) (entry->physpos / MAX_PHYSICAL_FILESIZE);
+	while (segment >= file->numFiles)
+		extendBufFile(file);
+	thisfile = file->files[segment];
+
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(io_start);
+	else
+		INSTR_TIME_SET_ZERO(io_start);
+
+	errno = 0;
+	if (FileWrite(thisfile, chunk_buffer, chunklen,
+				  entry->physpos % MAX_PHYSICAL_FILESIZE,
+				  WAIT_EVENT_BUFFILE_WRITE) != chunklen)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m",
+						FilePathName(thisfile))));
+	}
+
+	if (track_io_timing)
+	{
+		INSTR_TIME_SET_CURRENT(io_time);
+		INSTR_TIME_ACCUM_DIFF(pgBufferUsage.temp_blk_write_time, io_time, io_start);
+	}
+
+	pgBufferUsage.temp_blks_written++;
+	pgBufferUsage.temp_raw_bytes += file->nbytes;
+	pgBufferUsage.temp_compressed_bytes += chunklen;
+
+	file->dirty = false;
+}
+
+/*
+ * BufFileAllocSpace
+ *
+ * Allocate space for a chunk or map page of 'len' bytes at the physical end
+ * of a compressed file, and return its position.
+ */
+static off_t
+BufFileAllocSpace(BufFile *file, int len)
+{
+	off_t		pos;
+
+	/* Start a new component file, if the space doesn't fit in this one */
+	if (file->physEnd % MAX_PHYSICAL_FILESIZE +
+		BUFFILE_CHUNK_SPACE(len) > MAX_PHYSICAL_FILESIZE)
+		file->physEnd += MAX_PHYSICAL_FILESIZE -
+			file->physEnd % MAX_PHYSICAL_FILESIZE;
+	pos = file->physEnd;
+	file->physEnd += BUFFILE_CHUNK_SPACE(len);
+
+	return pos;
+}
+
+/*
+ * BufFileGetMapEntry
+ *
+ * Return the block map entry of block 'blknum' of a compressed file, reading
+ * in its map page if it's not in memory.  'forwrite' says whether the caller
+ * is going to modify the entry.  The result is only valid until the next
+ * call.
+ */
+static BufFileBlockMapEntry *
+BufFileGetMapEntry(BufFile *file, long blknum, bool forwrite)
+{
+	long		pageno = blknum / BUFFILE_MAP_PAGE_ENTRIES;
+	BufFileMapPage *page = NULL;
+
+	Assert(blknum >= 0 && blknum < file->nblocks);
+
+	for (int i = 0; i < file->nmappages; i++)
+	{
+		if (file->mappages[i].pageno == pageno)
+		{
+			page = &file->mappages[i];
+			break;
+		}
+	}
+
+	if (page == NULL)
+	{
+		/* Use a free slot if there's one left, else evict the oldest page */
+		if (file->nmappages < BUFFILE_MAP_CACHE_PAGES)
+		{
+			if (file->nmappages > 0)
+				file->mappages = (BufFileMapPage *)
+					repalloc(file->mappages,
+							 sizeof(BufFileMapPage) * (file->nmappages + 1));
+			page = &file->mappages[file->nmappages++];
+		}
+		else
+		{
+			page = &file->mappages[0];
+			for (int i = 1; i < file->nmappages; i++)
+			{
+				if (file->mappages[i].lastused < page->lastused)
+					page = &file->mappages[i];
+			}
+			if (page->dirty)
+				BufFileWriteMapPage(file, page);
+		}
+
+		if (pageno >= file->mapdirsize)
+		{
+			long		newsize = Max(file->mapdirsize * 2, pageno + 1);
+
+			file->mapdir = (off_t *)
+				repalloc_huge(file->mapdir, sizeof(off_t) * newsize);
+			for (long i = file->mapdirsize; i < newsize; i++)
+				file->mapdir[i] = -1;
+			file->mapdirsize = newsize;
+		}
+
+		page->pageno = pageno;
+		page->dirty = false;
+		if (file->mapdir[pageno] >= 0)
+		{
+			off_t		pos = file->mapdir[pageno];
+			File		thisfile = file->files[pos / MAX_PHYSICAL_FILESIZE];
+			int			nread;
+
+			nread = FileRead(thisfile, page->entries, BUFFILE_MAP_PAGE_SIZE,
+							 pos % MAX_PHYSICAL_FILESIZE,
+							 WAIT_EVENT_BUFFILE_READ);
+			if (nread < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read file \"%s\": %m",
+								FilePathName(thisfile))));
+			if (nread != BUFFILE_MAP_PAGE_SIZE)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read from temporary file: read only %d of %d bytes",
+								nread, (int) BUFFILE_MAP_PAGE_SIZE)));
+		}
+		else
+		{
+			/* A new page; zero it so that no garbage is written out */
+			Assert(forwrite);
+			memset(page->entries, 0, BUFFILE_MAP_PAGE_SIZE);
+		}
+	}
+
+	page->lastused = ++file->mapclock;
+	if (forwrite)
+		page->dirty = true;
+
+	return &page->entries[blknum % BUFFILE_MAP_PAGE_ENTRIES];
+}
+
+/*
+ * BufFileWriteMapPage
+ *
+ * Write out a block map page of a compressed file.  Map pages all have the
+ * same size, so a page keeps the space it got when first written out.
+ */
+static void
+BufFileWriteMapPage(BufFile *file, BufFileMapPage *page)
+{
+	off_t		pos;
+	int			segment;
+	File		thisfile;
+
+	Assert(page->pageno < file->mapdirsize);
+
+	if (file->mapdir[page->pageno] < 0)
+		file->mapdir[page->pageno] =
+			BufFileAllocSpace(file, BUFFILE_MAP_PAGE_SIZE);
+	pos = file->mapdir[page->pageno];
+
+	segment = (int) (pos / MAX_PHYSICAL_FILESIZE);
+	while (segment >= file->numFiles)
+		extendBufFile(file);
+	thisfile = file->files[segment];
+
+	errno = 0;
+	if (FileWrite(thisfile, page->entries, BUFFILE_MAP_PAGE_SIZE,
+				  pos % MAX_PHYSICAL_FILESIZE,
+				  WAIT_EVENT_BUFFILE_WRITE) != BUFFILE_MAP_PAGE_SIZE)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m",
+						FilePathName(thisfile))));
+	}
+
+	page->dirty = false;
+}
+
+/*
+ * BufFileNextBlock
+ *
+ * Move a compressed file to the start of the next logical block, writing out
+ * the current one first if it's dirty.
+ */
+static void
+BufFileNextBlock(BufFile *file)
+{
+	if (file->dirty)
+		BufFileDumpBlock(file);
+
+	file->curOffset += BLCKSZ;
+	if (file->curOffset >= MAX_PHYSICAL_FILESIZE)
+	{
+		file->curFile++;
+		file->curOffset = 0;
+	}
+	file->pos = 0;
+	file->nbytes = 0;
+	file->loaded = false;
+}
+
 /*
  * BufFileRead variants
  *
@@ -596,11 +1443,25 @@ BufFileReadCommon(BufFile *file, void *ptr, size_t size, bool exact, bool eofOK)
 	size_t		nread = 0;
 	size_t		nthistime;
 
-	BufFileFlush(file);
+	/* In a compressed file, reads are served from a dirty buffer as is */
+	if (file->compression == TEMP_FILE_COMPRESSION_NONE)
+		BufFileFlush(file);
 
 	while (size > 0)
 	{
-		if (file->pos >= file->nbytes)
+		if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+		{
+			if (!file->loaded)
+				BufFileLoadBlock(file);
+			if (file->pos >= file->nbytes)
+			{
+				if (file->nbytes < BLCKSZ)
+					break;		/* no more data available */
+				BufFileNextBlock(file);
+				continue;
+			}
+		}
+		else if (file->pos >= file->nbytes)
 		{
 			/* Try to load more data into buffer. */
 			file->curOffset += file->pos;
@@ -684,7 +1545,9 @@ BufFileWrite(BufFile *file, const void *ptr, size_t size)
 		if (file->pos >= BLCKSZ)
 		{
 			/* Buffer full, dump it out */
-			if (file->dirty)
+			if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+				BufFileNextBlock(file);
+			else if (file->dirty)
 				BufFileDumpBuffer(file);
 			else
 			{
@@ -695,6 +1558,28 @@ BufFileWrite(BufFile *file, const void *ptr, size_t size)
 			}
 		}
 
+		if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+		{
+			/*
+			 * Read the block in before modifying it, unless all of it is
+			 * about to be overwritten.  Zero-fill any gap left by seeking
+			 * beyond the end of the data in it.
+			 */
+			if (!file->loaded)
+			{
+				if (file->pos == 0 && size >= BLCKSZ)
+				{
+					file->nbytes = 0;
+					file->loaded = true;
+				}
+				else
+					BufFileLoadBlock(file);
+			}
+			if (file->pos > file->nbytes)
+				memset(file->buffer.data + file->nbytes, 0,
+					   file->pos - file->nbytes);
+		}
+
 		nthistime = BLCKSZ - file->pos;
 		if (nthistime > size)
 			nthistime = size;
@@ -742,6 +1627,9 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	int			newFile;
 	off_t		newOffset;
 
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+		return BufFileSeekCompressed(file, fileno, offset, whence);
+
 	switch (whence)
 	{
 		case SEEK_SET:
@@ -829,6 +1717,55 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	return 0;
 }
 
+/*
+ * BufFileSeek for a compressed file.  The logical position is not limited by
+ * the number of segment files, so only seeks before the start fail.
+ */
+static int
+BufFileSeekCompressed(BufFile *file, int fileno, off_t offset, int whence)
+{
+	int64		newPos;
+	int64		newBlockPos;
+
+	switch (whence)
+	{
+		case SEEK_SET:
+			if (fileno < 0)
+				return EOF;
+			newPos = (int64) fileno * MAX_PHYSICAL_FILESIZE + offset;
+			break;
+		case SEEK_CUR:
+			newPos = (int64) file->curFile * MAX_PHYSICAL_FILESIZE +
+				file->curOffset + file->pos + offset;
+			break;
+		case SEEK_END:
+			/* The block map knows the size, once the buffer is written */
+			BufFileFlush(file);
+			newPos = BufFileSize(file);
+			break;
+		default:
+			elog(ERROR, "invalid whence: %d", whence);
+			return EOF;
+	}
+	if (newPos < 0)
+		return EOF;
+
+	/* Load a different block only if the target is outside the buffer */
+	newBlockPos = newPos - newPos % BLCKSZ;
+	if (newBlockPos != (int64) file->curFile * MAX_PHYSICAL_FILESIZE +
+		file->curOffset)
+	{
+		if (file->dirty)
+			BufFileDumpBlock(file);
+		file->curFile = (int) (newBlockPos / MAX_PHYSICAL_FILESIZE);
+		file->curOffset = newBlockPos % MAX_PHYSICAL_FILESIZE;
+		file->nbytes = 0;
+		file->loaded = false;
+	}
+	file->pos = (int) (newPos - newBlockPos);
+	return 0;
+}
+
 void
 BufFileTell(BufFile *file, int *fileno, off_t *offset)
 {
@@ -856,6 +1793,70 @@ BufFileSeekBlock(BufFile *file, long blknum)
 					   SEEK_SET);
 }
 
+/*
+ * BufFilePrefetchBlock --- hint that blocks will be read soon
+ *
+ * Asks the kernel to start reading 'nblocks' BLCKSZ-sized blocks, starting
+ * at block 'blknum', so that a later BufFileSeekBlock() and read of them
+ * doesn't have to wait for the I/O.  The range is clipped at the end of the
+ * segment file containing 'blknum'.  This is only a hint: it does nothing on
+ * platforms without posix_fadvise(), and blocks beyond the end of the file
+ * are silently ignored.
+ */
+void
+BufFilePrefetchBlock(BufFile *file, long blknum, int nblocks)
+{
+	int			fileno = (int) (blknum / BUFFILE_SEG_SIZE);
+	long		segblock = blknum % BUFFILE_SEG_SIZE;
+
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		long		endblk = Min(blknum + nblocks, file->nblocks);
+
+		/*
+		 * Prefetch the blocks' chunks, merging chunks that are adjacent on
+		 * disk into one request, as they are when written sequentially.
+		 */
+		while (blknum < endblk)
+		{
+			BufFileBlockMapEntry entry = *BufFileGetMapEntry(file, blknum++,
+															 false);
+			off_t		start;
+			off_t		end;
+			off_t		next;
+
+			if (entry.physpos < 0)
+				continue;
+			start = entry.physpos;
+			end = start + entry.chunklen;
+			next = start + BUFFILE_CHUNK_SPACE(entry.chunklen);
+			while (blknum < endblk && next % MAX_PHYSICAL_FILESIZE != 0)
+			{
+				entry = *BufFileGetMapEntry(file, blknum, false);
+				if (entry.physpos != next)
+					break;
+				blknum++;
+				end = entry.physpos + entry.chunklen;
+				next = entry.physpos + BUFFILE_CHUNK_SPACE(entry.chunklen);
+			}
+			(void) FilePrefetch(file->files[start / MAX_PHYSICAL_FILESIZE],
+								start % MAX_PHYSICAL_FILESIZE,
+								end - start,
+								WAIT_EVENT_BUFFILE_READ);
+		}
+		return;
+	}
+
+	if (fileno >= file->numFiles || nblocks <= 0)
+		return;
+
+	nblocks = Min(nblocks, BUFFILE_SEG_SIZE - segblock);
+	(void) FilePrefetch(file->files[fileno],
+						(off_t) segblock * BLCKSZ,
+						(off_t) nblocks * BLCKSZ,
+						WAIT_EVENT_BUFFILE_READ);
+}
+
 #ifdef NOT_USED
 /*
  * BufFileTellBlock --- block-oriented tell
@@ -885,6 +1886,15 @@ BufFileSize(BufFile *file)
 {
 	int64		lastFileSize;
 
+	/* The logical size of a compressed file is known from its block map */
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+	{
+		if (file->nblocks == 0)
+			return 0;
+		return (int64) (file->nblocks - 1) * BLCKSZ +
+			BufFileGetMapEntry(file, file->nblocks - 1, false)->rawlen;
+	}
+
 	Assert(file->fileset != NULL);
 
 	/* Get the size of the last physical file. */
@@ -933,6 +1943,9 @@ BufFileAppend(BufFile *target, BufFile *source)
 
 	if (target->resowner != source->resowner)
 		elog(ERROR, "could not append BufFile with non-matching resource owner");
+	if (target->compression != TEMP_FILE_COMPRESSION_NONE ||
+		source->compression != TEMP_FILE_COMPRESSION_NONE)
+		elog(ERROR, "cannot append compressed BufFile");
 
 	target->files = (File *)
 		repalloc(target->files, sizeof(File) * newNumFiles);
@@ -956,6 +1969,9 @@ BufFileTruncateFileSet(BufFile *file, int fileno, off_t offset)
 	char		segment_name[MAXPGPATH];
 	int			i;
 
+	if (file->compression != TEMP_FILE_COMPRESSION_NONE)
+		elog(ERROR, "cannot truncate compressed BufFile");
+
 	/*
 	 * Loop over all the files up to the given fileno and remove the files
 	 * that are greater than the fileno and truncate the given file up to the
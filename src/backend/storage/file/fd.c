@@ -2142,19 +2142,24 @@ retry:
 	return returnCode;
 }
 
-int
-FileWrite(File file, const void *buffer, size_t amount, off_t offset,
-		  uint32 wait_event_info)
+ssize_t
+FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		   uint32 wait_event_info)
 {
-	int			returnCode;
+	ssize_t		returnCode;
 	Vfd		   *vfdP;
+	size_t		amount = 0;
 
 	Assert(FileIsValid(file));
+	Assert(iovcnt > 0);
 
-	DO_DB(elog(LOG, "FileWrite: %d (%s) " INT64_FORMAT " %zu %p",
+	for (int i = 0; i < iovcnt; ++i)
+		amount += iov[i].iov_len;
+
+	DO_DB(elog(LOG, "FileWriteV: %d (%s) " INT64_FORMAT " %zu %d",
 			   file, VfdCache[file].fileName,
 			   (int64) offset,
-			   amount, buffer));
+			   amount, iovcnt));
 
 	returnCode = FileAccess(file);
 	if (returnCode < 0)
@@ -2190,7 +2195,7 @@ FileWrite(File file, const void *buffer, size_t amount, off_t offset,
 retry:
 	errno = 0;
 	pgstat_report_wait_start(wait_event_info);
-	returnCode = pg_pwrite(VfdCache[file].fd, buffer, amount, offset);
+	returnCode = pg_pwritev(VfdCache[file].fd, iov, iovcnt, offset);
 	pgstat_report_wait_end();
 
 	/* if write didn't set errno, assume problem is no disk space */
@@ -190,6 +190,8 @@ static const char *const BuiltinTrancheNames[] = {
 	"LogicalRepLauncherDSA",
 	/* LWTRANCHE_LAUNCHER_HASH: */
 	"LogicalRepLauncherHash",
+	/* LWTRANCHE_PARALLEL_MEMOIZE: */
+	"ParallelMemoize",
 };
 
 StaticAssertDecl(lengthof(BuiltinTrancheNames) ==
@@ -47,6 +47,7 @@ pgstat_report_bgwriter(void)
 #define BGWRITER_ACC(fld) stats_shmem->stats.fld += PendingBgWriterStats.fld
 	BGWRITER_ACC(buf_written_clean);
 	BGWRITER_ACC(maxwritten_clean);
+	BGWRITER_ACC(buf_written_evict);
 	BGWRITER_ACC(buf_alloc);
 #undef BGWRITER_ACC
 
@@ -110,6 +111,7 @@ pgstat_bgwriter_snapshot_cb(void)
 #define BGWRITER_COMP(fld) pgStatLocal.snapshot.bgwriter.fld -= reset.fld;
 	BGWRITER_COMP(buf_written_clean);
 	BGWRITER_COMP(maxwritten_clean);
+	BGWRITER_COMP(buf_written_evict);
 	BGWRITER_COMP(buf_alloc);
 #undef BGWRITER_COMP
 }
@@ -0,0 +1,286 @@
+/*-------------------------------------------------------------------------
+ *
+ * jsonb_expanded.c
+ *	  Basic functions for expanded jsonb values.
+ *
+ * An expanded jsonb lets a large, toasted jsonb value be detoasted once and
+ * then queried many times.  It's used by the executor when the same jsonb
+ * column is the input of several key lookups within one expression; see
+ * ExecEvalJsonbExpand().
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/adt/jsonb_expanded.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "common/hashfn.h"
+#include "utils/jsonb.h"
+#include "utils/memutils.h"
+
+/*
+ * Objects with fewer keys than this are just binary-searched.  Building the
+ * hash table costs about as much as a few binary searches over that many
+ * keys, so it only pays off for larger objects.
+ */
+#define EJ_KEYINDEX_MIN_KEYS	32
+
+/* A top-level key, pointing into the flat value */
+typedef struct JsonbKeyIndexKey
+{
+	const char *val;			/* not null-terminated */
+	int			len;
+} JsonbKeyIndexKey;
+
+typedef struct JsonbKeyIndexEntry
+{
+	JsonbKeyIndexKey key;
+	uint32		validx;			/* index of the value's JEntry */
+	uint32		valoffset;		/* offset of the value's data */
+	uint32		hash;			/* hash value (cached) */
+	char		status;			/* hash status */
+} JsonbKeyIndexEntry;
+
+#define SH_PREFIX jsonb_keyidx
+#define SH_ELEMENT_TYPE JsonbKeyIndexEntry
+#define SH_KEY_TYPE JsonbKeyIndexKey
+#define SH_KEY key
+#define SH_HASH_KEY(tb, key) \
+	hash_bytes((const unsigned char *) (key).val, (key).len)
+#define SH_EQUAL(tb, a, b) \
+	((a).len == (b).len && memcmp((a).val, (b).val, (a).len) == 0)
+#define SH_STORE_HASH
+#define SH_GET_HASH(tb, a) a->hash
+#define SH_SCOPE static inline
+#define SH_DECLARE
+#define SH_DEFINE
+#include "lib/simplehash.h"
+
+/* "Methods" required for an expanded object */
+static Size EJ_get_flat_size(ExpandedObjectHeader *eohptr);
+static void EJ_flatten_into(ExpandedObjectHeader *eohptr,
+							void *result, Size allocated_size);
+
+static const ExpandedObjectMethods EJ_methods =
+{
+	EJ_get_flat_size,
+	EJ_flatten_into
+};
+
+/* Other local functions */
+static void build_jsonb_keyindex(ExpandedJsonbHeader *ejh);
+
+
+/*
+ * expand_jsonb: convert a jsonb Datum into an expanded jsonb
+ *
+ * The expanded object will be a child of parentcontext.
+ */
+Datum
+expand_jsonb(Datum jsonbdatum, MemoryContext parentcontext)
+{
+	ExpandedJsonbHeader *ejh;
+	MemoryContext objcxt;
+	MemoryContext oldcxt;
+
+	objcxt = AllocSetContextCreate(parentcontext,
+								   "expanded jsonb",
+								   ALLOCSET_START_SMALL_SIZES);
+
+	/* Set up expanded jsonb header */
+	ejh = (ExpandedJsonbHeader *)
+		MemoryContextAlloc(objcxt, sizeof(ExpandedJsonbHeader));
+
+	EOH_init_header(&ejh->hdr, &EJ_methods, objcxt);
+	ejh->ej_magic = EJ_MAGIC;
+
+	/*
+	 * Detoast and copy source value into private context.  If the source is
+	 * itself an expanded jsonb, this just copies its flat value; we don't
+	 * bother copying the key index, too.
+	 */
+	oldcxt = MemoryContextSwitchTo(objcxt);
+	ejh->fvalue = DatumGetJsonbPCopy(jsonbdatum);
+	MemoryContextSwitchTo(oldcxt);
+
+	/* the key index is built on first use */
+	ejh->keyindex = NULL;
+
+	/* return a R/W pointer to the expanded jsonb */
+	return EOHPGetRWDatum(&ejh->hdr);
+}
+
+/*
+ * get_flat_size method for expanded jsonb
+ */
+static Size
+EJ_get_flat_size(ExpandedObjectHeader *eohptr)
+{
+	ExpandedJsonbHeader *ejh = (ExpandedJsonbHeader *) eohptr;
+
+	Assert(ejh->ej_magic == EJ_MAGIC);
+
+	return VARSIZE(ejh->fvalue);
+}
+
+/*
+ * flatten_into method for expanded jsonb
+ */
+static void
+EJ_flatten_into(ExpandedObjectHeader *eohptr,
+				void *result, Size allocated_size)
+{
+	ExpandedJsonbHeader *ejh = (ExpandedJsonbHeader *) eohptr;
+
+	Assert(ejh->ej_magic == EJ_MAGIC);
+	Assert(allocated_size == VARSIZE(ejh->fvalue));
+
+	memcpy(result, ejh->fvalue, allocated_size);
+}
+
+/*
+ * DatumGetExpandedJsonb: get an expanded jsonb from an input argument
+ *
+ * If the input is an expanded jsonb already, read-only or not, it is
+ * returned as is, since expanded jsonb values are never modified.
+ */
+ExpandedJsonbHeader *
+DatumGetExpandedJsonb(Datum d)
+{
+	if (VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(d)))
+	{
+		ExpandedJsonbHeader *ejh = (ExpandedJsonbHeader *) DatumGetEOHP(d);
+
+		Assert(ejh->ej_magic == EJ_MAGIC);
+		return ejh;
+	}
+
+	/* Else expand the hard way */
+	d = expand_jsonb(d, CurrentMemoryContext);
+	return (ExpandedJsonbHeader *) DatumGetEOHP(d);
+}
+
+/*
+ * Build the hash table over the top-level keys of an expanded jsonb object.
+ *
+ * Each entry remembers where the key's value is, so that a lookup doesn't
+ * have to walk the JEntry array to compute the value's offset.
+ */
+static void
+build_jsonb_keyindex(ExpandedJsonbHeader *ejh)
+{
+	JsonbContainer *container = &ejh->fvalue->root;
+	JEntry	   *children = container->children;
+	uint32		count = JsonContainerSize(container);
+	char	   *baseAddr = (char *) (children + count * 2);
+	struct jsonb_keyidx_hash *keyindex;
+	uint32		keyoffset = 0;
+	uint32		valoffset = 0;
+	uint32		i;
+
+	Assert(JsonContainerIsObject(container));
+
+	keyindex = jsonb_keyidx_create(ejh->hdr.eoh_context, count, NULL);
+
+	/* The values follow all the keys */
+	for (i = 0; i < count; i++)
+		JBE_ADVANCE_OFFSET(valoffset, children[i]);
+
+	for (i = 0; i < count; i++)
+	{
+		JsonbKeyIndexKey key;
+		JsonbKeyIndexEntry *entry;
+		uint32		nextoffset = keyoffset;
+		bool		found;
+
+		JBE_ADVANCE_OFFSET(nextoffset, children[i]);
+
+		key.val = baseAddr + keyoffset;
+		key.len = nextoffset - keyoffset;
+
+		entry = jsonb_keyidx_insert(keyindex, key, &found);
+		Assert(!found);			/* keys of a jsonb object are unique */
+		entry->validx = i + count;
+		entry->valoffset = valoffset;
+
+		keyoffset = nextoffset;
+		JBE_ADVANCE_OFFSET(valoffset, children[i + count]);
+	}
+
+	ejh->keyindex = keyindex;
+}
+
+/*
+ * Find value by key in an expanded jsonb and fetch it into 'res', which is
+ * also returned.
+ *
+ * 'res' can be passed in as NULL, in which case it's newly palloc'ed here.
+ * Returns NULL if the value is not an object, or if the key is not found.
+ */
+JsonbValue *
+getKeyJsonValueFromExpandedJsonb(ExpandedJsonbHeader *ejh,
+								 const char *keyVal, int keyLen,
+								 JsonbValue *res)
+{
+	JsonbContainer *container = &ejh->fvalue->root;
+	JsonbKeyIndexKey key;
+	JsonbKeyIndexEntry *entry;
+
+	Assert(ejh->ej_magic == EJ_MAGIC);
+
+	if (!JsonContainerIsObject(container))
+		return NULL;
+
+	if (ejh->keyindex == NULL)
+	{
+		if (JsonContainerSize(container) < EJ_KEYINDEX_MIN_KEYS)
+			return getKeyJsonValueFromContainer(container, keyVal, keyLen,
+												res);
+		build_jsonb_keyindex(ejh);
+	}
+
+	key.val = keyVal;
+	key.len = keyLen;
+	entry = jsonb_keyidx_lookup(ejh->keyindex, key);
+	if (entry == NULL)
+		return NULL;
+
+	if (!res)
+		res = palloc(sizeof(JsonbValue));
+
+	fillJsonbValue(container, entry->validx,
+				   (char *) (container->children +
+							 JsonContainerSize(container) * 2),
+				   entry->valoffset, res);
+
+	return res;
+}
+
+/*
+ * Find value by key in a jsonb Datum, which may be an expanded jsonb, and
+ * fetch it into 'res', which is also returned.
+ *
+ * 'res' can be passed in as NULL, in which case it's newly palloc'ed here.
+ * Returns NULL if the value is not an object, or if the key is not found.
+ */
+JsonbValue *
+getKeyJsonValueFromDatum(Datum jsonbdatum, const char *keyVal, int keyLen,
+						 JsonbValue *res)
+{
+	Jsonb	   *jb;
+
+	if (VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(jsonbdatum)))
+		return getKeyJsonValueFromExpandedJsonb(DatumGetExpandedJsonb(jsonbdatum),
+												keyVal, keyLen, res);
+
+	jb = DatumGetJsonbP(jsonbdatum);
+	if (!JB_ROOT_IS_OBJECT(jb))
+		return NULL;
+
+	return getKeyJsonValueFromContainer(&jb->root, keyVal, keyLen, res);
+}
@@ -21,8 +21,9 @@
 Datum
 jsonb_exists(PG_FUNCTION_ARGS)
 {
-	Jsonb	   *jb = PG_GETARG_JSONB_P(0);
+	Datum		jsonb = PG_GETARG_DATUM(0);
 	text	   *key = PG_GETARG_TEXT_PP(1);
+	Jsonb	   *jb;
 	JsonbValue	kval;
 	JsonbValue *v = NULL;
 
@@ -36,6 +37,26 @@ jsonb_exists(PG_FUNCTION_ARGS)
 	kval.val.string.val = VARDATA_ANY(key);
 	kval.val.string.len = VARSIZE_ANY_EXHDR(key);
 
+	/* An expanded jsonb can use its key index to search an object */
+	if (VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(jsonb)))
+	{
+		ExpandedJsonbHeader *ejh = DatumGetExpandedJsonb(jsonb);
+
+		if (JB_ROOT_IS_OBJECT(ejh->fvalue))
+		{
+			JsonbValue	vbuf;
+
+			v = getKeyJsonValueFromExpandedJsonb(ejh,
+												 kval.val.string.val,
+												 kval.val.string.len,
+												 &vbuf);
+			PG_RETURN_BOOL(v != NULL);
+		}
+		jb = ejh->fvalue;
+	}
+	else
+		jb = DatumGetJsonbP(jsonb);
+
 	v = findJsonbValueFromContainer(&jb->root,
 									JB_FOBJECT | JB_FARRAY,
 									&kval);
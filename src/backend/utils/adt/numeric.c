@@ -311,6 +311,17 @@ typedef struct NumericVar
 	NumericDigit *digits;		/* base-NBASE digits */
 } NumericVar;
 
+/*
+ * Limits for the "small" value fast path; see numeric_get_small().  A small
+ * value has at most NUMERIC_SMALL_MAX_DIGITS NBASE digits, the most that fit
+ * in 18 decimal digits.  With DEC_DIGITS = 4 that's 4 NBASE digits, ie. 16
+ * decimal digits, so small values are less than 10^16 in absolute value.
+ * An int64 may need up to 20 decimal digits, so NUMERIC_SMALL_BUF_DIGITS is
+ * enough to convert any int64 back.
+ */
+#define NUMERIC_SMALL_MAX_DIGITS	(18 / DEC_DIGITS)
+#define NUMERIC_SMALL_BUF_DIGITS	((20 + DEC_DIGITS - 1) / DEC_DIGITS)
+
 
 /* ----------
  * Data for generate_series
@@ -525,6 +536,11 @@ static bool numericvar_to_int32(const NumericVar *var, int32 *result);
 static bool numericvar_to_int64(const NumericVar *var, int64 *result);
 static void int64_to_numericvar(int64 val, NumericVar *var);
 static bool numericvar_to_uint64(const NumericVar *var, uint64 *result);
+static bool numeric_get_small(Numeric num, int64 *val, int *scale);
+static bool small_align(int64 *val1, int *scale1, int64 *val2, int *scale2);
+static void small_to_numericvar(int64 val, int scale, NumericVar *var,
+								NumericDigit *digitbuf);
+static Numeric small_to_numeric(int64 val, int scale, int dscale);
 #ifdef HAVE_INT128
 static bool numericvar_to_int128(const NumericVar *var, int128 *result);
 static void int128_to_numericvar(int128 val, NumericVar *var);
@@ -2869,6 +2885,10 @@ numeric_add_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	NumericVar	arg2;
 	NumericVar	result;
 	Numeric		res;
+	int64		val1,
+				val2;
+	int			scale1,
+				scale2;
 
 	/*
 	 * Handle NaN and infinities
@@ -2898,6 +2918,17 @@ numeric_add_opt_error(Numeric num1, Numeric num2, bool *have_error)
 		return make_result(&const_ninf);
 	}
 
+	/*
+	 * Use integer arithmetic if both values are small, and the result doesn't
+	 * overflow.
+	 */
+	if (numeric_get_small(num1, &val1, &scale1) &&
+		numeric_get_small(num2, &val2, &scale2) &&
+		small_align(&val1, &scale1, &val2, &scale2) &&
+		!pg_add_s64_overflow(val1, val2, &val1))
+		return small_to_numeric(val1, scale1,
+								Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2)));
+
 	/*
 	 * Unpack the values, let add_var() compute the result and return it.
 	 */
@@ -2947,6 +2978,10 @@ numeric_sub_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	NumericVar	arg2;
 	NumericVar	result;
 	Numeric		res;
+	int64		val1,
+				val2;
+	int			scale1,
+				scale2;
 
 	/*
 	 * Handle NaN and infinities
@@ -2976,6 +3011,17 @@ numeric_sub_opt_error(Numeric num1, Numeric num2, bool *have_error)
 		return make_result(&const_pinf);
 	}
 
+	/*
+	 * Use integer arithmetic if both values are small, and the result doesn't
+	 * overflow.
+	 */
+	if (numeric_get_small(num1, &val1, &scale1) &&
+		numeric_get_small(num2, &val2, &scale2) &&
+		small_align(&val1, &scale1, &val2, &scale2) &&
+		!pg_sub_s64_overflow(val1, val2, &val1))
+		return small_to_numeric(val1, scale1,
+								Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2)));
+
 	/*
 	 * Unpack the values, let sub_var() compute the result and return it.
 	 */
@@ -3025,6 +3071,10 @@ numeric_mul_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	NumericVar	arg2;
 	NumericVar	result;
 	Numeric		res;
+	int64		val1,
+				val2;
+	int			scale1,
+				scale2;
 
 	/*
 	 * Handle NaN and infinities
@@ -3086,6 +3136,19 @@ numeric_mul_opt_error(Numeric num1, Numeric num2, bool *have_error)
 		Assert(false);
 	}
 
+	/*
+	 * Use integer arithmetic if both values are small, and the result doesn't
+	 * overflow.  The exact product has no more digits after the decimal point
+	 * than the two dscales together, so no rounding is needed (except beyond
+	 * NUMERIC_DSCALE_MAX, which we leave to the general code).
+	 */
+	if (NUMERIC_DSCALE(num1) + NUMERIC_DSCALE(num2) <= NUMERIC_DSCALE_MAX &&
+		numeric_get_small(num1, &val1, &scale1) &&
+		numeric_get_small(num2, &val2, &scale2) &&
+		!pg_mul_s64_overflow(val1, val2, &val1))
+		return small_to_numeric(val1, scale1 + scale2,
+								NUMERIC_DSCALE(num1) + NUMERIC_DSCALE(num2));
+
 	/*
 	 * Unpack the values, let mul_var() compute the result and return it.
 	 * Unlike add_var() and sub_var(), mul_var() will round its result. In the
@@ -4720,6 +4783,17 @@ typedef struct NumericAggState
 	int64		N;				/* count of processed numbers */
 	NumericSumAccum sumX;		/* sum of processed numbers */
 	NumericSumAccum sumX2;		/* sum of squares of processed numbers */
+
+	/*
+	 * Small inputs (see numeric_get_small) are summed in smallSumX rather
+	 * than sumX, in integer arithmetic.  smallSumX is moved into sumX when it
+	 * would overflow, and before sumX is used; see numeric_agg_flush_small.
+	 */
+	bool		haveSmallSumX;	/* smallSumX includes any inputs? */
+	int64		smallSumX;		/* sum of small inputs, as a small value */
+	int			smallScale;		/* ... and its scale */
+	int			smallDscale;	/* maximum dscale of small inputs */
+
 	int			maxScale;		/* maximum scale seen so far */
 	int64		maxScaleCount;	/* number of values seen with maximum scale */
 	/* These counts are *not* included in N!  Use NA_TOTAL_COUNT() as needed */
@@ -4772,6 +4846,71 @@ makeNumericAggStateCurrentContext(bool calcSumX2)
 	return state;
 }
 
+/*
+ * Move the sum of small inputs into sumX.
+ *
+ * This must be called before state->sumX is used for anything.
+ */
+static void
+numeric_agg_flush_small(NumericAggState *state)
+{
+	NumericVar	X;
+	NumericDigit digitbuf[NUMERIC_SMALL_BUF_DIGITS];
+	MemoryContext old_context;
+
+	if (!state->haveSmallSumX)
+		return;
+
+	small_to_numericvar(state->smallSumX, state->smallScale, &X, digitbuf);
+	X.dscale = state->smallDscale;
+
+	old_context = MemoryContextSwitchTo(state->agg_context);
+	accum_sum_add(&(state->sumX), &X);
+	MemoryContextSwitchTo(old_context);
+
+	state->haveSmallSumX = false;
+	state->smallSumX = 0;
+	state->smallScale = 0;
+	state->smallDscale = 0;
+}
+
+/*
+ * Add a finite input value, or subtract it if 'negate', to the sum of small
+ * inputs.  Returns false if the value is not small, in which case the caller
+ * must add it to sumX instead.
+ */
+static bool
+numeric_agg_accum_small(NumericAggState *state, Numeric newval, int dscale,
+						bool negate)
+{
+	int64		val;
+	int			scale;
+	int64		sum = state->smallSumX;
+	int			sumscale = state->smallScale;
+
+	if (!numeric_get_small(newval, &val, &scale))
+		return false;
+	if (negate)
+		val = -val;				/* can't overflow, small values are < 10^16 */
+
+	if (!state->haveSmallSumX ||
+		!small_align(&sum, &sumscale, &val, &scale) ||
+		pg_add_s64_overflow(sum, val, &sum))
+	{
+		/* Start over with just this value */
+		numeric_agg_flush_small(state);
+		numeric_get_small(newval, &sum, &sumscale);
+		if (negate)
+			sum = -sum;
+		state->haveSmallSumX = true;
+	}
+
+	state->smallSumX = sum;
+	state->smallScale = sumscale;
+	state->smallDscale = Max(state->smallDscale, dscale);
+	return true;
+}
+
 /*
  * Accumulate a new input value for numeric aggregate functions.
  */
@@ -4822,7 +4961,8 @@ do_numeric_accum(NumericAggState *state, Numeric newval)
 	state->N++;
 
 	/* Accumulate sums */
-	accum_sum_add(&(state->sumX), &X);
+	if (!numeric_agg_accum_small(state, newval, X.dscale, false))
+		accum_sum_add(&(state->sumX), &X);
 
 	if (state->calcSumX2)
 		accum_sum_add(&(state->sumX2), &X2);
@@ -4910,8 +5050,11 @@ do_numeric_discard(NumericAggState *state, Numeric newval)
 	if (state->N-- > 1)
 	{
 		/* Negate X, to subtract it from the sum */
-		X.sign = (X.sign == NUMERIC_POS ? NUMERIC_NEG : NUMERIC_POS);
-		accum_sum_add(&(state->sumX), &X);
+		if (!numeric_agg_accum_small(state, newval, X.dscale, true))
+		{
+			X.sign = (X.sign == NUMERIC_POS ? NUMERIC_NEG : NUMERIC_POS);
+			accum_sum_add(&(state->sumX), &X);
+		}
 
 		if (state->calcSumX2)
 		{
@@ -4928,6 +5071,10 @@ do_numeric_discard(NumericAggState *state, Numeric newval)
 		accum_sum_reset(&state->sumX);
 		if (state->calcSumX2)
 			accum_sum_reset(&state->sumX2);
+		state->haveSmallSumX = false;
+		state->smallSumX = 0;
+		state->smallScale = 0;
+		state->smallDscale = 0;
 	}
 
 	MemoryContextSwitchTo(old_context);
@@ -4975,6 +5122,9 @@ numeric_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+	/* state1 can keep its small inputs' sum, but state2's goes into sumX */
+	numeric_agg_flush_small(state2);
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -5067,6 +5217,9 @@ numeric_avg_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+	/* state1 can keep its small inputs' sum, but state2's goes into sumX */
+	numeric_agg_flush_small(state2);
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -5136,6 +5289,8 @@ numeric_avg_serialize(PG_FUNCTION_ARGS)
 
 	state = (NumericAggState *) PG_GETARG_POINTER(0);
 
+	numeric_agg_flush_small(state);
+
 	init_var(&tmp_var);
 
 	pq_begintypsend(&buf);
@@ -5248,6 +5403,8 @@ numeric_serialize(PG_FUNCTION_ARGS)
 
 	state = (NumericAggState *) PG_GETARG_POINTER(0);
 
+	numeric_agg_flush_small(state);
+
 	init_var(&tmp_var);
 
 	pq_begintypsend(&buf);
@@ -5555,6 +5712,11 @@ numeric_poly_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+#ifndef HAVE_INT128
+	/* state1 can keep its small inputs' sum, but state2's goes into sumX */
+	numeric_agg_flush_small(state2);
+#endif
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -5637,6 +5799,7 @@ numeric_poly_serialize(PG_FUNCTION_ARGS)
 #ifdef HAVE_INT128
 	int128_to_numericvar(state->sumX, &tmp_var);
 #else
+	numeric_agg_flush_small(state);
 	accum_sum_final(&state->sumX, &tmp_var);
 #endif
 	numericvar_serialize(&buf, &tmp_var);
@@ -5760,6 +5923,11 @@ int8_avg_combine(PG_FUNCTION_ARGS)
 	if (state2 == NULL)
 		PG_RETURN_POINTER(state1);
 
+#ifndef HAVE_INT128
+	/* state1 can keep its small inputs' sum, but state2's goes into sumX */
+	numeric_agg_flush_small(state2);
+#endif
+
 	/* manually copy all fields from state2 to state1 */
 	if (state1 == NULL)
 	{
@@ -5837,6 +6005,7 @@ int8_avg_serialize(PG_FUNCTION_ARGS)
 #ifdef HAVE_INT128
 	int128_to_numericvar(state->sumX, &tmp_var);
 #else
+	numeric_agg_flush_small(state);
 	accum_sum_final(&state->sumX, &tmp_var);
 #endif
 	numericvar_serialize(&buf, &tmp_var);
@@ -6081,6 +6250,7 @@ numeric_avg(PG_FUNCTION_ARGS)
 
 	N_datum = NumericGetDatum(int64_to_numeric(state->N));
 
+	numeric_agg_flush_small(state);
 	init_var(&sumX_var);
 	accum_sum_final(&state->sumX, &sumX_var);
 	sumX_datum = NumericGetDatum(make_result(&sumX_var));
@@ -6113,6 +6283,7 @@ numeric_sum(PG_FUNCTION_ARGS)
 	if (state->nInfcount > 0)
 		PG_RETURN_NUMERIC(make_result(&const_ninf));
 
+	numeric_agg_flush_small(state);
 	init_var(&sumX_var);
 	accum_sum_final(&state->sumX, &sumX_var);
 	result = make_result(&sumX_var);
@@ -6177,6 +6348,7 @@ numeric_stddev_internal(NumericAggState *state,
 	init_var(&vsumX2);
 
 	int64_to_numericvar(state->N, &vN);
+	numeric_agg_flush_small(state);
 	accum_sum_final(&(state->sumX), &vsumX);
 	accum_sum_final(&(state->sumX2), &vsumX2);
 
@@ -8072,6 +8244,138 @@ int64_to_numericvar(int64 val, NumericVar *var)
 	var->weight = ndigits - 1;
 }
 
+/*
+ * numeric_get_small() -
+ *
+ *	Fast path support for small values.  A finite numeric whose digits span
+ *	at most NUMERIC_SMALL_MAX_DIGITS NBASE digits (16 decimal digits with
+ *	DEC_DIGITS = 4) is "small": it can be represented exactly by its digits
+ *	taken as an int64 integer, together with a scale giving the number of
+ *	those NBASE digits that are after the decimal point.  Addition,
+ *	subtraction and multiplication of small values can be done in integer
+ *	arithmetic, as long as it doesn't overflow, without building NumericVars.
+ *	Most numeric data in practice, such as monetary amounts, is small.
+ *
+ *	Returns false if the value is not small.  Note that the scale is unrelated
+ *	to the display scale; the caller must keep track of that separately.
+ */
+static bool
+numeric_get_small(Numeric num, int64 *val, int *scale)
+{
+	int			ndigits = NUMERIC_NDIGITS(num);
+	int			weight;
+	int			nzeros;
+	NumericDigit *digits;
+	int64		result;
+	int			i;
+
+	Assert(!NUMERIC_IS_SPECIAL(num));
+
+	if (ndigits == 0)
+	{
+		*val = 0;
+		*scale = 0;
+		return true;
+	}
+
+	/* number of zero NBASE digits between the last digit and the point */
+	weight = NUMERIC_WEIGHT(num);
+	nzeros = Max(weight - (ndigits - 1), 0);
+	if (ndigits + nzeros > NUMERIC_SMALL_MAX_DIGITS)
+		return false;
+
+	digits = NUMERIC_DIGITS(num);
+	result = digits[0];
+	for (i = 1; i < ndigits; i++)
+		result = result * NBASE + digits[i];
+	for (i = 0; i < nzeros; i++)
+		result *= NBASE;
+
+	*val = (NUMERIC_SIGN(num) == NUMERIC_NEG) ? -result : result;
+	*scale = ndigits - 1 - weight + nzeros;
+	return true;
+}
+
+/*
+ * small_align() -
+ *
+ *	Rescale two small values to the larger of their scales.  Returns false
+ *	on overflow.
+ */
+static bool
+small_align(int64 *val1, int *scale1, int64 *val2, int *scale2)
+{
+	int64	   *val = (*scale1 < *scale2) ? val1 : val2;
+	int			n = abs(*scale1 - *scale2);
+
+	if (*val != 0)
+	{
+		while (n-- > 0)
+		{
+			if (unlikely(pg_mul_s64_overflow(*val, NBASE, val)))
+				return false;
+		}
+	}
+
+	*scale1 = *scale2 = Max(*scale1, *scale2);
+	return true;
+}
+
+/*
+ * small_to_numericvar() -
+ *
+ *	Convert a small value to a NumericVar, using digitbuf, which must have
+ *	room for NUMERIC_SMALL_BUF_DIGITS digits, for the digits.  The display
+ *	scale is left for the caller to set.
+ */
+static void
+small_to_numericvar(int64 val, int scale, NumericVar *var,
+					NumericDigit *digitbuf)
+{
+	uint64		uval;
+	NumericDigit *ptr = digitbuf + NUMERIC_SMALL_BUF_DIGITS;
+
+	if (val < 0)
+	{
+		var->sign = NUMERIC_NEG;
+		uval = -(uint64) val;
+	}
+	else
+	{
+		var->sign = NUMERIC_POS;
+		uval = val;
+	}
+
+	while (uval != 0)
+	{
+		*--ptr = uval % NBASE;
+		uval /= NBASE;
+	}
+
+	var->ndigits = digitbuf + NUMERIC_SMALL_BUF_DIGITS - ptr;
+	var->weight = var->ndigits - 1 - scale;
+	var->dscale = 0;
+	var->buf = NULL;
+	var->digits = ptr;
+}
+
+/*
+ * small_to_numeric() -
+ *
+ *	Convert a small value to a Numeric with the given display scale.
+ */
+static Numeric
+small_to_numeric(int64 val, int scale, int dscale)
+{
+	NumericVar	var;
+	NumericDigit digitbuf[NUMERIC_SMALL_BUF_DIGITS];
+
+	small_to_numericvar(val, scale, &var, digitbuf);
+	var.dscale = dscale;
+
+	return make_result(&var);
+}
+
 /*
  * Convert numeric to uint64, rounding if needed.
  *
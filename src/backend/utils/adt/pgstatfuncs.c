@@ -1214,6 +1214,12 @@ pg_stat_get_bgwriter_maxwritten_clean(PG_FUNCTION_ARGS)
 	PG_RETURN_INT64(pgstat_fetch_stat_bgwriter()->maxwritten_clean);
 }
 
+Datum
+pg_stat_get_bgwriter_buf_written_evict(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT64(pgstat_fetch_stat_bgwriter()->buf_written_evict);
+}
+
 Datum
 pg_stat_get_checkpoint_write_time(PG_FUNCTION_ARGS)
 {
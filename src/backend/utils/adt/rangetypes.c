@@ -41,6 +41,7 @@
 #include "utils/date.h"
 #include "utils/lsyscache.h"
 #include "utils/rangetypes.h"
+#include "utils/sortsupport.h"
 #include "utils/timestamp.h"
 #include "varatt.h"
 
@@ -1237,13 +1238,13 @@ range_intersect_agg_transfn(PG_FUNCTION_ARGS)
 
 /* Btree support */
 
-/* btree comparator */
-Datum
-range_cmp(PG_FUNCTION_ARGS)
+/*
+ * Compare two ranges of the same type, b-tree style.
+ */
+static int
+range_cmp_internal(TypeCacheEntry *typcache, const RangeType *r1,
+				   const RangeType *r2)
 {
-	RangeType  *r1 = PG_GETARG_RANGE_P(0);
-	RangeType  *r2 = PG_GETARG_RANGE_P(1);
-	TypeCacheEntry *typcache;
 	RangeBound	lower1,
 				lower2;
 	RangeBound	upper1,
@@ -1252,14 +1253,6 @@ range_cmp(PG_FUNCTION_ARGS)
 				empty2;
 	int			cmp;
 
-	check_stack_depth();		/* recurses when subtype is a range type */
-
-	/* Different types should be prevented by ANYRANGE matching rules */
-	if (RangeTypeGetOid(r1) != RangeTypeGetOid(r2))
-		elog(ERROR, "range types do not match");
-
-	typcache = range_get_typcache(fcinfo, RangeTypeGetOid(r1));
-
 	range_deserialize(typcache, r1, &lower1, &upper1, &empty1);
 	range_deserialize(typcache, r2, &lower2, &upper2, &empty2);
 
@@ -1277,12 +1270,87 @@ range_cmp(PG_FUNCTION_ARGS)
 			cmp = range_cmp_bounds(typcache, &upper1, &upper2);
 	}
 
+	return cmp;
+}
+
+/* btree comparator */
+Datum
+range_cmp(PG_FUNCTION_ARGS)
+{
+	RangeType  *r1 = PG_GETARG_RANGE_P(0);
+	RangeType  *r2 = PG_GETARG_RANGE_P(1);
+	TypeCacheEntry *typcache;
+	int			cmp;
+
+	check_stack_depth();		/* recurses when subtype is a range type */
+
+	/* Different types should be prevented by ANYRANGE matching rules */
+	if (RangeTypeGetOid(r1) != RangeTypeGetOid(r2))
+		elog(ERROR, "range types do not match");
+
+	typcache = range_get_typcache(fcinfo, RangeTypeGetOid(r1));
+
+	cmp = range_cmp_internal(typcache, r1, r2);
+
 	PG_FREE_IF_COPY(r1, 0);
 	PG_FREE_IF_COPY(r2, 1);
 
 	PG_RETURN_INT32(cmp);
 }
 
+/*
+ * SortSupport comparator for ranges.  The range type isn't known until we
+ * see the first value, so the type cache entry is looked up lazily and
+ * remembered in ssup_extra.
+ */
+static int
+range_fastcmp(Datum x, Datum y, SortSupport ssup)
+{
+	RangeType  *r1 = DatumGetRangeTypeP(x);
+	RangeType  *r2 = DatumGetRangeTypeP(y);
+	TypeCacheEntry *typcache = (TypeCacheEntry *) ssup->ssup_extra;
+	int			cmp;
+
+	check_stack_depth();		/* recurses when subtype is a range type */
+
+	/* Different types should be prevented by ANYRANGE matching rules */
+	if (RangeTypeGetOid(r1) != RangeTypeGetOid(r2))
+		elog(ERROR, "range types do not match");
+
+	if (typcache == NULL || typcache->type_id != RangeTypeGetOid(r1))
+	{
+		typcache = lookup_type_cache(RangeTypeGetOid(r1),
+									 TYPECACHE_RANGE_INFO);
+		if (typcache->rngelemtype == NULL)
+			elog(ERROR, "type %u is not a range type", RangeTypeGetOid(r1));
+		ssup->ssup_extra = typcache;
+	}
+
+	cmp = range_cmp_internal(typcache, r1, r2);
+
+	if ((Pointer) r1 != DatumGetPointer(x))
+		pfree(r1);
+	if ((Pointer) r2 != DatumGetPointer(y))
+		pfree(r2);
+
+	return cmp;
+}
+
+/*
+ * Sort support routine for ranges, used by b-tree and also by GiST, where it
+ * enables the sorted index build method for range_ops.
+ */
+Datum
+range_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	ssup->comparator = range_fastcmp;
+	ssup->ssup_extra = NULL;
+
+	PG_RETURN_VOID();
+}
+
 /* inequality operators using the range_cmp function */
 Datum
 range_lt(PG_FUNCTION_ARGS)
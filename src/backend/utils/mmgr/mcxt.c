@@ -85,6 +85,20 @@ static const MemoryContextMethods mcxt_methods[] = {
 	[MCTX_SLAB_ID].check = SlabCheck,
 #endif
 
+	/* bump.c */
+	[MCTX_BUMP_ID].alloc = BumpAlloc,
+	[MCTX_BUMP_ID].free_p = BumpFree,
+	[MCTX_BUMP_ID].realloc = BumpRealloc,
+	[MCTX_BUMP_ID].reset = BumpReset,
+	[MCTX_BUMP_ID].delete_context = BumpDelete,
+	[MCTX_BUMP_ID].get_chunk_context = BumpGetChunkContext,
+	[MCTX_BUMP_ID].get_chunk_space = BumpGetChunkSpace,
+	[MCTX_BUMP_ID].is_empty = BumpIsEmpty,
+	[MCTX_BUMP_ID].stats = BumpStats,
+#ifdef MEMORY_CONTEXT_CHECKING
+	[MCTX_BUMP_ID].check = BumpCheck,
+#endif
+
 	/* alignedalloc.c */
 	[MCTX_ALIGNED_REDIRECT_ID].alloc = NULL,	/* not required */
 	[MCTX_ALIGNED_REDIRECT_ID].free_p = AlignedAllocFree,
@@ -126,6 +140,41 @@ static const MemoryContextMethods mcxt_methods[] = {
 	[MCTX_UNUSED4_ID].realloc = BogusRealloc,
 	[MCTX_UNUSED4_ID].get_chunk_context = BogusGetChunkContext,
 	[MCTX_UNUSED4_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED5_ID].free_p = BogusFree,
+	[MCTX_UNUSED5_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED5_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED5_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED6_ID].free_p = BogusFree,
+	[MCTX_UNUSED6_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED6_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED6_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED7_ID].free_p = BogusFree,
+	[MCTX_UNUSED7_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED7_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED7_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED8_ID].free_p = BogusFree,
+	[MCTX_UNUSED8_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED8_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED8_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED9_ID].free_p = BogusFree,
+	[MCTX_UNUSED9_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED9_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED9_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED10_ID].free_p = BogusFree,
+	[MCTX_UNUSED10_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED10_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED10_ID].get_chunk_space = BogusGetChunkSpace,
+
+	[MCTX_UNUSED11_ID].free_p = BogusFree,
+	[MCTX_UNUSED11_ID].realloc = BogusRealloc,
+	[MCTX_UNUSED11_ID].get_chunk_context = BogusGetChunkContext,
+	[MCTX_UNUSED11_ID].get_chunk_space = BogusGetChunkSpace,
 };
 
 /*
@@ -227,6 +227,7 @@ static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static long ltsGetPreallocBlock(LogicalTapeSet *lts, LogicalTape *lt);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
 static void ltsInitReadBuffer(LogicalTape *lt);
+static void ltsPrefetchBuffer(LogicalTape *lt, long blocknum);
 
 
 /*
@@ -289,6 +290,30 @@ ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 	BufFileReadExact(lts->pfile, buffer, BLCKSZ);
 }
 
+/*
+ * Hint to the OS that we'll soon fill the tape's buffer, starting at the
+ * given block.
+ *
+ * We don't know which blocks will follow without reading the block trailers,
+ * but blocks are handed out to a tape in preallocated batches of consecutive
+ * block numbers, so most of the time the next buffer load is a contiguous
+ * range of the underlying file.  Issuing the prefetch as soon as we know the
+ * first block lets the read proceed in the background while the caller
+ * consumes the current buffer, and lets the initial reads of all the input
+ * tapes of a merge be in flight at once.  If the guess is wrong, we've only
+ * wasted some read-ahead.
+ */
+static void
+ltsPrefetchBuffer(LogicalTape *lt, long blocknum)
+{
+	if (blocknum == -1L)
+		return;
+
+	BufFilePrefetchBlock(lt->tapeSet->pfile,
+						 blocknum + lt->offsetBlockNumber,
+						 (int) (lt->buffer_size / BLCKSZ));
+}
+
 /*
  * Read as many blocks as we can into the per-tape buffer.
  *
@@ -330,6 +355,9 @@ ltsReadFillBuffer(LogicalTape *lt)
 		/* Advance to next block, if we have buffer space left */
 	} while (lt->buffer_size - lt->nbytes > BLCKSZ);
 
+	/* Start reading the next buffer load in the background */
+	ltsPrefetchBuffer(lt, lt->nextBlockNumber);
+
 	return (lt->nbytes > 0);
 }
 
@@ -581,6 +609,8 @@ LogicalTapeSetCreate(bool preallocate, SharedFileSet *fileset, int worker)
 	 * create a BufFile here. Things are simpler for the worker case and the
 	 * serial case, though.  They are generally very similar -- workers use a
 	 * shared fileset, whereas serial sorts use a conventional serial BufFile.
+	 * Only the serial BufFile can be compressed, as compressed BufFiles can't
+	 * be concatenated.
 	 */
 	if (fileset && worker == -1)
 		lts->pfile = NULL;
@@ -592,7 +622,7 @@ LogicalTapeSetCreate(bool preallocate, SharedFileSet *fileset, int worker)
 		lts->pfile = BufFileCreateFileSet(&fileset->fs, filename);
 	}
 	else
-		lts->pfile = BufFileCreateTemp(false);
+		lts->pfile = BufFileCreateCompressTemp(false);
 
 	return lts;
 }
@@ -917,6 +947,9 @@ LogicalTapeRewindForRead(LogicalTape *lt, size_t buffer_size)
 		lt->nprealloc = 0;
 		lt->prealloc_size = 0;
 	}
+
+	/* Get the first buffer load on its way */
+	ltsPrefetchBuffer(lt, lt->firstBlockNumber);
 }
 
 /*
@@ -315,7 +315,7 @@ sts_puttuple(SharedTuplestoreAccessor *accessor, void *meta_data,
 
 		oldcxt = MemoryContextSwitchTo(accessor->context);
 		accessor->write_file =
-			BufFileCreateFileSet(&accessor->fileset->fs, name);
+			BufFileCreateCompressFileSet(&accessor->fileset->fs, name);
 		MemoryContextSwitchTo(oldcxt);
 
 		/* Set up the shared state for this backend's file. */
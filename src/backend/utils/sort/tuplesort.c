@@ -42,10 +42,10 @@
  * end of the input is reached, we dump out remaining tuples in memory into
  * a final run, then merge the runs.
  *
- * When merging runs, we use a heap containing just the frontmost tuple from
- * each source run; we repeatedly output the smallest tuple and replace it
- * with the next tuple from its source tape (if any).  When the heap empties,
- * the merge is complete.  The basic merge algorithm thus needs very little
+ * When merging runs, we use a tree of losers holding just the frontmost tuple
+ * of each source run; we repeatedly output the smallest tuple and replace it
+ * with the next tuple from its source tape (if any), until all the source
+ * runs are exhausted.  The basic merge algorithm thus needs very little
  * memory --- only M tuples for an M-way merge, and M is constrained to a
  * small number.  However, we can still make good use of our full workMem
  * allocation by pre-reading additional blocks from each source tape.  Without
@@ -61,7 +61,9 @@
  * bytes from each tape in turn, and making the sequential blocks immediately
  * available for reuse.  This approach helps to localize both read and write
  * accesses.  The pre-reading is handled by logtape.c, we just tell it how
- * much memory to use for the buffers.
+ * much memory to use for the buffers.  logtape.c also asks the kernel to
+ * start reading each tape's next buffer load as soon as the previous one has
+ * been read, so that the I/O overlaps with merging the tuples in memory.
  *
  * In the current code we determine the number of input tapes M on the basis
  * of workMem: we want workMem/M to be large enough that we read a fair
@@ -196,6 +198,11 @@ struct Tuplesortstate
 	int			bound;			/* if bounded, the maximum number of tuples */
 	int64		availMem;		/* remaining memory available, in bytes */
 	int64		allowedMem;		/* total memory allowed, in bytes */
+	int64		tupleMem;		/* memory consumed by individual tuples.
+								 * storing this separately from what we track
+								 * in availMem allows us to subtract the
+								 * memory consumed by all tuples when dumping
+								 * tuples to tape */
 	int			maxTapes;		/* max number of input tapes to merge in each
 								 * pass */
 	int64		maxSpace;		/* maximum amount of space occupied among sort
@@ -209,15 +216,36 @@ struct Tuplesortstate
 	/*
 	 * This array holds the tuples now in sort memory.  If we are in state
 	 * INITIAL, the tuples are in no particular order; if we are in state
-	 * SORTEDINMEM, the tuples are in final sorted order; in states BUILDRUNS
-	 * and FINALMERGE, the tuples are organized in "heap" order per Algorithm
-	 * H.  In state SORTEDONTAPE, the array is not used.
+	 * SORTEDINMEM, the tuples are in final sorted order; in a bounded sort,
+	 * they are organized in "heap" order per Algorithm H.  While merging
+	 * (including state FINALMERGE), memtuples[i] holds the current tuple of
+	 * input tape i, and memtupcount is the number of input tapes that are not
+	 * yet exhausted.  In state SORTEDONTAPE, the array is not used.
 	 */
 	SortTuple  *memtuples;		/* array of SortTuple structs */
 	int			memtupcount;	/* number of tuples currently present */
 	int			memtupsize;		/* allocated length of memtuples array */
 	bool		growmemtuples;	/* memtuples' growth still underway? */
 
+	/*
+	 * While merging, the input tapes are ordered by a "tree of losers" (Knuth
+	 * 5.4.1, Algorithm R) over the memtuples[] entries.  mergeTree[0] is the
+	 * index of the tape holding the smallest current tuple, and internal
+	 * node n (1 <= n < mergeTreeSize) holds the tape that lost the comparison
+	 * at that node.  The leaf for tape i is node mergeTreeSize + i, and the
+	 * parent of node n is n / 2.  Replacing the winner takes exactly one
+	 * comparison per level, against a single tuple, instead of the two
+	 * comparisons per level and the SortTuple copying of a binary heap's
+	 * sift-down.  mergeDone[i] is set once input tape i is exhausted; such a
+	 * tape loses against every other.
+	 *
+	 * mergeTree has room for twice the maximum number of input tapes; the
+	 * upper half is scratch space for building the tree.
+	 */
+	int		   *mergeTree;
+	bool	   *mergeDone;
+	int			mergeTreeSize;	/* number of tapes in current merge */
+
 	/*
 	 * Memory for tuples is sometimes allocated using a simple slab allocator,
 	 * rather than with palloc().  Currently, we switch to slab allocation
@@ -229,7 +257,7 @@ struct Tuplesortstate
 	 * For the slab, we use one large allocation, divided into SLAB_SLOT_SIZE
 	 * slots.  The allocation is sized to have one slot per tape, plus one
 	 * additional slot.  We need that many slots to hold all the tuples kept
-	 * in the heap during merge, plus the one we have last returned from the
+	 * in memtuples during merge, plus the one we have last returned from the
 	 * sort, with tuplesort_gettuple.
 	 *
 	 * Initially, all the slots are kept in a linked list of free slots.  When
@@ -446,6 +474,9 @@ struct Sharedsort
  * a lot better than what we were doing before 7.3.  As of 9.6, a
  * separate memory context is used for caller passed tuples.  Resetting
  * it at certain key increments significantly ameliorates fragmentation.
+ * Caller tuples are allocated in a bump context unless the sort may become
+ * bounded, and GetMemoryChunkSpace cannot be used on those, so the
+ * tuplesort_put* routines pass in the space each tuple uses instead.
  * readtup routines use the slab allocator (they cannot use
  * the reset context because it gets deleted at the point that merging
  * begins).
@@ -462,6 +493,8 @@ static void mergeruns(Tuplesortstate *state);
 static void mergeonerun(Tuplesortstate *state);
 static void beginmerge(Tuplesortstate *state);
 static bool mergereadnext(Tuplesortstate *state, LogicalTape *srcTape, SortTuple *stup);
+static void merge_tree_build(Tuplesortstate *state);
+static void merge_tree_replay(Tuplesortstate *state);
 static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
@@ -623,6 +656,278 @@ qsort_tuple_int32_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
 #define ST_DEFINE
 #include "lib/sort_template.h"
 
+/*
+ * Radix sort for SortTuples whose leading key is compared by one of the
+ * specialized comparators above.
+ *
+ * Each of those comparators orders the datum1 values as plain integers, so
+ * we can map datum1 to an unsigned integer "radix key" that sorts the same
+ * way, and distribute the tuples on it one byte at a time, starting with the
+ * most significant byte (an in-place MSD radix sort, also known as American
+ * flag sort).  That avoids the O(n log n) comparisons of quicksort, which
+ * is a big win for large in-memory sorts.
+ *
+ * Partitions smaller than RADIXSORT_THRESHOLD are finished with the
+ * specialized quicksort for the comparator instead, since the per-pass
+ * overhead of the radix sort isn't worth it for them.  Tuples that end up
+ * with equal datum1 after all bytes have been looked at are sorted by the
+ * comparetup function, to apply the remaining sort keys, or the full
+ * comparator when datum1 is an abbreviated key.  NULLs are separated out
+ * before the radix sort, as they have no meaningful datum1.
+ */
+#define RADIXSORT_THRESHOLD 256
+
+typedef enum RadixKeyType
+{
+	RADIX_KEY_UNSIGNED,			/* ssup_datum_unsigned_cmp */
+	RADIX_KEY_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_KEY_INT32				/* ssup_datum_int32_cmp */
+} RadixKeyType;
+
+/*
+ * Map a non-NULL datum1 to an unsigned integer that sorts in the same order
+ * as the datums do according to the leading sort key.  Only the low
+ * 'nbytes' bytes of the result are significant.
+ */
+static pg_attribute_always_inline uint64
+radix_sort_key(Datum datum, RadixKeyType keytype, bool reverse)
+{
+	uint64		key;
+
+	switch (keytype)
+	{
+		case RADIX_KEY_UNSIGNED:
+			key = (uint64) datum;
+			break;
+#if SIZEOF_DATUM >= 8
+		case RADIX_KEY_SIGNED:
+			/* flip the sign bit so that negative values sort first */
+			key = ((uint64) DatumGetInt64(datum)) ^ (UINT64CONST(1) << 63);
+			break;
+#endif
+		case RADIX_KEY_INT32:
+			key = ((uint32) DatumGetInt32(datum)) ^ (((uint32) 1) << 31);
+			break;
+		default:
+			pg_unreachable();
+	}
+
+	return reverse ? ~key : key;
+}
+
+/*
+ * Sort a partition that is too small to be worth another radix pass, using
+ * the specialized quicksort for the leading key's comparator.
+ */
+static void
+radix_sort_fallback(SortTuple *tuples, size_t n, RadixKeyType keytype,
+					Tuplesortstate *state)
+{
+	switch (keytype)
+	{
+		case RADIX_KEY_UNSIGNED:
+			qsort_tuple_unsigned(tuples, n, state);
+			break;
+#if SIZEOF_DATUM >= 8
+		case RADIX_KEY_SIGNED:
+			qsort_tuple_signed(tuples, n, state);
+			break;
+#endif
+		case RADIX_KEY_INT32:
+			qsort_tuple_int32(tuples, n, state);
+			break;
+	}
+}
+
+/*
+ * Sort 'n' non-NULL tuples on radix key bytes 'level' (counting from the
+ * most significant one) and below.
+ */
+static void
+radix_sort_tuple_level(SortTuple *tuples, size_t n, int level, int nbytes,
+					   RadixKeyType keytype, Tuplesortstate *state)
+{
+	bool		reverse = state->base.sortKeys[0].ssup_reverse;
+	size_t		counts[256];
+	size_t		next[256];
+	size_t		ends[256];
+	size_t		start;
+	int			shift;
+	int			b;
+
+	Assert(n > 1);
+
+	CHECK_FOR_INTERRUPTS();
+
+	/* Skip over leading bytes that are the same in all tuples */
+	for (;;)
+	{
+		shift = (nbytes - 1 - level) * BITS_PER_BYTE;
+
+		memset(counts, 0, sizeof(counts));
+		for (size_t i = 0; i < n; i++)
+			counts[(radix_sort_key(tuples[i].datum1, keytype, reverse) >> shift) & 0xFF]++;
+
+		for (b = 0; b < 256; b++)
+		{
+			if (counts[b] != 0)
+				break;
+		}
+		if (counts[b] != n)
+			break;
+
+		if (++level == nbytes)
+		{
+			/* all radix keys are equal, so only the tiebreak is left */
+			if (state->base.onlyKey == NULL)
+				qsort_tuple(tuples, n, state->base.comparetup, state);
+			return;
+		}
+	}
+
+	/* Compute the bucket boundaries */
+	start = 0;
+	for (b = 0; b < 256; b++)
+	{
+		next[b] = start;
+		start += counts[b];
+		ends[b] = start;
+	}
+
+	/*
+	 * Permute the tuples into their buckets.  Each swap moves at least one
+	 * tuple into its final bucket.
+	 */
+	for (b = 0; b < 256; b++)
+	{
+		while (next[b] < ends[b])
+		{
+			SortTuple  *tuple = &tuples[next[b]];
+			int			tb;
+
+			tb = (radix_sort_key(tuple->datum1, keytype, reverse) >> shift) & 0xFF;
+			if (tb == b)
+				next[b]++;
+			else
+			{
+				SortTuple	tmp = *tuple;
+
+				*tuple = tuples[next[tb]];
+				tuples[next[tb]++] = tmp;
+			}
+		}
+	}
+
+	/* Sort each bucket on the remaining bytes */
+	start = 0;
+	for (b = 0; b < 256; b++)
+	{
+		SortTuple  *bucket = &tuples[start];
+		size_t		nbucket = counts[b];
+
+		start += nbucket;
+		if (nbucket < 2)
+			continue;
+
+		if (level == nbytes - 1)
+		{
+			/* radix keys within the bucket are equal, break ties */
+			if (state->base.onlyKey == NULL)
+				qsort_tuple(bucket, nbucket, state->base.comparetup, state);
+		}
+		else if (nbucket < RADIXSORT_THRESHOLD)
+			radix_sort_fallback(bucket, nbucket, keytype, state);
+		else
+			radix_sort_tuple_level(bucket, nbucket, level + 1, nbytes,
+								   keytype, state);
+	}
+}
+
+/*
+ * Sort all memtuples with a radix sort on datum1, if the leading key's
+ * comparator allows it.  Returns false if it doesn't, leaving memtuples
+ * untouched.
+ */
+static bool
+radix_sort_tuple(Tuplesortstate *state)
+{
+	SortSupport ssup = &state->base.sortKeys[0];
+	SortTuple  *tuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	RadixKeyType keytype;
+	int			nbytes;
+	size_t		nnulls;
+	SortTuple  *nulls;
+	SortTuple  *notnulls;
+
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+	{
+		keytype = RADIX_KEY_UNSIGNED;
+		nbytes = SIZEOF_DATUM;
+	}
+#if SIZEOF_DATUM >= 8
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+	{
+		keytype = RADIX_KEY_SIGNED;
+		nbytes = 8;
+	}
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+	{
+		keytype = RADIX_KEY_INT32;
+		nbytes = 4;
+	}
+	else
+		return false;
+
+	/*
+	 * Move the NULLs to the front or the back, as the sort key asks.  The
+	 * comparators treat all NULLs as equal on the leading key.
+	 */
+	nnulls = 0;
+	if (ssup->ssup_nulls_first)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			if (tuples[i].isnull1)
+			{
+				SortTuple	tmp = tuples[i];
+
+				tuples[i] = tuples[nnulls];
+				tuples[nnulls++] = tmp;
+			}
+		}
+		nulls = tuples;
+		notnulls = tuples + nnulls;
+	}
+	else
+	{
+		for (size_t i = n; i > 0; i--)
+		{
+			if (tuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = tuples[i - 1];
+
+				tuples[i - 1] = tuples[n - 1 - nnulls];
+				tuples[n - 1 - nnulls++] = tmp;
+			}
+		}
+		nulls = tuples + n - nnulls;
+		notnulls = tuples;
+	}
+
+	if (nnulls > 1 && state->base.onlyKey == NULL)
+		qsort_tuple(nulls, nnulls, state->base.comparetup, state);
+
+	if (n - nnulls >= RADIXSORT_THRESHOLD)
+		radix_sort_tuple_level(notnulls, n - nnulls, 0, nbytes, keytype,
+							   state);
+	else if (n - nnulls > 1)
+		radix_sort_fallback(notnulls, n - nnulls, keytype, state);
+
+	return true;
+}
+
 /*
  *		tuplesort_begin_xxx
  *
@@ -770,18 +1075,19 @@ tuplesort_begin_batch(Tuplesortstate *state)
 	 * in the parent context, not this context, because there is no need to
 	 * free memtuples early.  For bounded sorts, tuples may be pfreed in any
 	 * order, so we use a regular aset.c context so that it can make use of
-	 * free'd memory.  When the sort is not bounded, we make use of a
-	 * generation.c context as this keeps allocations more compact with less
-	 * wastage.  Allocations are also slightly more CPU efficient.
-	 */
-	if (state->base.sortopt & TUPLESORT_ALLOWBOUNDED)
+	 * free'd memory.  When the sort is not bounded, tuples are never pfreed
+	 * individually, so we make use of a bump.c context as this keeps
+	 * allocations more compact with less wastage, since it doesn't need chunk
+	 * headers.  Allocations are also slightly more CPU efficient.
+	 */
+	if (TupleSortUseBumpTupleCxt(state->base.sortopt))
+		state->base.tuplecontext = BumpContextCreate(state->base.sortcontext,
+													 "Caller tuples",
+													 ALLOCSET_DEFAULT_SIZES);
+	else
 		state->base.tuplecontext = AllocSetContextCreate(state->base.sortcontext,
 														 "Caller tuples",
 														 ALLOCSET_DEFAULT_SIZES);
-	else
-		state->base.tuplecontext = GenerationContextCreate(state->base.sortcontext,
-														   "Caller tuples",
-														   ALLOCSET_DEFAULT_SIZES);
 
 
 	state->status = TSS_INITIAL;
@@ -789,6 +1095,7 @@ tuplesort_begin_batch(Tuplesortstate *state)
 	state->boundUsed = false;
 
 	state->availMem = state->allowedMem;
+	state->tupleMem = 0;
 
 	state->tapeset = NULL;
 
@@ -811,6 +1118,13 @@ tuplesort_begin_batch(Tuplesortstate *state)
 		state->memtuples = (SortTuple *) palloc(state->memtupsize * sizeof(SortTuple));
 		USEMEM(state, GetMemoryChunkSpace(state->memtuples));
 	}
+	if (state->mergeTree != NULL)
+	{
+		pfree(state->mergeTree);
+		pfree(state->mergeDone);
+		state->mergeTree = NULL;
+		state->mergeDone = NULL;
+	}
 
 	/* workMem must be large enough for the minimal memtuples array */
 	if (LACKMEM(state))
@@ -1185,17 +1499,20 @@ noalloc:
 
 /*
  * Shared code for tuple and datum cases.
+ *
+ * 'tuplen' is the space used by the out-of-line data, or 0 if there is none.
  */
 void
-tuplesort_puttuple_common(Tuplesortstate *state, SortTuple *tuple, bool useAbbrev)
+tuplesort_puttuple_common(Tuplesortstate *state, SortTuple *tuple,
+						  bool useAbbrev, Size tuplen)
 {
 	MemoryContext oldcontext = MemoryContextSwitchTo(state->base.sortcontext);
 
 	Assert(!LEADER(state));
 
-	/* Count the size of the out-of-line data */
-	if (tuple->tuple != NULL)
-		USEMEM(state, GetMemoryChunkSpace(tuple->tuple));
+	/* account for the memory used for this tuple */
+	USEMEM(state, tuplen);
+	state->tupleMem += tuplen;
 
 	if (!useAbbrev)
 	{
@@ -1682,11 +1999,11 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 			 */
 			if (state->memtupcount > 0)
 			{
-				int			srcTapeIndex = state->memtuples[0].srctape;
+				int			srcTapeIndex = state->mergeTree[0];
 				LogicalTape *srcTape = state->inputTapes[srcTapeIndex];
-				SortTuple	newtup;
+				SortTuple  *top = &state->memtuples[srcTapeIndex];
 
-				*stup = state->memtuples[0];
+				*stup = *top;
 
 				/*
 				 * Remember the tuple we return, so that we can recycle its
@@ -1695,16 +2012,18 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 				state->lastReturnedTuple = stup->tuple;
 
 				/*
-				 * Pull next tuple from tape, and replace the returned tuple
-				 * at top of the heap with it.
+				 * Pull next tuple from tape into the returned tuple's place,
+				 * and find the new winner.
 				 */
-				if (!mergereadnext(state, srcTape, &newtup))
+				if (!mergereadnext(state, srcTape, top))
 				{
 					/*
 					 * If no more data, we've reached end of run on this tape.
-					 * Remove the top node from the heap.
+					 * Mark it as exhausted, so that it loses every
+					 * comparison from now on.
 					 */
-					tuplesort_heap_delete_top(state);
+					state->mergeDone[srcTapeIndex] = true;
+					state->memtupcount--;
 					state->nInputRuns--;
 
 					/*
@@ -1712,10 +2031,8 @@ tuplesort_gettuple_common(Tuplesortstate *state, bool forward,
 					 * anyway, but better to release the memory early.
 					 */
 					LogicalTapeClose(srcTape);
-					return true;
 				}
-				newtup.srctape = srcTapeIndex;
-				tuplesort_heap_replace_top(state, &newtup);
+				merge_tree_replay(state);
 				return true;
 			}
 			return false;
@@ -2073,7 +2390,7 @@ mergeruns(Tuplesortstate *state)
 
 	/*
 	 * We no longer need a large memtuples array.  (We will allocate a smaller
-	 * one for the heap later.)
+	 * one for the merge later.)
 	 */
 	FREEMEM(state, GetMemoryChunkSpace(state->memtuples));
 	pfree(state->memtuples);
@@ -2081,7 +2398,7 @@ mergeruns(Tuplesortstate *state)
 
 	/*
 	 * Initialize the slab allocator.  We need one slab slot per input tape,
-	 * for the tuples in the heap, plus one to hold the tuple last returned
+	 * for the tuples being merged, plus one to hold the tuple last returned
 	 * from tuplesort_gettuple.  (If we're sorting pass-by-val Datums,
 	 * however, we don't need to do allocate anything.)
 	 *
@@ -2098,17 +2415,23 @@ mergeruns(Tuplesortstate *state)
 		init_slab_allocator(state, 0);
 
 	/*
-	 * Allocate a new 'memtuples' array, for the heap.  It will hold one tuple
-	 * from each input tape.
+	 * Allocate a new 'memtuples' array, and the tree of losers over it.  It
+	 * will hold one tuple from each input tape.
 	 *
-	 * We could shrink this, too, between passes in a multi-pass merge, but we
-	 * don't bother.  (The initial input tapes are still in outputTapes.  The
-	 * number of input tapes will not increase between passes.)
+	 * We could shrink these, too, between passes in a multi-pass merge, but
+	 * we don't bother.  (The initial input tapes are still in outputTapes.
+	 * The number of input tapes will not increase between passes.)
 	 */
 	state->memtupsize = state->nOutputTapes;
 	state->memtuples = (SortTuple *) MemoryContextAlloc(state->base.maincontext,
 														state->nOutputTapes * sizeof(SortTuple));
 	USEMEM(state, GetMemoryChunkSpace(state->memtuples));
+	state->mergeTree = (int *) MemoryContextAlloc(state->base.maincontext,
+												  2 * state->nOutputTapes * sizeof(int));
+	USEMEM(state, GetMemoryChunkSpace(state->mergeTree));
+	state->mergeDone = (bool *) MemoryContextAlloc(state->base.maincontext,
+												   state->nOutputTapes * sizeof(bool));
+	USEMEM(state, GetMemoryChunkSpace(state->mergeDone));
 
 	/*
 	 * Use all the remaining memory we have available for tape buffers among
@@ -2236,49 +2559,46 @@ mergeonerun(Tuplesortstate *state)
 
 	/*
 	 * Start the merge by loading one tuple from each active source tape into
-	 * the heap.
+	 * the tree.
 	 */
 	beginmerge(state);
 
 	Assert(state->slabAllocatorUsed);
 
 	/*
-	 * Execute merge by repeatedly extracting lowest tuple in heap, writing it
-	 * out, and replacing it with next tuple from same tape (if there is
-	 * another one).
+	 * Execute merge by repeatedly writing out the winning tuple, and
+	 * replacing it with next tuple from same tape (if there is another one).
 	 */
 	while (state->memtupcount > 0)
 	{
-		SortTuple	stup;
+		SortTuple  *top;
 
 		/* write the tuple to destTape */
-		srcTapeIndex = state->memtuples[0].srctape;
+		srcTapeIndex = state->mergeTree[0];
 		srcTape = state->inputTapes[srcTapeIndex];
-		WRITETUP(state, state->destTape, &state->memtuples[0]);
+		top = &state->memtuples[srcTapeIndex];
+		WRITETUP(state, state->destTape, top);
 
 		/* recycle the slot of the tuple we just wrote out, for the next read */
-		if (state->memtuples[0].tuple)
-			RELEASE_SLAB_SLOT(state, state->memtuples[0].tuple);
+		if (top->tuple)
+			RELEASE_SLAB_SLOT(state, top->tuple);
 
 		/*
-		 * pull next tuple from the tape, and replace the written-out tuple in
-		 * the heap with it.
+		 * pull next tuple from the tape into the written-out tuple's place,
+		 * and find the new winner.
 		 */
-		if (mergereadnext(state, srcTape, &stup))
-		{
-			stup.srctape = srcTapeIndex;
-			tuplesort_heap_replace_top(state, &stup);
-		}
-		else
+		if (!mergereadnext(state, srcTape, top))
 		{
-			tuplesort_heap_delete_top(state);
+			state->mergeDone[srcTapeIndex] = true;
+			state->memtupcount--;
 			state->nInputRuns--;
 		}
+		merge_tree_replay(state);
 	}
 
 	/*
-	 * When the heap empties, we're done.  Write an end-of-run marker on the
-	 * output tape.
+	 * When all the tapes are exhausted, we're done.  Write an end-of-run
+	 * marker on the output tape.
 	 */
 	markrunend(state->destTape);
 }
@@ -2286,7 +2606,8 @@ mergeonerun(Tuplesortstate *state)
 /*
  * beginmerge - initialize for a merge pass
  *
- * Fill the merge heap with the first tuple from each input tape.
+ * Load the first tuple from each input tape, and build the tree of losers
+ * over them.
  */
 static void
 beginmerge(Tuplesortstate *state)
@@ -2294,21 +2615,29 @@ beginmerge(Tuplesortstate *state)
 	int			activeTapes;
 	int			srcTapeIndex;
 
-	/* Heap should be empty here */
+	/* Previous merge should be finished here */
 	Assert(state->memtupcount == 0);
 
 	activeTapes = Min(state->nInputTapes, state->nInputRuns);
+	Assert(activeTapes <= state->memtupsize);
 
 	for (srcTapeIndex = 0; srcTapeIndex < activeTapes; srcTapeIndex++)
 	{
-		SortTuple	tup;
+		SortTuple  *tup = &state->memtuples[srcTapeIndex];
 
-		if (mergereadnext(state, state->inputTapes[srcTapeIndex], &tup))
+		if (mergereadnext(state, state->inputTapes[srcTapeIndex], tup))
 		{
-			tup.srctape = srcTapeIndex;
-			tuplesort_heap_insert(state, &tup);
+			tup->srctape = srcTapeIndex;
+			state->mergeDone[srcTapeIndex] = false;
+			state->memtupcount++;
 		}
+		else
+			state->mergeDone[srcTapeIndex] = true;
 	}
+
+	state->mergeTreeSize = activeTapes;
+	if (state->memtupcount > 0)
+		merge_tree_build(state);
 }
 
 /*
@@ -2329,6 +2658,89 @@ mergereadnext(Tuplesortstate *state, LogicalTape *srcTape, SortTuple *stup)
 	return true;
 }
 
+/*
+ * Does the current tuple of merge input tape 'a' sort before that of 'b'?
+ *
+ * An exhausted tape sorts after everything else.
+ */
+static inline bool
+merge_tree_beats(Tuplesortstate *state, int a, int b)
+{
+	if (state->mergeDone[a])
+		return false;
+	if (state->mergeDone[b])
+		return true;
+	return COMPARETUP(state, &state->memtuples[a], &state->memtuples[b]) < 0;
+}
+
+/*
+ * merge_tree_build - build the tree of losers for a merge
+ *
+ * Plays a tournament bottom-up, remembering the winner of each internal node
+ * in the scratch half of mergeTree, and leaving the loser in the node.
+ */
+static void
+merge_tree_build(Tuplesortstate *state)
+{
+	int			k = state->mergeTreeSize;
+	int		   *tree = state->mergeTree;
+	int		   *winners = state->mergeTree + k;
+	int			n;
+
+	Assert(k > 0);
+
+	for (n = k - 1; n >= 1; n--)
+	{
+		int			left = 2 * n;
+		int			right = 2 * n + 1;
+		int			a = (left >= k) ? left - k : winners[left];
+		int			b = (right >= k) ? right - k : winners[right];
+
+		if (merge_tree_beats(state, b, a))
+		{
+			winners[n] = b;
+			tree[n] = a;
+		}
+		else
+		{
+			winners[n] = a;
+			tree[n] = b;
+		}
+	}
+
+	tree[0] = (k == 1) ? 0 : winners[1];
+}
+
+/*
+ * merge_tree_replay - find the new winner after the current one has changed
+ *
+ * The caller has replaced the tuple of tape mergeTree[0] with the next tuple
+ * from that tape, or marked the tape as exhausted.  Replay the matches on the
+ * path from its leaf to the root.
+ */
+static void
+merge_tree_replay(Tuplesortstate *state)
+{
+	int		   *tree = state->mergeTree;
+	int			winner = tree[0];
+	int			n;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (n = (state->mergeTreeSize + winner) / 2; n > 0; n /= 2)
+	{
+		if (merge_tree_beats(state, tree[n], winner))
+		{
+			int			loser = winner;
+
+			winner = tree[n];
+			tree[n] = loser;
+		}
+	}
+
+	tree[0] = winner;
+}
+
 /*
  * dumptuples - remove tuples from memtuples and write initial run to tape
  *
@@ -2403,17 +2815,17 @@ dumptuples(Tuplesortstate *state, bool alltuples)
 		SortTuple  *stup = &state->memtuples[i];
 
 		WRITETUP(state, state->destTape, stup);
-
-		/*
-		 * Account for freeing the tuple, but no need to do the actual pfree
-		 * since the tuplecontext is being reset after the loop.
-		 */
-		if (stup->tuple != NULL)
-			FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	}
 
 	state->memtupcount = 0;
 
+	/*
+	 * Account for freeing the tuples, but no need to do the actual pfree
+	 * since the tuplecontext is being reset just below.
+	 */
+	FREEMEM(state, state->tupleMem);
+	state->tupleMem = 0;
+
 	/*
 	 * Reset tuple memory.  We've freed all of the tuples that we previously
 	 * allocated.  It's important to avoid fragmentation when there is a stark
@@ -2706,9 +3118,10 @@ sort_bounded_heap(Tuplesortstate *state)
 }
 
 /*
- * Sort all memtuples using specialized qsort() routines.
+ * Sort all memtuples using specialized qsort() routines, or a radix sort
+ * when there are enough of them and the leading key allows it.
  *
- * Quicksort is used for small in-memory sorts, and external sort runs.
+ * This is used for small in-memory sorts, and external sort runs.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -2723,6 +3136,11 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 		 */
 		if (state->base.haveDatum1 && state->base.sortKeys)
 		{
+			/* Is it large enough for a radix sort to pay off? */
+			if (state->memtupcount >= RADIXSORT_THRESHOLD &&
+				radix_sort_tuple(state))
+				return;
+
 			if (state->base.sortKeys[0].comparator == ssup_datum_unsigned_cmp)
 			{
 				qsort_tuple_unsigned(state->memtuples,
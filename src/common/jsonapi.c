@@ -19,7 +19,7 @@
 
 #include "common/jsonapi.h"
 #include "mb/pg_wchar.h"
-#include "port/pg_lfind.h"
+#include "port/simd.h"
 
 #ifndef FRONTEND
 #include "miscadmin.h"
@@ -545,6 +545,64 @@ parse_array(JsonLexContext *lex, JsonSemAction *sem)
 	return JSON_SUCCESS;
 }
 
+/*
+ * Check whether the chunk of input starting at s, of size sizeof(Vector8),
+ * consists only of spaces and tabs.
+ */
+static inline bool
+json_is_blank_chunk(const char *s)
+{
+#ifndef USE_NO_SIMD
+	Vector8		chunk;
+	Vector8		blanks;
+
+	vector8_load(&chunk, (const uint8 *) s);
+	blanks = vector8_or(vector8_eq(chunk, vector8_broadcast(' ')),
+						vector8_eq(chunk, vector8_broadcast('\t')));
+
+	/* any lane that is not blank compares equal to zero here */
+	return !vector8_is_highbit_set(vector8_eq(blanks, vector8_broadcast(0)));
+#else
+	/* the caller's byte-at-a-time loop is just as fast */
+	return false;
+#endif
+}
+
+/*
+ * Check whether the chunk of string contents starting at s, of size
+ * sizeof(Vector8), can be copied as is, that is, contains no quote,
+ * backslash or control character.
+ */
+static inline bool
+json_is_plain_chunk(const char *s)
+{
+	Vector8		chunk;
+
+	vector8_load(&chunk, (const uint8 *) s);
+
+#ifndef USE_NO_SIMD
+	{
+		Vector8		special;
+
+		/*
+		 * Compute all three conditions in vector registers and test the
+		 * result once, instead of testing each condition separately.  Bytes
+		 * <= 31 are those for which the saturating subtraction yields zero.
+		 */
+		special = vector8_or(vector8_eq(chunk, vector8_broadcast('\\')),
+							 vector8_eq(chunk, vector8_broadcast('"')));
+		special = vector8_or(special,
+							 vector8_eq(vector8_ssub(chunk, vector8_broadcast(31)),
+										vector8_broadcast(0)));
+		return !vector8_is_highbit_set(special);
+	}
+#else
+	return !(vector8_has(chunk, '\\') ||
+			 vector8_has(chunk, '"') ||
+			 vector8_has_le(chunk, 31));
+#endif
+}
+
 /*
  * Lex one token from the input stream.
  */
@@ -557,13 +615,25 @@ json_lex(JsonLexContext *lex)
 
 	/* Skip leading whitespace. */
 	s = lex->token_terminator;
-	while (s < end && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+	while (s < end)
 	{
-		if (*s++ == '\n')
+		if (*s == ' ' || *s == '\t' || *s == '\r')
+			s++;
+		else if (*s == '\n')
 		{
 			++lex->line_number;
-			lex->line_start = s;
+			lex->line_start = ++s;
+
+			/*
+			 * In pretty-printed input, a newline is usually followed by
+			 * indentation, which can be long in deeply nested documents.
+			 * Skip whole chunks of it at once.
+			 */
+			while (end - s >= sizeof(Vector8) && json_is_blank_chunk(s))
+				s += sizeof(Vector8);
 		}
+		else
+			break;
 	}
 	lex->token_start = s;
 
@@ -895,10 +965,7 @@ json_lex_string(JsonLexContext *lex)
 			 * Skip to the first byte that requires special handling, so we
 			 * can batch calls to appendBinaryStringInfo.
 			 */
-			while (p < end - sizeof(Vector8) &&
-				   !pg_lfind8('\\', (uint8 *) p, sizeof(Vector8)) &&
-				   !pg_lfind8('"', (uint8 *) p, sizeof(Vector8)) &&
-				   !pg_lfind8_le(31, (uint8 *) p, sizeof(Vector8)))
+			while (p < end - sizeof(Vector8) && json_is_plain_chunk(p))
 				p += sizeof(Vector8);
 
 			for (; p < end; p++)
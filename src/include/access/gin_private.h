@@ -12,6 +12,7 @@
 
 #include "access/amapi.h"
 #include "access/gin.h"
+#include "access/gin_tuple.h"
 #include "access/ginblock.h"
 #include "access/itup.h"
 #include "catalog/pg_am_d.h"
@@ -113,6 +114,7 @@ extern Datum gintuple_get_key(GinState *ginstate, IndexTuple tuple,
 extern IndexBuildResult *ginbuild(Relation heap, Relation index,
 								  struct IndexInfo *indexInfo);
 extern void ginbuildempty(Relation index);
+extern int	ginCompareGinTuples(GinTuple *a, GinTuple *b, GinState *ginstate);
 extern bool gininsert(Relation index, Datum *values, bool *isnull,
 					  ItemPointer ht_ctid, Relation heapRel,
 					  IndexUniqueCheck checkUnique,
@@ -220,7 +222,8 @@ extern ItemPointer ginReadTuple(GinState *ginstate, OffsetNumber attnum,
 								IndexTuple itup, int *nitems);
 
 /* gindatapage.c */
-extern ItemPointer GinDataLeafPageGetItems(Page page, int *nitems, ItemPointerData advancePast);
+extern ItemPointer GinDataLeafPageGetItems(Page page, int *nitems, ItemPointerData advancePast,
+										   bool *more);
 extern int	GinDataLeafPageGetItemsToTbm(Page page, TIDBitmap *tbm);
 extern BlockNumber createPostingTree(Relation index,
 									 ItemPointerData *items, uint32 nitems,
@@ -287,6 +290,14 @@ typedef struct GinScanKeyData
 	GinScanEntry *additionalEntries;
 	int			nadditional;
 
+	/*
+	 * skipEntry[i] is true if scanEntry[i] would have been an additional
+	 * entry, but is so frequent that we don't read it at all; it's always
+	 * passed to the consistent function as MAYBE.  Skipped entries are not
+	 * included in additionalEntries.  NULL if no entries are skipped.
+	 */
+	bool	   *skipEntry;
+
 	/* array of check flags, reported to consistentFn */
 	GinTernaryValue *entryRes;
 	bool		(*boolConsistentFn) (GinScanKey key);
@@ -358,6 +369,8 @@ typedef struct GinScanEntryData
 	ItemPointerData *list;
 	int			nlist;
 	OffsetNumber offset;
+	/* true if list holds only part of the current posting tree page */
+	bool		moreOnPage;
 
 	bool		isFinished;
 	bool		reduceResult;
@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------------
+ * gin_tuple.h
+ *	  Declarations for the tuples passed through tuplesort during a
+ *	  parallel GIN index build.
+ *
+ *	Copyright (c) 2006-2023, PostgreSQL Global Development Group
+ *
+ *	src/include/access/gin_tuple.h
+ *--------------------------------------------------------------------------
+ */
+#ifndef GIN_TUPLE_H
+#define GIN_TUPLE_H
+
+#include "access/ginblock.h"
+#include "storage/itemptr.h"
+
+/*
+ * A GinTuple carries one index key and a sorted list of heap TIDs having that
+ * key, as accumulated by one participant of a parallel build.  The key datum
+ * follows the fixed-size header, and the TIDs follow the key, each starting
+ * at a MAXALIGN'd offset, so that a by-reference key can be used in place.
+ * Use GinTupleGetKey() and GinTupleGetItems() to access them.
+ */
+typedef struct GinTuple
+{
+	int			tuplen;			/* length of the whole tuple */
+	OffsetNumber attrnum;		/* attnum of index key */
+	int16		typlen;			/* typlen of key */
+	bool		typbyval;		/* typbyval of key */
+	GinNullCategory category;	/* category: normal or NULL? */
+	int			keylen;			/* bytes of key data */
+	int			nitems;			/* number of TIDs */
+} GinTuple;
+
+static inline char *
+GinTupleGetKeyData(GinTuple *tup)
+{
+	return (char *) tup + MAXALIGN(sizeof(GinTuple));
+}
+
+static inline ItemPointer
+GinTupleGetItems(GinTuple *tup)
+{
+	return (ItemPointer) (GinTupleGetKeyData(tup) + MAXALIGN(tup->keylen));
+}
+
+static inline Datum
+GinTupleGetKey(GinTuple *tup)
+{
+	Datum		key;
+
+	if (tup->category != GIN_CAT_NORM_KEY)
+		return (Datum) 0;
+
+	if (tup->typbyval)
+	{
+		memcpy(&key, GinTupleGetKeyData(tup), sizeof(Datum));
+		return key;
+	}
+
+	return PointerGetDatum(GinTupleGetKeyData(tup));
+}
+
+#endif							/* GIN_TUPLE_H */
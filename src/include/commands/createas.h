@@ -28,6 +28,7 @@ extern ObjectAddress ExecCreateTableAs(ParseState *pstate, CreateTableAsStmt *st
 extern int	GetIntoRelEFlags(IntoClause *intoClause);
 
 extern DestReceiver *CreateIntoRelDestReceiver(IntoClause *intoClause);
+extern DestReceiver *CreateParallelIntoRelDestReceiver(Oid relid);
 
 extern bool CreateTableAsRelExists(CreateTableAsStmt *ctas);
 
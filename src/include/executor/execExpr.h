@@ -238,6 +238,10 @@ typedef enum ExprEvalOp
 	EEOP_XMLEXPR,
 	EEOP_JSON_CONSTRUCTOR,
 	EEOP_IS_JSON,
+
+	/* share one expanded jsonb among key lookups on the same Var */
+	EEOP_JSONB_EXPAND,
+
 	EEOP_AGGREF,
 	EEOP_GROUPING_FUNC,
 	EEOP_WINDOW_FUNC,
@@ -689,6 +693,12 @@ typedef struct ExprEvalStep
 			JsonIsPredicate *pred;	/* original expression node */
 		}			is_json;
 
+		/* for EEOP_JSONB_EXPAND */
+		struct
+		{
+			struct JsonbExpandCache *cache; /* shared by all uses of Var */
+		}			jsonb_expand;
+
 	}			d;
 } ExprEvalStep;
 
@@ -737,6 +747,23 @@ typedef struct SubscriptExecSteps
 	ExecEvalSubroutine sbs_fetch_old;	/* fetch old value for assignment */
 } SubscriptExecSteps;
 
+/*
+ * EEOP_JSONB_EXPAND state.  There's one of these per jsonb Var that is the
+ * input of key lookups in an expression, shared by the EEOP_JSONB_EXPAND
+ * steps following each evaluation of that Var.  It remembers the value last
+ * expanded, identified by its TOAST pointer.
+ */
+typedef struct JsonbExpandCache
+{
+	int			varno;			/* Var whose value is cached */
+	AttrNumber	varattno;
+	int			nrefs;			/* number of lookups sharing the cache */
+	MemoryContext cxt;			/* parent context of the expanded value */
+	Oid			toastrelid;		/* identity of the cached value */
+	Oid			valueid;
+	Datum		value;			/* R/W pointer to expanded jsonb, or 0 */
+} JsonbExpandCache;
+
 /* EEOP_JSON_CONSTRUCTOR state, too big to inline */
 typedef struct JsonConstructorExprState
 {
@@ -805,6 +832,7 @@ extern void ExecEvalXmlExpr(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalJsonConstructor(ExprState *state, ExprEvalStep *op,
 									ExprContext *econtext);
 extern void ExecEvalJsonIsPredicate(ExprState *state, ExprEvalStep *op);
+extern void ExecEvalJsonbExpand(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalGroupingFunc(ExprState *state, ExprEvalStep *op);
 extern void ExecEvalSubPlan(ExprState *state, ExprEvalStep *op,
 							ExprContext *econtext);
@@ -91,6 +91,29 @@ typedef struct HashJoinTupleData
 #define HJTUPLE_MINTUPLE(hjtup)  \
 	((MinimalTuple) ((char *) (hjtup) + HJTUPLE_OVERHEAD))
 
+/*
+ * Each bucket of the in-memory hash table also has a 32-bit tag, with a bit
+ * set for each tuple in the bucket.  The bit is chosen by the tuple's hash
+ * value, mixed so that it doesn't just repeat the bits that chose the bucket
+ * and batch.  A probe whose bit isn't set in the tag can't match anything in
+ * the bucket, so it can skip the bucket without following the pointer to its
+ * first tuple.  Tuples removed from a bucket leave their bits behind, which
+ * costs only a useless visit to the bucket.
+ *
+ * The tags are kept in an array of their own, so that the tags of many
+ * buckets share a cache line, right after the bucket array in the same
+ * allocation.  HJ_BUCKET_SIZE is the space that one bucket takes up.
+ */
+#define HJ_TAG_BIT(hashvalue) \
+	(((uint32) 1) << (((uint32) (hashvalue) * 0x9E3779B1U) >> 27))
+#define HJ_BUCKET_SIZE	(sizeof(HashJoinTuple) + sizeof(uint32))
+#define HJ_BUCKET_TAGS(buckets, nbuckets) \
+	((uint32 *) ((buckets) + (nbuckets)))
+#define HJ_SHARED_BUCKET_SIZE \
+	(sizeof(dsa_pointer_atomic) + sizeof(pg_atomic_uint32))
+#define HJ_SHARED_BUCKET_TAGS(buckets, nbuckets) \
+	((pg_atomic_uint32 *) ((buckets) + (nbuckets)))
+
 /*
  * If the outer relation's distribution is sufficiently nonuniform, we attempt
  * to optimize the join by treating the hash values corresponding to the outer
@@ -313,6 +336,13 @@ typedef struct HashJoinTableData
 		dsa_pointer_atomic *shared;
 	}			buckets;
 
+	/* bucketTags[i] is the tag of the i'th bucket; see HJ_TAG_BIT */
+	union
+	{
+		uint32	   *unshared;
+		pg_atomic_uint32 *shared;
+	}			bucketTags;
+
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
 	bool		skewEnabled;	/* are we using skew optimization? */
@@ -329,6 +359,18 @@ typedef struct HashJoinTableData
 
 	bool		growEnabled;	/* flag to shut off nbatch increases */
 
+	/*
+	 * A parallel-oblivious inner join that planned a single batch asks the
+	 * Hash node to stop, rather than add batches, when the table first runs
+	 * out of memory, so that it can consider hashing the outer relation
+	 * instead.  See ExecHashJoinTryReverse.
+	 */
+	bool		reversible;		/* stop building instead of adding batches? */
+	bool		buildPaused;	/* did we stop building for that reason? */
+	bool		reversed;		/* did the join then swap roles? */
+	double		reversedTuples; /* # outer tuples hashed after swapping */
+	Size		reversedSpace;	/* space used by those tuples and buckets */
+
 	double		totalTuples;	/* # tuples obtained from inner plan */
 	double		partialTuples;	/* # tuples obtained from inner plan by me */
 	double		skewTuples;		/* # tuples inserted into skew tuples */
@@ -33,6 +33,10 @@ typedef struct BufferUsage
 	int64		local_blks_written; /* # of local disk blocks written */
 	int64		temp_blks_read; /* # of temp blocks read */
 	int64		temp_blks_written;	/* # of temp blocks written */
+	int64		temp_raw_bytes; /* # of bytes written to compressed temp
+								 * files, before compression */
+	int64		temp_compressed_bytes;	/* # of bytes written to compressed
+										 * temp files, after compression */
 	instr_time	blk_read_time;	/* time spent reading blocks */
 	instr_time	blk_write_time; /* time spent writing blocks */
 	instr_time	temp_blk_read_time; /* time spent reading temp blocks */
@@ -18,6 +18,9 @@
 #include "nodes/execnodes.h"
 
 
+/* Hash table state for DISTINCT aggregates; private to nodeAgg.c */
+typedef struct AggDistinctHashData *AggDistinctHash;
+
 /*
  * AggStatePerTransData - per aggregate state value information
  *
@@ -161,6 +164,14 @@ typedef struct AggStatePerTransData
 
 	Tuplesortstate **sortstates;	/* sort objects, if DISTINCT or ORDER BY */
 
+	/*
+	 * If the planner marked the Aggref with aggdistincthash, duplicate inputs
+	 * are discarded with a hash table before they reach the sort.  There's
+	 * one such table for each grouping set; see ExecAggDistinctHashInsert.
+	 */
+	FmgrInfo	hashfnOne;
+	AggDistinctHash distincthashes; /* NULL if not hashing */
+
 	/*
 	 * This field is a pre-initialized FunctionCallInfo struct used for
 	 * calling this aggregate's transfn.  We save a few cycles per row by not
@@ -326,6 +337,9 @@ extern AggState *ExecInitAgg(Agg *node, EState *estate, int eflags);
 extern void ExecEndAgg(AggState *node);
 extern void ExecReScanAgg(AggState *node);
 
+extern bool ExecAggDistinctHashInsert(AggStatePerTrans pertrans, int setno,
+									  Datum value, bool isnull);
+
 extern Size hash_agg_entry_size(int numTrans, Size tupleWidth,
 								Size transitionSpace);
 extern void hash_agg_set_limits(double hashentrysize, double input_groups,
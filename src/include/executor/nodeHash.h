@@ -54,6 +54,8 @@ extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 									  int *bucketno,
 									  int *batchno);
 extern bool ExecScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
+extern void ExecHashPrefetchBucket(HashJoinTable hashtable, uint32 hashvalue);
+extern void ExecHashPrefetchTuple(HashJoinTable hashtable, uint32 hashvalue);
 extern bool ExecParallelScanHashBucket(HashJoinState *hjstate, ExprContext *econtext);
 extern void ExecPrepHashTableForUnmatched(HashJoinState *hjstate);
 extern bool ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate);
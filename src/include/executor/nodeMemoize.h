@@ -28,5 +28,6 @@ extern void ExecMemoizeInitializeDSM(MemoizeState *node,
 extern void ExecMemoizeInitializeWorker(MemoizeState *node,
 										ParallelWorkerContext *pwcxt);
 extern void ExecMemoizeRetrieveInstrumentation(MemoizeState *node);
+extern void ExecShutdownMemoize(MemoizeState *node);
 
 #endif							/* NODEMEMOIZE_H */
@@ -30,4 +30,7 @@ extern void ExecReScanModifyTable(ModifyTableState *node);
 extern void ExecInitMergeTupleSlots(ModifyTableState *mtstate,
 									ResultRelInfo *resultRelInfo);
 
+extern int	ExecGetMultiInsertBatchSize(ModifyTableState *mtstate,
+										ResultRelInfo *resultRelInfo);
+
 #endif							/* NODEMODIFYTABLE_H */
@@ -1323,6 +1323,14 @@ typedef struct ModifyTableState
 	double		mt_merge_inserted;
 	double		mt_merge_updated;
 	double		mt_merge_deleted;
+
+	/*
+	 * Tuples buffered for multi-insert into local tables, over all result
+	 * relations.  Only used if mt_multi_insert is set.
+	 */
+	bool		mt_multi_insert;	/* may INSERTed rows be buffered? */
+	int			mt_buffered_tuples; /* number of buffered tuples */
+	Size		mt_buffered_bytes;	/* their total data size */
 } ModifyTableState;
 
 /* ----------------
@@ -2093,6 +2101,10 @@ typedef struct MergeJoinState
  *		hj_JoinState			current state of ExecHashJoin state machine
  *		hj_MatchedOuter			true if found a join match for current outer
  *		hj_OuterNotEmpty		true if outer relation known not empty
+ *		hj_Reversal				state for swapping inner and outer roles
+ *								(NULL if not considered)
+ *		hj_Prefetch				queue of outer tuples read ahead of probing
+ *								(NULL if not used yet)
  * ----------------
  */
 
@@ -2120,6 +2132,8 @@ typedef struct HashJoinState
 	int			hj_JoinState;
 	bool		hj_MatchedOuter;
 	bool		hj_OuterNotEmpty;
+	struct HashJoinReversal *hj_Reversal;
+	struct HashJoinPrefetch *hj_Prefetch;
 } HashJoinState;
 
 
@@ -2148,6 +2162,8 @@ typedef struct MaterialState
 struct MemoizeEntry;
 struct MemoizeTuple;
 struct MemoizeKey;
+struct MemoizeSharedEntry;
+struct ParallelMemoizeCache;
 
 typedef struct MemoizeInstrumentation
 {
@@ -2171,6 +2187,8 @@ typedef struct MemoizeInstrumentation
 typedef struct SharedMemoizeInfo
 {
 	int			num_workers;
+	dsa_pointer shared_cache;	/* ParallelMemoizeCache for a Parallel
+								 * Memoize node, else InvalidDsaPointer */
 	MemoizeInstrumentation sinstrument[FLEXIBLE_ARRAY_MEMBER];
 } SharedMemoizeInfo;
 
@@ -2213,6 +2231,15 @@ typedef struct MemoizeState
 	SharedMemoizeInfo *shared_info; /* statistics for parallel workers */
 	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
 								 * param_exprs */
+
+	/* These fields are only used by Parallel Memoize */
+	struct ParallelMemoizeCache *shared_cache;	/* cache shared with the other
+												 * participants, or NULL */
+	struct dshash_table *shared_table;	/* shared_cache's hash table */
+	struct dsa_area *shared_area;	/* area holding the shared cache */
+	struct MemoizeSharedEntry *shared_entry;	/* entry pinned for the
+												 * current scan, or NULL */
+	dsa_pointer shared_last_tuple;	/* like last_tuple, for shared_entry */
 } MemoizeState;
 
 /* ----------------
@@ -2587,6 +2614,7 @@ typedef struct GatherState
 	bool		initialized;	/* workers launched? */
 	bool		need_to_scan_locally;	/* need to read from local plan? */
 	int64		tuples_needed;	/* tuple bound, see ExecSetTupleBound */
+	Oid			insert_relid;	/* table workers insert into, or InvalidOid */
 	/* these fields are set up once: */
 	TupleTableSlot *funnel_slot;
 	struct ParallelExecutorInfo *pei;
@@ -2640,6 +2668,9 @@ typedef struct HashInstrumentation
 	int			nbatch;			/* number of batches at end of execution */
 	int			nbatch_original;	/* planned number of batches */
 	Size		space_peak;		/* peak memory usage in bytes */
+	bool		reversed;		/* did the join swap inner and outer? */
+	int64		reversed_tuples;	/* outer tuples hashed after swapping */
+	Size		reversed_space;	/* memory used by those tuples in bytes */
 } HashInstrumentation;
 
 /* ----------------
@@ -398,6 +398,11 @@ typedef struct Param
  * aggregates where the chosen plan provides presorted input for this
  * aggregate during execution.
  *
+ * aggdistincthash is set by the query planner for single-argument DISTINCT
+ * aggregates, when it estimates that eliminating duplicates with a hash
+ * table before sorting is cheaper than sorting all the input.  It has no
+ * effect if aggpresorted is also set.
+ *
  * aggsplit indicates the expected partial-aggregation mode for the Aggref's
  * parent plan node.  It's always set to AGGSPLIT_SIMPLE in the parser, but
  * the planner might change it to something else.  We use this mainly as
@@ -469,6 +474,9 @@ typedef struct Aggref
 	/* aggregate input already sorted */
 	bool		aggpresorted pg_node_attr(equal_ignore, query_jumble_ignore);
 
+	/* remove duplicate inputs with a hash table before sorting */
+	bool		aggdistincthash pg_node_attr(equal_ignore, query_jumble_ignore);
+
 	/* > 0 if agg belongs to outer query */
 	Index		agglevelsup pg_node_attr(query_jumble_ignore);
 
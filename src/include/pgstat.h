@@ -235,7 +235,7 @@ typedef struct PgStat_TableXactStatus
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BCAC
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BCAD
 
 typedef struct PgStat_ArchiverStats
 {
@@ -254,6 +254,7 @@ typedef struct PgStat_BgWriterStats
 {
 	PgStat_Counter buf_written_clean;
 	PgStat_Counter maxwritten_clean;
+	PgStat_Counter buf_written_evict;
 	PgStat_Counter buf_alloc;
 	TimestampTz stat_reset_timestamp;
 } PgStat_BgWriterStats;
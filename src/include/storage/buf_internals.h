@@ -400,8 +400,11 @@ extern void StrategyFreeBuffer(BufferDesc *buf);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 								 BufferDesc *buf, bool from_ring);
 
-extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
+extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+							  uint32 *num_dirty_evictions);
+extern int	StrategyBufferAtClockPosition(int pos);
 extern void StrategyNotifyBgWriter(int bgwprocno);
+extern void StrategyReportDirtyEviction(void);
 
 extern Size StrategyShmemSize(void);
 extern void StrategyInitialize(bool init);
@@ -116,6 +116,9 @@ struct SMgrRelationData;
 /* in globals.c ... this duplicates miscadmin.h */
 extern PGDLLIMPORT int NBuffers;
 
+/* in buf_init.c */
+extern PGDLLIMPORT bool shared_buffers_numa_interleave;
+
 /* in bufmgr.c */
 extern PGDLLIMPORT bool zero_damaged_pages;
 extern PGDLLIMPORT int bgwriter_lru_maxpages;
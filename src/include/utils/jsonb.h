@@ -368,6 +368,32 @@ typedef struct JsonbIterator
 	struct JsonbIterator *parent;
 } JsonbIterator;
 
+/*
+ * An expanded jsonb is a flat, fully detoasted copy of a jsonb value kept in
+ * a private memory context (as all expanded objects must be), so that it can
+ * be looked at repeatedly without detoasting it again each time.  If the
+ * root is an object with many keys, the first key lookup also builds a hash
+ * table over its top-level keys, making further lookups O(1) instead of a
+ * binary search through the JEntry array.  Expanded jsonb values are never
+ * modified in place.
+ */
+#define EJ_MAGIC 719281634		/* ID for debugging crosschecks */
+
+typedef struct ExpandedJsonbHeader
+{
+	/* Standard header for expanded objects */
+	ExpandedObjectHeader hdr;
+
+	/* Magic value identifying an expanded jsonb (for debugging only) */
+	int			ej_magic;
+
+	/* The flat representation; always valid */
+	Jsonb	   *fvalue;
+
+	/* Hash table of top-level keys, or NULL if not built (yet) */
+	struct jsonb_keyidx_hash *keyindex;
+} ExpandedJsonbHeader;
+
 
 /* Convenience macros */
 static inline Jsonb *
@@ -404,6 +430,9 @@ extern JsonbValue *getKeyJsonValueFromContainer(JsonbContainer *container,
 												JsonbValue *res);
 extern JsonbValue *getIthJsonbValueFromContainer(JsonbContainer *container,
 												 uint32 i);
+extern void fillJsonbValue(JsonbContainer *container, int index,
+						   char *base_addr, uint32 offset,
+						   JsonbValue *result);
 extern JsonbValue *pushJsonbValue(JsonbParseState **pstate,
 								  JsonbIteratorToken seq, JsonbValue *jbval);
 extern JsonbIterator *JsonbIteratorInit(JsonbContainer *container);
@@ -417,6 +446,17 @@ extern void JsonbHashScalarValue(const JsonbValue *scalarVal, uint32 *hash);
 extern void JsonbHashScalarValueExtended(const JsonbValue *scalarVal,
 										 uint64 *hash, uint64 seed);
 
+/* expanded jsonb support functions, in jsonb_expanded.c */
+extern Datum expand_jsonb(Datum jsonbdatum, MemoryContext parentcontext);
+extern ExpandedJsonbHeader *DatumGetExpandedJsonb(Datum d);
+extern JsonbValue *getKeyJsonValueFromExpandedJsonb(ExpandedJsonbHeader *ejh,
+													const char *keyVal,
+													int keyLen,
+													JsonbValue *res);
+extern JsonbValue *getKeyJsonValueFromDatum(Datum jsonbdatum,
+											const char *keyVal, int keyLen,
+											JsonbValue *res);
+
 /* jsonb.c support functions */
 extern char *JsonbToCString(StringInfo out, JsonbContainer *in,
 							int estimated_len);
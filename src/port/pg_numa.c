@@ -0,0 +1,117 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_numa.c
+ *		Basic NUMA portability routines
+ *
+ * These are thin wrappers around libnuma, so that callers don't need to
+ * care whether the build has NUMA support.  Without it, the system is
+ * treated as having a single node and no placement is done.
+ *
+ * Copyright (c) 2023, PostgreSQL Global Development Group
+ *
+ *
+ * IDENTIFICATION
+ *	  src/port/pg_numa.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "c.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "port/pg_numa.h"
+
+#ifdef USE_LIBNUMA
+
+#include <numa.h>
+#include <numaif.h>
+
+/*
+ * Returns -1 if NUMA is not available on this system, like numa_available().
+ * This must be called before any other function of this file.
+ */
+int
+pg_numa_init(void)
+{
+	return numa_available();
+}
+
+/*
+ * Returns the highest node number available on this system.
+ */
+int
+pg_numa_get_max_node(void)
+{
+	return numa_max_node();
+}
+
+/*
+ * Fill status[i] with the node that the memory page containing pages[i]
+ * resides on, or with a negative errno value if that can't be determined
+ * (for example -ENOENT if the page has not been faulted in yet).  Returns 0
+ * on success, -1 with errno set on failure.
+ */
+int
+pg_numa_query_pages(int pid, unsigned long count, void **pages, int *status)
+{
+	return numa_move_pages(pid, count, pages, NULL, status, 0);
+}
+
+/*
+ * Set the memory policy of the given range to interleave its pages across
+ * all nodes.  This only affects pages that haven't been faulted in yet.
+ *
+ * pagesize is the size of the pages backing the range, which matters when it
+ * is backed by huge pages: those are placed whole, and the range must be
+ * aligned to them.  Pass 0 to use the system's default page size.  The range
+ * is extended to whole pages.  Returns 0 on success, -1 with errno set on
+ * failure.
+ */
+int
+pg_numa_interleave_memory(void *start, size_t size, size_t pagesize)
+{
+	char	   *aligned;
+
+	if (pagesize == 0)
+		pagesize = sysconf(_SC_PAGESIZE);
+
+	aligned = (char *) TYPEALIGN_DOWN(pagesize, start);
+	size = TYPEALIGN(pagesize, size + ((char *) start - aligned));
+
+	return mbind(aligned, size, MPOL_INTERLEAVE,
+				 numa_all_nodes_ptr->maskp, numa_all_nodes_ptr->size + 1, 0);
+}
+
+#else
+
+/* Empty wrappers */
+int
+pg_numa_init(void)
+{
+	/* We state that NUMA is not available */
+	return -1;
+}
+
+int
+pg_numa_get_max_node(void)
+{
+	return 0;
+}
+
+int
+pg_numa_query_pages(int pid, unsigned long count, void **pages, int *status)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+int
+pg_numa_interleave_memory(void *start, size_t size, size_t pagesize)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+#endif
@@ -0,0 +1,36 @@
+# Copyright (c) 2023, PostgreSQL Global Development Group
+
+# Check that the JSON parser microbenchmark runs, and accepts and rejects
+# input as expected.  Timings are not checked.
+
+use strict;
+use warnings;
+
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $exe = 'test_json_parser_perf';
+
+command_like([ $exe, '1' ],
+	qr/compact.*\n.*pretty.*\n.*strings/,
+	'generated payloads');
+command_like([ $exe, '-e', '1' ],
+	qr/compact.*\n.*pretty.*\n.*strings/,
+	'generated payloads, de-escaping strings');
+
+my $tempdir = PostgreSQL::Test::Utils::tempdir;
+
+# Long indentation and strings, to cover chunk boundaries
+my $good = "$tempdir/good.json";
+append_to_file($good,
+	    "{\n" . (' ' x 37) . "\"key\": \"" . ('x' x 40) . "\\\"" . ('y' x 40)
+	  . "\",\n" . ("\t" x 20) . "\"n\": [1, 2,\n\n" . (' ' x 64) . "3]\n}\n");
+command_like([ $exe, '-e', '3', $good ], qr/^file/, 'valid input file');
+
+my $bad = "$tempdir/bad.json";
+append_to_file($bad, "{\"key\": \"" . ('x' x 40) . "\n\"}");
+command_fails_like([ $exe, '1', $bad ],
+	qr/invalid JSON .* at offset 49/,
+	'invalid input file');
+
+done_testing();
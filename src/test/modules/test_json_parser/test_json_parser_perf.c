@@ -0,0 +1,297 @@
+/*-------------------------------------------------------------------------
+ *
+ * test_json_parser_perf.c
+ *		Microbenchmark for the JSON lexer and parser
+ *
+ * This program parses JSON documents repeatedly with pg_parse_json() and
+ * reports the time taken.  Without an input file, it runs through a set of
+ * generated payloads resembling typical input: compact records, a
+ * pretty-printed nested document, and records with long string values,
+ * some of them containing escapes.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_json_parser/test_json_parser_perf.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include <sys/stat.h>
+
+#include "common/jsonapi.h"
+#include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
+#include "pg_getopt.h"
+#include "portability/instr_time.h"
+
+const char *const progname = "test_json_parser_perf";
+
+static bool need_escapes = false;
+
+static void usage(void);
+static void run_test(const char *name, char *json, int len, int iterations);
+static void make_compact(StringInfo buf);
+static void make_pretty(StringInfo buf);
+static void make_strings(StringInfo buf);
+static void append_indent(StringInfo buf, int level);
+
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: %s [-e] num_iterations [input_file]\n", progname);
+	fprintf(stderr, "  -e  de-escape strings, as json and jsonb input do\n");
+	exit(1);
+}
+
+/*
+ * Parse the document 'iterations' times, and report the time per iteration
+ * and the throughput.
+ */
+static void
+run_test(const char *name, char *json, int len, int iterations)
+{
+	instr_time	start;
+	instr_time	duration;
+	double		msec;
+	int			i;
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < iterations; i++)
+	{
+		JsonLexContext *lex;
+		JsonParseErrorType result;
+
+		lex = makeJsonLexContextCstringLen(json, len, PG_UTF8, need_escapes);
+		result = pg_parse_json(lex, &nullSemAction);
+		if (result != JSON_SUCCESS)
+		{
+			/* json_errdetail() is not available in frontend code */
+			fprintf(stderr, "%s: %s: invalid JSON (error %d) at offset %d\n",
+					progname, name, (int) result,
+					(int) (lex->token_terminator - lex->input));
+			exit(1);
+		}
+
+		if (lex->strval != NULL)
+		{
+			pfree(lex->strval->data);
+			pfree(lex->strval);
+		}
+		pfree(lex);
+	}
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start);
+	msec = INSTR_TIME_GET_MILLISEC(duration);
+
+	printf("%-10s %10d bytes %12.4f ms/iteration %10.1f MB/s\n",
+		   name, len, msec / iterations,
+		   msec > 0 ? (double) len * iterations / (msec * 1000.0) : 0.0);
+}
+
+/*
+ * An array of small records, without any whitespace, as produced by most
+ * JSON serializers.
+ */
+static void
+make_compact(StringInfo buf)
+{
+	int			i;
+
+	appendStringInfoChar(buf, '[');
+	for (i = 0; i < 2000; i++)
+	{
+		if (i > 0)
+			appendStringInfoChar(buf, ',');
+		appendStringInfo(buf,
+						 "{\"id\":%d,\"name\":\"user%d\",\"active\":%s,"
+						 "\"score\":%d.%d,\"tags\":[\"alpha\",\"beta\"],"
+						 "\"parent\":null}",
+						 i, i, (i % 3) ? "true" : "false", i % 100, i % 7);
+	}
+	appendStringInfoChar(buf, ']');
+}
+
+static void
+append_indent(StringInfo buf, int level)
+{
+	appendStringInfoChar(buf, '\n');
+	appendStringInfoSpaces(buf, level * 4);
+}
+
+/*
+ * A pretty-printed document with several levels of nesting, so that much of
+ * the input is indentation.
+ */
+static void
+make_pretty(StringInfo buf)
+{
+	int			i;
+	int			j;
+
+	appendStringInfoString(buf, "{");
+	append_indent(buf, 1);
+	appendStringInfoString(buf, "\"orders\": [");
+	for (i = 0; i < 500; i++)
+	{
+		if (i > 0)
+			appendStringInfoChar(buf, ',');
+		append_indent(buf, 2);
+		appendStringInfoChar(buf, '{');
+		append_indent(buf, 3);
+		appendStringInfo(buf, "\"order_id\": %d,", i);
+		append_indent(buf, 3);
+		appendStringInfoString(buf, "\"customer\": {");
+		append_indent(buf, 4);
+		appendStringInfo(buf, "\"name\": \"customer %d\",", i);
+		append_indent(buf, 4);
+		appendStringInfoString(buf, "\"address\": {");
+		append_indent(buf, 5);
+		appendStringInfoString(buf, "\"city\": \"Springfield\",");
+		append_indent(buf, 5);
+		appendStringInfo(buf, "\"zip\": \"%05d\"", i * 7);
+		append_indent(buf, 4);
+		appendStringInfoChar(buf, '}');
+		append_indent(buf, 3);
+		appendStringInfoString(buf, "},");
+		append_indent(buf, 3);
+		appendStringInfoString(buf, "\"items\": [");
+		for (j = 0; j < 3; j++)
+		{
+			if (j > 0)
+				appendStringInfoChar(buf, ',');
+			append_indent(buf, 4);
+			appendStringInfoChar(buf, '{');
+			append_indent(buf, 5);
+			appendStringInfo(buf, "\"sku\": \"SKU-%d-%d\",", i, j);
+			append_indent(buf, 5);
+			appendStringInfo(buf, "\"quantity\": %d,", j + 1);
+			append_indent(buf, 5);
+			appendStringInfo(buf, "\"price\": %d.99", i % 50);
+			append_indent(buf, 4);
+			appendStringInfoChar(buf, '}');
+		}
+		append_indent(buf, 3);
+		appendStringInfoChar(buf, ']');
+		append_indent(buf, 2);
+		appendStringInfoChar(buf, '}');
+	}
+	append_indent(buf, 1);
+	appendStringInfoChar(buf, ']');
+	append_indent(buf, 0);
+	appendStringInfoChar(buf, '}');
+}
+
+/*
+ * Records with long free-text values, as in logs or documents.  Every
+ * fourth value contains escapes.
+ */
+static void
+make_strings(StringInfo buf)
+{
+	int			i;
+
+	appendStringInfoChar(buf, '[');
+	for (i = 0; i < 500; i++)
+	{
+		if (i > 0)
+			appendStringInfoChar(buf, ',');
+		appendStringInfo(buf, "{\"id\":%d,\"message\":\"", i);
+		appendStringInfoString(buf,
+							   "Lorem ipsum dolor sit amet, consectetur "
+							   "adipiscing elit, sed do eiusmod tempor "
+							   "incididunt ut labore et dolore magna aliqua. "
+							   "Ut enim ad minim veniam, quis nostrud "
+							   "exercitation ullamco laboris nisi ut aliquip "
+							   "ex ea commodo consequat.");
+		if (i % 4 == 0)
+			appendStringInfoString(buf,
+								   "\\n\\tDuis aute \\\"irure\\\" dolor in "
+								   "reprehenderit caf\\u00e9 \\\\ voluptate.");
+		appendStringInfoString(buf, "\"}");
+	}
+	appendStringInfoChar(buf, ']');
+}
+
+int
+main(int argc, char **argv)
+{
+	int			iterations;
+	int			c;
+
+	while ((c = getopt(argc, argv, "e")) != -1)
+	{
+		switch (c)
+		{
+			case 'e':
+				need_escapes = true;
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (optind >= argc || argc - optind > 2)
+		usage();
+
+	iterations = atoi(argv[optind]);
+	if (iterations <= 0)
+		usage();
+
+	if (optind + 1 < argc)
+	{
+		const char *filename = argv[optind + 1];
+		FILE	   *fp;
+		struct stat st;
+		char	   *json;
+
+		if ((fp = fopen(filename, PG_BINARY_R)) == NULL)
+		{
+			fprintf(stderr, "%s: could not open file \"%s\": %m\n",
+					progname, filename);
+			exit(1);
+		}
+		if (fstat(fileno(fp), &st) != 0)
+		{
+			fprintf(stderr, "%s: could not stat file \"%s\": %m\n",
+					progname, filename);
+			exit(1);
+		}
+		json = pg_malloc(st.st_size + 1);
+		if (fread(json, 1, st.st_size, fp) != st.st_size)
+		{
+			fprintf(stderr, "%s: could not read file \"%s\": %m\n",
+					progname, filename);
+			exit(1);
+		}
+		json[st.st_size] = '\0';
+		fclose(fp);
+
+		run_test("file", json, st.st_size, iterations);
+	}
+	else
+	{
+		StringInfoData buf;
+
+		initStringInfo(&buf);
+		make_compact(&buf);
+		run_test("compact", buf.data, buf.len, iterations);
+
+		resetStringInfo(&buf);
+		make_pretty(&buf);
+		run_test("pretty", buf.data, buf.len, iterations);
+
+		resetStringInfo(&buf);
+		make_strings(&buf);
+		run_test("strings", buf.data, buf.len, iterations);
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+# Check that dirty buffers that backends have to write out themselves are
+# counted in pg_stat_bgwriter.buffers_backend_evict, and that the background
+# writer cleans buffers for them when its LRU scan is enabled.  This needs a
+# shared_buffers setting much smaller than the regression tests can use.
+
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+# Disable the LRU scan at first, so that only backends write dirty victims.
+# Keep checkpoints and autovacuum from writing or reading buffers meanwhile.
+$node->append_conf(
+	'postgresql.conf', qq{
+shared_buffers = 1MB
+bgwriter_lru_maxpages = 0
+bgwriter_delay = 10ms
+checkpoint_timeout = 1h
+max_wal_size = 1GB
+autovacuum = off
+});
+$node->start;
+
+# A table several times the size of shared_buffers.
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE evict_test (a int, b text);
+INSERT INTO evict_test SELECT g, repeat('x', 100) FROM generate_series(1, 50000) g;
+});
+
+my $evict_before = $node->safe_psql('postgres',
+	"SELECT buffers_backend_evict FROM pg_stat_bgwriter");
+my $writes_before = $node->safe_psql('postgres',
+	"SELECT sum(writes) FROM pg_stat_io WHERE backend_type = 'client backend' AND object = 'relation' AND context = 'normal'"
+);
+
+# An UPDATE dirties every page, and doesn't use a buffer access strategy
+# ring, so the clock sweep keeps handing the backend dirty victims.
+$node->safe_psql('postgres', "UPDATE evict_test SET a = a + 1");
+
+# The background writer collects the count on its next round.
+ok( $node->poll_query_until(
+		'postgres',
+		"SELECT buffers_backend_evict > $evict_before FROM pg_stat_bgwriter"),
+	'backend evictions of dirty buffers are counted');
+
+my $writes_after = $node->safe_psql('postgres',
+	"SELECT sum(writes) FROM pg_stat_io WHERE backend_type = 'client backend' AND object = 'relation' AND context = 'normal'"
+);
+cmp_ok($writes_after, '>', $writes_before,
+	'backend writes are shown in pg_stat_io');
+
+# With the LRU scan enabled, the background writer writes dirty buffers
+# ahead of the clock sweep, as backends keep evicting.
+my $clean_before = $node->safe_psql('postgres',
+	"SELECT buffers_clean FROM pg_stat_bgwriter");
+$node->append_conf('postgresql.conf', 'bgwriter_lru_maxpages = 100');
+$node->reload;
+$node->safe_psql('postgres', "UPDATE evict_test SET a = a + 1");
+
+ok( $node->poll_query_until(
+		'postgres',
+		"SELECT buffers_clean > $clean_before FROM pg_stat_bgwriter"),
+	'background writer cleans buffers for backends');
+
+is( $node->safe_psql(
+		'postgres', "SELECT count(*), sum(a) FROM evict_test"),
+	'50000|1250125000',
+	'table contents are intact');
+
+$node->stop;
+
+done_testing();
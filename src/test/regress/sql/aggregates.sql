@@ -607,6 +607,27 @@ select array_agg(distinct a order by a desc)
 select array_agg(distinct a order by a desc nulls last)
   from (values (1),(2),(1),(3),(null),(2)) v(a);
 
+-- DISTINCT aggregates may discard duplicates with a hash table before
+-- sorting, if many inputs of each group are expected to be duplicates;
+-- EXPLAIN VERBOSE shows which ones do
+set enable_presorted_aggregate = off;
+explain (verbose, costs off)
+select two, count(distinct four), count(distinct unique1)
+  from tenk1 group by two;
+reset enable_presorted_aggregate;
+
+-- check that the results of such aggregates are the same
+select count(distinct a), sum(distinct a), array_agg(distinct a order by a desc)
+  from (values (3),(1),(null),(3),(2),(null),(1)) v(a);
+select two, count(distinct four), array_agg(distinct ten)
+  from tenk1 group by two order by two;
+-- also when the hash table fills up
+set work_mem = '64kB';
+select count(distinct g::text), sum(distinct g),
+       array_agg(distinct g % 20000) = array(select generate_series(0, 19999)) as sorted
+  from generate_series(1, 30000) g, generate_series(1, 2);
+reset work_mem;
+
 -- multi-arg aggs, strict/nonstrict, distinct/order by
 
 select aggfstr(a,b,c)
@@ -1381,6 +1402,16 @@ create table agg_group_4 as
 select (g/2)::numeric as c1, array_agg(g::numeric) as c2, count(*) as c3
   from agg_data_2k group by g/2;
 
+-- Same as agg_group_1, with compressed temporary files
+
+set temp_file_compression = pglz;
+
+create table agg_group_5 as
+select g%10000 as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g%10000;
+
+set temp_file_compression to default;
+
 -- Produce results with hash aggregation
 
 set enable_hashagg = true;
@@ -1417,6 +1448,16 @@ create table agg_hash_4 as
 select (g/2)::numeric as c1, array_agg(g::numeric) as c2, count(*) as c3
   from agg_data_2k group by g/2;
 
+-- Same as agg_hash_1, with compressed temporary files
+
+set temp_file_compression = pglz;
+
+create table agg_hash_5 as
+select g%10000 as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g%10000;
+
+set temp_file_compression to default;
+
 set enable_sort = true;
 set work_mem to default;
 
@@ -1438,11 +1479,17 @@ set work_mem to default;
   union all
 (select * from agg_group_4 except select * from agg_hash_4);
 
+(select * from agg_hash_5 except select * from agg_group_5)
+  union all
+(select * from agg_group_5 except select * from agg_hash_5);
+
 drop table agg_group_1;
 drop table agg_group_2;
 drop table agg_group_3;
 drop table agg_group_4;
+drop table agg_group_5;
 drop table agg_hash_1;
 drop table agg_hash_2;
 drop table agg_hash_3;
 drop table agg_hash_4;
+drop table agg_hash_5;
@@ -159,6 +159,10 @@ explain (costs off)
 select count(*) from t_gin_test_tbl where j @> '{}'::int[];
 select count(*) from t_gin_test_tbl where j @> '{}'::int[];
 
+-- intersect short lists with long posting trees
+select count(*) from t_gin_test_tbl where i @> array[500] and j @> array[2];
+select count(*) from t_gin_test_tbl where i @> array[1999] and j @> array[2, 1999];
+
 -- test vacuuming of posting trees
 delete from t_gin_test_tbl where j @> array[2];
 vacuum t_gin_test_tbl;
@@ -181,3 +185,33 @@ values
   ('{}',    null),
   ('{1}',   '{2,3}');
 drop table t_gin_test_tbl;
+
+-- test parallel build; the parallel_workers setting makes the build use
+-- workers regardless of table size and maintenance_work_mem.  The workers'
+-- I/O statistics show that they took part: they are flushed when the workers
+-- exit, which CREATE INDEX waits for.
+create table t_gin_test_tbl(i int4[]) with (parallel_workers = 2);
+insert into t_gin_test_tbl
+  select array[g % 10, g % 100, g] from generate_series(1, 10000) g;
+insert into t_gin_test_tbl values (null), ('{}');
+set max_parallel_maintenance_workers = 2;
+set maintenance_work_mem = '1MB';
+select sum(coalesce(reads, 0) + coalesce(hits, 0)) as worker_io_before
+  from pg_stat_io
+  where backend_type = 'background worker' and object = 'relation' \gset
+create index t_gin_test_tbl_i_idx on t_gin_test_tbl using gin (i);
+select sum(coalesce(reads, 0) + coalesce(hits, 0)) > :worker_io_before
+    as workers_took_part
+  from pg_stat_io
+  where backend_type = 'background worker' and object = 'relation';
+reset max_parallel_maintenance_workers;
+reset maintenance_work_mem;
+
+set enable_seqscan = off;
+select count(*) from t_gin_test_tbl where i @> array[5];
+select count(*) from t_gin_test_tbl where i @> array[5, 55];
+select count(*) from t_gin_test_tbl where i @> array[1234];
+select count(*) from t_gin_test_tbl where i @> '{}'::int[];
+reset enable_seqscan;
+
+drop table t_gin_test_tbl;
@@ -597,3 +597,16 @@ alter table returningwrtest2 drop c;
 alter table returningwrtest attach partition returningwrtest2 for values in (2);
 insert into returningwrtest values (2, 'foo') returning returningwrtest;
 drop table returningwrtest;
+
+-- check that rows buffered by INSERT ... SELECT are inserted and indexed
+create table multiins (a int primary key, b text);
+insert into multiins select g, 'row ' || g from generate_series(1, 2500) g;
+select count(*), sum(a), count(distinct b) from multiins;
+insert into multiins select g from generate_series(2400, 2600) g;
+select count(*) from multiins;
+create table multiins_p (a int, b text) partition by range (a);
+create table multiins_p1 partition of multiins_p for values from (1) to (1001);
+create table multiins_p2 partition of multiins_p for values from (1001) to (3001);
+insert into multiins_p select * from multiins;
+select tableoid::regclass, count(*) from multiins_p group by 1 order by 1;
+drop table multiins, multiins_p;
@@ -157,6 +157,20 @@ $$
 $$);
 rollback to settings;
 
+-- non-parallel, with compressed batch files
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '128kB';
+set local hash_mem_multiplier = 1.0;
+set local temp_file_compression = pglz;
+select count(*), sum(r.id) from simple r join simple s using (id);
+select original > 1 as initially_multibatch, final > original as increased_batches
+  from hash_join_batches(
+$$
+  select count(*) from simple r join simple s using (id);
+$$);
+rollback to settings;
+
 -- parallel with parallel-oblivious hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
@@ -191,6 +205,22 @@ $$);
 select count(*) from simple r full outer join simple s using (id);
 rollback to settings;
 
+-- parallel with parallel-aware hash join, with compressed batch files
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+set local work_mem = '192kB';
+set local hash_mem_multiplier = 1.0;
+set local enable_parallel_hash = on;
+set local temp_file_compression = pglz;
+select count(*) from simple r join simple s using (id);
+select original > 1 as initially_multibatch, final > original as increased_batches
+  from hash_join_batches(
+$$
+  select count(*) from simple r join simple s using (id);
+$$);
+select count(*) from simple r full outer join simple s using (id);
+rollback to settings;
+
 -- The "bad" case: during execution we need to increase number of
 -- batches; in this case we plan for 1 batch, and increase at least a
 -- couple of times, and peak memory usage stays within our work_mem
@@ -293,6 +323,87 @@ $$
 $$);
 rollback to settings;
 
+-- The "upside down" case: the inner relation is much bigger than
+-- planned, but the outer one is small, so rather than adding batches
+-- we hash the outer relation and stream the inner one past it.  This
+-- is only done for parallel-oblivious inner joins.
+create or replace function hash_join_reversed(query text)
+returns table (reversed bool, final int) language plpgsql
+as
+$$
+declare
+  whole_plan json;
+  hash_node json;
+begin
+  for whole_plan in
+    execute 'explain (analyze, format ''json'') ' || query
+  loop
+    hash_node := find_hash(json_extract_path(whole_plan, '0', 'Plan'));
+    reversed := coalesce((hash_node->>'Roles Reversed')::bool, false);
+    final := hash_node->>'Hash Batches';
+    return next;
+  end loop;
+end;
+$$;
+
+-- Make a relation whose size we will over-estimate.  We want stats to
+-- say 100,000 rows, but actually there are 200 rows.
+create table smaller_than_it_looks as
+  select generate_series(1, 200) as id, 'aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa';
+alter table smaller_than_it_looks set (autovacuum_enabled = 'false');
+analyze smaller_than_it_looks;
+update pg_class
+  set reltuples = 100000, relpages = pg_relation_size('smaller_than_it_looks') / 8192
+  where relname = 'smaller_than_it_looks';
+
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '128kB';
+set local hash_mem_multiplier = 1.0;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+explain (costs off)
+  select count(*) from smaller_than_it_looks r join bigger_than_it_looks s using (id);
+select count(*) from smaller_than_it_looks r join bigger_than_it_looks s using (id);
+select count(*) from smaller_than_it_looks r join bigger_than_it_looks s
+  on r.id = s.id and r.id + s.id < 100;
+select * from hash_join_reversed(
+$$
+  select count(*) from smaller_than_it_looks r join bigger_than_it_looks s using (id);
+$$);
+-- if the outer relation doesn't fit either, we add batches as usual
+select reversed, final > 1 as multibatch
+  from hash_join_reversed(
+$$
+  select count(*) from simple r join bigger_than_it_looks s using (id);
+$$);
+rollback to settings;
+
+-- A hash table big enough for outer tuples to be read ahead of probing
+-- it, so that their buckets can be prefetched
+create table join_big as select generate_series(1, 100000) as id;
+alter table join_big set (parallel_workers = 2);
+analyze join_big;
+
+-- non-parallel
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local work_mem = '16MB';
+set local hash_mem_multiplier = 1.0;
+select count(*), sum(r.id) from join_big r join join_big s using (id);
+select count(*), count(s.id) from join_big r
+  left join join_big s on r.id = s.id + 50000;
+rollback to settings;
+
+-- parallel with parallel-aware hash join
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+set local work_mem = '16MB';
+set local hash_mem_multiplier = 1.0;
+set local enable_parallel_hash = on;
+select count(*), sum(r.id) from join_big r join join_big s using (id);
+rollback to settings;
+
 -- A couple of other hash join tests unrelated to work_mem management.
 
 -- Check that EXPLAIN ANALYZE has data even if the leader doesn't participate
@@ -85,6 +85,13 @@ SELECT '{
 		"two":"two",
 		"averyveryveryveryveryveryveryveryveryverylongfieldname":}'::jsonb;
 -- ERROR missing value for last field
+-- Long indentation and strings, spanning several chunks examined at once
+SELECT ('{' || chr(10) || repeat(' ', 40) || '"one": "' || repeat('x', 20) ||
+        '\"' || repeat('y', 20) || '",' || chr(10) || repeat(' ', 40) ||
+        '"two": 2' || chr(10) || '}')::jsonb;
+SELECT ('{' || chr(10) || repeat(' ', 40) || '"one": "' || repeat('x', 20) ||
+        '\"' || repeat('y', 20) || '",' || chr(10) || repeat(' ', 40) ||
+        '"two":,' || chr(10) || '}')::jsonb;
 
 -- test non-error-throwing input
 select pg_input_is_valid('{"a":true}', 'jsonb');
@@ -192,6 +199,20 @@ SELECT (test_json->>'field3') IS NULL AS expect_true FROM test_jsonb WHERE json_
 SELECT (test_json->3) IS NULL AS expect_false FROM test_jsonb WHERE json_type = 'array';
 SELECT (test_json->>3) IS NULL AS expect_true FROM test_jsonb WHERE json_type = 'array';
 
+-- key lookups on a large, toasted object share one expanded copy per row
+CREATE TEMP TABLE test_jsonb_big (id int, j jsonb);
+ALTER TABLE test_jsonb_big ALTER COLUMN j SET STORAGE EXTERNAL;
+INSERT INTO test_jsonb_big
+  SELECT i, jsonb_object_agg('k' || g, g * i)
+  FROM generate_series(1, 2) i, generate_series(1, 500) g
+  GROUP BY i;
+SELECT id, j -> 'k1' AS k1, j ->> 'k250' AS k250, j -> 'k500' AS k500,
+       j -> 'nokey' AS nokey, j ? 'k499' AS has_k499, j ? 'nokey' AS has_nokey
+  FROM test_jsonb_big ORDER BY id;
+SELECT id FROM test_jsonb_big WHERE j ? 'k2' AND (j ->> 'k2')::int > 2;
+SELECT id, j -> 'k1' AS k1, jsonb_typeof(j) AS type FROM test_jsonb_big ORDER BY id;
+DROP TABLE test_jsonb_big;
+
 -- corner cases
 select '{"a": [{"b": "c"}, {"b": "cc"}]}'::jsonb -> null::text;
 select '{"a": [{"b": "c"}, {"b": "cc"}]}'::jsonb -> null::int;
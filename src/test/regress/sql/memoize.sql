@@ -177,6 +177,65 @@ SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
 LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
 WHERE t1.unique1 < 1000;
 
+-- Exercise evictions from the shared cache.  Each participant brings its
+-- hash_mem to the shared cache, and the cached rows are made wide, so that
+-- they don't all fit.  Evictions may be made by any participant, and the
+-- number of workers that get to do any work varies, so add up the evictions
+-- shown for the leader and all the workers.  Also report whether the plan
+-- that ran used a Parallel Memoize node, as separate caches in each process
+-- could evict entries too.
+create function memoize_evictions(query text,
+    out parallel_memoize bool, out evictions bigint)
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    parallel_memoize := false;
+    evictions := 0;
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        if ln ~ 'Parallel Memoize' then
+            parallel_memoize := true;
+        end if;
+        evictions := evictions +
+            coalesce((regexp_match(ln, 'Evictions: (\d+)'))[1]::bigint, 0);
+    end loop;
+end;
+$$;
+SET work_mem TO '64kB';
+SET hash_mem_multiplier TO 1.0;
+SET enable_hashjoin TO off;
+SET enable_mergejoin TO off;
+SELECT parallel_memoize, evictions > 0 AS evicted FROM memoize_evictions('
+SELECT COUNT(*),SUM(t2.unique1),COUNT(t2.*) FROM tenk1 t1,
+LATERAL (SELECT * FROM tenk1 t2 WHERE t1.thousand = t2.unique1) t2
+WHERE t1.unique1 < 5000;');
+
+-- And check we get the expected results.
+SELECT COUNT(*),SUM(t2.unique1),COUNT(t2.*) FROM tenk1 t1,
+LATERAL (SELECT * FROM tenk1 t2 WHERE t1.thousand = t2.unique1) t2
+WHERE t1.unique1 < 5000;
+RESET enable_mergejoin;
+RESET enable_hashjoin;
+RESET hash_mem_multiplier;
+RESET work_mem;
+DROP FUNCTION memoize_evictions(text);
+
+-- Ensure we can still give each process its own cache.
+SET enable_parallel_memoize TO off;
+EXPLAIN (COSTS OFF)
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
+WHERE t1.unique1 < 1000;
+
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
+WHERE t1.unique1 < 1000;
+RESET enable_parallel_memoize;
+
 RESET max_parallel_workers_per_gather;
 RESET parallel_tuple_cost;
 RESET parallel_setup_cost;
@@ -1168,6 +1168,22 @@ select 4769999999999999999999999999999999999999999999999999999999999999999999999
 
 select trim_scale((0.1 - 2e-16383) * (0.1 - 3e-16383));
 
+--
+-- Test the integer arithmetic fast path for small values, near the limits
+-- where it has to fall back to the general code
+--
+select a, b, a + b as sum, a - b as diff, a * b as prod
+from (values (999999999999999.99, 0.01),
+             (9999999999999999, 1),
+             (-9999999999999999, -1),
+             (99999999.99999999, 99999999.99999999),
+             (0.0001, 1e-20),
+             (1.5000, -1.50),
+             (123456789012345678, 1000)) v(a, b);
+select sum(999999999999999.9999) from generate_series(1, 1000);
+select x, sum(x) over (order by x rows between 1 preceding and current row)
+from (values (1.5), (2.25), (1e-20), (9999999999999999)) v(x);
+
 --
 -- Test some corner cases for division
 --
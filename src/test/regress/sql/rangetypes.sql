@@ -310,6 +310,20 @@ select count(*) from test_range_gist where ir &< int4multirange(int4range(100,20
 select count(*) from test_range_gist where ir &> int4multirange(int4range(100,200), int4range(400,500));
 select count(*) from test_range_gist where ir -|- int4multirange(int4range(100,200), int4range(400,500));
 
+-- range_ops has a sortsupport function, so the bulk-loaded index above was
+-- built with the sorted method, which packs pages much more tightly than a
+-- build that has to split pages, such as a forced buffering build
+create index test_range_gist_idx_buffered on test_range_gist
+  using gist (ir) with (buffering = on);
+select pg_relation_size('test_range_gist_idx') <
+       pg_relation_size('test_range_gist_idx_buffered') as sorted_is_smaller;
+drop index test_range_gist_idx_buffered;
+
+-- the same sortsupport function is used for sorting ranges
+select ir from (values (int4range(5,10)), ('empty'), (int4range(NULL,3)),
+  (int4range(5,NULL)), (int4range(1,2)), (int4range(5,7))) v(ir)
+  order by ir;
+
 -- test SP-GiST index that's been built incrementally
 create table test_range_spgist(ir int4range);
 create index test_range_spgist_idx on test_range_spgist using spgist (ir);
@@ -211,6 +211,47 @@ FETCH NEXT FROM c;
 
 COMMIT;
 
+-- disk based, with compressed temporary files
+BEGIN;
+SET LOCAL enable_indexscan = false;
+SET LOCAL work_mem = '100kB';
+SET LOCAL temp_file_compression = pglz;
+EXPLAIN (COSTS OFF) DECLARE c SCROLL CURSOR FOR SELECT noabort_decreasing FROM abbrev_abort_uuids ORDER BY noabort_decreasing;
+DECLARE c SCROLL CURSOR FOR SELECT noabort_decreasing FROM abbrev_abort_uuids ORDER BY noabort_decreasing;
+
+-- first and second
+FETCH NEXT FROM c;
+FETCH NEXT FROM c;
+
+-- scroll beyond beginning
+FETCH BACKWARD FROM c;
+FETCH BACKWARD FROM c;
+FETCH BACKWARD FROM c;
+FETCH BACKWARD FROM c;
+FETCH NEXT FROM c;
+
+-- scroll beyond end end
+FETCH LAST FROM c;
+FETCH BACKWARD FROM c;
+FETCH NEXT FROM c;
+FETCH NEXT FROM c;
+FETCH NEXT FROM c;
+FETCH BACKWARD FROM c;
+FETCH NEXT FROM c;
+
+COMMIT;
+
+-- compressed sort whose block map doesn't fit in memory, so that map pages
+-- are written out and read back while the runs are merged
+BEGIN;
+SET LOCAL work_mem = '4MB';
+SET LOCAL temp_file_compression = pglz;
+SELECT count(*) FROM
+  (SELECT g, row_number() OVER () AS rn
+     FROM (SELECT g FROM generate_series(1, 600000) g ORDER BY g DESC) s) t
+  WHERE g <> 600001 - rn;
+COMMIT;
+
 
 ----
 -- test tuplesort using both in-memory and disk sort
@@ -296,3 +337,32 @@ EXPLAIN (COSTS OFF) :qry;
 :qry;
 
 COMMIT;
+
+----
+-- test radix sort of integer leading keys
+----
+
+CREATE TEMP TABLE radix_sort_ints AS
+    SELECT (g % 1000 - 500) * 10000000007 AS i8,
+           ((g * 7919) % 2001 - 1000) * 1000003 AS i4,
+           g AS id
+    FROM generate_series(1, 5000) g;
+INSERT INTO radix_sort_ints VALUES (NULL, NULL, 0), (NULL, NULL, 5001);
+
+-- signed int8 key, descending, with ties broken by a second key
+SELECT count(*) AS n,
+       count(*) FILTER (WHERE (prev_i8 IS NOT NULL AND i8 IS NULL) OR
+                              prev_i8 < i8 OR
+                              (prev_i8 IS NOT DISTINCT FROM i8 AND prev_id > id)) AS out_of_order
+FROM (SELECT i8, id, lag(i8) OVER w AS prev_i8, lag(id) OVER w AS prev_id
+      FROM (SELECT i8, id FROM radix_sort_ints
+            ORDER BY i8 DESC NULLS FIRST, id OFFSET 0) s
+      WINDOW w AS ()) s;
+
+-- int4 key on its own, ascending
+SELECT count(*) AS n,
+       count(*) FILTER (WHERE (rn > 1 AND prev_i4 IS NULL AND i4 IS NOT NULL) OR
+                              prev_i4 > i4) AS out_of_order
+FROM (SELECT i4, row_number() OVER w AS rn, lag(i4) OVER w AS prev_i4
+      FROM (SELECT i4 FROM radix_sort_ints ORDER BY i4 OFFSET 0) s
+      WINDOW w AS ()) s;
@@ -1716,6 +1716,49 @@ SELECT i, b, bool_and(b) OVER w, bool_or(b) OVER w
   FROM (VALUES (1,true), (2,true), (3,false), (4,false), (5,true)) v(i,b)
   WINDOW w AS (ORDER BY i ROWS BETWEEN CURRENT ROW AND 1 FOLLOWING);
 
+-- Sliding frames for aggregates without an inverse transition function are
+-- evaluated using a segment tree over the partition's rows
+SELECT i, v, min(v) OVER w AS mn, max(v) OVER w AS mx,
+       max(v) FILTER (WHERE v % 2 = 0) OVER w AS mx_even
+  FROM (VALUES (1,5), (2,NULL), (3,8), (4,2), (5,9), (6,NULL), (7,4)) t(i,v)
+  WINDOW w AS (ORDER BY i ROWS BETWEEN 2 PRECEDING AND 1 FOLLOWING);
+
+-- frames large enough to wrap around the tree's ring buffer several times
+SELECT count(*) FROM
+  (SELECT i, p, min(v) OVER w AS mn, max(v) OVER w AS mx
+     FROM (SELECT i, i % 3 AS p, (i * 7919) % 1000 AS v
+             FROM generate_series(1, 1000) i) s
+     WINDOW w AS (PARTITION BY p ORDER BY i
+                  ROWS BETWEEN 100 PRECEDING AND 50 FOLLOWING)) w
+  WHERE (mn, mx) IS DISTINCT FROM
+        (SELECT min((j * 7919) % 1000), max((j * 7919) % 1000)
+           FROM generate_series(1, 1000) j
+          WHERE j % 3 = w.p AND j BETWEEN w.i - 300 AND w.i + 150);
+
+-- aggregates with INTERNAL state must not use the segment tree, as their
+-- combine functions modify their input states
+SELECT i, v, array_agg(i) OVER w, string_agg(v, ',') OVER w
+  FROM (VALUES (1,'a'), (2,'b'), (3,NULL), (4,'d'), (5,'e'), (6,'f')) t(i,v)
+  WINDOW w AS (ORDER BY i ROWS BETWEEN 2 PRECEDING AND 1 FOLLOWING);
+
+-- float addition isn't associative, so float states must not use the
+-- segment tree either; the third row must be summed in frame order
+SELECT i, v, sum(v) OVER w
+  FROM (VALUES (1,1::float8), (2,1), (3,1), (4,1e16)) t(i,v)
+  WINDOW w AS (ORDER BY i ROWS BETWEEN 1 PRECEDING AND 1 FOLLOWING);
+
+-- a frame too large for work_mem makes the aggregate fall back to the
+-- regular code in the middle of a partition
+SET work_mem = '64kB';
+SELECT count(*) FROM
+  (SELECT i, min(i) OVER w AS mn, max(i) OVER w AS mx
+     FROM generate_series(1, 5000) i
+     WINDOW w AS (PARTITION BY i > 2500 ORDER BY i
+                  ROWS BETWEEN 2100 PRECEDING AND CURRENT ROW)) w
+  WHERE mn <> greatest(i - 2100, CASE WHEN i > 2500 THEN 2501 ELSE 1 END)
+     OR mx <> i;
+RESET work_mem;
+
 -- Tests for problems with failure to walk or mutate expressions
 -- within window frame clauses.
 
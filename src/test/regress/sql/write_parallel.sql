@@ -40,4 +40,37 @@ explain (costs off) create table parallel_write as execute prep_stmt;
 create table parallel_write as execute prep_stmt;
 drop table parallel_write;
 
+-- if the Gather is at the top, the workers insert the rows themselves
+explain (costs off) create table parallel_write as
+    select unique1, stringu1 from tenk1 where unique1 % 2 = 0;
+create table parallel_write as
+    select unique1, stringu1 from tenk1 where unique1 % 2 = 0;
+select count(*), sum(unique1) from parallel_write;
+drop table parallel_write;
+
 rollback;
+
+--
+-- Test INSERT ... SELECT with rows inserted by parallel workers
+--
+create table parallel_write (unique1 int, stringu1 name);
+
+begin;
+
+set parallel_setup_cost=0;
+set min_parallel_table_scan_size=0;
+set max_parallel_workers_per_gather=4;
+
+explain (costs off) insert into parallel_write
+    select unique1, stringu1 from tenk1;
+insert into parallel_write select unique1, stringu1 from tenk1;
+select count(*), sum(unique1) from parallel_write;
+
+-- not possible if the table has indexes
+create index on parallel_write (unique1);
+explain (costs off) insert into parallel_write
+    select unique1, stringu1 from tenk1;
+
+rollback;
+
+drop table parallel_write;